@@ -10,12 +10,25 @@ Tests: spec_protocol_happy_path, spec_invalid_inputs, spec_partial_io, spec_time
 from __future__ import annotations
 
 import argparse
+import contextlib
+import gzip
+import multiprocessing
+import multiprocessing.synchronize
+import os
+import select
+import shutil
 import signal
 import socket
+import subprocess
+import tempfile
+import threading
 import time
+import zlib
 from collections.abc import Iterable
+from pathlib import Path
 
-from tests.common.runtime import ServerProcess, binary_path
+from tests.common.runtime import ServerProcess, binary_path, build_dir
+from tools import result_decoder
 
 
 def _read_until(sock: socket.socket, substrings: Iterable[str], timeout: float = 3.0) -> str:
@@ -242,12 +255,1633 @@ def spec_sigint_shutdown() -> None:
         assert "server initialized" in server.stderr
 
 
+def spec_client_timestamps() -> None:
+    """Sequence: SEQ0133. Verifies client-supplied timestamps and reordering from SEQ0128–SEQ0134."""
+
+    cpp_binary = binary_path("cpp")
+    cpp_log = 15150
+    cpp_query = 15151
+    with ServerProcess(
+        cpp_binary,
+        "--log-port",
+        str(cpp_log),
+        "--query-port",
+        str(cpp_query),
+        "--client-timestamps",
+    ) as server:
+        server.wait_ready([cpp_log, cpp_query])
+        # 2021-01-01T00:00:00Z == 1609459200; lines arrive out of event-time order.
+        lines = [
+            "2021-01-01T00:00:20Z stamp-b",
+            "2021-01-01T09:00:10+09:00 stamp-a",
+            "1609459230 stamp-c",
+            "1609459205000 stamp-early",
+            "stamp-arrival without a leading timestamp",
+        ]
+        _send_log_line(cpp_log, "", [(line + "\n").encode() for line in lines])
+        response = _query_command(cpp_query, "QUERY keyword=stamp- time_from=1609459200 time_to=1609459225")
+        assert "FOUND: 3" in response, response
+        positions = [response.find(tag) for tag in ("stamp-early", "stamp-a", "stamp-b")]
+        assert all(pos >= 0 for pos in positions), response
+        assert positions == sorted(positions), response
+        assert "stamp-c" not in response
+        assert "2021-01-01T" not in response
+        stats = _query_command(cpp_query, "STATS")
+        assert "Reordered=" in stats
+
+
+def spec_source_quotas() -> None:
+    """Sequence: SEQ0142. Verifies per-source quotas and fairness counters from SEQ0138–SEQ0144."""
+
+    cpp_binary = binary_path("cpp")
+    cpp_log = 15160
+    cpp_query = 15161
+    with ServerProcess(
+        cpp_binary,
+        "--log-port",
+        str(cpp_log),
+        "--query-port",
+        str(cpp_query),
+        "--source-rate",
+        "5",
+        "--source-burst",
+        "5",
+        "--quota-action",
+        "drop",
+    ) as server:
+        server.wait_ready([cpp_log, cpp_query])
+        noisy = "SOURCE noisy\n" + "".join(f"noisy-{index}\n" for index in range(40))
+        _send_log_line(cpp_log, "", [noisy.encode()])
+        _send_log_line(cpp_log, "", [b"SOURCE quiet\nquiet-0\nquiet-1\nquiet-2\n"])
+
+        response = _query_command(cpp_query, "QUERY keyword=quiet-")
+        assert "FOUND: 3" in response, response
+        response = _query_command(cpp_query, "QUERY keyword=noisy-")
+        found = int(response.split("FOUND: ", 1)[1].split("\n", 1)[0])
+        assert 5 <= found < 40, response
+        assert "SOURCE " not in _query_command(cpp_query, "QUERY keyword=SOURCE")
+
+        stats = _query_command(cpp_query, "STATS")
+        dropped = int(stats.split("QuotaDropped=", 1)[1].split(",", 1)[0])
+        assert dropped == 40 - found, stats
+        assert f"TopSources=[noisy={found}/{dropped}/0" in stats, stats
+
+
+def _drain_stdout(server: ServerProcess, stop: threading.Event) -> None:
+    # The server echoes every stored line; keep the pipe empty so bulk ingest never blocks on it.
+    fd = server.process.stdout.fileno()
+    while not stop.is_set():
+        readable, _, _ = select.select([fd], [], [], 0.1)
+        if readable and not os.read(fd, 65536):
+            break
+
+
+def _stats_field(stats: str, name: str) -> int:
+    return int(stats.split(f"{name}=", 1)[1].split(",", 1)[0])
+
+
+def _timed_ingest(log_port: int, query_port: int, prefix: str, lines: int, expected_total: int) -> float:
+    payload = "".join(f"{prefix}-{index}\n" for index in range(lines)).encode()
+    start = time.monotonic()
+    with socket.create_connection(("127.0.0.1", log_port), timeout=5.0) as sock:
+        _read_until(sock, ("LogCrafter",))
+        sock.sendall(payload)
+        sock.shutdown(socket.SHUT_WR)
+        deadline = time.monotonic() + 30.0
+        while _stats_field(_query_command(query_port, "STATS"), "Total") < expected_total:
+            assert time.monotonic() < deadline, f"ingest of {prefix} did not complete"
+            time.sleep(0.01)
+    return time.monotonic() - start
+
+
+_STATS_POLL_HZ = 10000.0
+# Each poll is a fresh connection, so the rate the host can reach is bounded by connection
+# handling on both ends. HELP polled at the same target costs the same and takes no locks, so
+# STATS is held to a share of the HELP rate, which is the target itself on a fast enough host.
+_STATS_POLL_MIN_RATE_VS_HELP = 0.75
+# Best ingest time with STATS polled over the best with HELP polled, across the rounds.
+_STATS_POLL_MAX_SLOWDOWN = 1.2
+_STATS_POLL_ROUNDS = 3
+
+
+def _poll_at_rate(query_port: int, command: str, stop: multiprocessing.synchronize.Event, results) -> None:
+    # Runs in its own process so the poll rate does not depend on the ingest thread's GIL share.
+    period = 1.0 / _STATS_POLL_HZ
+    start = next_poll = time.monotonic()
+    polls = 0
+    totals: list[int] = []
+    request = (command + "\n").encode()
+    while not stop.is_set():
+        # The request is sent without waiting for the banner; the server reads it once the banner is out.
+        with socket.create_connection(("127.0.0.1", query_port), timeout=1.0) as sock:
+            sock.sendall(request)
+            sock.shutdown(socket.SHUT_WR)
+            chunks = []
+            while chunk := sock.recv(65536):
+                chunks.append(chunk)
+        response = b"".join(chunks).decode(errors="ignore")
+        polls += 1
+        if command == "STATS":
+            totals.append(_stats_field(response, "Total"))
+        next_poll += period
+        delay = next_poll - time.monotonic()
+        if delay > 0:
+            time.sleep(delay)
+    results.put((polls / (time.monotonic() - start), totals == sorted(totals)))
+
+
+@contextlib.contextmanager
+def _poller(query_port: int, command: str):
+    """Polls `command` at _STATS_POLL_HZ until the block exits, then appends the rate reached."""
+
+    context = multiprocessing.get_context("fork")
+    stop = context.Event()
+    results = context.SimpleQueue()
+    process = context.Process(target=_poll_at_rate, args=(query_port, command, stop, results), daemon=True)
+    rates: list[float] = []
+    process.start()
+    try:
+        yield rates
+    finally:
+        stop.set()
+        rate, ordered = results.get()
+        process.join(timeout=5.0)
+    assert ordered, f"{command} totals went backwards"
+    rates.append(rate)
+
+
+def spec_stats_polling() -> None:
+    """Sequence: SEQ0149. Verifies lock-free STATS under polling from SEQ0146–SEQ0159.
+
+    STATS and HELP are each polled at a 10 kHz target, idle and during bulk ingest. STATS must
+    reach at least 75% of the HELP rate both times, and the best of three ingest runs with STATS
+    polled may take at most 1.2x the best of three with HELP polled.
+    """
+
+    cpp_binary = binary_path("cpp")
+    cpp_log = 15170
+    cpp_query = 15171
+    lines = 50000
+    with ServerProcess(
+        cpp_binary,
+        "--log-port",
+        str(cpp_log),
+        "--query-port",
+        str(cpp_query),
+        "--capacity",
+        str(lines * _STATS_POLL_ROUNDS * 2),
+    ) as server:
+        server.wait_ready([cpp_log, cpp_query])
+        stop_draining = threading.Event()
+        drainer = threading.Thread(target=_drain_stdout, args=(server, stop_draining), daemon=True)
+        drainer.start()
+
+        # Rounds alternate which command goes first, so neither always runs on a fuller ring.
+        orders = [("HELP", "STATS"), ("STATS", "HELP")]
+        idle: dict[str, list[float]] = {"HELP": [], "STATS": []}
+        for round_index in range(_STATS_POLL_ROUNDS):
+            for command in orders[round_index % 2]:
+                with _poller(cpp_query, command) as reached:
+                    time.sleep(1.0)
+                idle[command].extend(reached)
+        print(
+            f"Idle: STATS polled at {max(idle['STATS']):.0f}/s, HELP at {max(idle['HELP']):.0f}/s "
+            f"(target {_STATS_POLL_HZ:.0f}/s)"
+        )
+        assert max(idle["STATS"]) >= max(idle["HELP"]) * _STATS_POLL_MIN_RATE_VS_HELP, idle
+
+        expected = 0
+        samples: dict[str, tuple[list[float], list[float]]] = {"HELP": ([], []), "STATS": ([], [])}
+        for round_index in range(_STATS_POLL_ROUNDS):
+            for command in orders[round_index % 2]:
+                times, rates = samples[command]
+                expected += lines
+                with _poller(cpp_query, command) as reached:
+                    times.append(_timed_ingest(cpp_log, cpp_query, f"{command}{round_index}", lines, expected))
+                rates.extend(reached)
+
+        help_times, help_rates = samples["HELP"]
+        stats_times, stats_rates = samples["STATS"]
+        slowdown = min(stats_times) / min(help_times)
+        print(
+            f"During ingest: STATS polled at {max(stats_rates):.0f}/s, HELP at {max(help_rates):.0f}/s; "
+            f"ingest took {slowdown:.2f}x the HELP-polled time"
+        )
+        assert max(stats_rates) >= max(help_rates) * _STATS_POLL_MIN_RATE_VS_HELP, (help_rates, stats_rates)
+        assert slowdown <= _STATS_POLL_MAX_SLOWDOWN, (help_times, stats_times)
+        assert "COUNT: " + str(expected) in _query_command(cpp_query, "COUNT")
+
+        stop_draining.set()
+        drainer.join(timeout=5.0)
+
+
+def _wait_for_count(query_port: int, expected: int) -> None:
+    deadline = time.monotonic() + 30.0
+    while True:
+        response = _query_command(query_port, "COUNT")
+        if int(response.split(":", 1)[1].strip()) >= expected:
+            return
+        assert time.monotonic() < deadline, response
+        time.sleep(0.05)
+
+
+def _assert_large_query(log_port: int, query_port: int, prefix: str, lines: int) -> None:
+    padding = "x" * 96
+    payload = "".join(f"{prefix}-{index:06d} {padding}\n" for index in range(lines)).encode()
+    with socket.create_connection(("127.0.0.1", log_port), timeout=5.0) as sock:
+        _read_until(sock, ("LogCrafter",))
+        sock.sendall(payload)
+        sock.shutdown(socket.SHUT_WR)
+        _wait_for_count(query_port, lines)
+
+    with socket.create_connection(("127.0.0.1", query_port), timeout=5.0) as sock:
+        _read_until(sock, ("Commands",))
+        sock.sendall(f"QUERY keyword={prefix}\n".encode())
+        sock.shutdown(socket.SHUT_WR)
+        response = _read_all(sock, timeout=10.0)
+
+    header, _, body = response.partition("\n")
+    assert header == f"FOUND: {lines}", header
+    results = body.splitlines()
+    assert len(results) == lines, len(results)
+    # Every line arrives whole and in ring order, so batch boundaries never split or drop output.
+    for index, line in enumerate(results):
+        assert line.endswith(f"{prefix}-{index:06d} {padding}"), (index, line)
+
+
+def spec_large_query_response() -> None:
+    """Sequence: SEQ0171. Verifies batched QUERY transmission from SEQ0166–SEQ0172."""
+
+    lines = 5000
+    c_binary = binary_path("c")
+    with ServerProcess(c_binary) as server:
+        server.wait_ready([9999, 9998])
+        stop_draining = threading.Event()
+        drainer = threading.Thread(target=_drain_stdout, args=(server, stop_draining), daemon=True)
+        drainer.start()
+        try:
+            _assert_large_query(9999, 9998, "bulk-c", lines)
+        finally:
+            stop_draining.set()
+            drainer.join(timeout=5.0)
+
+    cpp_binary = binary_path("cpp")
+    cpp_log = 15180
+    cpp_query = 15181
+    with ServerProcess(
+        cpp_binary,
+        "--log-port",
+        str(cpp_log),
+        "--query-port",
+        str(cpp_query),
+    ) as server:
+        server.wait_ready([cpp_log, cpp_query])
+        stop_draining = threading.Event()
+        drainer = threading.Thread(target=_drain_stdout, args=(server, stop_draining), daemon=True)
+        drainer.start()
+        try:
+            _assert_large_query(cpp_log, cpp_query, "bulk-cpp", lines)
+        finally:
+            stop_draining.set()
+            drainer.join(timeout=5.0)
+
+
+def _send_session(port: int, lines: list[str]) -> None:
+    with socket.create_connection(("127.0.0.1", port), timeout=5.0) as sock:
+        _read_until(sock, ("LogCrafter",))
+        sock.sendall("".join(f"{line}\n" for line in lines).encode())
+        sock.shutdown(socket.SHUT_WR)
+        _read_all(sock, timeout=1.0)
+
+
+def _stream_entry(stats: str, name: str) -> list[int]:
+    entries = stats.split("Streams=", 1)[1].split("[", 1)[1].split("]", 1)[0]
+    for entry in entries.split(", "):
+        stream, _, counters = entry.partition("=")
+        if stream == name:
+            return [int(value) for value in counters.split("/")]
+    raise AssertionError(f"stream {name} missing from {stats!r}")
+
+
+def spec_named_streams() -> None:
+    """Sequence: SEQ0177. Verifies named streams, per-stream retention, and stream-scoped queries from SEQ0175–SEQ0186."""
+
+    cpp_binary = binary_path("cpp")
+    cpp_log = 15190
+    cpp_query = 15191
+    tmp_root = Path(tempfile.mkdtemp(prefix="lc-spec-streams-", dir=str(build_dir())))
+    persist_dir = tmp_root / "persist"
+    args = (
+        "--log-port",
+        str(cpp_log),
+        "--query-port",
+        str(cpp_query),
+        "--capacity",
+        "50",
+        "--stream",
+        "audit:1000",
+        "--persistence-dir",
+        str(persist_dir),
+    )
+    try:
+        with ServerProcess(cpp_binary, *args) as server:
+            server.wait_ready([cpp_log, cpp_query])
+            _send_session(cpp_log, ["STREAM audit"] + [f"audit-event-{index}" for index in range(5)])
+            # A chatty unnamed producer churns the default stream without touching audit lines.
+            _send_session(cpp_log, [f"debug-noise-{index}" for index in range(200)])
+            _send_session(cpp_log, ["SOURCE billing", "STREAM payments"] + [f"payment-{index}" for index in range(3)])
+
+            deadline = time.monotonic() + 10.0
+            while True:
+                stats = _query_command(cpp_query, "STATS")
+                if _stats_field(stats, "Total") >= 208 and _stats_field(stats, "Persisted") >= 208:
+                    break
+                assert time.monotonic() < deadline, stats
+                time.sleep(0.05)
+
+            assert "Streams=3 [" in stats, stats
+            assert _stream_entry(stats, "default") == [50, 200, 150, 200], stats
+            assert _stream_entry(stats, "audit") == [5, 5, 0, 5], stats
+            assert _stream_entry(stats, "payments") == [3, 3, 0, 3], stats
+            assert "COUNT: 58" in _query_command(cpp_query, "COUNT")
+
+            audit = _query_command(cpp_query, "QUERY stream=audit")
+            assert audit.startswith("FOUND: 5\n"), audit
+            assert "debug-noise" not in audit and "payment-" not in audit
+
+            both = _query_command(cpp_query, "QUERY stream=payments,audit keyword=-1")
+            assert both.startswith("FOUND: 2\n"), both
+            assert both.index("payment-1") < both.index("audit-event-1"), both
+
+            everywhere = _query_command(cpp_query, "QUERY keyword=-199")
+            assert everywhere.startswith("FOUND: 1\n") and "debug-noise-199" in everywhere, everywhere
+
+            unknown = _query_command(cpp_query, "QUERY stream=missing keyword=x")
+            assert "ERROR: Unknown stream 'missing'." in unknown, unknown
+
+        assert (persist_dir / "audit" / "current.log").exists()
+        assert (persist_dir / "payments" / "current.log").exists()
+
+        # Streams with a persistence subdirectory come back on restart, before any producer.
+        with ServerProcess(cpp_binary, *args) as server:
+            server.wait_ready([cpp_log, cpp_query])
+            restored = _query_command(cpp_query, "QUERY stream=payments")
+            assert restored.startswith("FOUND: 3\n"), restored
+            assert "COUNT: 58" in _query_command(cpp_query, "COUNT")
+    finally:
+        shutil.rmtree(tmp_root, ignore_errors=True)
+
+
+def spec_repeat_collapsing() -> None:
+    """Sequence: SEQ0189. Verifies per-source repeat collapsing and its STATS counters from SEQ0187–SEQ0195."""
+
+    cpp_binary = binary_path("cpp")
+    cpp_log = 15200
+    cpp_query = 15201
+    with ServerProcess(
+        cpp_binary,
+        "--log-port",
+        str(cpp_log),
+        "--query-port",
+        str(cpp_query),
+        "--collapse-repeats",
+        "masked",
+        "--collapse-window",
+        "60000",
+    ) as server:
+        server.wait_ready([cpp_log, cpp_query])
+        storm = ["SOURCE storm"] + ["disk full on /dev/sda"] * 1000
+        storm += [f"retry {index} failed after {index % 7}ms" for index in range(500)]
+        storm.append("recovered")
+        _send_session(cpp_log, storm)
+        # The run still open when a source's last session closes is summarised on close.
+        _send_session(cpp_log, ["SOURCE other"] + ["disk full on /dev/sda"] * 3)
+
+        deadline = time.monotonic() + 10.0
+        while True:
+            stats = _query_command(cpp_query, "STATS")
+            if _stats_field(stats, "Total") >= 7:
+                break
+            assert time.monotonic() < deadline, stats
+            time.sleep(0.05)
+        assert _stats_field(stats, "Total") == 7, stats
+        assert _stats_field(stats, "Collapsed") == 1500, stats
+        assert _stats_field(stats, "CollapsedRuns") == 3, stats
+
+        summaries = _query_command(cpp_query, "QUERY keyword=(repeated")
+        assert summaries.startswith("FOUND: 3\n"), summaries
+        assert "disk full on /dev/sda (repeated 999 times)" in summaries
+        assert "retry 499 failed after 2ms (repeated 499 times)" in summaries
+        assert "disk full on /dev/sda (repeated 2 times)" in summaries
+
+        stored = _query_command(cpp_query, "QUERY keyword=retry")
+        assert stored.startswith("FOUND: 2\n") and "retry 0 failed after 0ms\n" in stored, stored
+
+
+@contextlib.contextmanager
+def _draining(server: ServerProcess):
+    stop = threading.Event()
+    drainer = threading.Thread(target=_drain_stdout, args=(server, stop), daemon=True)
+    drainer.start()
+    try:
+        yield server
+    finally:
+        stop.set()
+        drainer.join(timeout=5.0)
+
+
+def _wait_for_stats(query_port: int, ready) -> str:
+    deadline = time.monotonic() + 15.0
+    while True:
+        stats = _query_command(query_port, "STATS")
+        if ready(stats):
+            return stats
+        assert time.monotonic() < deadline, stats
+        time.sleep(0.05)
+
+
+def spec_relay_forwarding() -> None:
+    """Sequence: SEQ0203. Verifies relay forwarding, spooling through an upstream outage, and catch-up from SEQ0196–SEQ0204."""
+
+    cpp_binary = binary_path("cpp")
+    upstream_log = 15210
+    upstream_query = 15211
+    edge_log = 15212
+    edge_query = 15213
+    tmp_root = Path(tempfile.mkdtemp(prefix="lc-spec-relay-", dir=str(build_dir())))
+    upstream_args = ("--log-port", str(upstream_log), "--query-port", str(upstream_query))
+    edge_args = (
+        "--log-port",
+        str(edge_log),
+        "--query-port",
+        str(edge_query),
+        "--relay-to",
+        f"127.0.0.1:{upstream_log}",
+        "--relay-spool",
+        str(tmp_root / "spool"),
+        "--relay-name",
+        "edge1",
+        "--relay-batch",
+        "128",
+        "--relay-compress",
+    )
+    try:
+        with ServerProcess(cpp_binary, *edge_args) as edge, _draining(edge):
+            edge.wait_ready([edge_log, edge_query])
+            with ServerProcess(cpp_binary, *upstream_args) as upstream, _draining(upstream):
+                upstream.wait_ready([upstream_log, upstream_query])
+                events = [f"app-event-{index:04d} status=ok latency=12ms" for index in range(300)]
+                _send_session(edge_log, ["STREAM app"] + events)
+
+                # Relayed entries are accounted to the relay's name (TopSources refreshes lazily).
+                stats = _wait_for_stats(
+                    upstream_query, lambda text: _stats_field(text, "Total") >= 300 and "TopSources=[edge1=" in text
+                )
+                assert _stats_field(stats, "RelayInbound") == 300, stats
+                assert _stream_entry(stats, "app")[1] == 300, stats
+
+                edge_stats = _wait_for_stats(edge_query, lambda text: _stats_field(text, "RelayAcked") >= 300)
+                assert "Relay=up" in edge_stats, edge_stats
+                assert _stats_field(edge_stats, "RelayBacklogBytes") == 0, edge_stats
+                # Compressed frames carry less than the raw messages alone.
+                assert _stats_field(edge_stats, "RelayWireBytes") < sum(len(event) for event in events), edge_stats
+
+            # Upstream down: entries pile up in the edge spool instead of being lost.
+            _send_session(edge_log, [f"outage-{index:05d}" for index in range(2000)])
+            edge_stats = _wait_for_stats(edge_query, lambda text: _stats_field(text, "RelaySpooled") >= 2300)
+            assert "Relay=down" in edge_stats, edge_stats
+            assert _stats_field(edge_stats, "RelayAcked") == 300, edge_stats
+            assert _stats_field(edge_stats, "RelayBacklogBytes") > 0, edge_stats
+
+            with ServerProcess(cpp_binary, *upstream_args) as upstream, _draining(upstream):
+                upstream.wait_ready([upstream_log, upstream_query])
+                stats = _wait_for_stats(upstream_query, lambda text: _stats_field(text, "Total") >= 2000)
+                edge_stats = _wait_for_stats(edge_query, lambda text: _stats_field(text, "RelayBacklogBytes") == 0)
+                assert _stats_field(edge_stats, "RelayAcked") == 2300, edge_stats
+                assert _stats_field(edge_stats, "RelayReconnects") >= 1, edge_stats
+
+                stats = _query_command(upstream_query, "STATS")
+                assert _stats_field(stats, "Total") == 2000, stats
+                assert _stats_field(stats, "RelayInbound") == 2000, stats
+                caught_up = _query_command(upstream_query, "QUERY keyword=outage-")
+                header, _, body = caught_up.partition("\n")
+                assert header == "FOUND: 2000", header
+                # Exactly once and in spool order.
+                for index, line in enumerate(body.splitlines()):
+                    assert line.endswith(f"outage-{index:05d}"), (index, line)
+    finally:
+        shutil.rmtree(tmp_root, ignore_errors=True)
+
+
+def spec_federated_query() -> None:
+    """Sequence: SEQ0215. Verifies scope=cluster fan-out, timestamp merging, limit pushdown, and partial answers from SEQ0205–SEQ0216."""
+
+    cpp_binary = binary_path("cpp")
+    ports = [(15220, 15221), (15222, 15223), (15224, 15225)]
+    hung_port = 15227
+    # Accepts into the backlog but never answers, so its exchange can only time out.
+    hung = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+    hung.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+    hung.bind(("127.0.0.1", hung_port))
+    hung.listen(8)
+    peer_args = (
+        "--peer",
+        f"127.0.0.1:{ports[1][1]}",
+        "--peer",
+        f"127.0.0.1:{ports[2][1]}",
+        "--peer",
+        f"127.0.0.1:{hung_port}",
+        "--peer-timeout",
+        "500",
+    )
+    labels = ["{local}", f"{{127.0.0.1:{ports[1][1]}}}", f"{{127.0.0.1:{ports[2][1]}}}"]
+    try:
+        with contextlib.ExitStack() as stack:
+            nodes = []
+            for index, (log_port, query_port) in enumerate(ports):
+                args = ["--log-port", str(log_port), "--query-port", str(query_port), "--client-timestamps"]
+                if index == 0:
+                    args.extend(peer_args)
+                node = stack.enter_context(ServerProcess(cpp_binary, *args))
+                stack.enter_context(_draining(node))
+                node.wait_ready([log_port, query_port])
+                nodes.append(node)
+
+            # Event times interleave across the nodes: entry i lives on node i % 3.
+            for index, (log_port, _) in enumerate(ports):
+                _send_session(log_port, [f"{1609459200 + i} fed-{i:02d}" for i in range(index, 12, 3)])
+            for _, query_port in ports:
+                _wait_for_count(query_port, 4)
+
+            merged = _query_command(ports[0][1], "QUERY keyword=fed- scope=cluster")
+            cluster, found, *lines = merged.splitlines()
+            assert cluster == f"CLUSTER: nodes=4 answered=3 partial=yes failed=127.0.0.1:{hung_port}(timeout)", merged
+            assert found == "FOUND: 12", merged
+            for i, line in enumerate(lines):
+                assert line.startswith(labels[i % 3] + " [") and line.endswith(f"fed-{i:02d}"), (i, merged)
+
+            # The limit reaches the peers and the merge keeps the newest entries overall.
+            newest = _query_command(ports[0][1], "QUERY keyword=fed- limit=4 scope=cluster").splitlines()
+            assert newest[1] == "FOUND: 4", newest
+            assert [line.rsplit(" ", 1)[1] for line in newest[2:]] == ["fed-08", "fed-09", "fed-10", "fed-11"], newest
+
+            stats = _query_command(ports[0][1], "STATS")
+            assert _stats_field(stats, "Peers") == 3, stats
+            assert _stats_field(stats, "PeerQueries") == 6, stats
+            assert _stats_field(stats, "PeerTimeouts") == 2, stats
+            # Both healthy peers answered the second query on their pooled connection.
+            assert _stats_field(stats, "PeerReused") == 2, stats
+
+            local = _query_command(ports[0][1], "QUERY keyword=fed- limit=2")
+            assert local.splitlines()[0] == "FOUND: 2" and local.rstrip().endswith("fed-09"), local
+            assert "fed-06" in local and "CLUSTER" not in local, local
+            invalid = _query_command(ports[0][1], "QUERY keyword=fed- scope=galaxy")
+            assert invalid.startswith("ERROR"), invalid
+    finally:
+        hung.close()
+
+
+def spec_replication() -> None:
+    """Sequence: SEQ0227. Verifies streaming replication, read-only replicas, and sequence-based catch-up from SEQ0217–SEQ0228."""
+
+    cpp_binary = binary_path("cpp")
+    primary_log = 15230
+    primary_query = 15231
+    replica_log = 15232
+    replica_query = 15233
+    tmp_root = Path(tempfile.mkdtemp(prefix="lc-spec-replication-", dir=str(build_dir())))
+    primary_args = (
+        "--log-port",
+        str(primary_log),
+        "--query-port",
+        str(primary_query),
+        "--replication-log",
+        str(tmp_root / "replication"),
+    )
+    replica_args = (
+        "--log-port",
+        str(replica_log),
+        "--query-port",
+        str(replica_query),
+        "--replica-of",
+        f"127.0.0.1:{primary_log}",
+        "--replica-name",
+        "r1",
+        "--enable-persistence",
+        "--persistence-dir",
+        str(tmp_root / "replica"),
+    )
+    try:
+        with ServerProcess(cpp_binary, *primary_args) as primary, _draining(primary):
+            primary.wait_ready([primary_log, primary_query])
+            with ServerProcess(cpp_binary, *replica_args) as replica, _draining(replica):
+                replica.wait_ready([replica_log, replica_query])
+                _send_session(primary_log, ["STREAM app"] + [f"rep-{index:04d}" for index in range(200)])
+                stats = _wait_for_stats(replica_query, lambda text: _stats_field(text, "ReplicaSeq") == 200)
+                assert "Replica=up" in stats and _stats_field(stats, "ReplicaLag") == 0, stats
+                assert _stream_entry(stats, "app")[1] == 200, stats
+                primary_stats = _wait_for_stats(primary_query, lambda text: "Replicas=1 [r1=200/0]" in text)
+                assert _stats_field(primary_stats, "ReplicationHead") == 200, primary_stats
+
+                # Replicas serve queries but refuse writes.
+                with socket.create_connection(("127.0.0.1", replica_log), timeout=5.0) as sock:
+                    _read_until(sock, ("LogCrafter",))
+                    sock.sendall(b"rep-rogue\n")
+                    assert "read-only replica" in _read_all(sock), "replica accepted a log line"
+                assert _query_command(replica_query, "COUNT") == "COUNT: 200\n"
+
+            # The primary keeps logging while the replica is away.
+            _send_session(primary_log, [f"rep-{index:04d}" for index in range(200, 500)])
+            _wait_for_stats(primary_query, lambda text: _stats_field(text, "ReplicationHead") == 500)
+
+            with ServerProcess(cpp_binary, *replica_args) as replica, _draining(replica):
+                replica.wait_ready([replica_log, replica_query])
+                # 200 entries come back from the replica's own persistence, the rest from the
+                # primary's log starting at the saved sequence.
+                stats = _wait_for_stats(replica_query, lambda text: _stats_field(text, "ReplicaSeq") == 500)
+                assert _stats_field(stats, "ReplicaApplied") == 300, stats
+                assert _stats_field(stats, "ReplicaGaps") == 0, stats
+
+        # A restarted primary continues the sequence from its segments.
+        with ServerProcess(cpp_binary, *primary_args) as primary, _draining(primary):
+            primary.wait_ready([primary_log, primary_query])
+            with ServerProcess(cpp_binary, *replica_args) as replica, _draining(replica):
+                replica.wait_ready([replica_log, replica_query])
+                _send_session(primary_log, [f"rep-{index:04d}" for index in range(500, 510)])
+                stats = _wait_for_stats(replica_query, lambda text: _stats_field(text, "ReplicaSeq") == 510)
+                assert _stats_field(stats, "ReplicaApplied") == 10, stats
+                response = _query_command(replica_query, "QUERY keyword=rep- limit=1000")
+                header, _, body = response.partition("\n")
+                assert header == "FOUND: 510", header
+                seen = sorted(line.rsplit(" ", 1)[1] for line in body.splitlines())
+                assert seen == [f"rep-{index:04d}" for index in range(510)], response[:200]
+    finally:
+        shutil.rmtree(tmp_root, ignore_errors=True)
+
+
+def _query_raw(port: int, lines: list[str]) -> bytes:
+    with socket.create_connection(("127.0.0.1", port), timeout=5.0) as sock:
+        banner = b""
+        while banner.count(b"\n") < 2:
+            chunk = sock.recv(1)
+            assert chunk, banner
+            banner += chunk
+        sock.sendall("".join(f"{line}\n" for line in lines).encode())
+        sock.shutdown(socket.SHUT_WR)
+        chunks: list[bytes] = []
+        while True:
+            chunk = sock.recv(65536)
+            if not chunk:
+                return b"".join(chunks)
+            chunks.append(chunk)
+
+
+def spec_compressed_query() -> None:
+    """Sequence: SEQ0235. Verifies deflate-compressed query responses per request and per session from SEQ0229–SEQ0236."""
+
+    cpp_binary = binary_path("cpp")
+    log_port = 15240
+    query_port = 15241
+    with ServerProcess(cpp_binary, "--log-port", str(log_port), "--query-port", str(query_port)) as server, _draining(
+        server
+    ):
+        server.wait_ready([log_port, query_port])
+        # Repetitive lines, several compression chunks' worth.
+        padding = "payload " * 12
+        _send_session(log_port, [f"zip-{index:05d} {padding}" for index in range(3000)])
+        _wait_for_count(query_port, 3000)
+
+        plain = _query_raw(query_port, ["QUERY keyword=zip-"])
+        assert plain.startswith(b"FOUND: 3000\n"), plain[:80]
+
+        compressed = _query_raw(query_port, ["QUERY keyword=zip- compress=deflate"])
+        marker, _, stream = compressed.partition(b"\n")
+        assert marker == b"COMPRESSED: deflate", compressed[:80]
+        assert zlib.decompress(stream) == plain
+        assert len(stream) * 4 < len(plain), (len(stream), len(plain))
+
+        # A leading COMPRESS line sets the session default; compress= still overrides it.
+        session = _query_raw(query_port, ["COMPRESS deflate", "QUERY keyword=zip-00001 limit=1"])
+        ack, _, rest = session.partition(b"\n")
+        assert ack == b"COMPRESS: deflate", session[:80]
+        marker, _, stream = rest.partition(b"\n")
+        assert marker == b"COMPRESSED: deflate", rest[:80]
+        session_body = zlib.decompress(stream)
+        assert session_body.startswith(b"FOUND: 1\n"), session_body
+        overridden = _query_raw(query_port, ["COMPRESS deflate", "QUERY keyword=zip-00001 compress=none"])
+        assert overridden.split(b"\n")[1] == b"FOUND: 1", overridden[:80]
+
+        # Errors stay plain text, and unknown codecs are rejected.
+        assert _query_command(query_port, "QUERY keyword=zip- compress=lz4").startswith("ERROR:")
+        assert _query_raw(query_port, ["COMPRESS lz4"]).startswith(b"ERROR:")
+        error = _query_raw(query_port, ["QUERY stream=missing compress=deflate"])
+        assert error.startswith(b"ERROR: Unknown stream"), error
+
+        stats = _query_command(query_port, "STATS")
+        assert _stats_field(stats, "CompressedQueries") == 2, stats
+        assert _stats_field(stats, "CompressRawBytes") == len(plain) + len(session_body), stats
+        ratio = float(stats.split("CompressRatio=", 1)[1].split(",", 1)[0])
+        assert ratio > 4.0, stats
+
+
+def spec_binary_query() -> None:
+    """Sequence: SEQ0247. Verifies format=binary and format=ndjson query responses and both decoders from SEQ0237–SEQ0248."""
+
+    cpp_binary = binary_path("cpp")
+    decoder = cpp_binary.parent / "logcrafter_cpp_decode"
+    log_port = 15242
+    query_port = 15243
+    started = int(time.time())
+    with ServerProcess(cpp_binary, "--log-port", str(log_port), "--query-port", str(query_port)) as server, _draining(
+        server
+    ):
+        server.wait_ready([log_port, query_port])
+        _send_session(log_port, ["bin-0 plain start", "bin-1 ERROR disk full", 'bin-2 warning "quoted" \\ path'])
+        _send_session(log_port, ["STREAM app", "bin-3 info from app", "bin-4 DEBUG from app"])
+        _wait_for_count(query_port, 5)
+
+        text = _query_command(query_port, "QUERY keyword=bin-")
+        header, _, body = text.partition("\n")
+        assert header == "FOUND: 5", text
+        text_messages = [line.split("] ", 1)[1] for line in body.splitlines()]
+
+        binary = _query_raw(query_port, ["QUERY keyword=bin- format=binary"])
+        ndjson = _query_raw(query_port, ["QUERY keyword=bin- format=ndjson"])
+        records = result_decoder.decode_binary(binary)
+        assert records == result_decoder.decode_ndjson(ndjson), (binary[:200], ndjson[:400])
+        assert [record["message"] for record in records] == text_messages, records
+        assert [record["stream"] for record in records] == ["default"] * 3 + ["app"] * 2, records
+        assert [record["seq"] for record in records] == [1, 2, 3, 1, 2], records
+        assert [record["level"] for record in records] == ["unknown", "error", "warning", "info", "debug"], records
+        for record in records:
+            assert record["ts_ns"] % 1_000_000_000 == 0, record
+            assert started - 1 <= record["ts_ns"] // 1_000_000_000 <= time.time() + 1, record
+
+        # The C++ decoder turns the binary response into the NDJSON one byte for byte, also
+        # when the binary response was compressed.
+        decoded = subprocess.run([str(decoder)], input=binary, capture_output=True, check=True).stdout
+        assert decoded == ndjson, (decoded, ndjson)
+        compressed = _query_raw(query_port, ["QUERY keyword=bin- format=binary compress=deflate"])
+        assert compressed.startswith(b"COMPRESSED: deflate\n"), compressed[:40]
+        decoded = subprocess.run([str(decoder)], input=compressed, capture_output=True, check=True).stdout
+        assert decoded == ndjson, decoded
+
+        # limit= keeps the newest matches across streams, oldest first.
+        limited = result_decoder.decode_binary(_query_raw(query_port, ["QUERY keyword=bin- limit=2 format=binary"]))
+        assert [record["message"] for record in limited] == text_messages[-2:], limited
+        empty = _query_raw(query_port, ["QUERY keyword=absent format=binary"])
+        assert empty == b"BINARY: 0\n", empty
+
+        assert _query_command(query_port, "QUERY keyword=bin- format=xml").startswith("ERROR:")
+        assert _query_command(query_port, "QUERY keyword=bin- format=ndjson scope=cluster").startswith("ERROR:")
+
+
+def spec_export() -> None:
+    """Sequence: SEQ0257. Verifies EXPORT of persisted segments by time range from SEQ0249–SEQ0258."""
+
+    cpp_binary = binary_path("cpp")
+    log_port = 15244
+    query_port = 15245
+    base = 1700000000
+    total = 12000
+    padding = "x" * 160
+    tmp_root = Path(tempfile.mkdtemp(prefix="lc-spec-export-", dir=str(build_dir())))
+    try:
+        with ServerProcess(
+            cpp_binary,
+            "--log-port",
+            str(log_port),
+            "--query-port",
+            str(query_port),
+            "--client-timestamps",
+            "--persistence-dir",
+            str(tmp_root),
+            "--persistence-max-size",
+            "1",
+        ) as server, _draining(server):
+            server.wait_ready([log_port, query_port])
+            _send_session(log_port, [f"{base + index} export-{index:05d} {padding}" for index in range(total)])
+            _wait_for_stats(query_port, lambda text: _stats_field(text, "Persisted") == total)
+            assert len(list(tmp_root.glob("*.log"))) >= 3, sorted(path.name for path in tmp_root.iterdir())
+
+            # The range spans rotated files and is cut inside the first and last of them.
+            response = _query_raw(query_port, [f"EXPORT from={base + 3000} to={base + 9000}"])
+            header, _, body = response.partition(b"\n")
+            assert header == f"EXPORT: {len(body)}".encode(), header
+            indices = [int(line.split(b"export-", 1)[1][:5]) for line in body.splitlines()]
+            assert indices == list(range(3000, 9001)), (indices[:3], indices[-3:], len(indices))
+            assert body.startswith(b"[") and body.endswith(padding.encode() + b"\n"), body[:80]
+
+            everything = _query_raw(query_port, [f"EXPORT from=0 to={base + total}"])
+            assert everything.count(b"\n") == total + 1, everything[:80]
+            assert _query_raw(query_port, [f"EXPORT from={base + total} to={base + total + 10}"]) == b"EXPORT: 0\n"
+
+            assert _query_command(query_port, "EXPORT from=5").startswith("ERROR:")
+            assert _query_command(query_port, "EXPORT from=9 to=5").startswith("ERROR:")
+            assert _query_command(query_port, "EXPORT from=1 to=5 stream=missing").startswith("ERROR: Unknown stream")
+            stats = _query_command(query_port, "STATS")
+            assert _stats_field(stats, "Exports") == 3, stats
+            assert _stats_field(stats, "ExportBytes") == len(body) + len(everything.partition(b"\n")[2]), stats
+
+        with ServerProcess(cpp_binary, "--log-port", str(log_port), "--query-port", str(query_port)) as server:
+            server.wait_ready([log_port, query_port])
+            assert "--enable-persistence" in _query_command(query_port, "EXPORT from=0 to=1")
+    finally:
+        shutil.rmtree(tmp_root, ignore_errors=True)
+
+
+def spec_rollup() -> None:
+    """Sequence: SEQ0268. Verifies ROLLUP counts by level and source across eviction and restarts from SEQ0259–SEQ0269."""
+
+    cpp_binary = binary_path("cpp")
+    log_port = 15246
+    query_port = 15247
+    base = 1700000040
+    tmp_root = Path(tempfile.mkdtemp(prefix="lc-spec-rollup-", dir=str(build_dir())))
+    args = (
+        "--log-port",
+        str(log_port),
+        "--query-port",
+        str(query_port),
+        "--client-timestamps",
+        "--capacity",
+        "5",
+        "--persistence-dir",
+        str(tmp_root),
+    )
+    try:
+        with ServerProcess(cpp_binary, *args) as server, _draining(server):
+            server.wait_ready([log_port, query_port])
+            api = [f"{base + index} request ok INFO {index}" for index in range(10)]
+            api += [f"{base + 30} ERROR upstream timeout", f"{base + 31} error upstream reset"]
+            api += [f"{base + 60 + index} warning slow response" for index in range(5)]
+            api += [f"{base + 125} debug cache miss", f"{base - 3 * 86400} info from long ago"]
+            _send_session(log_port, ["SOURCE api"] + api)
+            _send_session(log_port, ["SOURCE web"] + [f"{base + 61} plain line {index}" for index in range(4)])
+            _wait_for_stats(query_port, lambda text: _stats_field(text, "Total") == len(api) + 4)
+            assert _query_command(query_port, "COUNT") == "COUNT: 5\n"
+
+            minutes = _query_command(query_port, f"ROLLUP resolution=minute from={base} to={base + 179}")
+            assert minutes.splitlines() == [
+                f"ROLLUP: resolution=minute from={base} to={base + 120} buckets=3 by=level",
+                f"{base} total=12 unknown=0 debug=0 info=10 warning=0 error=2",
+                f"{base + 60} total=9 unknown=4 debug=0 info=0 warning=5 error=0",
+                f"{base + 120} total=1 unknown=0 debug=1 info=0 warning=0 error=0",
+            ], minutes
+            by_source = _query_command(query_port, f"ROLLUP from={base} to={base + 60} by=source")
+            assert by_source.splitlines()[1:] == [f"{base} total=12 api=12", f"{base + 60} total=9 api=5 web=4"]
+            errors = _query_command(
+                query_port, f"ROLLUP resolution=second from={base + 30} to={base + 32} source=api level=error"
+            )
+            assert errors.splitlines()[1:] == [
+                f"{base + 30} total=1 unknown=0 debug=0 info=0 warning=0 error=1",
+                f"{base + 31} total=1 unknown=0 debug=0 info=0 warning=0 error=1",
+                f"{base + 32} total=0 unknown=0 debug=0 info=0 warning=0 error=0",
+            ], errors
+            # Without bounds: the newest 60 buckets, ending at the newest entry.
+            latest = _query_command(query_port, "ROLLUP resolution=second").splitlines()
+            assert latest[0] == f"ROLLUP: resolution=second from={base + 66} to={base + 125} buckets=60 by=level"
+            assert latest[-1].startswith(f"{base + 125} total=1 "), latest[-1]
+
+            assert _query_command(query_port, "ROLLUP resolution=hour").startswith("ERROR:")
+            assert _query_command(query_port, "ROLLUP from=9 to=5").startswith("ERROR:")
+            assert _query_command(query_port, "ROLLUP source=missing").startswith("ERROR: No rollups")
+            stats = _query_command(query_port, "STATS")
+            assert _stats_field(stats, "RollupSources") == 2, stats
+            assert _stats_field(stats, "RollupLate") == 1, stats
+            assert _stats_field(stats, "RollupQueries") == 4, stats
+        assert (tmp_root / "rollup.state").exists(), sorted(path.name for path in tmp_root.iterdir())
+
+        with ServerProcess(cpp_binary, *args) as server, _draining(server):
+            server.wait_ready([log_port, query_port])
+            assert _query_command(query_port, f"ROLLUP resolution=minute from={base} to={base + 179}") == minutes
+            _send_session(log_port, ["SOURCE api", f"{base + 130} error after restart"])
+            _wait_for_stats(query_port, lambda text: _stats_field(text, "Persisted") == 1)
+            restarted = _query_command(query_port, f"ROLLUP from={base + 120} to={base + 120} by=source")
+            assert restarted.splitlines()[1:] == [f"{base + 120} total=2 api=2"], restarted
+    finally:
+        shutil.rmtree(tmp_root, ignore_errors=True)
+
+
+def spec_alert_rules() -> None:
+    """Sequence: SEQ0277. Verifies ingest-time alert rules, their IRC and log actions, and ALERTS from SEQ0270–SEQ0278."""
+
+    cpp_binary = binary_path("cpp")
+    log_port = 15248
+    query_port = 15249
+    irc_port = 15250
+    tmp_root = Path(tempfile.mkdtemp(prefix="lc-spec-alerts-", dir=str(build_dir())))
+    alert_log = tmp_root / "alerts.log"
+    rules = tmp_root / "rules.conf"
+    rules.write_text(
+        "# name  window  threshold  action  filters\n"
+        f"errors window=60 count=5 notify=#ops log={alert_log} keyword=ERROR\n"
+        "\n"
+        f"payments window=10 rate=0.3 log={alert_log} stream=payments keywords=declined,refused operator=OR\n"
+    )
+    try:
+        with ServerProcess(
+            cpp_binary,
+            "--log-port",
+            str(log_port),
+            "--query-port",
+            str(query_port),
+            "--enable-irc",
+            "--irc-port",
+            str(irc_port),
+            "--irc-auto-join",
+            "#ops",
+            "--alert-rules",
+            str(rules),
+        ) as server, _draining(server):
+            server.wait_ready([log_port, query_port, irc_port])
+            with socket.create_connection(("127.0.0.1", irc_port), timeout=5.0) as irc:
+                irc.sendall(b"NICK watcher\r\nUSER watcher 0 * :Watcher\r\n")
+                _read_until(irc, ("Try !help",))
+
+                _send_session(log_port, [f"ERROR disk {index} failed" for index in range(4)] + ["all good"])
+                _wait_for_stats(query_port, lambda text: _stats_field(text, "Total") == 5)
+                assert "errors count=4 threshold=5 window=60s fired=0 state=ok" in _query_command(query_port, "ALERTS")
+
+                # The fifth match fires once; later matches in the same window do not fire again.
+                _send_session(log_port, ["ERROR disk 4 failed", "ERROR disk 5 failed"])
+                notice = _read_until(irc, ("disk 4 failed",))
+                assert "NOTICE #ops :ALERT errors: 5 matching lines in 60s (threshold 5), latest: ERROR disk 4" in notice
+
+                _send_session(log_port, ["STREAM payments", "card declined", "card refused", "card declined"])
+                _send_session(log_port, ["card declined in the default stream"] * 3)
+                _wait_for_stats(query_port, lambda text: _stats_field(text, "Total") == 13)
+                alerts = _query_command(query_port, "ALERTS")
+                assert alerts.splitlines() == [
+                    "ALERTS: 2",
+                    "errors count=6 threshold=5 window=60s fired=1 state=firing",
+                    "payments count=3 threshold=3 window=10s fired=1 state=firing",
+                ], alerts
+                stats = _query_command(query_port, "STATS")
+                assert _stats_field(stats, "AlertRules") == 2, stats
+                assert _stats_field(stats, "AlertMatches") == 9, stats
+                assert _stats_field(stats, "AlertsFired") == 2, stats
+                irc.settimeout(0.5)
+                with contextlib.suppress(socket.timeout):
+                    assert "NOTICE" not in irc.recv(4096).decode(errors="replace")
+
+        entries = alert_log.read_text().splitlines()
+        assert len(entries) == 2, entries
+        assert "] ALERT errors: 5 matching lines in 60s" in entries[0], entries
+        assert "] ALERT payments: 3 matching lines in 10s (threshold 3), latest: card declined" in entries[1], entries
+
+        # Bad rule files and IRC rules without IRC stop the server at startup.
+        for text, expected in (
+            ("# window out of range\nbroken window=0 count=1 log=x.log\n", "rules.conf:2: window must be"),
+            ("spikes window=5 count=2 notify=#ops keyword=x\n", "--enable-irc"),
+            ("noaction window=5 count=2 keyword=x\n", "needs notify=<#channel> or log=<path>"),
+        ):
+            rules.write_text(text)
+            with ServerProcess(
+                cpp_binary, "--log-port", str(log_port), "--query-port", str(query_port), "--alert-rules", str(rules)
+            ) as server:
+                assert server.process.wait(timeout=5.0) != 0
+                assert expected in server.process.stderr.read()
+    finally:
+        shutil.rmtree(tmp_root, ignore_errors=True)
+
+
+def spec_load_shedding() -> None:
+    """Sequence: SEQ0285. Verifies severity-aware load shedding under an ingest backlog from SEQ0279–SEQ0286."""
+
+    cpp_binary = binary_path("cpp")
+    log_port = 15251
+    query_port = 15252
+    sessions = 8
+    rounds = 400
+
+    def produce(index: int) -> None:
+        lines = ["SOURCE producer-" + str(index)]
+        for round_index in range(rounds):
+            lines += [
+                f"debug cache probe {index}-{round_index}",
+                f"info request served {index}-{round_index}",
+                f"debug cache probe again {index}-{round_index}",
+                f"warning slow disk {index}-{round_index}",
+                f"ERROR request failed {index}-{round_index}",
+            ]
+        _send_session(log_port, lines)
+
+    with ServerProcess(
+        cpp_binary,
+        "--log-port",
+        str(log_port),
+        "--query-port",
+        str(query_port),
+        "--capacity",
+        "100000",
+        "--shed-ladder",
+        "debug:10,info:2",
+        "--shed-high-water",
+        "2",
+    ) as server, _draining(server):
+        server.wait_ready([log_port, query_port])
+        stats = _query_command(query_port, "STATS")
+        assert "ShedStage=0/2, ShedUnknown=0, ShedDebug=0, ShedInfo=0, ShedWarning=0" in stats, stats
+
+        producers = [threading.Thread(target=produce, args=(index,)) for index in range(sessions)]
+        for producer in producers:
+            producer.start()
+        for producer in producers:
+            producer.join()
+
+        sent = sessions * rounds * 5
+        shed_fields = ("ShedUnknown", "ShedDebug", "ShedInfo", "ShedWarning")
+        stats = _wait_for_stats(
+            query_port,
+            lambda text: _stats_field(text, "Total") + sum(_stats_field(text, field) for field in shed_fields) == sent,
+        )
+        # Debug is the first rung, so any backlog thins it; warnings and errors are never in the ladder.
+        assert _stats_field(stats, "ShedDebug") > 0, stats
+        assert _stats_field(stats, "ShedUnknown") == 0, stats
+        assert _stats_field(stats, "ShedWarning") == 0, stats
+        assert _stats_field(stats, "ShedInfo") <= sessions * rounds // 2 + 1, stats
+        assert f"FOUND: {sessions * rounds}\n" in _query_command(query_port, "QUERY keyword=ERROR"), stats
+        assert f"FOUND: {sessions * rounds}\n" in _query_command(query_port, "QUERY keyword=warning"), stats
+
+    # Without a ladder nothing is shed and no Shed* fields are reported; error lines cannot be shed.
+    with ServerProcess(cpp_binary, "--log-port", str(log_port), "--query-port", str(query_port)) as server:
+        server.wait_ready([log_port, query_port])
+        assert "ShedStage" not in _query_command(query_port, "STATS")
+    with ServerProcess(
+        cpp_binary, "--log-port", str(log_port), "--query-port", str(query_port), "--shed-ladder", "debug:10,error:2"
+    ) as server:
+        assert server.process.wait(timeout=5.0) != 0
+        assert "error lines are never shed" in server.process.stderr.read()
+
+
+def spec_severity_rings() -> None:
+    """Sequence: SEQ0298. Verifies severity-partitioned buffer rings, borrowing, merged scans, and level= from SEQ0287–SEQ0299."""
+
+    cpp_binary = binary_path("cpp")
+    log_port = 15253
+    query_port = 15254
+    base = 1609459200
+    with ServerProcess(
+        cpp_binary,
+        "--log-port",
+        str(log_port),
+        "--query-port",
+        str(query_port),
+        "--capacity",
+        "100",
+        "--level-shares",
+        "50,30,20",
+        "--client-timestamps",
+    ) as server, _draining(server):
+        server.wait_ready([log_port, query_port])
+        # Errors and info alternate in event time but land in different rings.
+        lines = []
+        for i in range(10):
+            lines += [f"{base + 2 * i} ERROR svr-e{i}", f"{base + 2 * i + 1} info svr-i{i}"]
+        _send_session(log_port, lines)
+        _wait_for_stats(query_port, lambda text: _stats_field(text, "Total") == 20)
+        merged = _query_command(query_port, "QUERY keyword=svr-").splitlines()
+        assert merged[0] == "FOUND: 20", merged
+        assert [line.rsplit(" ", 1)[1] for line in merged[1:]] == [
+            f"svr-{kind}{i}" for i in range(10) for kind in ("e", "i")
+        ], merged
+
+        # A debug storm borrows the free space, then only ever overwrites debug lines.
+        _send_session(log_port, [f"{base + 100 + i} debug storm-{i}" for i in range(500)])
+        stats = _wait_for_stats(query_port, lambda text: _stats_field(text, "Total") == 520)
+        assert "RingSevere=10, RingInfo=10, RingDebug=80" in stats, stats
+        assert _stats_field(stats, "Dropped") == 420, stats
+        assert _query_command(query_port, "QUERY keyword=svr-").startswith("FOUND: 20\n")
+        assert _query_command(query_port, "QUERY level=error").startswith("FOUND: 10\n")
+        assert _query_command(query_port, "QUERY level=debug keyword=storm-").startswith("FOUND: 80\n")
+        newest_debug = _query_command(query_port, "QUERY level=debug limit=1").splitlines()
+        assert newest_debug[1].endswith("debug storm-499"), newest_debug
+
+        # Errors take back their reserve from the borrower, then wrap within it.
+        _send_session(log_port, [f"{base + 1000 + i} ERROR late-{i}" for i in range(60)])
+        stats = _wait_for_stats(query_port, lambda text: _stats_field(text, "Total") == 580)
+        assert "RingSevere=50, RingInfo=10, RingDebug=40" in stats, stats
+        errors = _query_command(query_port, "QUERY level=error").splitlines()
+        assert errors[0] == "FOUND: 50", errors
+        assert errors[1].endswith("ERROR late-10") and errors[-1].endswith("ERROR late-59"), errors
+        assert _query_command(query_port, "QUERY level=info").startswith("FOUND: 10\n")
+        assert _query_command(query_port, "QUERY level=fatal").startswith("ERROR:")
+
+    # Without shares there is one ring and no Ring* fields, and level= still filters.
+    with ServerProcess(cpp_binary, "--log-port", str(log_port), "--query-port", str(query_port)) as server, _draining(
+        server
+    ):
+        server.wait_ready([log_port, query_port])
+        _send_session(log_port, ["warning disk 91% full", "info all good", "WARN fan speed"])
+        stats = _wait_for_stats(query_port, lambda text: _stats_field(text, "Total") == 3)
+        assert "RingSevere" not in stats, stats
+        assert _query_command(query_port, "QUERY level=warning").startswith("FOUND: 2\n")
+    for shares in ("50,30", "50,30,30", "a,b,c"):
+        with ServerProcess(
+            cpp_binary, "--log-port", str(log_port), "--query-port", str(query_port), "--level-shares", shares
+        ) as server:
+            assert server.process.wait(timeout=5.0) != 0
+
+
+def spec_query_context() -> None:
+    """Sequence: SEQ0309. Verifies before=/after= context lines around QUERY matches from SEQ0300–SEQ0310."""
+
+    cpp_binary = binary_path("cpp")
+    log_port = 15255
+    query_port = 15256
+    errors = {5, 7, 15}
+    lines = [f"ERROR ctx-{i}" if i in errors else f"info ctx-{i}" for i in range(20)]
+
+    for shares in ((), ("--level-shares", "50,30,20")):
+        with ServerProcess(
+            cpp_binary, "--log-port", str(log_port), "--query-port", str(query_port), *shares
+        ) as server, _draining(server):
+            server.wait_ready([log_port, query_port])
+            _send_session(log_port, lines)
+            _wait_for_stats(query_port, lambda text: _stats_field(text, "Total") == 20)
+
+            # Windows around ctx-5 and ctx-7 overlap and are merged; ctx-6 is sent once.
+            response = _query_command(query_port, "QUERY keyword=ERROR before=2 after=1")
+            assert response.splitlines()[0] == "FOUND: 10", response
+            marked = [line.split("]", 1)[1] for line in response.splitlines()[1:]]
+            assert marked == [
+                "- info ctx-3",
+                "- info ctx-4",
+                " ERROR ctx-5",
+                "- info ctx-6",
+                " ERROR ctx-7",
+                "- info ctx-8",
+                "- info ctx-13",
+                "- info ctx-14",
+                " ERROR ctx-15",
+                "- info ctx-16",
+            ], response
+
+            # level= in a split buffer still draws context from the other rings.
+            around = _query_command(query_port, "QUERY level=error keyword=ctx-1 after=2").splitlines()
+            assert [line.split("]", 1)[1] for line in around[1:]] == [
+                " ERROR ctx-15",
+                "- info ctx-16",
+                "- info ctx-17",
+            ], around
+
+            records = result_decoder.decode_ndjson(
+                _query_raw(query_port, ["QUERY keyword=ctx-19 before=1 format=ndjson"])
+            )
+            assert [(record["message"], record.get("context", False)) for record in records] == [
+                ("info ctx-18", True),
+                ("info ctx-19", False),
+            ], records
+
+    with ServerProcess(cpp_binary, "--log-port", str(log_port), "--query-port", str(query_port)) as server:
+        server.wait_ready([log_port, query_port])
+        for arguments in (
+            "keyword=x before=0",
+            "keyword=x after=101",
+            "keyword=x before=1 before=2",
+            "keyword=x after=1 limit=5",
+            "keyword=x before=1 format=binary",
+            "keyword=x before=1 scope=cluster",
+        ):
+            assert _query_command(query_port, "QUERY " + arguments).startswith("ERROR:"), arguments
+        assert _query_command(query_port, "QUERY before=3").startswith("ERROR: Provide at least one filter")
+
+
+def _fetch_session(port: int, lines: list[str]) -> list[dict]:
+    return result_decoder.decode_fetch(_query_raw(port, lines))
+
+
+def spec_fetch() -> None:
+    """Sequence: SEQ0319. Verifies offset-based FETCH with long-polling over the replication log from SEQ0311–SEQ0320."""
+
+    cpp_binary = binary_path("cpp")
+    log_port = 15257
+    query_port = 15258
+    tmp_root = Path(tempfile.mkdtemp(prefix="lc-spec-fetch-", dir=str(build_dir())))
+    args = (
+        "--log-port",
+        str(log_port),
+        "--query-port",
+        str(query_port),
+        "--replication-log",
+        str(tmp_root / "replication"),
+        "--replication-tail",
+        "100",
+    )
+    expected = [f"fetch-{i:03d}" for i in range(150)] + [f"ERROR fetch-{i:03d}" for i in range(150, 300)]
+    try:
+        with ServerProcess(cpp_binary, *args) as server, _draining(server):
+            server.wait_ready([log_port, query_port])
+            _send_session(log_port, expected[:150])
+            _send_session(log_port, ["STREAM app"] + expected[150:])
+            _wait_for_stats(query_port, lambda text: _stats_field(text, "ReplicationHead") == 300)
+
+            # One consumer connection: 1-240 are behind the 100-entry tail and come from the
+            # segments, the rest from memory.
+            batches = _fetch_session(
+                query_port,
+                [
+                    "FETCH from_seq=0 max=120",
+                    "FETCH from_seq=121 max=120",
+                    "FETCH from_seq=241 max=120",
+                    "FETCH from_seq=301",
+                ],
+            )
+            assert [(batch["next"], batch["head"], len(batch["records"])) for batch in batches] == [
+                (121, 300, 120),
+                (241, 300, 120),
+                (301, 300, 60),
+                (301, 300, 0),
+            ], batches
+            records = [record for batch in batches for record in batch["records"]]
+            assert [record["seq"] for record in records] == list(range(1, 301))
+            assert [record["message"] for record in records] == expected
+            assert (records[0]["stream"], records[-1]["stream"], records[-1]["level"]) == ("default", "app", "error")
+            stats = _query_command(query_port, "STATS")
+            assert _stats_field(stats, "Fetches") == 4, stats
+            assert (_stats_field(stats, "FetchedDisk"), _stats_field(stats, "FetchedMemory")) == (240, 60), stats
+
+            # A long poll is answered as soon as the entry arrives, without holding a worker.
+            answers: list[list[dict]] = []
+            consumer = threading.Thread(
+                target=lambda: answers.append(_fetch_session(query_port, ["FETCH from_seq=301 wait_ms=5000"]))
+            )
+            started = time.monotonic()
+            consumer.start()
+            _wait_for_stats(query_port, lambda text: _stats_field(text, "FetchWaiting") == 1)
+            _send_log_line(log_port, "fetch-late")
+            consumer.join(timeout=10.0)
+            assert time.monotonic() - started < 4.0
+            assert [(record["seq"], record["message"]) for record in answers[0][0]["records"]] == [(301, "fetch-late")]
+
+            # With nothing new the wait runs out and an empty batch comes back.
+            started = time.monotonic()
+            timed_out = _fetch_session(query_port, ["FETCH from_seq=302 wait_ms=300"])
+            assert time.monotonic() - started >= 0.25
+            assert timed_out == [{"next": 302, "head": 301, "records": []}], timed_out
+
+            for arguments in (
+                "",
+                "from_seq=-1",
+                "from_seq=1 max=0",
+                "from_seq=1 max=10001",
+                "from_seq=1 wait_ms=60001",
+                "from_seq=1 from_seq=2",
+                "from_seq=1 bogus=1",
+            ):
+                assert _query_raw(query_port, ["FETCH " + arguments]).startswith(b"ERROR:"), arguments
+
+        # After a restart the tail is empty and every offset is read back from the segments.
+        with ServerProcess(cpp_binary, *args) as server, _draining(server):
+            server.wait_ready([log_port, query_port])
+            batches = _fetch_session(query_port, ["FETCH from_seq=299 max=5"])
+            assert [record["message"] for record in batches[0]["records"]] == expected[-2:] + ["fetch-late"]
+            assert _stats_field(_query_command(query_port, "STATS"), "FetchedDisk") == 3
+
+        with ServerProcess(cpp_binary, "--log-port", str(log_port), "--query-port", str(query_port)) as server:
+            server.wait_ready([log_port, query_port])
+            assert _query_raw(query_port, ["FETCH from_seq=1"]).startswith(b"ERROR: FETCH reads the replication log")
+    finally:
+        shutil.rmtree(tmp_root, ignore_errors=True)
+
+
+def spec_prepared_query() -> None:
+    """Sequence: SEQ0330. Verifies PREPARE/EXECUTE plans and the shared regex cache from SEQ0321–SEQ0331."""
+
+    cpp_binary = binary_path("cpp")
+    log_port = 15259
+    query_port = 15260
+    lines = ["prep-alpha one", "ERROR prep-alpha two", "prep-beta three", "ERROR prep-alllpha four"]
+    with ServerProcess(cpp_binary, "--log-port", str(log_port), "--query-port", str(query_port)) as server:
+        server.wait_ready([log_port, query_port])
+        _send_session(log_port, lines)
+        _wait_for_stats(query_port, lambda text: _stats_field(text, "Total") == len(lines))
+
+        assert _query_command(query_port, "PREPARE errs regex=prep-al+pha level=error") == "PREPARED: errs\n"
+        direct = _query_command(query_port, "QUERY regex=prep-al+pha level=error")
+        assert direct.startswith("FOUND: 2\n"), direct
+        assert _query_command(query_port, "EXECUTE errs") == direct
+        assert _query_command(query_port, "EXECUTE errs limit=1").endswith("] ERROR prep-alllpha four\n")
+        assert _query_command(query_port, "EXECUTE errs time_to=1") == "FOUND: 0\n"
+
+        # The plan compiled the pattern once; the direct QUERY found it in the cache.
+        stats = _query_command(query_port, "STATS")
+        assert (_stats_field(stats, "Prepared"), _stats_field(stats, "PreparedExecutes")) == (1, 3), stats
+        assert (_stats_field(stats, "RegexCacheMisses"), _stats_field(stats, "RegexCacheHits")) == (1, 1), stats
+        assert _stats_field(stats, "RegexCacheEntries") == 1, stats
+        _stats_field(stats, "ParseUsSaved")
+        _stats_field(stats, "RegexCompileUsSaved")
+
+        # Preparing a name again replaces its plan.
+        assert _query_command(query_port, "PREPARE errs keyword=prep-beta") == "PREPARED: errs\n"
+        replaced = _query_command(query_port, "EXECUTE errs")
+        assert replaced.startswith("FOUND: 1\n") and replaced.endswith("] prep-beta three\n"), replaced
+
+        for command in (
+            "PREPARE",
+            "PREPARE only-a-name",
+            "PREPARE bad!name keyword=x",
+            "PREPARE bad bogus=1",
+            "EXECUTE",
+            "EXECUTE missing",
+            "EXECUTE errs keyword=x",
+            "EXECUTE errs limit=0",
+            "EXECUTE errs time_from=5 time_to=1",
+            "EXECUTE errs time_from=1 time_from=2",
+        ):
+            assert _query_command(query_port, command).startswith("ERROR:"), command
+        assert _stats_field(_query_command(query_port, "STATS"), "Prepared") == 1
+
+
+def _pipeline_stages(stats: str) -> dict[str, list[int]]:
+    text = stats.split("Pipeline=[", 1)[1].split("]", 1)[0]
+    items = (item.split("=") for item in text.split(", "))
+    return {name: [int(part) for part in value.split("/")] for name, value in items}
+
+
+def spec_ingest_pipeline() -> None:
+    """Sequence: SEQ0339. Verifies the staged ingest pipeline on dedicated stage threads from SEQ0332–SEQ0340."""
+
+    cpp_binary = binary_path("cpp")
+    log_port = 15261
+    query_port = 15262
+    streams = ["alpha", "beta", "gamma"]
+    per_stream = 600
+    total = per_stream * len(streams)
+    expected = {
+        stream: [f"{'ERROR ' if i % 10 == 0 else ''}{stream}-{i:04d}" for i in range(per_stream)] for stream in streams
+    }
+    tmp_root = Path(tempfile.mkdtemp(prefix="lc-spec-pipeline-", dir=str(build_dir())))
+    try:
+        with ServerProcess(
+            cpp_binary,
+            "--log-port",
+            str(log_port),
+            "--query-port",
+            str(query_port),
+            "--capacity",
+            str(total),
+            "--enable-persistence",
+            "--persistence-dir",
+            str(tmp_root),
+            "--pipeline-threads",
+            "enrich=1,store=2,persist=2,fanout=1",
+            "--pipeline-queue",
+            "8",
+        ) as server, _draining(server):
+            server.wait_ready([log_port, query_port])
+            producers = [
+                threading.Thread(target=_send_session, args=(log_port, [f"STREAM {stream}"] + expected[stream]))
+                for stream in streams
+            ]
+            for producer in producers:
+                producer.start()
+            for producer in producers:
+                producer.join(timeout=30.0)
+            stats = _wait_for_stats(
+                query_port,
+                lambda text: _pipeline_stages(text)["fanout"][1] == total and _stats_field(text, "Persisted") == total,
+            )
+            stages = _pipeline_stages(stats)
+            assert {name: (values[0], values[1], values[2]) for name, values in stages.items()} == {
+                "enrich": (1, total, 0),
+                "store": (2, total, 0),
+                "persist": (2, total, 0),
+                "fanout": (1, total, 0),
+            }, stats
+            assert _stats_field(stats, "Total") == total, stats
+
+            # Streams are spread over the store workers, and each keeps its arrival order.
+            for stream in streams:
+                records = result_decoder.decode_ndjson(
+                    _query_raw(query_port, [f"QUERY stream={stream} format=ndjson"])
+                )
+                assert [record["message"] for record in records] == expected[stream], stream
+            # The level the enrich stage assigned is what the rollups counted.
+            rollup = _query_command(query_port, "ROLLUP by=level")
+            errors = sum(int(field.split("=")[1]) for field in rollup.split() if field.startswith("error="))
+            assert errors == total // 10, rollup
+
+        # Without --pipeline-threads every stage runs on the ingest drain and nothing is queued.
+        with ServerProcess(cpp_binary, "--log-port", str(log_port), "--query-port", str(query_port)) as server:
+            server.wait_ready([log_port, query_port])
+            _send_session(log_port, expected["alpha"][:50])
+            stats = _wait_for_stats(query_port, lambda text: _stats_field(text, "Total") == 50)
+            assert set(map(tuple, _pipeline_stages(stats).values())) == {(0, 50, 0, 0)}, stats
+    finally:
+        shutil.rmtree(tmp_root, ignore_errors=True)
+
+
+def _redaction_counts(stats: str) -> dict[str, int]:
+    text = stats.split("RedactRules=", 1)[1].split("[", 1)[1].split("]", 1)[0]
+    return {name: int(count) for name, count in (item.split("=") for item in text.split(", "))}
+
+
+def spec_redaction() -> None:
+    """Sequence: SEQ0348. Verifies ingest-time redaction rules and their per-rule counters from SEQ0341–SEQ0349."""
+
+    cpp_binary = binary_path("cpp")
+    log_port = 15263
+    query_port = 15264
+    tmp_root = Path(tempfile.mkdtemp(prefix="lc-spec-redact-", dir=str(build_dir())))
+    rules = tmp_root / "redact.conf"
+    rules.write_text(
+        "# name  literal=<text> | regex=<pattern>\n"
+        "api_key regex=sk_live_[0-9A-Za-z]{8,}\n"
+        "email regex=[A-Za-z0-9._%+-]+@[A-Za-z0-9.-]+\\.[A-Za-z]{2,}\n"
+        "\n"
+        "card regex=[0-9]{4}(?:[ -]?[0-9]{4}){3}\n"
+        "session literal=X-Session-Secret: hunter2\n"
+    )
+    secrets = {
+        "api_key": ["sk_live_a8F3kQ9z", "sk_live_0000000000000000"],
+        "email": ["alice@example.com", "ops.team+pager@mail.example.org"],
+        "card": ["4111 1111 1111 1111", "5500-0000-0000-0004"],
+        "session": ["X-Session-Secret: hunter2"],
+    }
+    lines = [
+        f"login user={secrets['email'][0]} key={secrets['api_key'][0]}",
+        f"charge card={secrets['card'][0]} then {secrets['card'][1]} notify {secrets['email'][1]}",
+        f"[WARN] header {secrets['session'][0]} with key {secrets['api_key'][1]}",
+        "clean line: order 1234 shipped to alice at example dot com, key sk_live_short",
+    ]
+    masked = list(lines)
+    for values in secrets.values():
+        for value in values:
+            masked = [line.replace(value, "*" * len(value)) for line in masked]
+    try:
+        with ServerProcess(
+            cpp_binary,
+            "--log-port",
+            str(log_port),
+            "--query-port",
+            str(query_port),
+            "--enable-persistence",
+            "--persistence-dir",
+            str(tmp_root / "persist"),
+            "--redact-rules",
+            str(rules),
+        ) as server, _draining(server):
+            server.wait_ready([log_port, query_port])
+            _send_session(log_port, lines)
+            stats = _wait_for_stats(
+                query_port, lambda text: _stats_field(text, "Total") == 4 and _stats_field(text, "Persisted") == 4
+            )
+            assert _stats_field(stats, "RedactedLines") == 3, stats
+            assert _stats_field(stats, "Redactions") == 7, stats
+            assert _redaction_counts(stats) == {"api_key": 2, "email": 2, "card": 2, "session": 1}, stats
+
+            # Masking keeps lengths, so level detection and every reader see the same line.
+            records = result_decoder.decode_ndjson(_query_raw(query_port, ["QUERY stream=default format=ndjson"]))
+            assert [record["message"] for record in records] == masked, records
+            assert [record["level"] for record in records][2] == "warning", records
+            assert "alice@example.com" not in _query_command(query_port, "QUERY keyword=example")
+
+        persisted = "".join(path.read_text() for path in (tmp_root / "persist").rglob("*.log"))
+        for values in secrets.values():
+            for value in values:
+                assert value not in persisted, value
+        assert masked[3] in persisted, persisted
+
+        # Unsupported patterns and malformed files stop the server at startup.
+        for text, expected in (
+            ("anchored regex=^secret\n", "redact.conf:1: anchors are not supported"),
+            ("# comment\nlazy regex=a+?\n", "redact.conf:2: lazy and possessive quantifiers"),
+            ("same literal=a\nsame literal=b\n", "duplicate rule name 'same'"),
+            ("empty regex=a*\n", "matches the empty string"),
+            ("nokind secret\n", "expected <name> literal=<text> or <name> regex=<pattern>"),
+        ):
+            rules.write_text(text)
+            with ServerProcess(
+                cpp_binary, "--log-port", str(log_port), "--query-port", str(query_port), "--redact-rules", str(rules)
+            ) as server:
+                assert server.process.wait(timeout=5.0) != 0
+                assert expected in server.process.stderr.read()
+    finally:
+        shutil.rmtree(tmp_root, ignore_errors=True)
+
+
+def spec_bulk_import() -> None:
+    """Sequence: SEQ0353. Verifies bulk import into persisted segments, replay, and EXPORT from SEQ0350–SEQ0354."""
+
+    cpp_binary = binary_path("cpp")
+    importer = cpp_binary.parent / "logcrafter_cpp_import"
+    log_port = 15265
+    query_port = 15266
+    base = 1714564800
+    padding = "p" * 80
+    tmp_root = Path(tempfile.mkdtemp(prefix="lc-spec-import-", dir=str(build_dir())))
+    persist = tmp_root / "persist"
+    # RFC 3339 stamps ten lines a second, with unstamped continuation lines and one late line.
+    plain = tmp_root / "app-a.log"
+    a_lines = []
+    for index in range(40000):
+        stamp = time.strftime("%Y-%m-%dT%H:%M:%SZ", time.gmtime(base + index // 10))
+        a_lines.append(f"{stamp} app-a line {index:05d} {padding}\r")
+        if index % 5000 == 0:
+            a_lines.append(f"    at frame {index:05d}")
+    a_lines.append(f"{base + 2} app-a late line")
+    plain.write_text("\n".join(a_lines) + "\n")
+    # Epoch stamps, gzip-compressed in two members, interleaved in time with the first file.
+    packed = tmp_root / "app-b.log.gz"
+    b_lines = [f"{base + 5 + index // 10} app-b event {index:05d} {padding}" for index in range(20000)]
+    packed.write_bytes(
+        gzip.compress(("\n".join(b_lines[:7000]) + "\n").encode())
+        + gzip.compress(("\n".join(b_lines[7000:]) + "\n").encode())
+    )
+    total = 40000 + 8 + 1 + 20000
+    try:
+        result = subprocess.run(
+            [str(importer), "--persistence-dir", str(persist), "--threads", "4", "--persistence-max-size", "1"]
+            + [str(plain), str(packed)],
+            capture_output=True,
+            text=True,
+            check=True,
+            timeout=60,
+        )
+        assert f"Imported {total} lines from 2 files into" in result.stdout, result.stdout
+        assert "Sorted 1 lines that were out of time order" in result.stdout, result.stdout
+
+        # Rotated-style segments of about 1 MB, named by their last stamp, in time order throughout.
+        segments = sorted(persist.glob("*.log"))
+        assert len(segments) >= 5 and not (persist / "current.log").exists(), [path.name for path in segments]
+        lines = [line for path in segments for line in path.read_text().splitlines()]
+        assert len(lines) == total, len(lines)
+        stamps = [line[1:20] for line in lines]
+        assert stamps == sorted(stamps), "segments are out of order"
+        for path in segments:
+            assert path.name == path.read_text().splitlines()[-1][1:20] + ".log", path.name
+        assert lines[0].endswith("] app-a line 00000 " + padding), lines[0]
+        assert lines[1].endswith("]     at frame 00000"), lines[1]
+        assert lines[1][:22] == lines[0][:22], lines[:2]
+
+        with ServerProcess(
+            cpp_binary,
+            "--log-port",
+            str(log_port),
+            "--query-port",
+            str(query_port),
+            "--capacity",
+            str(total),
+            "--persistence-dir",
+            str(persist),
+            "--persistence-max-files",
+            "100",
+        ) as server, _draining(server):
+            server.wait_ready([log_port, query_port])
+            stats = _wait_for_stats(query_port, lambda text: _stats_field(text, "Total") == total)
+            response = _query_command(query_port, "QUERY keyword=late")
+            assert response.startswith("FOUND: 1\n") and "app-a late line" in response, response
+            response = _query_command(query_port, f"QUERY keyword=app-b time_from={base + 505} time_to={base + 505}")
+            assert response.startswith("FOUND: 10\n"), response[:200]
+
+            exported = _query_raw(query_port, [f"EXPORT from={base + 1000} to={base + 1999}"])
+            header, _, body = exported.partition(b"\n")
+            assert header == f"EXPORT: {len(body)}".encode(), header
+            assert body.count(b"app-a line") == 10000 and body.count(b"app-b event") == 10000, len(body)
+
+        # The same second cannot be written twice: importing again fails instead of replacing a segment.
+        again = subprocess.run(
+            [str(importer), "--persistence-dir", str(persist), str(plain)], capture_output=True, text=True, timeout=60
+        )
+        assert again.returncode != 0 and "already exists" in again.stderr, again.stderr
+        assert not list(persist.glob(".import-*")), list(persist.iterdir())
+        bad = subprocess.run([str(importer), "--persistence-dir", str(persist), "--stream", "no/slash", str(plain)],
+                             capture_output=True, text=True, timeout=60)
+        assert bad.returncode != 0 and "invalid stream name" in bad.stderr, bad.stderr
+    finally:
+        shutil.rmtree(tmp_root, ignore_errors=True)
+
+
 SPEC_CASES = {
     "spec_protocol_happy_path": spec_protocol_happy_path,
     "spec_invalid_inputs": spec_invalid_inputs,
     "spec_partial_io": spec_partial_io,
     "spec_timeouts": spec_timeouts,
     "spec_sigint_shutdown": spec_sigint_shutdown,
+    "spec_client_timestamps": spec_client_timestamps,
+    "spec_source_quotas": spec_source_quotas,
+    "spec_stats_polling": spec_stats_polling,
+    "spec_large_query_response": spec_large_query_response,
+    "spec_named_streams": spec_named_streams,
+    "spec_repeat_collapsing": spec_repeat_collapsing,
+    "spec_relay_forwarding": spec_relay_forwarding,
+    "spec_federated_query": spec_federated_query,
+    "spec_replication": spec_replication,
+    "spec_compressed_query": spec_compressed_query,
+    "spec_binary_query": spec_binary_query,
+    "spec_export": spec_export,
+    "spec_rollup": spec_rollup,
+    "spec_alert_rules": spec_alert_rules,
+    "spec_load_shedding": spec_load_shedding,
+    "spec_severity_rings": spec_severity_rings,
+    "spec_query_context": spec_query_context,
+    "spec_fetch": spec_fetch,
+    "spec_prepared_query": spec_prepared_query,
+    "spec_ingest_pipeline": spec_ingest_pipeline,
+    "spec_redaction": spec_redaction,
+    "spec_bulk_import": spec_bulk_import,
 }
 
 
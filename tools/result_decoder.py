@@ -0,0 +1,138 @@
+"""
+Sequence: SEQ0318
+Track: Shared
+MVP: Step D
+Change: Decode format=binary and format=ndjson QUERY responses (optionally compress=deflate)
+        and FETCH batches into dictionaries, for tooling that consumes the C++ query port.
+Tests: spec_binary_query, spec_fetch
+"""
+
+from __future__ import annotations
+
+import argparse
+import json
+import socket
+import struct
+import sys
+import zlib
+from typing import Iterator
+
+LEVELS = {0: "unknown", 1: "debug", 2: "info", 3: "warning", 4: "error"}
+
+# u32 length of the rest | i64 ts_ns | u64 seq | u8 level | u8 stream length
+_RECORD_HEADER = struct.Struct(">IqQBB")
+_COMPRESSED_LINE = b"COMPRESSED: deflate\n"
+
+
+def _split_header(response: bytes, prefix: bytes) -> tuple[int, bytes]:
+    header, newline, body = response.partition(b"\n")
+    if not newline or not header.startswith(prefix):
+        raise ValueError(f"unexpected response header: {header[:120]!r}")
+    return int(header[len(prefix) :]), body
+
+
+def _inflate(response: bytes) -> bytes:
+    if response.startswith(_COMPRESSED_LINE):
+        return zlib.decompress(response[len(_COMPRESSED_LINE) :])
+    return response
+
+
+def iter_binary(body: bytes) -> Iterator[dict]:
+    offset = 0
+    while offset < len(body):
+        if len(body) - offset < _RECORD_HEADER.size:
+            raise ValueError(f"truncated record header at byte {offset}")
+        length, ts_ns, seq, level, stream_length = _RECORD_HEADER.unpack_from(body, offset)
+        end = offset + 4 + length
+        stream_start = offset + _RECORD_HEADER.size
+        if end > len(body) or stream_start + stream_length > end:
+            raise ValueError(f"truncated record at byte {offset}")
+        yield {
+            "ts_ns": ts_ns,
+            "seq": seq,
+            "level": LEVELS.get(level, "unknown"),
+            "stream": body[stream_start : stream_start + stream_length].decode(errors="replace"),
+            "message": body[stream_start + stream_length : end].decode(errors="replace"),
+        }
+        offset = end
+
+
+def decode_binary(response: bytes) -> list[dict]:
+    expected, body = _split_header(_inflate(response), b"BINARY: ")
+    records = list(iter_binary(body))
+    if len(records) != expected:
+        raise ValueError(f"expected {expected} records, decoded {len(records)}")
+    return records
+
+
+def decode_ndjson(response: bytes) -> list[dict]:
+    expected, body = _split_header(_inflate(response), b"NDJSON: ")
+    records = [json.loads(line) for line in body.splitlines()]
+    if len(records) != expected:
+        raise ValueError(f"expected {expected} records, decoded {len(records)}")
+    return records
+
+
+def decode_fetch(response: bytes) -> list[dict]:
+    """Splits the FETCH answers read from one connection into {"next", "head", "records"} batches."""
+    batches = []
+    while response:
+        header, newline, body = response.partition(b"\n")
+        if not newline or not header.startswith(b"FETCH: "):
+            raise ValueError(f"unexpected response header: {header[:120]!r}")
+        count, *fields = header[len(b"FETCH: ") :].split()
+        values = dict(field.split(b"=", 1) for field in fields)
+        end = 0
+        for _ in range(int(count)):
+            if len(body) - end < 4:
+                raise ValueError(f"truncated record header at byte {end}")
+            end += 4 + struct.unpack_from(">I", body, end)[0]
+        batches.append(
+            {"next": int(values[b"next"]), "head": int(values[b"head"]), "records": list(iter_binary(body[:end]))}
+        )
+        response = body[end:]
+    return batches
+
+
+def decode(response: bytes) -> list[dict]:
+    """Decodes either machine-readable format; ERROR lines raise ValueError."""
+    plain = _inflate(response)
+    if plain.startswith(b"NDJSON: "):
+        return decode_ndjson(plain)
+    return decode_binary(plain)
+
+
+def query(port: int, arguments: str, host: str = "127.0.0.1", timeout: float = 5.0) -> bytes:
+    """Sends one QUERY line and returns the raw response after the banner."""
+    with socket.create_connection((host, port), timeout=timeout) as sock:
+        banner = b""
+        while banner.count(b"\n") < 2:
+            chunk = sock.recv(1)
+            if not chunk:
+                raise ConnectionError(f"connection closed during banner: {banner!r}")
+            banner += chunk
+        sock.sendall(f"QUERY {arguments}\n".encode())
+        sock.shutdown(socket.SHUT_WR)
+        chunks: list[bytes] = []
+        while True:
+            chunk = sock.recv(65536)
+            if not chunk:
+                return b"".join(chunks)
+            chunks.append(chunk)
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description="Run a QUERY with format=binary and print NDJSON records")
+    parser.add_argument("arguments", help="QUERY arguments, e.g. 'keyword=error stream=app'")
+    parser.add_argument("--port", type=int, default=9998)
+    parser.add_argument("--host", default="127.0.0.1")
+    args = parser.parse_args()
+
+    response = query(args.port, f"{args.arguments} format=binary", host=args.host)
+    for record in decode_binary(response):
+        sys.stdout.write(json.dumps(record) + "\n")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -1,9 +1,9 @@
 /*
- * Sequence: SEQ0027
+ * Sequence: SEQ0168
  * Track: C
  * MVP: mvp5
- * Change: Enforce connection limits, guarded metrics, and sanitized log ingestion for the security hardening stage.
- * Tests: smoke_security_capacity
+ * Change: Coalesce the QUERY header and result lines into sendmsg batches flagged MSG_MORE until the last one.
+ * Tests: spec_large_query_response, spec_protocol_happy_path
  */
 #include "lc_server.h"
 
@@ -16,12 +16,19 @@
 #include <sys/select.h>
 #include <sys/socket.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 #include <time.h>
 #include <unistd.h>
 
 #include "query_parser.h"
 
 #define LC_ARRAY_SIZE(arr) (sizeof(arr) / sizeof((arr)[0]))
+#define LC_SEND_BATCH_SEGMENTS 512
+#define LC_SEND_BATCH_BYTES (256u * 1024u)
+
+#ifndef MSG_MORE
+#define MSG_MORE 0
+#endif
 
 typedef struct LCServerClientJob {
     LCServer *server;
@@ -44,7 +51,9 @@ static void lc_send_help(int client_fd);
 static void lc_send_count(LCServer *server, int client_fd);
 static void lc_send_stats(LCServer *server, int client_fd);
 static void lc_send_query_advanced(LCServer *server, int client_fd, const char *arguments);
-static void lc_send_query_results(int client_fd, char **results, size_t count);
+static void lc_send_query_results(int client_fd, const char *header, size_t header_length,
+                                  char **results, size_t count);
+static int lc_send_batch(int fd, struct iovec *segments, size_t count, int more);
 static void lc_send_error_message(int client_fd, const char *message);
 static void lc_metrics_log_client_enter(LCServer *server);
 static void lc_metrics_log_client_leave(LCServer *server);
@@ -685,11 +694,7 @@ static void lc_send_query_advanced(LCServer *server, int client_fd, const char *
 
     char header[64];
     int written = snprintf(header, sizeof(header), "FOUND: %zu\n", count);
-    if (written > 0) {
-        lc_send_all(client_fd, header, (size_t)written);
-    }
-
-    lc_send_query_results(client_fd, results, count);
+    lc_send_query_results(client_fd, header, written > 0 ? (size_t)written : 0, results, count);
 
     if (results != NULL) {
         for (size_t i = 0; i < count; ++i) {
@@ -700,20 +705,73 @@ static void lc_send_query_advanced(LCServer *server, int client_fd, const char *
     lc_query_request_reset(&request);
 }
 
-static void lc_send_query_results(int client_fd, char **results, size_t count) {
-    if (results == NULL) {
-        return;
+/* Gathers the header and result lines into iovec batches; every batch but the last carries
+ * MSG_MORE so the kernel packs full segments instead of one packet per line. */
+static void lc_send_query_results(int client_fd, const char *header, size_t header_length,
+                                  char **results, size_t count) {
+    static char newline[] = "\n";
+    struct iovec segments[LC_SEND_BATCH_SEGMENTS];
+    size_t used = 0;
+    size_t pending = 0;
+
+    if (header_length > 0) {
+        segments[used].iov_base = (void *)header;
+        segments[used].iov_len = header_length;
+        pending += header_length;
+        ++used;
     }
-    for (size_t i = 0; i < count; ++i) {
+    for (size_t i = 0; results != NULL && i < count; ++i) {
         if (results[i] == NULL) {
             continue;
         }
+        if (used + 2 > LC_SEND_BATCH_SEGMENTS || pending >= LC_SEND_BATCH_BYTES) {
+            if (lc_send_batch(client_fd, segments, used, 1) != 0) {
+                return;
+            }
+            used = 0;
+            pending = 0;
+        }
         size_t length = strlen(results[i]);
         if (length > 0) {
-            lc_send_all(client_fd, results[i], length);
+            segments[used].iov_base = results[i];
+            segments[used].iov_len = length;
+            ++used;
+        }
+        segments[used].iov_base = newline;
+        segments[used].iov_len = 1;
+        ++used;
+        pending += length + 1;
+    }
+    lc_send_batch(client_fd, segments, used, 0);
+}
+
+static int lc_send_batch(int fd, struct iovec *segments, size_t count, int more) {
+    size_t first = 0;
+    while (first < count) {
+        struct msghdr message;
+        memset(&message, 0, sizeof(message));
+        message.msg_iov = segments + first;
+        message.msg_iovlen = count - first;
+        ssize_t sent = sendmsg(fd, &message, more ? MSG_MORE : 0);
+        if (sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("sendmsg");
+            return -1;
+        }
+        /* Resume a partial write inside the segment the kernel stopped in. */
+        size_t remaining = (size_t)sent;
+        while (first < count && remaining >= segments[first].iov_len) {
+            remaining -= segments[first].iov_len;
+            ++first;
+        }
+        if (remaining > 0) {
+            segments[first].iov_base = (char *)segments[first].iov_base + remaining;
+            segments[first].iov_len -= remaining;
         }
-        lc_send_all(client_fd, "\n", 1);
     }
+    return 0;
 }
 
 static void lc_send_error_message(int client_fd, const char *message) {
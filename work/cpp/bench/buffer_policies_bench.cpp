@@ -0,0 +1,130 @@
+/*
+ * Sequence: SEQ0163
+ * Track: C++
+ * MVP: Step D
+ * Change: Benchmark push, scan, time-filtered scan, and mixed read/write cost across BasicLogBuffer policy combinations.
+ * Tests: logcrafter_cpp_bench_buffer_policies (manual)
+ */
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <type_traits>
+
+#include "log_buffer_impl.hpp"
+
+namespace {
+
+using namespace logcrafter::cpp;
+using BenchClock = std::chrono::steady_clock;
+
+constexpr std::size_t kCapacity = 10000;
+constexpr std::time_t kBaseTime = 1714564800;
+
+struct Settings {
+    std::size_t pushes;
+    std::size_t queries;
+};
+
+double seconds_since(BenchClock::time_point start) {
+    return std::chrono::duration<double>(BenchClock::now() - start).count();
+}
+
+template <typename Buffer>
+void fill(Buffer &buffer, std::size_t lines, const std::string &message) {
+    for (std::size_t i = 0; i < lines; ++i) {
+        buffer.push_with_time(message, kBaseTime + static_cast<std::time_t>(i / 100));
+    }
+}
+
+template <typename Buffer>
+double queries_per_second(const Buffer &buffer, const QueryRequest &request, std::size_t queries) {
+    std::size_t found = 0;
+    const auto start = BenchClock::now();
+    for (std::size_t i = 0; i < queries; ++i) {
+        found += buffer.execute_query(request).size();
+    }
+    const double elapsed = seconds_since(start);
+    return found == static_cast<std::size_t>(-1) ? 0.0 : static_cast<double>(queries) / elapsed;
+}
+
+template <typename Storage, typename Sync, typename Index>
+void run(const char *storage, const char *sync, const char *index, const Settings &settings) {
+    using Buffer = BasicLogBuffer<Storage, Sync, Index>;
+    const std::string message = "worker=7 level=INFO request served in 12ms path=/api/v1/items user=alice";
+
+    Buffer buffer;
+    buffer.configure(kCapacity);
+    fill(buffer, kCapacity, message);
+
+    const auto push_start = BenchClock::now();
+    fill(buffer, settings.pushes, message);
+    const double push_ns = seconds_since(push_start) * 1e9 / static_cast<double>(settings.pushes);
+
+    QueryRequest keyword;
+    keyword.keyword = "alice";
+    const double scan_qps = queries_per_second(buffer, keyword, settings.queries);
+
+    // Matches one 100-entry second near the middle of the ring.
+    QueryRequest window;
+    window.has_time_from = true;
+    window.has_time_to = true;
+    window.time_from = kBaseTime + static_cast<std::time_t>((settings.pushes - kCapacity / 2) / 100);
+    window.time_to = window.time_from;
+    const double window_qps = queries_per_second(buffer, window, settings.queries * 10);
+
+    // One writer and one keyword reader running together; NullSync cannot share the buffer.
+    double mixed_ns = 0.0;
+    if (!std::is_same<Sync, NullSync>::value) {
+        std::atomic<bool> stop(false);
+        std::thread reader([&]() {
+            QueryRequest request;
+            request.keyword = "no-such-token";
+            while (!stop.load(std::memory_order_relaxed)) {
+                buffer.execute_query(request);
+            }
+        });
+        const auto mixed_start = BenchClock::now();
+        fill(buffer, settings.pushes, message);
+        mixed_ns = seconds_since(mixed_start) * 1e9 / static_cast<double>(settings.pushes);
+        stop.store(true, std::memory_order_relaxed);
+        reader.join();
+    }
+
+    std::printf("%-16s %-10s %-10s %10.1f %12.0f %12.0f %12.1f\n", storage, sync, index, push_ns, scan_qps,
+                window_qps, mixed_ns);
+}
+
+template <typename Storage>
+void run_storage(const char *storage, const Settings &settings) {
+    run<Storage, MutexSync, TimeBlockIndex>(storage, "mutex", "timeblock", settings);
+    run<Storage, MutexSync, NoIndex>(storage, "mutex", "none", settings);
+    run<Storage, SharedMutexSync, TimeBlockIndex>(storage, "shared", "timeblock", settings);
+    run<Storage, SharedMutexSync, NoIndex>(storage, "shared", "none", settings);
+    run<Storage, SpinLockSync, TimeBlockIndex>(storage, "spin", "timeblock", settings);
+    run<Storage, SpinLockSync, NoIndex>(storage, "spin", "none", settings);
+    run<Storage, NullSync, TimeBlockIndex>(storage, "null", "timeblock", settings);
+    run<Storage, NullSync, NoIndex>(storage, "null", "none", settings);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    Settings settings{300000, 100};
+    if (argc > 1) {
+        const std::size_t pushes = static_cast<std::size_t>(std::strtoull(argv[1], nullptr, 10));
+        if (pushes >= kCapacity) {
+            settings.pushes = pushes;
+        }
+    }
+
+    std::printf("BasicLogBuffer policy matrix: capacity %zu, %zu pushes, %zu scans\n", kCapacity, settings.pushes,
+                settings.queries);
+    std::printf("%-16s %-10s %-10s %10s %12s %12s %12s\n", "storage", "sync", "index", "push ns", "scan q/s",
+                "window q/s", "mixed ns");
+    run_storage<StringStorage>("string", settings);
+    run_storage<FixedSlotStorage<1024>>("fixed-slot-1k", settings);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,80 @@
+/*
+ * Sequence: SEQ0122
+ * Track: C++
+ * MVP: Step D
+ * Change: Measure per-line timestamp cost of time()+strftime against the coarse clock service.
+ * Tests: logcrafter_cpp_bench_clock (manual)
+ */
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <string>
+
+#include "clock_service.hpp"
+
+namespace {
+
+using logcrafter::cpp::ClockService;
+using BenchClock = std::chrono::steady_clock;
+
+volatile std::size_t g_sink = 0;
+
+std::size_t stamp_with_libc(char *line) {
+    const std::time_t now = std::time(nullptr);
+    std::tm tm_value{};
+    localtime_r(&now, &tm_value);
+    line[0] = '[';
+    const std::size_t length = std::strftime(line + 1, 31, "%Y-%m-%d %H:%M:%S", &tm_value);
+    line[length + 1] = ']';
+    return length + 2;
+}
+
+std::size_t stamp_with_service(char *line) {
+    ClockService &clock = ClockService::instance();
+    line[0] = '[';
+    const std::size_t length = clock.format_timestamp(clock.now_seconds(), line + 1, 31);
+    line[length + 1] = ']';
+    return length + 2;
+}
+
+template <typename Fn>
+double run(const char *label, std::size_t iterations, Fn &&fn) {
+    char line[40];
+    const auto start = BenchClock::now();
+    for (std::size_t i = 0; i < iterations; ++i) {
+        g_sink += fn(line);
+    }
+    const auto elapsed = std::chrono::duration<double, std::nano>(BenchClock::now() - start).count();
+    const double per_line = elapsed / static_cast<double>(iterations);
+    std::printf("%-34s %10.2f ns/line\n", label, per_line);
+    return per_line;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    std::size_t iterations = 5000000;
+    if (argc > 1) {
+        iterations = static_cast<std::size_t>(std::strtoull(argv[1], nullptr, 10));
+        if (iterations == 0) {
+            iterations = 5000000;
+        }
+    }
+
+    std::printf("timestamp cost over %zu lines\n", iterations);
+    const double libc = run("time()+localtime_r+strftime", iterations, stamp_with_libc);
+    const double coarse = run("coarse clock (no ticker)", iterations, stamp_with_service);
+
+    ClockService::instance().start();
+    const double ticker = run("clock service (ticker)", iterations, stamp_with_service);
+    const double millis = run("now_millis() read", iterations, [](char *) {
+        return static_cast<std::size_t>(ClockService::instance().now_millis());
+    });
+    ClockService::instance().stop();
+
+    std::printf("speedup vs libc: coarse %.1fx, ticker %.1fx (millis read %.2f ns)\n",
+                libc / coarse, libc / ticker, millis);
+    return g_sink == 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,158 @@
+/*
+ * Sequence: SEQ0169
+ * Track: C++
+ * MVP: Step D
+ * Change: Measure large-result QUERY transmission latency over loopback TCP, per-line send() versus ResponseWriter batches.
+ * Tests: logcrafter_cpp_bench_query_send (manual)
+ */
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <netinet/in.h>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "log_buffer.hpp"
+#include "response_writer.hpp"
+
+namespace {
+
+using logcrafter::cpp::QueryResults;
+using logcrafter::cpp::ResponseWriter;
+using BenchClock = std::chrono::steady_clock;
+
+constexpr int kRepeats = 5;
+
+struct Connection {
+    int sender = -1;
+    int receiver = -1;
+};
+
+Connection connect_loopback() {
+    Connection connection;
+    const int listener = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t length = sizeof(address);
+    if (listener < 0 || ::bind(listener, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0 ||
+        ::listen(listener, 1) != 0 ||
+        ::getsockname(listener, reinterpret_cast<sockaddr *>(&address), &length) != 0) {
+        std::perror("listener");
+        std::exit(EXIT_FAILURE);
+    }
+    connection.receiver = ::socket(AF_INET, SOCK_STREAM, 0);
+    if (::connect(connection.receiver, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0) {
+        std::perror("connect");
+        std::exit(EXIT_FAILURE);
+    }
+    connection.sender = ::accept(listener, nullptr, nullptr);
+    ::close(listener);
+    return connection;
+}
+
+// The pre-batching path: one send() for each line and another for its newline.
+void send_per_line(int fd, const std::string &header, const QueryResults &results) {
+    auto send_all = [fd](const char *data, std::size_t length) {
+        std::size_t total = 0;
+        while (total < length) {
+            const ssize_t sent = ::send(fd, data + total, length - total, 0);
+            if (sent < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                std::perror("send");
+                std::exit(EXIT_FAILURE);
+            }
+            total += static_cast<std::size_t>(sent);
+        }
+    };
+    send_all(header.data(), header.size());
+    for (const std::pmr::string &line : results) {
+        send_all(line.data(), line.size());
+        send_all("\n", 1);
+    }
+}
+
+void send_batched(int fd, const std::string &header, const QueryResults &results) {
+    ResponseWriter writer(fd);
+    writer.append(header);
+    for (const std::pmr::string &line : results) {
+        writer.append_line(line);
+    }
+    if (!writer.finish()) {
+        std::exit(EXIT_FAILURE);
+    }
+}
+
+// Time from the first send until the client has read the last byte, best of kRepeats.
+template <typename Sender>
+double best_latency_ms(Connection &connection, const std::string &header, const QueryResults &results,
+                       std::size_t total_bytes, Sender sender) {
+    double best = 0.0;
+    for (int repeat = 0; repeat < kRepeats; ++repeat) {
+        const auto start = BenchClock::now();
+        std::thread reader([&]() {
+            std::vector<char> chunk(64 * 1024);
+            std::size_t received = 0;
+            while (received < total_bytes) {
+                const ssize_t got = ::recv(connection.receiver, chunk.data(), chunk.size(), 0);
+                if (got <= 0) {
+                    std::perror("recv");
+                    std::exit(EXIT_FAILURE);
+                }
+                received += static_cast<std::size_t>(got);
+            }
+        });
+        sender(connection.sender, header, results);
+        reader.join();
+        const double ms = std::chrono::duration<double, std::milli>(BenchClock::now() - start).count();
+        best = repeat == 0 ? ms : std::min(best, ms);
+    }
+    return best;
+}
+
+void run(Connection &connection, std::size_t lines) {
+    QueryResults results;
+    results.reserve(lines);
+    std::size_t total_bytes = 0;
+    for (std::size_t i = 0; i < lines; ++i) {
+        results.emplace_back("[2024-05-01 12:00:00] worker=7 level=INFO request served in 12ms path=/api/v1/items/" +
+                             std::to_string(i));
+        total_bytes += results.back().size() + 1;
+    }
+    const std::string header = "FOUND: " + std::to_string(lines) + "\n";
+    total_bytes += header.size();
+
+    const double per_line = best_latency_ms(connection, header, results, total_bytes, send_per_line);
+    const double batched = best_latency_ms(connection, header, results, total_bytes, send_batched);
+    std::printf("%10zu %12.2f %12.2f %10.2fx\n", lines, per_line, batched, per_line / batched);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    std::size_t max_lines = 100000;
+    if (argc > 1) {
+        const std::size_t requested = static_cast<std::size_t>(std::strtoull(argv[1], nullptr, 10));
+        if (requested > 0) {
+            max_lines = requested;
+        }
+    }
+
+    Connection connection = connect_loopback();
+    std::printf("QUERY response latency over loopback TCP (best of %d)\n", kRepeats);
+    std::printf("%10s %12s %12s %11s\n", "lines", "per-line ms", "batched ms", "speedup");
+    for (std::size_t lines = 100; lines <= max_lines; lines *= 10) {
+        run(connection, lines);
+    }
+    ::close(connection.sender);
+    ::close(connection.receiver);
+    return EXIT_SUCCESS;
+}
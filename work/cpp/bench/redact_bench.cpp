@@ -0,0 +1,130 @@
+/*
+ * Sequence: SEQ0346
+ * Track: C++
+ * MVP: Step D
+ * Change: Measure per-line redaction overhead against a copy-only baseline and per-pattern std::regex.
+ * Tests: logcrafter_cpp_bench_redact (manual)
+ */
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <regex>
+#include <string>
+#include <vector>
+
+#include "redactor.hpp"
+
+namespace {
+
+using logcrafter::cpp::RedactionRule;
+using logcrafter::cpp::Redactor;
+using BenchClock = std::chrono::steady_clock;
+
+constexpr std::size_t kCorpusLines = 4096;
+
+std::vector<RedactionRule> bench_rules() {
+    return {
+        {"api_key", RedactionRule::Kind::Regex, "sk_live_[0-9A-Za-z]{8,}"},
+        {"email", RedactionRule::Kind::Regex, "[A-Za-z0-9._%+-]+@[A-Za-z0-9.-]+\\.[A-Za-z]{2,}"},
+        {"card", RedactionRule::Kind::Regex, "[0-9]{4}[ -]?[0-9]{4}[ -]?[0-9]{4}[ -]?[0-9]{4}"},
+        {"session", RedactionRule::Kind::Literal, "X-Session-Secret"},
+    };
+}
+
+// Every `dirty_every`th line carries one secret of each kind; the rest look like ordinary traffic.
+std::vector<std::string> corpus(std::size_t dirty_every) {
+    std::vector<std::string> lines;
+    lines.reserve(kCorpusLines);
+    char line[256];
+    for (std::size_t i = 0; i < kCorpusLines; ++i) {
+        if (dirty_every > 0 && i % dirty_every == 0) {
+            std::snprintf(line, sizeof(line),
+                          "[WARN] worker=%zu charge failed card=4111 1111 1111 %04zu user=ops%zu@example.com "
+                          "key=sk_live_a8F3k%05zu header=X-Session-Secret",
+                          i % 16, i % 10000, i, i);
+        } else {
+            std::snprintf(line, sizeof(line),
+                          "[INFO] worker=%zu request served in %zums path=/api/v1/items/%zu status=200 bytes=%zu",
+                          i % 16, i % 97, i, 512 + i % 4096);
+        }
+        lines.emplace_back(line);
+    }
+    return lines;
+}
+
+// The copy every received line already gets, plus whatever `mask` does to it.
+template <typename Mask>
+double ns_per_line(const std::vector<std::string> &lines, std::size_t total, Mask &&mask, std::size_t &matches) {
+    std::string copy;
+    matches = 0;
+    const auto start = BenchClock::now();
+    for (std::size_t i = 0; i < total; ++i) {
+        copy = lines[i % lines.size()];
+        matches += mask(copy);
+    }
+    const double ns = std::chrono::duration<double, std::nano>(BenchClock::now() - start).count();
+    return ns / static_cast<double>(total);
+}
+
+void run(const char *label, const std::vector<std::string> &lines, std::size_t total, Redactor &redactor,
+         const std::vector<std::regex> &regexes) {
+    std::size_t matches = 0;
+    const double baseline = ns_per_line(lines, total, [](std::string &) { return std::size_t{0}; }, matches);
+    const double automaton = ns_per_line(
+        lines, total, [&redactor](std::string &line) { return redactor.redact(line.data(), line.size()); },
+        matches);
+    const std::size_t automaton_matches = matches;
+    // std::regex is slow enough that a tenth of the lines gives a stable figure.
+    const double per_pattern = ns_per_line(
+        lines, total / 10,
+        [&regexes](std::string &line) {
+            std::size_t found = 0;
+            for (const std::regex &regex : regexes) {
+                for (auto it = std::sregex_iterator(line.begin(), line.end(), regex); it != std::sregex_iterator();
+                     ++it) {
+                    std::memset(line.data() + it->position(), '*', static_cast<std::size_t>(it->length()));
+                    ++found;
+                }
+            }
+            return found;
+        },
+        matches);
+
+    std::printf("%s\n", label);
+    std::printf("  %-28s %10.1f ns/line\n", "copy only", baseline);
+    std::printf("  %-28s %10.1f ns/line  (+%.1f ns, %zu matches)\n", "redactor", automaton, automaton - baseline,
+                automaton_matches);
+    std::printf("  %-28s %10.1f ns/line  (+%.1f ns)\n", "std::regex per pattern", per_pattern,
+                per_pattern - baseline);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    std::size_t lines = 2000000;
+    if (argc > 1) {
+        lines = static_cast<std::size_t>(std::strtoull(argv[1], nullptr, 10));
+        if (lines == 0) {
+            lines = 2000000;
+        }
+    }
+
+    Redactor redactor;
+    std::string error;
+    if (!redactor.compile(bench_rules(), error)) {
+        std::fprintf(stderr, "rules: %s\n", error.c_str());
+        return EXIT_FAILURE;
+    }
+    std::vector<std::regex> regexes;
+    for (const RedactionRule &rule : bench_rules()) {
+        regexes.emplace_back(rule.pattern, std::regex::optimize);
+    }
+
+    std::printf("Redaction over %zu lines, %zu rules, %zu automaton states\n", lines, bench_rules().size(),
+                redactor.automaton_states());
+    run("clean lines", corpus(0), lines, redactor, regexes);
+    run("1 in 20 lines with secrets", corpus(20), lines, redactor, regexes);
+    run("every line with secrets", corpus(1), lines, redactor, regexes);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,125 @@
+/*
+ * Sequence: SEQ0147
+ * Track: C++
+ * MVP: Step D
+ * Change: Measure ingest throughput and STATS latency while a 10 kHz stats poller and a query scanner run.
+ * Tests: logcrafter_cpp_bench_stats (manual)
+ */
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+
+#include "log_buffer.hpp"
+#include "query_parser.hpp"
+
+namespace {
+
+using logcrafter::cpp::LogBuffer;
+using logcrafter::cpp::QueryRequest;
+using BenchClock = std::chrono::steady_clock;
+
+constexpr std::size_t kCapacity = 100000;
+
+struct PollResult {
+    unsigned long polls = 0;
+    double max_ns = 0.0;
+};
+
+double ingest(LogBuffer &buffer, std::size_t lines) {
+    const std::string message = "2024-05-01 worker=7 level=INFO request served in 12ms path=/api/v1/items";
+    const auto start = BenchClock::now();
+    for (std::size_t i = 0; i < lines; ++i) {
+        buffer.push_with_time(message, static_cast<std::time_t>(1714564800 + i / 1000));
+    }
+    const double seconds = std::chrono::duration<double>(BenchClock::now() - start).count();
+    return static_cast<double>(lines) / seconds;
+}
+
+// Polls stats() every `period` (0 = as fast as possible) until `stop` is set.
+void poll_stats(const LogBuffer &buffer, std::chrono::nanoseconds period, std::atomic<bool> &stop,
+                PollResult &result) {
+    auto next = BenchClock::now();
+    unsigned long sink = 0;
+    while (!stop.load(std::memory_order_relaxed)) {
+        const auto before = BenchClock::now();
+        sink += buffer.stats().total_logs;
+        const double ns = std::chrono::duration<double, std::nano>(BenchClock::now() - before).count();
+        result.max_ns = std::max(result.max_ns, ns);
+        ++result.polls;
+        if (period.count() > 0) {
+            next += period;
+            std::this_thread::sleep_until(next);
+        }
+    }
+    if (sink == 0) {
+        result.polls = 0;
+    }
+}
+
+void scan_queries(const LogBuffer &buffer, std::atomic<bool> &stop) {
+    QueryRequest request;
+    request.keyword = "does-not-match";
+    while (!stop.load(std::memory_order_relaxed)) {
+        const auto results = buffer.execute_query(request);
+        if (!results.empty()) {
+            break;
+        }
+    }
+}
+
+double run_ingest(const char *label, std::size_t lines, std::chrono::nanoseconds period, bool poll, bool scan) {
+    LogBuffer buffer;
+    buffer.configure(kCapacity);
+    ingest(buffer, kCapacity);
+
+    std::atomic<bool> stop(false);
+    PollResult polled;
+    std::thread poller;
+    std::thread scanner;
+    if (poll) {
+        poller = std::thread(poll_stats, std::cref(buffer), period, std::ref(stop), std::ref(polled));
+    }
+    if (scan) {
+        scanner = std::thread(scan_queries, std::cref(buffer), std::ref(stop));
+    }
+    const double rate = ingest(buffer, lines);
+    stop.store(true, std::memory_order_relaxed);
+    if (poller.joinable()) {
+        poller.join();
+    }
+    if (scanner.joinable()) {
+        scanner.join();
+    }
+
+    std::printf("%-34s %12.0f lines/s", label, rate);
+    if (poll) {
+        std::printf("  polls=%lu max_stats=%.0f ns", polled.polls, polled.max_ns);
+    }
+    std::printf("\n");
+    return rate;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    std::size_t lines = 2000000;
+    if (argc > 1) {
+        lines = static_cast<std::size_t>(std::strtoull(argv[1], nullptr, 10));
+        if (lines == 0) {
+            lines = 2000000;
+        }
+    }
+
+    std::printf("LogBuffer ingest over %zu lines (capacity %zu)\n", lines, kCapacity);
+    const double baseline = run_ingest("no poller", lines, std::chrono::nanoseconds(0), false, false);
+    const double paced = run_ingest("stats() at 10 kHz", lines, std::chrono::microseconds(100), true, false);
+    run_ingest("stats() tight loop", lines, std::chrono::nanoseconds(0), true, false);
+    run_ingest("stats() at 10 kHz + query scans", lines, std::chrono::microseconds(100), true, true);
+
+    std::printf("10 kHz poller ingest ratio: %.3f\n", paced / baseline);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,105 @@
+/*
+ * Sequence: SEQ0270
+ * Track: C++
+ * MVP: Step D
+ * Change: Declare ingest-time alert rules with sliding-window thresholds.
+ * Tests: spec_alert_rules
+ */
+#ifndef LOGCRAFTER_CPP_ALERT_ENGINE_HPP
+#define LOGCRAFTER_CPP_ALERT_ENGINE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <ctime>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "query_parser.hpp"
+
+namespace logcrafter::cpp {
+
+struct AlertStats {
+    std::size_t rules;
+    // Lines that matched some rule, and alerts raised for them.
+    unsigned long matched;
+    unsigned long fired;
+};
+
+// Rules come from a file, one per line; blank lines and lines starting with '#' are skipped:
+//
+//   <name> window=<seconds> count=<n>|rate=<per second> notify=<#channel>|log=<path> <QUERY filters>
+//
+// The filters (keyword=, keywords=, operator=, regex=, stream=) are parsed once with the QUERY
+// parser and checked against each stored line with the same matcher. Each rule counts its
+// matches in one bucket per second of arrival time, with a running sum over the window, so a
+// line costs one increment plus clearing the buckets of seconds that have passed. A rule fires
+// once when the sum reaches its threshold and is re-armed when the sum drops back below it.
+class AlertEngine {
+public:
+    // Delivers an alert to an IRC channel; only called for rules with notify=.
+    using Notify = std::function<void(const std::string &channel, const std::string &text)>;
+
+    static constexpr std::int64_t kMaxWindowSeconds = 3600;
+
+    AlertEngine();
+    ~AlertEngine();
+
+    AlertEngine(const AlertEngine &) = delete;
+    AlertEngine &operator=(const AlertEngine &) = delete;
+
+    // Replaces the rules with those in `path` and opens their alert logs; on failure the engine
+    // is left empty and `error` names the offending line.
+    int load(const std::string &path, Notify notify, std::string &error);
+    void reset();
+    bool needs_irc() const;
+
+    void evaluate(std::string_view stream, const std::string &message, std::time_t timestamp);
+
+    // "ALERTS: <n>" and one "<name> count=<c> threshold=<t> window=<w>s fired=<f> state=ok|firing" per rule.
+    std::string describe() const;
+    AlertStats stats() const;
+
+private:
+    struct Rule {
+        std::string name;
+        QueryRequest filter;
+        std::int64_t window_seconds = 0;
+        unsigned long threshold = 0;
+        std::string channel;
+        std::string log_path;
+
+        // Guarded by state_mutex_: per-second counts, the second of the newest bucket, and
+        // their sum.
+        std::vector<std::uint32_t> buckets;
+        std::int64_t head = -1;
+        unsigned long sum = 0;
+        bool firing = false;
+        unsigned long fired = 0;
+    };
+
+    static bool parse_rule(std::string_view line, Rule &rule, std::string &error);
+    static void advance(Rule &rule, std::int64_t now);
+    void raise(const Rule &rule, unsigned long count, const std::string &message, std::time_t now);
+
+    std::vector<Rule> rules_;
+    Notify notify_;
+
+    mutable std::mutex state_mutex_;
+    // Bumped under state_mutex_ but read without it, so STATS never waits behind a match.
+    std::atomic<unsigned long> matched_;
+    std::atomic<unsigned long> fired_;
+
+    // Alert logs by path, shared by the rules that name them.
+    std::mutex log_mutex_;
+    std::map<std::string, std::FILE *> logs_;
+};
+
+} // namespace logcrafter::cpp
+
+#endif // LOGCRAFTER_CPP_ALERT_ENGINE_HPP
@@ -0,0 +1,74 @@
+/*
+ * Sequence: SEQ0119
+ * Track: C++
+ * MVP: Step D
+ * Change: Declare the coarse clock service that publishes cached seconds, milliseconds, and formatted timestamps.
+ * Tests: spec_protocol_happy_path, integration_cpp_irc_feature, smoke_persistence_toggle
+ */
+#ifndef LOGCRAFTER_CPP_CLOCK_SERVICE_HPP
+#define LOGCRAFTER_CPP_CLOCK_SERVICE_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <mutex>
+#include <thread>
+
+namespace logcrafter::cpp {
+
+// Process-wide wall clock for hot paths. While started, a ticker thread refreshes the
+// published values so readers pay one atomic load instead of a time()/vDSO call; when it
+// is not running, reads fall back to CLOCK_REALTIME_COARSE.
+class ClockService {
+public:
+    static constexpr std::chrono::milliseconds kDefaultTick{1};
+    // Length of "YYYY-MM-DD HH:MM:SS" without the terminator.
+    static constexpr std::size_t kTimestampLength = 19;
+
+    static ClockService &instance();
+
+    ~ClockService();
+
+    ClockService(const ClockService &) = delete;
+    ClockService &operator=(const ClockService &) = delete;
+
+    // Reference counted so several servers (or a benchmark) can share the ticker.
+    int start(std::chrono::milliseconds tick = kDefaultTick);
+    void stop();
+    bool running() const { return running_.load(std::memory_order_acquire); }
+
+    std::time_t now_seconds() const;
+    std::int64_t now_millis() const;
+
+    // Writes the local-time text for `timestamp` plus a terminator and returns its length
+    // (0 when capacity is too small). The current second is served from the published copy;
+    // other seconds reuse a per-thread cache of the enclosing minute.
+    std::size_t format_timestamp(std::time_t timestamp, char *buffer, std::size_t capacity) const;
+
+private:
+    ClockService();
+
+    void ticker_loop(std::chrono::milliseconds tick);
+    void publish(std::int64_t millis);
+    bool copy_published(std::time_t timestamp, char *out) const;
+
+    std::atomic<bool> running_;
+    std::atomic<std::int64_t> millis_;
+    std::atomic<std::int64_t> seconds_;
+
+    // Seqlock guarding the formatted text of `text_second_`; the text is stored as relaxed
+    // atomic words so readers never race with the ticker.
+    std::atomic<std::uint64_t> text_sequence_;
+    std::atomic<std::int64_t> text_second_;
+    std::atomic<std::uint64_t> text_words_[3];
+
+    std::mutex lifecycle_mutex_;
+    std::size_t users_;
+    std::thread ticker_;
+};
+
+} // namespace logcrafter::cpp
+
+#endif // LOGCRAFTER_CPP_CLOCK_SERVICE_HPP
@@ -0,0 +1,65 @@
+/*
+ * Sequence: SEQ0229
+ * Track: C++
+ * MVP: Step D
+ * Change: Declare the chunked deflate writer for compressed query responses.
+ * Tests: spec_compressed_query
+ */
+#ifndef LOGCRAFTER_CPP_COMPRESSED_RESPONSE_WRITER_HPP
+#define LOGCRAFTER_CPP_COMPRESSED_RESPONSE_WRITER_HPP
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace logcrafter::cpp {
+
+// Same interface as ResponseWriter, but the response goes out as one zlib stream (level 1).
+// Appended text is copied into a 64 KiB staging buffer that is deflated whenever it fills, and
+// compressed output is sent in chunks of the same size, so memory stays fixed no matter how
+// large the response is. Every chunk but the last is sent with MSG_MORE.
+class CompressedResponseWriter {
+public:
+    static constexpr std::size_t kChunkBytes = 64 * 1024;
+
+    // False when the build has no zlib.
+    static bool available();
+
+    explicit CompressedResponseWriter(int fd);
+    ~CompressedResponseWriter();
+
+    CompressedResponseWriter(const CompressedResponseWriter &) = delete;
+    CompressedResponseWriter &operator=(const CompressedResponseWriter &) = delete;
+
+    void append(std::string_view text);
+    void append_line(std::string_view line);
+    // Ends the stream and sends what is left. Returns false once any step has failed.
+    bool finish();
+
+    bool failed() const { return failed_; }
+    std::size_t raw_bytes() const { return raw_bytes_; }
+    std::size_t bytes_sent() const { return bytes_sent_; }
+    // Thread CPU time spent deflating, in microseconds.
+    unsigned long long cpu_micros() const { return cpu_micros_; }
+
+private:
+    struct Stream;
+
+    void deflate_staging(bool final);
+    void send_output(bool more);
+
+    int fd_;
+    std::unique_ptr<Stream> stream_;
+    std::string staging_;
+    std::string output_;
+    std::size_t output_used_;
+    std::size_t raw_bytes_;
+    std::size_t bytes_sent_;
+    unsigned long long cpu_micros_;
+    bool failed_;
+};
+
+} // namespace logcrafter::cpp
+
+#endif // LOGCRAFTER_CPP_COMPRESSED_RESPONSE_WRITER_HPP
@@ -0,0 +1,111 @@
+/*
+ * Sequence: SEQ0209
+ * Track: C++
+ * MVP: Step D
+ * Change: Declare the scatter-gather client that sends one QUERY to every peer over pooled connections.
+ * Tests: spec_federated_query
+ */
+#ifndef LOGCRAFTER_CPP_FEDERATION_HPP
+#define LOGCRAFTER_CPP_FEDERATION_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace logcrafter::cpp {
+
+struct PeerAddress {
+    std::string host;
+    // The peer's query port.
+    int port;
+};
+
+struct PeerReply {
+    enum class Status {
+        Answered,
+        // The peer answered with an ERROR line (e.g. an unknown stream).
+        Rejected,
+        TimedOut,
+        Unreachable,
+    };
+
+    Status status = Status::Unreachable;
+    std::string error;
+    // Raw result lines; `lines` views into it.
+    std::string body;
+    std::vector<std::string_view> lines;
+};
+
+struct FederationStats {
+    unsigned long requests;
+    unsigned long timeouts;
+    unsigned long failures;
+    unsigned long reused;
+};
+
+// Peers are other LogCrafter query ports. A connection opens with `PEER`, after which the
+// peer answers any number of QUERY lines, one response each (`FOUND: n` plus n lines, or
+// one ERROR line). Connections that finish an exchange cleanly go back to a small per-peer
+// pool, so a steady query load reuses them instead of paying a handshake per request. One
+// scatter() runs every exchange from the calling thread with non-blocking sockets and a
+// single poll() loop under a shared deadline; peers still busy at the deadline are dropped
+// from the answer and their connections closed.
+class FederationClient {
+public:
+    static constexpr int kDefaultTimeoutMs = 2000;
+    static constexpr std::size_t kMaxIdlePerPeer = 4;
+    static constexpr std::size_t kMaxReplyBytes = 64 * 1024 * 1024;
+
+    FederationClient();
+    ~FederationClient();
+
+    FederationClient(const FederationClient &) = delete;
+    FederationClient &operator=(const FederationClient &) = delete;
+
+    void configure(const std::vector<PeerAddress> &peers, int timeout_ms);
+    // Closes pooled connections and forgets the peers.
+    void reset();
+
+    std::size_t peer_count() const { return peers_.size(); }
+    const std::string &label(std::size_t peer) const { return peers_[peer]->label; }
+
+    // Sends `request_line` (without newline) to every peer, runs `while_waiting` once the
+    // requests are on their way, then collects replies until all are in or the timeout hits.
+    void scatter(std::string_view request_line, const std::function<void()> &while_waiting,
+                 std::vector<PeerReply> &replies) const;
+
+    FederationStats stats() const;
+
+private:
+    struct Peer {
+        PeerAddress address;
+        std::string label;
+        std::mutex mutex;
+        std::vector<int> idle;
+    };
+
+    struct Exchange;
+
+    int checkout(Peer &peer) const;
+    void checkin(Peer &peer, int fd) const;
+    bool start_fresh(Exchange &exchange, std::string_view request_line) const;
+    bool advance(Exchange &exchange, short revents) const;
+    bool parse(Exchange &exchange) const;
+
+    std::vector<std::unique_ptr<Peer>> peers_;
+    int timeout_ms_;
+
+    mutable std::atomic<unsigned long> requests_;
+    mutable std::atomic<unsigned long> timeouts_;
+    mutable std::atomic<unsigned long> failures_;
+    mutable std::atomic<unsigned long> reused_;
+};
+
+} // namespace logcrafter::cpp
+
+#endif // LOGCRAFTER_CPP_FEDERATION_HPP
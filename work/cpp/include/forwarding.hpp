@@ -0,0 +1,140 @@
+/*
+ * Sequence: SEQ0198
+ * Track: C++
+ * MVP: Step D
+ * Change: Declare the relay forwarding sink that spools entries to disk and ships acknowledged batches upstream.
+ * Tests: spec_relay_forwarding
+ */
+#ifndef LOGCRAFTER_CPP_FORWARDING_HPP
+#define LOGCRAFTER_CPP_FORWARDING_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <ctime>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+
+namespace logcrafter::cpp {
+
+struct ForwardingConfig {
+    std::string upstream_host;
+    int upstream_port;
+    std::string spool_directory;
+    // Identifies this relay upstream; together with the spool epoch it scopes batch dedupe.
+    std::string relay_name;
+    bool compress;
+    std::size_t batch_records;
+};
+
+struct ForwardingStats {
+    bool connected;
+    unsigned long spooled_records;
+    unsigned long acked_records;
+    unsigned long acked_batches;
+    unsigned long reconnects;
+    unsigned long spool_failures;
+    unsigned long long backlog_bytes;
+    unsigned long long wire_bytes;
+};
+
+// Every stored entry is appended to a segmented spool on disk by a writer thread; a sender
+// thread reads the spool from its acknowledged cursor and ships relay frames upstream, one
+// batch in flight at a time. The spool absorbs upstream outages: after a reconnect the
+// sender drains the backlog back to back at batch size. The cursor (segment, offset, next
+// batch sequence) is saved after every ack, so a restarted relay resumes where it stopped
+// and a batch resent after a lost ack is discarded upstream by its sequence number.
+class ForwardingManager {
+public:
+    static constexpr const char *kDefaultSpoolDirectory = "./relay-spool";
+    static constexpr std::size_t kDefaultBatchRecords = 512;
+    static constexpr std::size_t kSegmentBytes = 4 * 1024 * 1024;
+
+    ForwardingManager();
+    ~ForwardingManager();
+
+    ForwardingManager(const ForwardingManager &) = delete;
+    ForwardingManager &operator=(const ForwardingManager &) = delete;
+
+    int init(const ForwardingConfig &config);
+    // Flushes queued entries to the spool; unsent spool contents stay on disk for the next run.
+    void shutdown();
+    bool enabled() const { return running_; }
+
+    bool enqueue(std::string_view stream, const std::string &message, std::time_t timestamp);
+    ForwardingStats stats() const;
+
+private:
+    struct Entry {
+        std::time_t timestamp;
+        std::string stream;
+        std::string message;
+    };
+
+    struct Cursor {
+        unsigned long long segment;
+        unsigned long long offset;
+        std::uint64_t next_sequence;
+    };
+
+    void spool_loop();
+    void send_loop();
+    bool open_write_segment();
+    bool load_cursor();
+    bool save_cursor() const;
+    std::string segment_path(unsigned long long segment) const;
+
+    bool connect_upstream();
+    void disconnect_upstream();
+    bool read_batch(std::string &payload, std::size_t &records, Cursor &after);
+    bool send_batch(const std::string &payload, std::uint64_t sequence);
+    void wait_for_spool(const Cursor &cursor);
+    void backoff(int &delay_ms);
+
+    ForwardingConfig config_;
+    std::uint64_t epoch_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable spool_condition_;
+    std::condition_variable send_condition_;
+    std::deque<Entry> queue_;
+    bool stop_;
+    bool running_;
+    std::thread spool_worker_;
+    std::thread sender_;
+    // Spool end visible to the sender; written by the spool worker under mutex_.
+    unsigned long long published_segment_;
+    unsigned long long published_offset_;
+
+    // Spool worker state.
+    std::FILE *write_file_;
+    unsigned long long write_segment_;
+    unsigned long long write_offset_;
+    std::string encode_scratch_;
+
+    // Sender state.
+    Cursor cursor_;
+    int read_fd_;
+    unsigned long long read_segment_;
+    std::string wire_scratch_;
+    // Written by the sender under mutex_ so shutdown() can interrupt a blocked send or ack wait.
+    int upstream_fd_;
+
+    std::atomic<bool> connected_;
+    std::atomic<unsigned long> spooled_records_;
+    std::atomic<unsigned long> acked_records_;
+    std::atomic<unsigned long> acked_batches_;
+    std::atomic<unsigned long> reconnects_;
+    std::atomic<unsigned long> spool_failures_;
+    std::atomic<unsigned long long> backlog_bytes_;
+    std::atomic<unsigned long long> wire_bytes_;
+};
+
+} // namespace logcrafter::cpp
+
+#endif // LOGCRAFTER_CPP_FORWARDING_HPP
@@ -0,0 +1,143 @@
+/*
+ * Sequence: SEQ0333
+ * Track: C++
+ * MVP: Step D
+ * Change: Declare the staged ingest pipeline (enrich, store, persist, fan-out) and its per-stage counters.
+ * Tests: spec_ingest_pipeline
+ */
+#ifndef LOGCRAFTER_CPP_INGEST_PIPELINE_HPP
+#define LOGCRAFTER_CPP_INGEST_PIPELINE_HPP
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <ctime>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "result_codec.hpp"
+#include "spsc_queue.hpp"
+
+namespace logcrafter::cpp {
+
+// One received line on its way from the ingest scheduler to its last consumer.
+struct PipelineEntry {
+    // The stream the line is stored in; also picks the worker of every threaded stage.
+    std::size_t stream = 0;
+    std::string message;
+    std::time_t timestamp = 0;
+    std::string source;
+    // Filled in by the enrich stage.
+    result_codec::Level level = result_codec::Level::Unknown;
+};
+
+enum class PipelineStage : std::size_t {
+    // Level classification, done once for every later consumer.
+    Enrich,
+    // Ring buffer, rollups, and alert rules: what queries see.
+    Store,
+    // Hand-off to the persistence, relay, and replication writers.
+    Persist,
+    // IRC channels and the console echo.
+    Fanout,
+};
+
+constexpr std::size_t kPipelineStages = 4;
+
+struct PipelineConfig {
+    // Threads per stage, indexed by PipelineStage; 0 runs the stage on whichever thread finished
+    // the stage before it (the ingest drain for Enrich).
+    std::array<std::size_t, kPipelineStages> threads;
+    // Slots in each queue feeding a threaded stage.
+    std::size_t queue_capacity;
+};
+
+struct PipelineStageStats {
+    std::size_t threads;
+    unsigned long processed;
+    // Entries waiting in the stage's queues.
+    std::size_t queued;
+    // Hand-offs that found the stage's queue full and had to wait.
+    unsigned long stalls;
+};
+
+// The stages every stored line passes through, in order. Received lines still arrive through
+// IngestScheduler, whose single drain thread is the pipeline's only producer. A stage with
+// threads gets one bounded SpscQueue per (upstream thread, worker) pair; an entry goes to worker
+// `stream % threads`, so each stream's entries keep their order through every stage while
+// different streams proceed in parallel. A full queue blocks the upstream thread, and that
+// backpressure reaches producers through the scheduler's queues as before.
+class IngestPipeline {
+public:
+    using Handler = std::function<void(PipelineEntry &entry)>;
+
+    static constexpr std::size_t kMaxStageThreads = 8;
+    static constexpr std::size_t kDefaultQueueCapacity = 1024;
+    static constexpr std::size_t kMaxQueueCapacity = 65536;
+    static constexpr std::array<std::string_view, kPipelineStages> kStageNames{"enrich", "store", "persist",
+                                                                                "fanout"};
+
+    IngestPipeline();
+    ~IngestPipeline();
+
+    IngestPipeline(const IngestPipeline &) = delete;
+    IngestPipeline &operator=(const IngestPipeline &) = delete;
+
+    void start(const PipelineConfig &config, std::array<Handler, kPipelineStages> handlers);
+    // Lets every queued entry finish its remaining stages, then joins the stage threads. Call once
+    // nothing submits any more.
+    void stop();
+
+    // From the ingest drain only (one thread at a time).
+    void submit(PipelineEntry &&entry);
+    // Runs every stage on the calling thread, bypassing the queues.
+    void run_inline(PipelineEntry &entry);
+
+    bool threaded() const { return threaded_; }
+    // Entries waiting in any stage queue.
+    std::size_t queued() const;
+    std::array<PipelineStageStats, kPipelineStages> stats() const;
+
+    // "store=2,fanout=1": stage names as in kStageNames, 0-kMaxStageThreads each; unnamed stages stay at 0.
+    static bool parse_threads(std::string_view text, std::array<std::size_t, kPipelineStages> &threads,
+                              std::string &error);
+
+private:
+    using Queue = SpscQueue<PipelineEntry>;
+
+    struct Worker {
+        // One per upstream thread, indexed by its lane.
+        std::vector<std::unique_ptr<Queue>> inputs;
+        std::thread thread;
+        std::mutex mutex;
+        std::condition_variable wake;
+        std::atomic<bool> sleeping{false};
+    };
+
+    struct Stage {
+        Handler handler;
+        std::vector<std::unique_ptr<Worker>> workers;
+        std::atomic<bool> stopping{false};
+        std::atomic<unsigned long> processed{0};
+        std::atomic<unsigned long> stalls{0};
+    };
+
+    // Runs stages from `first` inline until one has threads, then queues the entry for it. `lane`
+    // is the calling thread's index within the last threaded stage (0 for the ingest drain).
+    void advance(std::size_t first, std::size_t lane, PipelineEntry &entry);
+    void push(Stage &stage, Worker &worker, std::size_t lane, PipelineEntry &entry);
+    void worker_loop(std::size_t stage_index, std::size_t lane);
+
+    std::array<Stage, kPipelineStages> stages_;
+    bool threaded_;
+};
+
+} // namespace logcrafter::cpp
+
+#endif // LOGCRAFTER_CPP_INGEST_PIPELINE_HPP
@@ -0,0 +1,162 @@
+/*
+ * Sequence: SEQ0335
+ * Track: C++
+ * MVP: Step D
+ * Change: Let the sink move the drained message into the ingest pipeline.
+ * Tests: spec_ingest_pipeline, spec_source_quotas
+ */
+#ifndef LOGCRAFTER_CPP_INGEST_SCHEDULER_HPP
+#define LOGCRAFTER_CPP_INGEST_SCHEDULER_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "repeat_collapser.hpp"
+#include "seqlock_text.hpp"
+
+namespace logcrafter::cpp {
+
+enum class QuotaAction {
+    Drop,
+    Defer,
+};
+
+struct IngestConfig {
+    // Bytes credited to a session per round; at least one maximal line so every backlogged
+    // session makes progress each round.
+    std::size_t quantum_bytes;
+    // Lines a session may have waiting for the store before its producer blocks.
+    std::size_t queue_depth;
+    // Sustained lines per second per source; 0 disables quotas.
+    double source_rate;
+    std::size_t source_burst;
+    QuotaAction quota_action;
+    // Consecutive repeats from one source are folded into a summary entry per run.
+    RepeatMode repeat_mode;
+    std::int64_t repeat_window_ms;
+};
+
+struct IngestStats {
+    std::size_t sessions;
+    std::size_t backlogged_sessions;
+    std::size_t pending_lines;
+    unsigned long rounds;
+    unsigned long queue_waits;
+    unsigned long quota_dropped;
+    unsigned long quota_deferred;
+    // Repeats absorbed into runs, and summary entries emitted for them.
+    unsigned long collapsed_lines;
+    unsigned long collapsed_runs;
+    // "name=accepted/dropped/deferred, ..." for the sources with the most dropped+deferred
+    // lines, then the most accepted; refreshed at most every kTopSourcesRefreshMs.
+    std::string top_sources;
+};
+
+// Producer sessions hand lines to the scheduler instead of writing the store directly.
+// Whichever producer thread wins the drain lock serves every backlogged session in
+// deficit round-robin order, so a session pushing a flood of lines gets the same byte share
+// per round as a quiet one and, once its queue is full, is throttled by TCP backpressure.
+class IngestScheduler {
+public:
+    // `route` is whatever the session was tagged with via set_route() (0 by default); `source` is
+    // the name the session had when the line was submitted. The sink may move from `message`.
+    using Sink = std::function<void(std::string &message, std::time_t timestamp, std::size_t route,
+                                    const std::string &source)>;
+
+    class Session;
+    using SessionHandle = std::shared_ptr<Session>;
+
+    enum class Admission {
+        Queued,
+        Dropped,
+        Collapsed,
+    };
+
+    static constexpr std::size_t kDefaultQuantumBytes = 2048;
+    static constexpr std::size_t kDefaultQueueDepth = 256;
+    static constexpr std::size_t kMaxTrackedSources = 256;
+    static constexpr std::size_t kTopSources = 3;
+    static constexpr std::int64_t kTopSourcesRefreshMs = 100;
+
+    IngestScheduler();
+
+    void configure(const IngestConfig &config, Sink sink);
+    void reset();
+
+    SessionHandle open_session(const std::string &source);
+    // Rebinds the session to a declared source name (the first `SOURCE <name>` line).
+    void rename_session(const SessionHandle &session, const std::string &source);
+    // Tags lines the session submits from now on; the sink uses it to pick a destination.
+    void set_route(const SessionHandle &session, std::size_t route);
+    // Flushes anything the session still has queued (and, for a source's last session, its
+    // open repeat run), then forgets it.
+    void close_session(const SessionHandle &session);
+
+    Admission submit(const SessionHandle &session, std::string message, std::time_t timestamp);
+    // Never blocks: counters are relaxed atomics and the top-source list is a seqlock-published
+    // text that a caller refreshes only when it is stale and the source table is uncontended.
+    IngestStats stats() const;
+    // Lines queued or on their way to the sink; one relaxed load, for per-line overload checks.
+    std::size_t backlog() const { return pending_.load(std::memory_order_relaxed); }
+
+private:
+    struct Source;
+    struct Pending {
+        std::string message;
+        std::time_t timestamp;
+        std::size_t route;
+        // Held until the line reaches the sink, which may be after the session was renamed or closed.
+        std::shared_ptr<Source> source;
+    };
+
+    std::shared_ptr<Source> acquire_source_locked(const std::string &name);
+    void release_source_locked(const std::shared_ptr<Source> &source);
+    bool take_quota(Source &source, bool &deferred);
+    void enqueue_locked(std::unique_lock<std::mutex> &lock, Session &session, Pending pending);
+    void finish_submit();
+    void drain();
+    bool serve_round(std::vector<Pending> &batch);
+    void refresh_top_sources() const;
+
+    IngestConfig config_;
+    Sink sink_;
+
+    // Guards the session queues and the round-robin list.
+    std::mutex mutex_;
+    std::condition_variable space_available_;
+    std::deque<Session *> active_;
+
+    // Guards the source table; only touched on connect, SOURCE, disconnect, and stats refresh.
+    mutable std::mutex sources_mutex_;
+    std::unordered_map<std::string, std::shared_ptr<Source>> sources_;
+    mutable SeqlockText<320> top_sources_;
+    mutable std::atomic<std::int64_t> top_sources_refreshed_ms_;
+
+    std::atomic<std::size_t> sessions_;
+    std::atomic<std::size_t> backlogged_;
+    std::atomic<std::size_t> pending_lines_;
+    std::atomic<unsigned long> rounds_;
+    std::atomic<unsigned long> queue_waits_;
+
+    std::mutex drain_mutex_;
+    std::atomic<std::size_t> pending_;
+    std::atomic<std::size_t> submitters_;
+    std::atomic<unsigned long> quota_dropped_;
+    std::atomic<unsigned long> quota_deferred_;
+    std::atomic<unsigned long> collapsed_lines_;
+    std::atomic<unsigned long> collapsed_runs_;
+};
+
+} // namespace logcrafter::cpp
+
+#endif // LOGCRAFTER_CPP_INGEST_SCHEDULER_HPP
@@ -1,9 +1,9 @@
 /*
- * Sequence: SEQ0071
+ * Sequence: SEQ0272
  * Track: C++
- * MVP: mvp6
- * Change: Add command handler wiring, configurable server identity, and channel statistics helpers.
- * Tests: smoke_cpp_mvp6_irc
+ * MVP: Step D
+ * Change: Declare notice_channel() for alert notifications.
+ * Tests: spec_alert_rules
  */
 #ifndef LOGCRAFTER_CPP_IRC_SERVER_HPP
 #define LOGCRAFTER_CPP_IRC_SERVER_HPP
@@ -22,6 +22,7 @@
 #include "irc_channel_manager.hpp"
 #include "irc_command_parser.hpp"
 #include "irc_command_handler.hpp"
+#include "seqlock_text.hpp"
 
 namespace logcrafter::cpp {
 
@@ -39,8 +40,15 @@ public:
     void set_command_context(LogBuffer &buffer, IRCCommandHandler::StatsCallback stats_callback);
 
     void publish_log(const std::string &message, std::time_t timestamp);
+    // Sends `:<server> NOTICE <channel> :<text>` to every registered member of the channel.
+    void notice_channel(const std::string &channel, const std::string &text);
     std::size_t active_clients() const;
     std::vector<IRCChannelManager::ChannelStats> channel_stats() const;
+    // Lock-free views refreshed whenever membership changes, for STATS pollers.
+    std::size_t channel_count() const;
+    std::string channel_preview() const;
+
+    static constexpr std::size_t kChannelPreviewCount = 3;
 
 private:
     struct IRCClient {
@@ -63,6 +71,8 @@ private:
     bool handle_client_input(int client_fd);
     std::vector<std::string> drain_client_lines(IRCClient &client);
     std::vector<PendingSend> process_command(int client_fd, const IRCCommand &command, bool &client_closed);
+    std::vector<PendingSend> process_command_locked(int client_fd, const IRCCommand &command, bool &client_closed);
+    void publish_channel_stats_locked();
     std::vector<PendingSend> register_client(IRCClient &client);
     std::vector<PendingSend> handle_join(IRCClient &client, const IRCCommand &command);
     std::vector<PendingSend> handle_part(IRCClient &client, const IRCCommand &command);
@@ -90,6 +100,8 @@ private:
     std::unique_ptr<IRCCommandHandler> command_handler_;
     std::vector<std::string> auto_join_channels_;
     std::atomic<std::size_t> active_clients_;
+    std::atomic<std::size_t> channel_count_;
+    SeqlockText<256> channel_preview_;
 };
 
 } // namespace logcrafter::cpp
@@ -1,23 +1,43 @@
 /*
- * Sequence: SEQ0073
+ * Sequence: SEQ0343
  * Track: C++
- * MVP: mvp6
- * Change: Extend the server facade with IRC command wiring, server-name overrides, and channel statistics helpers.
- * Tests: smoke_cpp_mvp6_irc
+ * MVP: Step D
+ * Change: Hold the ingest redactor and its rule file path.
+ * Tests: spec_redaction
  */
 #ifndef LOGCRAFTER_CPP_LC_SERVER_HPP
 #define LOGCRAFTER_CPP_LC_SERVER_HPP
 
 #include <atomic>
+#include <chrono>
 #include <cstddef>
+#include <cstdint>
+#include <ctime>
 #include <memory>
+#include <memory_resource>
+#include <mutex>
 #include <string>
+#include <string_view>
+#include <unordered_map>
 #include <vector>
 
+#include "alert_engine.hpp"
+#include "federation.hpp"
+#include "forwarding.hpp"
+#include "ingest_pipeline.hpp"
+#include "ingest_scheduler.hpp"
 #include "irc_server.hpp"
+#include "load_shedder.hpp"
 #include "log_buffer.hpp"
 #include "persistence.hpp"
+#include "prepared_queries.hpp"
 #include "query_parser.hpp"
+#include "redactor.hpp"
+#include "replica_client.hpp"
+#include "replication.hpp"
+#include "response_writer.hpp"
+#include "rollup_store.hpp"
+#include "stream_registry.hpp"
 #include "thread_pool.hpp"
 
 namespace logcrafter::cpp {
@@ -37,6 +57,41 @@ struct ServerConfig {
     int irc_port;
     std::string irc_server_name;
     std::vector<std::string> irc_auto_join;
+    bool client_timestamps;
+    std::size_t reorder_window;
+    // Split each stream's capacity into severe/info/debug rings with these percentages.
+    LevelShares level_shares;
+    // Per-source token bucket (lines/sec, 0 = unlimited); sources are peer addresses or a
+    // name declared with a leading `SOURCE <name>` line.
+    double source_rate;
+    std::size_t source_burst;
+    QuotaAction quota_action;
+    // Consecutive repeats per source within the window become one "(repeated N times)" entry.
+    RepeatMode repeat_mode;
+    std::int64_t repeat_window_ms;
+    // Streams created at startup with their own capacity; producers select one with a leading
+    // `STREAM <name>` line, and undeclared names are created on demand with buffer_capacity.
+    std::vector<StreamDeclaration> streams;
+    // Forward every stored entry to an upstream LogCrafter's log port through a disk spool.
+    bool relay_enabled;
+    ForwardingConfig relay;
+    // Primary: log every stored entry under a sequence number for replicas to follow.
+    bool replication_enabled;
+    ReplicationConfig replication;
+    // Replica: follow a primary's log and refuse log connections of its own.
+    bool replica_enabled;
+    ReplicaConfig replica;
+    // Query ports answering `QUERY ... scope=cluster` together with this node.
+    std::vector<PeerAddress> peers;
+    int peer_timeout_ms;
+    // Alert rules checked against every stored line; see alert_engine.hpp for the file format.
+    std::string alert_rules_path;
+    // Patterns masked in every received line before it is stored; see redactor.hpp for the file format.
+    std::string redact_rules_path;
+    // Under overload, sample low-severity lines as they are received; an empty ladder keeps all.
+    SheddingConfig shedding;
+    // Threads per ingest stage after the scheduler; all zero runs every stage on the drain thread.
+    PipelineConfig pipeline;
 };
 
 ServerConfig default_config();
@@ -60,20 +115,81 @@ public:
     static constexpr std::size_t kDefaultPersistenceMaxFiles = 10;
     static constexpr int kDefaultIrcPort = 6667;
     static constexpr const char *kDefaultIrcServerName = "logcrafter";
+    static constexpr std::size_t kMaxPeerSessions = 64;
+    static constexpr std::size_t kMaxFetchWaiters = 256;
 
 private:
+    // What a worker does with a query connection once its request is answered.
+    enum class SessionAction {
+        Close,
+        // Wait in the accept loop's select() set for the next request (peers, FETCH consumers).
+        Park,
+        // A FETCH is waiting for new entries and the connection is held in fetch_waiters_.
+        Detached,
+    };
+
+    // A long-polling FETCH with nothing to return yet; `request.from` is already clamped to the log.
+    struct FetchWaiter {
+        int fd;
+        FetchRequest request;
+        std::chrono::steady_clock::time_point deadline;
+    };
+
     int create_listener(int port, int backlog);
-    void dispatch_log_client(int client_fd);
+    void dispatch_log_client(int client_fd, std::string peer);
     void dispatch_query_client(int client_fd);
-    void handle_log_client(int client_fd);
-    void handle_query_client(int client_fd);
-    void store_log(const std::string &message);
+    void dispatch_peer_request(int client_fd);
+    void park_peer_session(int client_fd);
+    void finish_session(int client_fd, SessionAction action);
+    void wake_accept_loop();
+    // Hands waiters whose entries arrived or whose wait ran out to workers; returns the time
+    // until the next deadline in ms, or -1 when nothing is waiting.
+    int dispatch_due_fetches();
+    void handle_log_client(int client_fd, const std::string &peer);
+    void handle_relay_client(int client_fd, const std::string &peer, const std::string &identity);
+    void apply_replicated(std::string_view stream, std::string message, std::time_t timestamp);
+    SessionAction handle_query_client(int client_fd);
+    SessionAction serve_peer_request(int client_fd);
+    std::time_t resolve_timestamp(std::string &line) const;
+    // The IngestPipeline stages, in order; `entry.source` names the producer for the rollups.
+    void enrich_entry(PipelineEntry &entry) const;
+    void store_entry(PipelineEntry &entry);
+    void persist_entry(PipelineEntry &entry);
+    void fanout_entry(PipelineEntry &entry);
     void send_help(int client_fd) const;
     void send_count(int client_fd) const;
     void send_stats(int client_fd) const;
-    void handle_query_command(int client_fd, const std::string &arguments) const;
-    void send_query_response(int client_fd, const QueryRequest &request) const;
-    void send_query_results(int client_fd, const std::vector<std::string> &results) const;
+    void handle_export_command(int client_fd, std::string_view arguments) const;
+    void handle_rollup_command(int client_fd, std::string_view arguments) const;
+    void send_alerts(int client_fd) const;
+    SessionAction handle_fetch_command(int client_fd, std::string_view arguments);
+    // Sends the batch at request.from, or with `may_wait` and nothing logged there yet, moves
+    // the connection to fetch_waiters_ until there is.
+    SessionAction send_fetch_batch(int client_fd, const FetchRequest &request, bool may_wait);
+    void handle_query_command(int client_fd, std::string_view arguments, bool from_peer,
+                              QueryRequest::Compression session_compression) const;
+    void handle_prepare_command(int client_fd, std::string_view arguments);
+    void handle_execute_command(int client_fd, std::string_view arguments,
+                                QueryRequest::Compression session_compression);
+    // Everything after parsing that QUERY and EXECUTE share; `arguments` is what peers are sent.
+    void answer_query(int client_fd, QueryRequest &request, std::string_view arguments, bool from_peer,
+                      QueryRequest::Compression session_compression, std::pmr::memory_resource *arena) const;
+    void send_query_response(int client_fd, const QueryRequest &request, std::string_view arguments,
+                             std::pmr::memory_resource *arena) const;
+    void send_cluster_response(int client_fd, const QueryRequest &request, std::string_view arguments,
+                               const std::pmr::vector<StreamRegistry::StreamId> &targets,
+                               std::pmr::memory_resource *arena) const;
+    // format=binary|ndjson: records straight from storage, without the text timestamp.
+    void send_record_response(int client_fd, const QueryRequest &request,
+                              const std::pmr::vector<StreamRegistry::StreamId> &targets,
+                              std::pmr::memory_resource *arena) const;
+    QueryResults collect_results(const QueryRequest &request, const std::pmr::vector<StreamRegistry::StreamId> &targets,
+                                 std::pmr::memory_resource *arena) const;
+    template <typename Writer>
+    void send_query_results(Writer &writer, const QueryResults &results) const;
+    // Runs `emit` against a plain or deflating writer and accounts compressed responses.
+    template <typename Emit>
+    void write_response(int client_fd, QueryRequest::Compression compression, Emit &&emit) const;
     void send_error(int client_fd, const std::string &message) const;
     std::string make_irc_stats_snapshot() const;
 
@@ -83,11 +199,47 @@ private:
     std::atomic<bool> running_;
 
     ThreadPool thread_pool_;
-    LogBuffer log_buffer_;
-    PersistenceManager persistence_;
+    StreamRegistry streams_;
+    IngestScheduler ingest_;
+    IngestPipeline pipeline_;
     bool persistence_enabled_;
+    ForwardingManager forwarder_;
+    bool relay_enabled_;
+    // Highest batch sequence applied per inbound relay ("<name> <epoch>").
+    std::mutex relay_mutex_;
+    std::unordered_map<std::string, std::uint64_t> relay_sequences_;
+    std::atomic<unsigned long> relay_inbound_records_;
+    std::atomic<unsigned long> relay_duplicate_batches_;
+    ReplicationSource replication_;
+    bool replication_enabled_;
+    ReplicaClient replica_;
+    bool replica_enabled_;
+    mutable std::atomic<unsigned long> compressed_queries_;
+    mutable std::atomic<unsigned long long> compress_raw_bytes_;
+    mutable std::atomic<unsigned long long> compress_wire_bytes_;
+    mutable std::atomic<unsigned long long> compress_cpu_micros_;
+    mutable std::atomic<unsigned long> exports_;
+    mutable std::atomic<unsigned long long> export_bytes_;
+    // Per-second and per-minute counts by level and source, saved next to the segments.
+    RollupStore rollups_;
+    AlertEngine alerts_;
+    Redactor redactor_;
+    PreparedQueries prepared_;
+    LoadShedder shedder_;
+    FederationClient federation_;
+    // Idle peer sessions wait in the accept loop's select() set rather than on a worker; a
+    // worker that finishes a peer request parks the connection and writes to the wake pipe.
+    std::mutex peer_sessions_mutex_;
+    std::vector<int> peer_sessions_;
+    // Waiting FETCHes are held the same way, under the same mutex; the replication writer wakes
+    // the loop after each batch while any are waiting.
+    std::vector<FetchWaiter> fetch_waiters_;
+    std::atomic<std::size_t> fetch_waiter_count_;
+    std::atomic<unsigned long> fetches_;
+    int wake_pipe_[2];
     std::unique_ptr<IRCServer> irc_server_;
     bool irc_enabled_;
+    bool clock_started_;
     std::atomic<int> active_log_clients_;
     std::atomic<int> active_query_clients_;
 };
@@ -0,0 +1,73 @@
+/*
+ * Sequence: SEQ0279
+ * Track: C++
+ * MVP: Step D
+ * Change: Declare the overload controller that samples low-severity lines by ingest backlog.
+ * Tests: spec_load_shedding
+ */
+#ifndef LOGCRAFTER_CPP_LOAD_SHEDDER_HPP
+#define LOGCRAFTER_CPP_LOAD_SHEDDER_HPP
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "result_codec.hpp"
+
+namespace logcrafter::cpp {
+
+// One rung of the ladder: once active, keep one line in `keep_one_in` of this level.
+struct ShedStep {
+    result_codec::Level level;
+    unsigned keep_one_in;
+};
+
+struct SheddingConfig {
+    // Applied in order as the backlog grows; empty disables shedding.
+    std::vector<ShedStep> ladder;
+    // Backlog (lines queued for the store) at which every rung is active.
+    std::size_t high_water;
+};
+
+struct SheddingStats {
+    std::size_t stage;
+    std::size_t stages;
+    // Lines sampled out, by result_codec::Level.
+    std::array<unsigned long, result_codec::kLevelCount> shed;
+};
+
+// Decides, before a received line is copied or parsed, whether to drop it. With n rungs, rung
+// i (1-based) is active while the ingest backlog is at least high_water * i / n, so DEBUG is
+// thinned first and INFO only as the backlog keeps growing. Error lines are never shed. Each
+// level keeps a deterministic one-in-N counter, so the kept share is exact and
+// downstream rates can be scaled back up from the Shed* counters.
+class LoadShedder {
+public:
+    static constexpr std::size_t kMaxSteps = 8;
+
+    LoadShedder();
+
+    void configure(const SheddingConfig &config);
+    bool enabled() const { return !config_.ladder.empty(); }
+
+    // True if `line` should be dropped at the current `backlog`.
+    bool shed(std::string_view line, std::size_t backlog);
+
+    SheddingStats stats() const;
+
+    // "debug:10,info:2": level names as in format=ndjson; error is refused.
+    static bool parse_ladder(std::string_view text, std::vector<ShedStep> &ladder, std::string &error);
+
+private:
+    SheddingConfig config_;
+    std::atomic<std::size_t> stage_;
+    std::array<std::atomic<unsigned long>, result_codec::kLevelCount> seen_;
+    std::array<std::atomic<unsigned long>, result_codec::kLevelCount> shed_;
+};
+
+} // namespace logcrafter::cpp
+
+#endif // LOGCRAFTER_CPP_LOAD_SHEDDER_HPP
@@ -1,60 +1,159 @@
 /*
- * Sequence: SEQ0051
+ * Sequence: SEQ0302
  * Track: C++
- * MVP: mvp4
- * Change: Allow timestamp-controlled log ingestion so persistence replay can restore historical entries.
- * Tests: smoke_cpp_mvp4_persistence
+ * MVP: Step D
+ * Change: Mark context entries in QueryRecord and formatted lines.
+ * Tests: spec_query_context, spec_binary_query
  */
 #ifndef LOGCRAFTER_CPP_LOG_BUFFER_HPP
 #define LOGCRAFTER_CPP_LOG_BUFFER_HPP
 
+#include <array>
+#include <atomic>
 #include <cstddef>
+#include <cstdint>
 #include <ctime>
-#include <mutex>
+#include <memory_resource>
 #include <string>
+#include <string_view>
 #include <vector>
 
+#include "log_buffer_policies.hpp"
 #include "query_parser.hpp"
 
 namespace logcrafter::cpp {
 
+// A buffer split by severity keeps three rings: error and warning lines, info and unclassified
+// lines, and debug lines.
+constexpr std::size_t kLevelRings = 3;
+
+constexpr std::size_t level_ring(result_codec::Level level) {
+    if (level == result_codec::Level::Error || level == result_codec::Level::Warning) {
+        return 0;
+    }
+    return level == result_codec::Level::Debug ? 2 : 1;
+}
+
+// Percent of the capacity reserved for each ring, in level_ring() order. All zero keeps a single
+// ring; otherwise the shares add up to 100 and a ring may borrow space the others leave unused.
+using LevelShares = std::array<unsigned, kLevelRings>;
+
 struct LogBufferStats {
     std::size_t current_size;
     unsigned long total_logs;
     unsigned long dropped_logs;
+    unsigned long reordered_logs;
+    // Entries held per ring; everything is in ring 0 when the buffer is not split.
+    std::array<std::size_t, kLevelRings> ring_sizes;
 };
 
-class LogBuffer {
+using QueryResults = std::pmr::vector<std::pmr::string>;
+
+// An unformatted match for machine-readable responses. `sequence` is the entry's 1-based
+// position in the buffer's history in time order (entries dropped from the ring keep theirs).
+// In a buffer split by severity it numbers the ring slot's write, so it is unique but only
+// ordered within a ring.
+struct QueryRecord {
+    std::time_t timestamp;
+    std::uint64_t sequence;
+    // A before=/after= neighbour of a match rather than a match.
+    bool context;
+    std::pmr::string message;
+};
+
+using QueryRecords = std::pmr::vector<QueryRecord>;
+
+// Ring buffer of timestamped log lines composed at compile time from a storage policy (slot
+// layout), a synchronization policy (ReadGuard/WriteGuard), and an index policy (time-filter
+// pruning); see log_buffer_policies.hpp. Member definitions live in log_buffer_impl.hpp, and
+// the default LogBuffer composition is instantiated once in log_buffer.cpp.
+//
+// Configured with LevelShares, the capacity is split across per-severity rings, each with its own
+// slots and index. A full buffer evicts from the ring that holds more than its share, so a debug
+// storm only overwrites debug lines once errors and info are within their reserve. Scans merge
+// the rings by timestamp, and a level= filter reads only the ring that stores that level.
+template <typename StoragePolicy, typename SyncPolicy, typename IndexPolicy>
+class BasicLogBuffer {
 public:
-    LogBuffer();
+    using storage_policy = StoragePolicy;
+    using sync_policy = SyncPolicy;
+    using index_policy = IndexPolicy;
+
+    static constexpr std::size_t kDefaultReorderWindow = 64;
+
+    BasicLogBuffer();
 
-    void configure(std::size_t capacity);
+    BasicLogBuffer(const BasicLogBuffer &) = delete;
+    BasicLogBuffer &operator=(const BasicLogBuffer &) = delete;
+
+    void configure(std::size_t capacity, const LevelShares &shares = LevelShares{});
+    // A late entry is moved back past at most `window` newer neighbours so the ring stays in
+    // event-time order; anything later than that is still found via the index policy.
+    void set_reorder_window(std::size_t window);
     void reset();
 
     void push(const std::string &message);
     void push_with_time(const std::string &message, std::time_t timestamp);
+    // Lock-free: reads relaxed counters, so fields may be a few pushes apart from each other.
     LogBufferStats stats() const;
     std::vector<std::string> snapshot() const;
-    std::vector<std::string> execute_query(const QueryRequest &request) const;
+    QueryResults execute_query(const QueryRequest &request,
+                               std::pmr::memory_resource *resource = std::pmr::get_default_resource()) const;
+    // Same matches as execute_query, copied straight from storage without text formatting.
+    QueryRecords execute_query_records(const QueryRequest &request,
+                                       std::pmr::memory_resource *resource = std::pmr::get_default_resource()) const;
 
 private:
-    struct Entry {
-        std::time_t timestamp;
-        std::string message;
+    using ReadGuard = typename SyncPolicy::ReadGuard;
+    using WriteGuard = typename SyncPolicy::WriteGuard;
+
+    // Calls visit(sequence, timestamp, message, context) for every match and requested context
+    // entry, oldest first, under the read guard.
+    template <typename Visit>
+    void scan(const QueryRequest &request, Visit &&visit) const;
+
+    // Every ring has `capacity_` slots so it can borrow the whole buffer; `size` counts the
+    // live ones, which end just before `head`.
+    struct Ring {
+        StoragePolicy storage;
+        IndexPolicy index;
+        std::vector<std::uint64_t> sequences;
+        std::size_t reserved = 0;
+        std::size_t size = 0;
+        std::size_t head = 0;
     };
 
-    static bool entry_matches(const Entry &entry, const QueryRequest &request);
-    static std::string format_entry(const Entry &entry);
+    std::size_t slot(const Ring &ring, std::size_t position) const;
+    std::size_t eviction_ring(std::size_t incoming) const;
+    std::size_t reorder_newest(Ring &ring, std::size_t index);
 
-    mutable std::mutex mutex_;
-    std::vector<Entry> entries_;
+    mutable SyncPolicy sync_;
+    std::array<Ring, kLevelRings> rings_;
+    std::size_t ring_count_;
     std::size_t capacity_;
     std::size_t size_;
-    std::size_t head_;
-    unsigned long total_logs_;
-    unsigned long dropped_logs_;
+    std::size_t reorder_window_;
+    // Mirrors of the counters for stats(); written under the write guard, read without it.
+    std::atomic<std::size_t> published_size_;
+    std::array<std::atomic<std::size_t>, kLevelRings> published_ring_sizes_;
+    std::atomic<unsigned long> total_logs_;
+    std::atomic<unsigned long> dropped_logs_;
+    std::atomic<unsigned long> reordered_logs_;
 };
 
+namespace log_buffer_detail {
+
+bool entry_matches(std::string_view message, std::time_t timestamp, const QueryRequest &request);
+// "[YYYY-MM-DD HH:MM:SS] message"; context lines put '-' after the stamp, as grep -C does.
+void format_entry(std::time_t timestamp, std::string_view message, std::pmr::string &out, bool context = false);
+std::time_t resolve_timestamp(std::time_t timestamp);
+
+} // namespace log_buffer_detail
+
+using LogBuffer = BasicLogBuffer<StringStorage, MutexSync, TimeBlockIndex>;
+
+extern template class BasicLogBuffer<StringStorage, MutexSync, TimeBlockIndex>;
+
 } // namespace logcrafter::cpp
 
 #endif // LOGCRAFTER_CPP_LOG_BUFFER_HPP
@@ -0,0 +1,343 @@
+/*
+ * Sequence: SEQ0303
+ * Track: C++
+ * MVP: Step D
+ * Change: Emit before/after context entries from the scan, merging overlapping windows.
+ * Tests: spec_query_context, spec_severity_rings
+ */
+#ifndef LOGCRAFTER_CPP_LOG_BUFFER_IMPL_HPP
+#define LOGCRAFTER_CPP_LOG_BUFFER_IMPL_HPP
+
+#include "log_buffer.hpp"
+
+namespace logcrafter::cpp {
+
+template <typename S, typename Y, typename I>
+BasicLogBuffer<S, Y, I>::BasicLogBuffer()
+    : sync_(),
+      rings_(),
+      ring_count_(1),
+      capacity_(0),
+      size_(0),
+      reorder_window_(kDefaultReorderWindow),
+      published_size_(0),
+      published_ring_sizes_(),
+      total_logs_(0),
+      dropped_logs_(0),
+      reordered_logs_(0) {
+    for (std::atomic<std::size_t> &ring_size : published_ring_sizes_) {
+        ring_size.store(0, std::memory_order_relaxed);
+    }
+}
+
+template <typename S, typename Y, typename I>
+void BasicLogBuffer<S, Y, I>::configure(std::size_t capacity, const LevelShares &shares) {
+    WriteGuard guard(sync_);
+    capacity_ = capacity;
+    ring_count_ = shares == LevelShares{} ? 1 : kLevelRings;
+    for (std::size_t r = 0; r < kLevelRings; ++r) {
+        Ring &ring = rings_[r];
+        // Any ring may borrow up to the whole capacity, so each used ring is sized to capacity_: a split
+        // buffer holds three times the slots, sequences and index blocks of a shared one. Unused rings
+        // keep no slots.
+        const std::size_t slots = r < ring_count_ ? capacity_ : 0;
+        ring.storage.configure(slots);
+        ring.index.configure(slots);
+        ring.sequences.assign(slots, 0);
+        ring.reserved = ring_count_ == 1 ? capacity_ : capacity_ * shares[r] / 100;
+        ring.size = 0;
+        ring.head = 0;
+        published_ring_sizes_[r].store(0, std::memory_order_relaxed);
+    }
+    size_ = 0;
+    published_size_.store(0, std::memory_order_relaxed);
+    total_logs_.store(0, std::memory_order_relaxed);
+    dropped_logs_.store(0, std::memory_order_relaxed);
+    reordered_logs_.store(0, std::memory_order_relaxed);
+}
+
+template <typename S, typename Y, typename I>
+void BasicLogBuffer<S, Y, I>::set_reorder_window(std::size_t window) {
+    WriteGuard guard(sync_);
+    reorder_window_ = window;
+}
+
+template <typename S, typename Y, typename I>
+void BasicLogBuffer<S, Y, I>::reset() {
+    WriteGuard guard(sync_);
+    size_ = 0;
+    published_size_.store(0, std::memory_order_relaxed);
+    total_logs_.store(0, std::memory_order_relaxed);
+    dropped_logs_.store(0, std::memory_order_relaxed);
+    reordered_logs_.store(0, std::memory_order_relaxed);
+    for (std::size_t r = 0; r < kLevelRings; ++r) {
+        Ring &ring = rings_[r];
+        ring.size = 0;
+        ring.head = 0;
+        ring.storage.clear();
+        ring.index.clear();
+        published_ring_sizes_[r].store(0, std::memory_order_relaxed);
+    }
+}
+
+template <typename S, typename Y, typename I>
+void BasicLogBuffer<S, Y, I>::push(const std::string &message) {
+    push_with_time(message, 0);
+}
+
+template <typename S, typename Y, typename I>
+void BasicLogBuffer<S, Y, I>::push_with_time(const std::string &message, std::time_t timestamp) {
+    WriteGuard guard(sync_);
+    if (capacity_ == 0) {
+        return;
+    }
+
+    // Counters are only written under the write guard, so a plain load/store pair is enough and
+    // avoids a locked read-modify-write on the ingest path.
+    auto bump = [](std::atomic<unsigned long> &counter) {
+        counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    };
+
+    const std::size_t target = ring_count_ == 1 ? 0 : level_ring(result_codec::classify_level(message));
+    if (size_ == capacity_) {
+        // Dropping the target's own oldest entry frees the slot at its head.
+        const std::size_t victim = eviction_ring(target);
+        --rings_[victim].size;
+        published_ring_sizes_[victim].store(rings_[victim].size, std::memory_order_relaxed);
+        bump(dropped_logs_);
+    } else {
+        ++size_;
+        published_size_.store(size_, std::memory_order_relaxed);
+    }
+
+    Ring &ring = rings_[target];
+    const std::size_t index = ring.head;
+    const std::time_t effective = log_buffer_detail::resolve_timestamp(timestamp);
+    ring.storage.store(index, effective, message);
+    ring.index.record_write(index, effective);
+    ring.sequences[index] = total_logs_.load(std::memory_order_relaxed) + 1;
+    ring.head = (ring.head + 1) % capacity_;
+    ++ring.size;
+    published_ring_sizes_[target].store(ring.size, std::memory_order_relaxed);
+    bump(total_logs_);
+
+    if (reorder_newest(ring, index) > 0) {
+        bump(reordered_logs_);
+    }
+}
+
+template <typename S, typename Y, typename I>
+LogBufferStats BasicLogBuffer<S, Y, I>::stats() const {
+    LogBufferStats result{published_size_.load(std::memory_order_relaxed),
+                          total_logs_.load(std::memory_order_relaxed),
+                          dropped_logs_.load(std::memory_order_relaxed),
+                          reordered_logs_.load(std::memory_order_relaxed),
+                          {}};
+    for (std::size_t r = 0; r < kLevelRings; ++r) {
+        result.ring_sizes[r] = published_ring_sizes_[r].load(std::memory_order_relaxed);
+    }
+    return result;
+}
+
+template <typename S, typename Y, typename I>
+std::vector<std::string> BasicLogBuffer<S, Y, I>::snapshot() const {
+    std::vector<std::string> copy;
+    scan(QueryRequest{},
+         [&copy](std::uint64_t, std::time_t, std::string_view message, bool) { copy.emplace_back(message); });
+    return copy;
+}
+
+template <typename S, typename Y, typename I>
+QueryResults BasicLogBuffer<S, Y, I>::execute_query(const QueryRequest &request,
+                                                    std::pmr::memory_resource *resource) const {
+    QueryResults results(resource);
+    scan(request, [&results](std::uint64_t, std::time_t timestamp, std::string_view message, bool context) {
+        results.emplace_back();
+        log_buffer_detail::format_entry(timestamp, message, results.back(), context);
+    });
+    return results;
+}
+
+template <typename S, typename Y, typename I>
+QueryRecords BasicLogBuffer<S, Y, I>::execute_query_records(const QueryRequest &request,
+                                                            std::pmr::memory_resource *resource) const {
+    QueryRecords records(resource);
+    scan(request, [&records](std::uint64_t sequence, std::time_t timestamp, std::string_view message, bool context) {
+        records.push_back(
+            QueryRecord{timestamp, sequence, context, std::pmr::string(message, records.get_allocator())});
+    });
+    return records;
+}
+
+template <typename S, typename Y, typename I>
+template <typename Visit>
+void BasicLogBuffer<S, Y, I>::scan(const QueryRequest &request, Visit &&visit) const {
+    ReadGuard guard(sync_);
+    if (size_ == 0 || capacity_ == 0) {
+        return;
+    }
+
+    // Rings that can hold a match: level= in a split buffer needs only the ring storing it, unless
+    // context lines of every level are wanted around the matches.
+    const bool with_context = request.before != 0 || request.after != 0;
+    std::size_t first_ring = 0;
+    std::size_t last_ring = ring_count_;
+    if (ring_count_ > 1 && request.has_level && !with_context) {
+        first_ring = level_ring(request.level);
+        last_ring = first_ring + 1;
+    }
+
+    const bool time_filtered = request.has_time_from || request.has_time_to;
+    // Context comes from the entries visited in scan order, so neighbours are by position in the
+    // stream. Up to `before` recent non-matches wait in a small ring until a match releases them,
+    // and each entry is emitted once, which merges overlapping windows.
+    struct Held {
+        const Ring *ring;
+        std::size_t index;
+    };
+    std::array<Held, QueryRequest::kMaxContextLines> held;
+    std::size_t held_start = 0;
+    std::size_t held_count = 0;
+    std::size_t after_left = 0;
+    auto emit = [&visit](const Ring &ring, std::size_t index, bool context) {
+        visit(ring.sequences[index], ring.storage.timestamp(index), ring.storage.message(index), context);
+    };
+    auto visit_if_match = [&](const Ring &ring, std::size_t index) {
+        const std::string_view message = ring.storage.message(index);
+        const std::time_t timestamp = ring.storage.timestamp(index);
+        if (message.empty()) {
+            return;
+        }
+        if (log_buffer_detail::entry_matches(message, timestamp, request)) {
+            for (; held_count > 0; --held_count) {
+                const Held &entry = held[held_start];
+                emit(*entry.ring, entry.index, true);
+                held_start = (held_start + 1) % held.size();
+            }
+            emit(ring, index, false);
+            after_left = request.after;
+            return;
+        }
+        if (!with_context || (request.has_time_from && timestamp < request.time_from) ||
+            (request.has_time_to && timestamp > request.time_to)) {
+            return;
+        }
+        if (after_left > 0) {
+            --after_left;
+            emit(ring, index, true);
+        } else if (request.before > 0) {
+            if (held_count == request.before) {
+                held_start = (held_start + 1) % held.size();
+                --held_count;
+            }
+            held[(held_start + held_count) % held.size()] = Held{&ring, index};
+            ++held_count;
+        }
+    };
+
+    if (last_ring - first_ring == 1) {
+        const Ring &ring = rings_[first_ring];
+        for (std::size_t position = 0; position < ring.size;) {
+            const std::size_t index = slot(ring, position);
+            if (time_filtered) {
+                const std::size_t next = ring.index.skip_to(index, request);
+                if (next != index) {
+                    position += next - index;
+                    continue;
+                }
+            }
+            visit_if_match(ring, index);
+            ++position;
+        }
+        return;
+    }
+
+    // Next position to read in each ring.
+    std::array<std::size_t, kLevelRings> positions{};
+    while (true) {
+        // Each ring is in time order, so the oldest head across rings is next; ties keep write order.
+        std::size_t best = kLevelRings;
+        std::size_t best_index = 0;
+        for (std::size_t r = first_ring; r < last_ring; ++r) {
+            const Ring &ring = rings_[r];
+            std::size_t &position = positions[r];
+            std::size_t index = 0;
+            while (position < ring.size) {
+                index = slot(ring, position);
+                const std::size_t next = time_filtered ? ring.index.skip_to(index, request) : index;
+                if (next == index) {
+                    break;
+                }
+                position += next - index;
+            }
+            if (position >= ring.size) {
+                continue;
+            }
+            if (best == kLevelRings) {
+                best = r;
+                best_index = index;
+                continue;
+            }
+            const Ring &current = rings_[best];
+            const std::time_t timestamp = ring.storage.timestamp(index);
+            const std::time_t best_timestamp = current.storage.timestamp(best_index);
+            if (timestamp < best_timestamp ||
+                (timestamp == best_timestamp && ring.sequences[index] < current.sequences[best_index])) {
+                best = r;
+                best_index = index;
+            }
+        }
+        if (best == kLevelRings) {
+            return;
+        }
+
+        visit_if_match(rings_[best], best_index);
+        ++positions[best];
+    }
+}
+
+template <typename S, typename Y, typename I>
+std::size_t BasicLogBuffer<S, Y, I>::slot(const Ring &ring, std::size_t position) const {
+    return (ring.head + capacity_ - ring.size + position) % capacity_;
+}
+
+template <typename S, typename Y, typename I>
+std::size_t BasicLogBuffer<S, Y, I>::eviction_ring(std::size_t incoming) const {
+    if (rings_[incoming].size >= rings_[incoming].reserved) {
+        return incoming;
+    }
+    // The incoming ring is inside its reserve, so it takes back space another ring borrowed; the
+    // shares never add up to more than the capacity, so some ring is over its own.
+    std::size_t victim = incoming;
+    std::size_t most_over = 0;
+    for (std::size_t r = 0; r < ring_count_; ++r) {
+        const Ring &ring = rings_[r];
+        if (ring.size > ring.reserved && ring.size - ring.reserved > most_over) {
+            most_over = ring.size - ring.reserved;
+            victim = r;
+        }
+    }
+    return victim;
+}
+
+template <typename S, typename Y, typename I>
+std::size_t BasicLogBuffer<S, Y, I>::reorder_newest(Ring &ring, std::size_t index) {
+    std::size_t moved = 0;
+    while (moved < reorder_window_ && moved + 1 < ring.size) {
+        const std::size_t previous = (index + capacity_ - 1) % capacity_;
+        if (ring.storage.timestamp(previous) <= ring.storage.timestamp(index)) {
+            break;
+        }
+        // Sequence numbers stay with the slot, so they keep counting up in time order.
+        ring.storage.swap(previous, index);
+        ring.index.record_move(index, ring.storage.timestamp(index));
+        ring.index.record_move(previous, ring.storage.timestamp(previous));
+        index = previous;
+        ++moved;
+    }
+    return moved;
+}
+
+} // namespace logcrafter::cpp
+
+#endif // LOGCRAFTER_CPP_LOG_BUFFER_IMPL_HPP
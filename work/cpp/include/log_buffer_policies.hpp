@@ -0,0 +1,252 @@
+/*
+ * Sequence: SEQ0160
+ * Track: C++
+ * MVP: Step D
+ * Change: Declare the storage, synchronization, and time-index policies that BasicLogBuffer is composed from.
+ * Tests: spec_protocol_happy_path, spec_client_timestamps, logcrafter_cpp_bench_buffer_policies (manual)
+ */
+#ifndef LOGCRAFTER_CPP_LOG_BUFFER_POLICIES_HPP
+#define LOGCRAFTER_CPP_LOG_BUFFER_POLICIES_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "query_parser.hpp"
+
+namespace logcrafter::cpp {
+
+// Storage policies own the ring slots. Every policy provides:
+//   configure(capacity), clear(), store(index, timestamp, message), timestamp(index),
+//   message(index) -> std::string_view, swap(lhs, rhs).
+
+// One heap-backed std::string per slot; assignment reuses each slot's capacity once warm.
+class StringStorage {
+public:
+    void configure(std::size_t capacity) { entries_.assign(capacity, Entry{}); }
+
+    void clear() {
+        for (Entry &entry : entries_) {
+            entry.timestamp = 0;
+            entry.message.clear();
+        }
+    }
+
+    void store(std::size_t index, std::time_t timestamp, std::string_view message) {
+        Entry &entry = entries_[index];
+        entry.timestamp = timestamp;
+        entry.message.assign(message.data(), message.size());
+    }
+
+    std::time_t timestamp(std::size_t index) const { return entries_[index].timestamp; }
+    std::string_view message(std::size_t index) const { return entries_[index].message; }
+    void swap(std::size_t lhs, std::size_t rhs) { std::swap(entries_[lhs], entries_[rhs]); }
+
+private:
+    struct Entry {
+        std::time_t timestamp;
+        std::string message;
+    };
+
+    std::vector<Entry> entries_;
+};
+
+// Inline fixed-size slots in one contiguous allocation: no per-message heap traffic and a
+// predictable footprint of roughly capacity * SlotBytes. Longer messages are cut to SlotBytes.
+template <std::size_t SlotBytes>
+class FixedSlotStorage {
+public:
+    static_assert(SlotBytes > 0 && SlotBytes <= UINT32_MAX, "slot size must fit the length field");
+
+    void configure(std::size_t capacity) {
+        slots_.assign(capacity, Slot{});
+    }
+
+    void clear() {
+        for (Slot &slot : slots_) {
+            slot.timestamp = 0;
+            slot.length = 0;
+        }
+    }
+
+    void store(std::size_t index, std::time_t timestamp, std::string_view message) {
+        Slot &slot = slots_[index];
+        const std::size_t length = std::min(message.size(), SlotBytes);
+        slot.timestamp = timestamp;
+        slot.length = static_cast<std::uint32_t>(length);
+        std::memcpy(slot.text, message.data(), length);
+    }
+
+    std::time_t timestamp(std::size_t index) const { return slots_[index].timestamp; }
+    std::string_view message(std::size_t index) const {
+        const Slot &slot = slots_[index];
+        return std::string_view(slot.text, slot.length);
+    }
+
+    void swap(std::size_t lhs, std::size_t rhs) {
+        Slot &a = slots_[lhs];
+        Slot &b = slots_[rhs];
+        std::swap(a.timestamp, b.timestamp);
+        char scratch[SlotBytes];
+        std::memcpy(scratch, a.text, a.length);
+        std::memcpy(a.text, b.text, b.length);
+        std::memcpy(b.text, scratch, a.length);
+        std::swap(a.length, b.length);
+    }
+
+private:
+    struct Slot {
+        std::time_t timestamp;
+        std::uint32_t length;
+        char text[SlotBytes];
+    };
+
+    std::vector<Slot> slots_;
+};
+
+// Synchronization policies expose nested ReadGuard/WriteGuard RAII types constructed from the
+// policy instance. Queries take ReadGuard; push/configure/reset take WriteGuard.
+
+// One mutex for readers and writers alike; the historical behaviour.
+class MutexSync {
+public:
+    class ReadGuard {
+    public:
+        explicit ReadGuard(MutexSync &sync) : lock_(sync.mutex_) {}
+
+    private:
+        std::lock_guard<std::mutex> lock_;
+    };
+    using WriteGuard = ReadGuard;
+
+private:
+    std::mutex mutex_;
+};
+
+// Concurrent queries (and IRC !query) share the buffer; writers are exclusive.
+class SharedMutexSync {
+public:
+    class ReadGuard {
+    public:
+        explicit ReadGuard(SharedMutexSync &sync) : lock_(sync.mutex_) {}
+
+    private:
+        std::shared_lock<std::shared_mutex> lock_;
+    };
+
+    class WriteGuard {
+    public:
+        explicit WriteGuard(SharedMutexSync &sync) : lock_(sync.mutex_) {}
+
+    private:
+        std::unique_lock<std::shared_mutex> lock_;
+    };
+
+private:
+    std::shared_mutex mutex_;
+};
+
+// Test-and-test-and-set spin lock for single-producer deployments where queries are rare and
+// critical sections short; avoids the futex path entirely when uncontended.
+class SpinLockSync {
+public:
+    class ReadGuard {
+    public:
+        explicit ReadGuard(SpinLockSync &sync) : sync_(sync) { sync_.lock(); }
+        ~ReadGuard() { sync_.unlock(); }
+
+        ReadGuard(const ReadGuard &) = delete;
+        ReadGuard &operator=(const ReadGuard &) = delete;
+
+    private:
+        SpinLockSync &sync_;
+    };
+    using WriteGuard = ReadGuard;
+
+private:
+    void lock() {
+        unsigned spins = 0;
+        while (locked_.exchange(true, std::memory_order_acquire)) {
+            while (locked_.load(std::memory_order_relaxed)) {
+                if (++spins % 64 == 0) {
+                    std::this_thread::yield();
+                }
+            }
+        }
+    }
+
+    void unlock() { locked_.store(false, std::memory_order_release); }
+
+    std::atomic<bool> locked_{false};
+};
+
+// No synchronization at all: for single-threaded tools, benchmarks, or callers that already
+// serialise every push and query themselves.
+class NullSync {
+public:
+    class ReadGuard {
+    public:
+        explicit ReadGuard(NullSync &) {}
+    };
+    using WriteGuard = ReadGuard;
+};
+
+// Index policies let time-filtered scans skip slots. Every policy provides:
+//   configure(capacity), clear(), record_write(index, timestamp), record_move(index, timestamp),
+//   skip_to(index, request) -> first slot at or after `index` that may match.
+
+// Min/max timestamp bounds per kBlockSize slots. `covered` spans every entry currently in the
+// block; `fresh` spans entries written since the head last entered the block and replaces
+// `covered` once the block is fully rewritten.
+class TimeBlockIndex {
+public:
+    static constexpr std::size_t kBlockSize = 256;
+
+    void configure(std::size_t capacity);
+    void clear();
+    void record_write(std::size_t index, std::time_t timestamp);
+    void record_move(std::size_t index, std::time_t timestamp);
+    std::size_t skip_to(std::size_t index, const QueryRequest &request) const;
+
+private:
+    struct TimeBounds {
+        std::time_t min;
+        std::time_t max;
+
+        static TimeBounds empty();
+        void widen(std::time_t timestamp);
+        bool overlaps(const QueryRequest &request) const;
+    };
+
+    struct TimeBlock {
+        TimeBounds covered;
+        TimeBounds fresh;
+    };
+
+    std::vector<TimeBlock> blocks_;
+    std::size_t capacity_ = 0;
+};
+
+// No bookkeeping on push; time filters are evaluated per entry.
+class NoIndex {
+public:
+    void configure(std::size_t) {}
+    void clear() {}
+    void record_write(std::size_t, std::time_t) {}
+    void record_move(std::size_t, std::time_t) {}
+    std::size_t skip_to(std::size_t index, const QueryRequest &) const { return index; }
+};
+
+} // namespace logcrafter::cpp
+
+#endif // LOGCRAFTER_CPP_LOG_BUFFER_POLICIES_HPP
@@ -0,0 +1,30 @@
+/*
+ * Sequence: SEQ0253
+ * Track: C++
+ * MVP: Step D
+ * Change: Declare the sendfile() range sender.
+ * Tests: spec_export, spec_relay_forwarding, spec_replication
+ */
+#ifndef LOGCRAFTER_CPP_NET_IO_HPP
+#define LOGCRAFTER_CPP_NET_IO_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace logcrafter::cpp::net_io {
+
+// Connects within `connect_timeout_ms`, then leaves the socket blocking with `io_timeout_seconds`
+// receive and send timeouts and TCP_NODELAY set. Returns -1 on failure.
+int connect_tcp(const std::string &host, int port, int connect_timeout_ms, int io_timeout_seconds);
+bool recv_exact(int fd, char *data, std::size_t length);
+bool send_text(int fd, std::string_view text);
+// Sends `length` bytes of `file_fd` from `offset` with sendfile(), straight from the page cache.
+bool send_file(int fd, int file_fd, std::uint64_t offset, std::uint64_t length);
+// Reads one newline-terminated line of at most `max_length` bytes, without the newline.
+bool recv_line(int fd, std::string &line, std::size_t max_length);
+
+} // namespace logcrafter::cpp::net_io
+
+#endif // LOGCRAFTER_CPP_NET_IO_HPP
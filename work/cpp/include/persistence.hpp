@@ -1,22 +1,25 @@
 /*
- * Sequence: SEQ0047
+ * Sequence: SEQ0350
  * Track: C++
- * MVP: mvp4
- * Change: Declare the asynchronous persistence manager interface for log rotation and replay support.
- * Tests: smoke_cpp_mvp4_persistence
+ * MVP: Step D
+ * Change: Expose the persisted line prefix and rotated segment name for the bulk importer.
+ * Tests: spec_bulk_import, spec_export
  */
 #ifndef LOGCRAFTER_CPP_PERSISTENCE_HPP
 #define LOGCRAFTER_CPP_PERSISTENCE_HPP
 
 #include <cstddef>
+#include <cstdint>
 #include <cstdio>
 #include <ctime>
+#include <atomic>
 #include <condition_variable>
 #include <deque>
 #include <functional>
 #include <mutex>
 #include <string>
 #include <thread>
+#include <vector>
 
 namespace logcrafter::cpp {
 
@@ -32,6 +35,28 @@ struct PersistenceStats {
     unsigned long failed_logs;
 };
 
+// A byte range of one persisted file, selected by EXPORT.
+struct ExportSlice {
+    int fd;
+    std::uint64_t offset;
+    std::uint64_t length;
+};
+
+// Owns the descriptors of a planned export. They are opened while rotation is held off, so
+// the ranges stay readable even if the files are renamed or pruned before they are sent.
+class ExportPlan {
+public:
+    ExportPlan() = default;
+    ~ExportPlan();
+
+    ExportPlan(const ExportPlan &) = delete;
+    ExportPlan &operator=(const ExportPlan &) = delete;
+
+    std::uint64_t total_bytes() const;
+
+    std::vector<ExportSlice> slices;
+};
+
 class PersistenceManager {
 public:
     PersistenceManager();
@@ -41,8 +66,22 @@ public:
     void shutdown();
 
     bool enqueue(const std::string &message, std::time_t timestamp);
+    // Lock-free snapshot of relaxed counters; never waits on the writer thread.
     PersistenceStats stats() const;
     int replay_existing(const std::function<void(const std::string &, std::time_t)> &callback);
+    // Selects the persisted lines stamped from..to, oldest file first. Files are skipped by
+    // their first stamp and by the stamp in their rotated name; the first and last overlapping
+    // files are trimmed by binary search over line offsets. Lines inside a file are assumed to
+    // be in time order, as ingest writes them.
+    int plan_export(std::time_t from, std::time_t to, ExportPlan &plan) const;
+
+    // Writes "[YYYY-MM-DD HH:MM:SS] " (local time), the prefix of every persisted line, and
+    // returns its length; `capacity` must be at least kLinePrefixCapacity.
+    static std::size_t format_line_prefix(std::time_t timestamp, char *buffer, std::size_t capacity);
+    // Name a segment is rotated to: the stamp of its last line, then ".log". Names sort in time order.
+    static std::string rotated_name(std::time_t timestamp);
+
+    static constexpr std::size_t kLinePrefixCapacity = 32;
 
 private:
     struct Entry {
@@ -57,7 +96,6 @@ private:
     bool rotate_file(std::time_t timestamp);
     bool prune_old_files();
     bool write_entry(const Entry &entry);
-    static void format_timestamp(std::time_t timestamp, char *buffer, std::size_t capacity);
     static std::time_t parse_line(const char *line, std::size_t &offset);
 
     PersistenceConfig config_;
@@ -72,10 +110,12 @@ private:
 
     std::FILE *current_file_;
     std::size_t current_size_;
+    // Held by rotation (rename and prune) and while an export opens its files.
+    mutable std::mutex files_mutex_;
 
-    unsigned long queued_logs_;
-    unsigned long persisted_logs_;
-    unsigned long failed_logs_;
+    std::atomic<unsigned long> queued_logs_;
+    std::atomic<unsigned long> persisted_logs_;
+    std::atomic<unsigned long> failed_logs_;
 };
 
 } // namespace logcrafter::cpp
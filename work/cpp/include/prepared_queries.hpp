@@ -0,0 +1,74 @@
+/*
+ * Sequence: SEQ0323
+ * Track: C++
+ * MVP: Step D
+ * Change: Declare the server-side store of PREPAREd query plans.
+ * Tests: spec_prepared_query
+ */
+#ifndef LOGCRAFTER_CPP_PREPARED_QUERIES_HPP
+#define LOGCRAFTER_CPP_PREPARED_QUERIES_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+
+#include "query_parser.hpp"
+
+namespace logcrafter::cpp {
+
+struct PreparedQueryStats {
+    std::size_t plans;
+    unsigned long executes;
+    // Sum, over every EXECUTE, of what parsing the plan's arguments took at PREPARE time.
+    unsigned long long parse_micros_saved;
+};
+
+// PREPARE <name> <QUERY arguments> parses the arguments once, regex included, and keeps the
+// resulting QueryRequest; EXECUTE <name> copies it instead of re-parsing. Plans are shared by
+// every query connection and live until the server stops; preparing an existing name replaces
+// its plan, and at most kMaxPlans names are held.
+class PreparedQueries {
+public:
+    static constexpr std::size_t kMaxPlans = 256;
+    static constexpr std::size_t kMaxNameLength = 64;
+
+    struct Plan {
+        // The arguments as sent, forwarded to peers for scope=cluster.
+        std::string arguments;
+        // Allocated from the default resource; EXECUTE copies it into the query arena.
+        QueryRequest request;
+        std::uint64_t parse_micros = 0;
+    };
+
+    PreparedQueries();
+
+    PreparedQueries(const PreparedQueries &) = delete;
+    PreparedQueries &operator=(const PreparedQueries &) = delete;
+
+    // Names use the stream-name alphabet: letters, digits, '_' and '-'.
+    static bool valid_name(std::string_view name);
+
+    // On failure `error` holds an "ERROR: ..." line and an existing plan of that name is kept.
+    bool prepare(std::string_view name, std::string_view arguments, std::string &error);
+    // Null when no plan has that name; otherwise counts one execute.
+    std::shared_ptr<const Plan> find(std::string_view name);
+
+    PreparedQueryStats stats() const;
+
+private:
+    std::mutex mutex_;
+    std::map<std::string, std::shared_ptr<const Plan>, std::less<>> plans_;
+    // plans_.size(), stored under mutex_ so stats() can read it without locking.
+    std::atomic<std::size_t> plan_count_;
+    std::atomic<unsigned long> executes_;
+    std::atomic<unsigned long long> parse_micros_saved_;
+};
+
+} // namespace logcrafter::cpp
+
+#endif // LOGCRAFTER_CPP_PREPARED_QUERIES_HPP
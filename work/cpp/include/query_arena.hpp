@@ -0,0 +1,55 @@
+/*
+ * Sequence: SEQ0109
+ * Track: C++
+ * MVP: Step D
+ * Change: Declare per-thread monotonic memory arenas that back query parsing, matching, and formatting.
+ * Tests: spec_protocol_happy_path, integration_multi_client_broadcast
+ */
+#ifndef LOGCRAFTER_CPP_QUERY_ARENA_HPP
+#define LOGCRAFTER_CPP_QUERY_ARENA_HPP
+
+#include <cstddef>
+#include <memory_resource>
+
+namespace logcrafter::cpp {
+
+// Thread-owned arena: a fixed seed buffer plus a monotonic resource that falls back to
+// the global allocator only when a single query outgrows the seed.
+class QueryArena {
+public:
+    static constexpr std::size_t kSeedBytes = 64 * 1024;
+
+    QueryArena();
+
+    QueryArena(const QueryArena &) = delete;
+    QueryArena &operator=(const QueryArena &) = delete;
+
+    std::pmr::memory_resource *resource() { return &resource_; }
+    void recycle() { resource_.release(); }
+
+    static QueryArena &for_current_thread();
+
+private:
+    alignas(std::max_align_t) std::byte seed_[kSeedBytes];
+    std::pmr::monotonic_buffer_resource resource_;
+};
+
+// Borrows the calling thread's arena for the lifetime of one query and recycles it on exit.
+// Nested scopes share the outer scope's allocations; only the outermost scope recycles.
+class QueryArenaScope {
+public:
+    QueryArenaScope();
+    ~QueryArenaScope();
+
+    QueryArenaScope(const QueryArenaScope &) = delete;
+    QueryArenaScope &operator=(const QueryArenaScope &) = delete;
+
+    std::pmr::memory_resource *resource() const { return arena_.resource(); }
+
+private:
+    QueryArena &arena_;
+};
+
+} // namespace logcrafter::cpp
+
+#endif // LOGCRAFTER_CPP_QUERY_ARENA_HPP
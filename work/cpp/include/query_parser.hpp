@@ -1,18 +1,25 @@
 /*
- * Sequence: SEQ0041
+ * Sequence: SEQ0325
  * Track: C++
- * MVP: mvp3
- * Change: Define the advanced query request model and parsing helpers for keyword, regex, and time filters.
- * Tests: smoke_cpp_mvp3_query
+ * MVP: Step D
+ * Change: Hold the compiled regex as a shared pointer and declare EXECUTE's override parser.
+ * Tests: spec_prepared_query
  */
 #ifndef LOGCRAFTER_CPP_QUERY_PARSER_HPP
 #define LOGCRAFTER_CPP_QUERY_PARSER_HPP
 
+#include <cstddef>
+#include <cstdint>
 #include <ctime>
+#include <memory>
+#include <memory_resource>
 #include <regex>
 #include <string>
+#include <string_view>
 #include <vector>
 
+#include "result_codec.hpp"
+
 namespace logcrafter::cpp {
 
 struct QueryRequest {
@@ -21,20 +28,123 @@ struct QueryRequest {
         Or,
     };
 
-    std::string keyword;
-    std::vector<std::string> keywords;
+    enum class Scope {
+        Local,
+        // Also fan out to the configured peers and merge their answers.
+        Cluster,
+    };
+
+    enum class Compression {
+        None,
+        Deflate,
+    };
+
+    enum class Format {
+        // "FOUND: n" plus "[YYYY-MM-DD HH:MM:SS] message" lines.
+        Text,
+        // Length-prefixed records; see result_codec.hpp.
+        Binary,
+        // One JSON object per line with integer epoch timestamps.
+        Ndjson,
+    };
+
+    using allocator_type = std::pmr::polymorphic_allocator<char>;
+
+    QueryRequest() = default;
+    explicit QueryRequest(const allocator_type &alloc) : keyword(alloc), keywords(alloc), streams(alloc) {}
+
+    std::pmr::string keyword;
+    std::pmr::vector<std::pmr::string> keywords;
+    // Streams to scan, in response order; empty means every stream.
+    std::pmr::vector<std::pmr::string> streams;
     Operator keyword_operator = Operator::And;
 
     bool has_regex = false;
-    std::regex regex;
+    // Shared with RegexCache, so copying a request (a prepared plan) does not recompile it.
+    std::shared_ptr<const std::regex> regex;
 
     bool has_time_from = false;
     std::time_t time_from = 0;
     bool has_time_to = false;
     std::time_t time_to = 0;
+
+    // level=<name>: only lines classify_level() puts at exactly that level.
+    bool has_level = false;
+    result_codec::Level level = result_codec::Level::Unknown;
+
+    // before=/after=: also return up to this many neighbouring entries of the same stream around
+    // each match, like grep -C; overlapping windows are merged. Text and NDJSON, local only.
+    static constexpr std::size_t kMaxContextLines = 100;
+    std::size_t before = 0;
+    std::size_t after = 0;
+
+    Scope scope = Scope::Local;
+    // Keep only the newest `limit` matches (0 = all); pushed down to peers for scope=cluster.
+    std::size_t limit = 0;
+
+    // compress=none|deflate; without it the session's COMPRESS choice applies.
+    bool has_compression = false;
+    Compression compression = Compression::None;
+
+    Format format = Format::Text;
+};
+
+// EXPORT from=<unix> to=<unix> [stream=<name>]; both bounds are inclusive.
+struct ExportRequest {
+    std::time_t from = 0;
+    std::time_t to = 0;
+    // Empty means the default stream.
+    std::string stream;
+};
+
+// ROLLUP [resolution=second|minute] [from=<unix>] [to=<unix>] [by=level|source] [source=<name>]
+// [level=<name>]; answered from the rollup rings, never from the buffers.
+struct RollupRequest {
+    enum class Resolution {
+        Second,
+        Minute,
+    };
+
+    enum class GroupBy {
+        Level,
+        Source,
+    };
+
+    Resolution resolution = Resolution::Minute;
+    // Without bounds the newest 60 buckets are returned.
+    bool has_from = false;
+    std::time_t from = 0;
+    bool has_to = false;
+    std::time_t to = 0;
+    GroupBy group_by = GroupBy::Level;
+    // Empty means every source.
+    std::string source;
+    bool has_level = false;
+    result_codec::Level level = result_codec::Level::Unknown;
+};
+
+// FETCH from_seq=<n> [max=<k>] [wait_ms=<t>]; reads the replication log by sequence number.
+struct FetchRequest {
+    static constexpr std::size_t kDefaultMax = 1000;
+    static constexpr std::size_t kMaxRecords = 10000;
+    static constexpr std::size_t kMaxWaitMs = 60000;
+
+    // 0 starts at the oldest retained entry.
+    std::uint64_t from = 0;
+    std::size_t max = kDefaultMax;
+    // How long to hold the request open when nothing at or after `from` is logged yet.
+    std::size_t wait_ms = 0;
 };
 
-bool parse_query_arguments(const std::string &arguments, QueryRequest &request, std::string &error_message);
+bool parse_query_arguments(std::string_view arguments, QueryRequest &request, std::string &error_message);
+bool parse_export_arguments(std::string_view arguments, ExportRequest &request, std::string &error_message);
+bool parse_rollup_arguments(std::string_view arguments, RollupRequest &request, std::string &error_message);
+bool parse_fetch_arguments(std::string_view arguments, FetchRequest &request, std::string &error_message);
+// EXECUTE's [time_from=<unix>] [time_to=<unix>] [limit=<n>]: replaces those fields of a copied
+// prepared plan and re-checks the combinations parse_query_arguments rejects.
+bool parse_execute_overrides(std::string_view arguments, QueryRequest &request, std::string &error_message);
+// "none" or "deflate"; shared by compress= and the query session's COMPRESS line.
+bool parse_compression(std::string_view value, QueryRequest::Compression &compression, std::string &error_message);
 
 } // namespace logcrafter::cpp
 
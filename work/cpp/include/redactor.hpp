@@ -0,0 +1,115 @@
+/*
+ * Sequence: SEQ0341
+ * Track: C++
+ * MVP: Step D
+ * Change: Declare the ingest-time redaction rules compiled into one combined automaton.
+ * Tests: spec_redaction
+ */
+#ifndef LOGCRAFTER_CPP_REDACTOR_HPP
+#define LOGCRAFTER_CPP_REDACTOR_HPP
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace logcrafter::cpp {
+
+struct RedactionRule {
+    enum class Kind {
+        Literal,
+        Regex,
+    };
+
+    std::string name;
+    Kind kind = Kind::Literal;
+    std::string pattern;
+};
+
+struct RedactionStats {
+    std::size_t rules;
+    // Lines with at least one match, and matches masked.
+    unsigned long lines;
+    unsigned long matches;
+    // Matches per rule, in file order.
+    std::vector<std::pair<std::string, unsigned long>> per_rule;
+};
+
+// Rules come from a file, one per line; blank lines and lines starting with '#' are skipped:
+//
+//   <name> literal=<text>
+//   <name> regex=<pattern>
+//
+// The value runs to the end of the line, so it may contain spaces. Regexes support literals,
+// '.', classes ([a-z], [^...], \d \w \s and their negations), escapes, grouping with ( ) or
+// (?: ), '|', and the greedy quantifiers * + ? {n} {n,} {n,m} (bounds up to kMaxRepeat).
+// Anchors, backreferences, and lazy quantifiers are rejected.
+//
+// Every rule is compiled into one DFA over byte classes, built when the rules are loaded, in
+// two forms. A line is looked at only if it contains one of the literals that every match of
+// some rule must contain (or some rule has no such literal); the unanchored search DFA then
+// reads it once, byte by byte, and most lines leave there with no match. Lines that do match
+// are masked in one more pass: at each byte that can start a match, the anchored DFA finds the
+// longest match of any rule (the earlier rule wins a tie), the match is overwritten with kMask
+// in place, and the scan resumes after it. Lengths never change, so masking needs no copy or
+// allocation.
+class Redactor {
+public:
+    static constexpr std::size_t kMaxRules = 64;
+    static constexpr std::size_t kMaxRepeat = 64;
+    static constexpr std::size_t kMaxNfaStates = 65536;
+    static constexpr std::size_t kMaxDfaStates = 8192;
+    static constexpr char kMask = '*';
+
+    Redactor();
+    ~Redactor();
+
+    Redactor(const Redactor &) = delete;
+    Redactor &operator=(const Redactor &) = delete;
+
+    // Replaces the rules with those in `path`; on failure the redactor is left empty and `error`
+    // names the offending line.
+    int load(const std::string &path, std::string &error);
+    // Same, from rules already in memory; `error` names the offending rule.
+    bool compile(std::vector<RedactionRule> rules, std::string &error);
+    void reset();
+    bool enabled() const { return !rules_.empty(); }
+
+    // Masks every match in data[0, length) and returns how many there were. Safe to call from
+    // any number of threads at once.
+    std::size_t redact(char *data, std::size_t length);
+
+    RedactionStats stats() const;
+    std::size_t automaton_states() const { return accepting_.size(); }
+
+private:
+    bool worth_scanning(std::string_view line) const;
+    // Length of the longest match starting at `start` (0 for none) and the rule it belongs to.
+    std::size_t longest_match(const unsigned char *data, std::size_t length, std::size_t start, int &rule) const;
+
+    std::vector<RedactionRule> rules_;
+    std::array<std::uint16_t, 256> byte_class_;
+    std::size_t class_count_;
+    // Anchored DFA: one row of class_count_ next states per state; -1 is the dead state. State 0 starts.
+    std::vector<std::int32_t> transitions_;
+    // Earliest rule accepting in each state, or -1.
+    std::vector<std::int32_t> accepting_;
+    // The same rules unanchored, holding the next state's row offset, or -1 as soon as any match ends.
+    std::vector<std::int32_t> search_transitions_;
+    std::array<bool, 256> starts_match_;
+    std::vector<std::string> required_literals_;
+    bool scan_every_line_;
+
+    std::unique_ptr<std::atomic<unsigned long>[]> rule_matches_;
+    std::atomic<unsigned long> lines_;
+    std::atomic<unsigned long> matches_;
+};
+
+} // namespace logcrafter::cpp
+
+#endif // LOGCRAFTER_CPP_REDACTOR_HPP
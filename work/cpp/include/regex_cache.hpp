@@ -0,0 +1,72 @@
+/*
+ * Sequence: SEQ0321
+ * Track: C++
+ * MVP: Step D
+ * Change: Declare the process-wide LRU cache of compiled query regexes.
+ * Tests: spec_prepared_query
+ */
+#ifndef LOGCRAFTER_CPP_REGEX_CACHE_HPP
+#define LOGCRAFTER_CPP_REGEX_CACHE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <regex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace logcrafter::cpp {
+
+struct RegexCacheStats {
+    std::size_t entries;
+    unsigned long long hits;
+    unsigned long long misses;
+    // Sum, over every hit, of what compiling that pattern cost the first time.
+    unsigned long long compile_micros_saved;
+};
+
+// Compiled regex= patterns keyed by pattern text and syntax flags, shared by the query port,
+// IRC !query, and alert rules so a dashboard repeating the same query compiles it once. The
+// least recently used pattern is evicted past kCapacity; entries are immutable and handed out
+// as shared pointers, so an evicted regex stays valid for queries still holding it.
+class RegexCache {
+public:
+    static constexpr std::size_t kCapacity = 128;
+
+    static RegexCache &instance();
+
+    RegexCache(const RegexCache &) = delete;
+    RegexCache &operator=(const RegexCache &) = delete;
+
+    // Throws std::regex_error like the std::regex constructor; failures are not cached.
+    std::shared_ptr<const std::regex> get(std::string_view pattern, std::regex_constants::syntax_option_type flags);
+
+    RegexCacheStats stats() const;
+
+private:
+    struct Entry {
+        std::string key;
+        std::shared_ptr<const std::regex> regex;
+        std::uint64_t compile_micros;
+    };
+
+    RegexCache() = default;
+
+    std::mutex mutex_;
+    // Most recently used first.
+    std::list<Entry> entries_;
+    std::unordered_map<std::string_view, std::list<Entry>::iterator> index_;
+    // Written only under mutex_ and read by stats() without it.
+    std::atomic<std::size_t> entry_count_{0};
+    std::atomic<unsigned long long> hits_{0};
+    std::atomic<unsigned long long> misses_{0};
+    std::atomic<unsigned long long> compile_micros_saved_{0};
+};
+
+} // namespace logcrafter::cpp
+
+#endif // LOGCRAFTER_CPP_REGEX_CACHE_HPP
@@ -0,0 +1,60 @@
+/*
+ * Sequence: SEQ0196
+ * Track: C++
+ * MVP: Step D
+ * Change: Declare the length-framed, optionally zlib-compressed record batches used between LogCrafter nodes.
+ * Tests: spec_relay_forwarding
+ */
+#ifndef LOGCRAFTER_CPP_RELAY_CODEC_HPP
+#define LOGCRAFTER_CPP_RELAY_CODEC_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <string>
+#include <string_view>
+
+namespace logcrafter::cpp::relay_codec {
+
+// Frame: u32 payload length | u8 flags | u64 batch sequence | payload. All integers are
+// big-endian. The receiver acknowledges a frame by echoing its sequence as a u64.
+constexpr std::size_t kFrameHeaderBytes = 13;
+constexpr std::size_t kAckBytes = 8;
+constexpr std::size_t kMaxPayloadBytes = 8 * 1024 * 1024;
+constexpr std::uint8_t kFlagCompressed = 0x01;
+
+// Record: i64 timestamp | u8 stream length | u32 message length | stream | message. A batch
+// payload is a run of records; a compressed payload is u32 raw length | zlib stream.
+constexpr std::size_t kRecordHeaderBytes = 13;
+
+struct FrameHeader {
+    std::uint32_t length;
+    std::uint8_t flags;
+    std::uint64_t sequence;
+};
+
+struct Record {
+    std::time_t timestamp;
+    std::string_view stream;
+    std::string_view message;
+};
+
+void append_record(std::string &out, std::time_t timestamp, std::string_view stream, std::string_view message);
+// Reads the record at `offset` and advances past it; false if the bytes there are not a whole record.
+bool next_record(std::string_view payload, std::size_t &offset, Record &record);
+// Total size of the record whose header starts at `header`.
+std::size_t record_size(const char *header);
+
+void encode_frame_header(const FrameHeader &header, char *out);
+FrameHeader decode_frame_header(const char *in);
+void encode_u64(std::uint64_t value, char *out);
+std::uint64_t decode_u64(const char *in);
+
+bool compression_available();
+// Leaves `out` empty (send raw) when compression is unavailable or does not shrink the payload.
+void compress_payload(std::string_view raw, std::string &out);
+bool decompress_payload(std::string_view compressed, std::string &out);
+
+} // namespace logcrafter::cpp::relay_codec
+
+#endif // LOGCRAFTER_CPP_RELAY_CODEC_HPP
@@ -0,0 +1,74 @@
+/*
+ * Sequence: SEQ0187
+ * Track: C++
+ * MVP: Step D
+ * Change: Declare the per-source repeat collapser that folds runs of identical lines into one summary entry.
+ * Tests: spec_repeat_collapsing
+ */
+#ifndef LOGCRAFTER_CPP_REPEAT_COLLAPSER_HPP
+#define LOGCRAFTER_CPP_REPEAT_COLLAPSER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <string>
+#include <string_view>
+
+namespace logcrafter::cpp {
+
+enum class RepeatMode {
+    Off,
+    // Byte-identical lines.
+    Exact,
+    // Lines identical once every run of digits is treated as the same token.
+    Masked,
+};
+
+struct RepeatSummary {
+    // The last suppressed line followed by " (repeated N times)".
+    std::string message;
+    // Arrival or client time of the last suppressed copy.
+    std::time_t timestamp;
+    std::size_t route;
+    unsigned long repeats;
+};
+
+// Tracks one run of consecutive repeats. The first line of a run is stored as usual. Later
+// copies within `window_ms` of the run's start are only counted. When the run ends (a
+// different line, an expired window, or finish()), one summary entry replaces them all.
+// Not synchronised; the owner serialises calls.
+class RepeatCollapser {
+public:
+    static constexpr std::int64_t kDefaultWindowMs = 10000;
+
+    RepeatCollapser();
+
+    void configure(RepeatMode mode, std::int64_t window_ms);
+
+    // True when `message` continues the current run; the copy is counted and must not be stored.
+    bool absorb(std::string_view message, std::time_t timestamp, std::size_t route, std::int64_t now_ms);
+    // Starts a new run at `message`. Returns true with `summary` filled if the run it replaces
+    // suppressed anything.
+    bool restart(std::string_view message, std::size_t route, std::int64_t now_ms, RepeatSummary &summary);
+    // Ends the current run; same summary contract as restart().
+    bool finish(RepeatSummary &summary);
+
+private:
+    bool take_summary(RepeatSummary &summary);
+    void make_key(std::string_view message, std::string &key) const;
+
+    RepeatMode mode_;
+    std::int64_t window_ms_;
+    bool active_;
+    std::string key_;
+    std::string last_message_;
+    std::time_t last_timestamp_;
+    std::size_t route_;
+    std::int64_t started_ms_;
+    unsigned long repeats_;
+    std::string scratch_;
+};
+
+} // namespace logcrafter::cpp
+
+#endif // LOGCRAFTER_CPP_REPEAT_COLLAPSER_HPP
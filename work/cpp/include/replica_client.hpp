@@ -0,0 +1,98 @@
+/*
+ * Sequence: SEQ0222
+ * Track: C++
+ * MVP: Step D
+ * Change: Declare the replica client that follows a primary's replication log.
+ * Tests: spec_replication
+ */
+#ifndef LOGCRAFTER_CPP_REPLICA_CLIENT_HPP
+#define LOGCRAFTER_CPP_REPLICA_CLIENT_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <ctime>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+
+namespace logcrafter::cpp {
+
+struct ReplicaConfig {
+    std::string primary_host;
+    // The primary's log port.
+    int primary_port;
+    std::string name;
+    // Where the applied position is kept across restarts; empty keeps it in memory only.
+    std::string state_path;
+};
+
+struct ReplicaStats {
+    bool connected;
+    // Last sequence applied here and the newest one the primary has logged.
+    std::uint64_t applied_sequence;
+    std::uint64_t primary_head;
+    unsigned long applied_records;
+    // Entries the primary no longer had when this replica asked for them.
+    unsigned long gaps;
+    unsigned long reconnects;
+};
+
+// Connects to the primary's log port, sends `REPLICATE <name> <epoch> <next sequence>`, and
+// applies the frames that follow in order, acknowledging each with the next sequence it
+// expects. After a disconnect it reconnects with backoff and resumes from that sequence, so
+// the primary replays whatever was logged meanwhile from its segments.
+class ReplicaClient {
+public:
+    using ApplyCallback = std::function<void(std::string_view stream, std::string message, std::time_t timestamp)>;
+
+    ReplicaClient();
+    ~ReplicaClient();
+
+    ReplicaClient(const ReplicaClient &) = delete;
+    ReplicaClient &operator=(const ReplicaClient &) = delete;
+
+    int init(const ReplicaConfig &config, ApplyCallback apply);
+    void shutdown();
+    bool enabled() const { return running_; }
+
+    ReplicaStats stats() const;
+
+private:
+    void run();
+    bool connect_primary();
+    void disconnect_primary();
+    bool apply_frame();
+    bool load_state();
+    bool save_state() const;
+    void backoff(int &delay_ms);
+
+    ReplicaConfig config_;
+    ApplyCallback apply_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable condition_;
+    bool stop_;
+    bool running_;
+    std::thread worker_;
+    // Written by the worker under mutex_ so shutdown() can interrupt a blocked read.
+    int primary_fd_;
+
+    // Worker state: the primary log being followed and the next sequence wanted from it.
+    std::uint64_t epoch_;
+    std::uint64_t next_sequence_;
+    std::string payload_;
+
+    std::atomic<bool> connected_;
+    std::atomic<std::uint64_t> applied_sequence_;
+    std::atomic<std::uint64_t> primary_head_;
+    std::atomic<unsigned long> applied_records_;
+    std::atomic<unsigned long> gaps_;
+    std::atomic<unsigned long> reconnects_;
+};
+
+} // namespace logcrafter::cpp
+
+#endif // LOGCRAFTER_CPP_REPLICA_CLIENT_HPP
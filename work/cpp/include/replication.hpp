@@ -0,0 +1,213 @@
+/*
+ * Sequence: SEQ0311
+ * Track: C++
+ * MVP: Step D
+ * Change: Declare FETCH batches, the in-memory tail, and resume positions on the replication log.
+ * Tests: spec_fetch, spec_replication
+ */
+#ifndef LOGCRAFTER_CPP_REPLICATION_HPP
+#define LOGCRAFTER_CPP_REPLICATION_HPP
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <ctime>
+#include <deque>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "seqlock_text.hpp"
+
+namespace logcrafter::cpp {
+
+struct ReplicationConfig {
+    std::string directory;
+    // Full segments kept for replica catch-up; the oldest is deleted once more exist.
+    std::size_t retain_segments;
+    std::size_t batch_records;
+    // Newest entries kept in memory for FETCH; older offsets are read from the segments.
+    std::size_t tail_entries;
+};
+
+struct ReplicaStatus {
+    std::string name;
+    // Highest sequence the replica reported as applied.
+    std::uint64_t acked;
+};
+
+struct ReplicationStats {
+    // Sequence of the newest logged entry (0 when the log is empty) and of the oldest one
+    // still on disk.
+    std::uint64_t head;
+    std::uint64_t oldest;
+    unsigned long log_failures;
+    // Entries handed to FETCH from the in-memory tail and from the segments.
+    unsigned long fetched_memory;
+    unsigned long fetched_disk;
+    std::vector<ReplicaStatus> replicas;
+};
+
+// One FETCH answer: `records` relay_codec records numbered from `first`. `first` is later than
+// the requested sequence when that one is no longer retained; `next` is where the following
+// FETCH continues.
+struct FetchBatch {
+    std::uint64_t first;
+    std::uint64_t next;
+    std::uint64_t head;
+    std::size_t records;
+    std::string payload;
+};
+
+// Every stored entry gets the next sequence number and is appended, in that order, to a
+// segmented log on disk by a writer thread. Segment files are named after the sequence of
+// their first entry, so a replica that asks for sequence N is served by seeking the newest
+// segment starting at or before N; the sequence numbers survive restarts because the log is
+// recovered from the segments. Each attached replica gets a sender thread that streams
+// frames from its position to the live tail and sends heartbeats while idle; replicas
+// acknowledge the next sequence they expect, which is what lag is measured against.
+//
+// The same log backs FETCH consumers. The newest entries are also kept in an in-memory tail, so
+// a consumer that keeps up is served without touching the files; one that fell behind reads
+// the segments, resuming at the byte offset where its previous fetch stopped.
+class ReplicationSource {
+public:
+    static constexpr const char *kDefaultDirectory = "./replication-log";
+    static constexpr std::size_t kDefaultRetainSegments = 16;
+    static constexpr std::size_t kDefaultBatchRecords = 512;
+    static constexpr std::size_t kDefaultTailEntries = 4096;
+    // Segment positions remembered for consumers reading behind the tail.
+    static constexpr std::size_t kResumePositions = 16;
+    static constexpr std::size_t kSegmentBytes = 4 * 1024 * 1024;
+    static constexpr std::size_t kMaxReplicas = 8;
+    // Longer replica names are cut short in STATS.
+    static constexpr std::size_t kReplicaNameBytes = 64;
+    static constexpr int kHeartbeatMs = 1000;
+
+    ReplicationSource();
+    ~ReplicationSource();
+
+    ReplicationSource(const ReplicationSource &) = delete;
+    ReplicationSource &operator=(const ReplicationSource &) = delete;
+
+    int init(const ReplicationConfig &config);
+    // Logs queued entries, then disconnects every replica.
+    void shutdown();
+    bool enabled() const { return running_; }
+
+    bool enqueue(std::string_view stream, const std::string &message, std::time_t timestamp);
+    // Runs on the writer thread after every published batch; set before init(), must not block.
+    void set_publish_hook(std::function<void()> hook) { publish_hook_ = std::move(hook); }
+    // Up to `max_records` entries from sequence `from` on, without waiting; `from` is clamped to
+    // the retained range, so 0 reads from the oldest entry. False when a segment cannot be read.
+    bool fetch(std::uint64_t from, std::size_t max_records, FetchBatch &batch);
+    // Sequence of the newest logged entry, 0 when the log is empty.
+    std::uint64_t head() const;
+    // Takes over `fd`, a log connection that opened with REPLICATE, and streams the log to it
+    // from `next_sequence` (from the oldest entry when `epoch` names another log). Closes `fd`
+    // and returns false when stopped or already serving kMaxReplicas.
+    bool attach(int fd, const std::string &name, std::uint64_t epoch, std::uint64_t next_sequence);
+    ReplicationStats stats() const;
+
+private:
+    struct Entry {
+        std::time_t timestamp;
+        std::string stream;
+        std::string message;
+    };
+
+    struct Cursor {
+        std::uint64_t segment;
+        std::uint64_t offset;
+        std::uint64_t next_sequence;
+        int fd;
+    };
+
+    enum class ReadResult {
+        Ok,
+        // The cursor's segment was deleted by retention.
+        Behind,
+        Failed,
+    };
+
+    // What STATS shows of one attached replica, read without replicas_mutex_. attach() fills
+    // the name before setting `live`; serve() clears `live` when the replica goes away.
+    struct ReplicaSlot {
+        SeqlockText<kReplicaNameBytes> name;
+        std::atomic<std::uint64_t> acked{0};
+        std::atomic<bool> live{false};
+    };
+
+    struct Replica {
+        std::string name;
+        int fd;
+        std::thread thread;
+        std::atomic<bool> finished;
+        ReplicaSlot *slot;
+    };
+
+    void write_loop();
+    void serve(Replica &replica, std::uint64_t epoch, std::uint64_t next_sequence);
+    bool recover();
+    bool open_write_segment();
+    std::string segment_path(std::uint64_t first_sequence) const;
+    void seek(Cursor &cursor, std::uint64_t sequence) const;
+    ReadResult read_batch(Cursor &cursor, std::size_t max_records, std::string &payload, std::size_t &records) const;
+    bool resume(Cursor &cursor, std::uint64_t sequence) const;
+    void remember(const Cursor &cursor);
+    // Copies next_sequence_ and segments_ into the atomics stats() reads; called under mutex_.
+    void publish_range_locked();
+
+    ReplicationConfig config_;
+    std::uint64_t epoch_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable write_condition_;
+    mutable std::condition_variable publish_condition_;
+    std::deque<Entry> queue_;
+    bool stop_;
+    bool running_;
+    std::thread writer_;
+    // Published log, under mutex_: first sequences of the retained segments (the last one is
+    // being appended to), the appended length of the last one, and the next sequence.
+    std::deque<std::uint64_t> segments_;
+    std::uint64_t published_offset_;
+    std::uint64_t next_sequence_;
+    // Newest and oldest retained sequences, for stats() to read without mutex_.
+    std::atomic<std::uint64_t> published_head_;
+    std::atomic<std::uint64_t> published_oldest_;
+
+    // Writer state.
+    std::FILE *write_file_;
+    std::uint64_t write_offset_;
+    std::string encode_scratch_;
+    std::function<void()> publish_hook_;
+
+    // FETCH state: the tail holds the entries from tail_first_ up to the published sequence and
+    // is filled by the writer before each batch is published; resume_ is a small ring of segment
+    // positions where earlier fetches stopped.
+    mutable std::mutex fetch_mutex_;
+    std::deque<Entry> tail_;
+    std::uint64_t tail_first_;
+    std::array<Cursor, kResumePositions> resume_;
+    std::size_t resume_next_;
+    std::atomic<unsigned long> fetched_memory_;
+    std::atomic<unsigned long> fetched_disk_;
+
+    mutable std::mutex replicas_mutex_;
+    std::list<std::unique_ptr<Replica>> replicas_;
+    std::array<ReplicaSlot, kMaxReplicas> replica_slots_;
+    std::atomic<unsigned long> log_failures_;
+};
+
+} // namespace logcrafter::cpp
+
+#endif // LOGCRAFTER_CPP_REPLICATION_HPP
@@ -0,0 +1,54 @@
+/*
+ * Sequence: SEQ0166
+ * Track: C++
+ * MVP: Step D
+ * Change: Declare the vectored response writer that batches query output into sendmsg calls.
+ * Tests: spec_protocol_happy_path, spec_large_query_response, logcrafter_cpp_bench_query_send (manual)
+ */
+#ifndef LOGCRAFTER_CPP_RESPONSE_WRITER_HPP
+#define LOGCRAFTER_CPP_RESPONSE_WRITER_HPP
+
+#include <cstddef>
+#include <string_view>
+#include <sys/uio.h>
+
+namespace logcrafter::cpp {
+
+// Gathers response fragments into an iovec batch and writes each batch with one sendmsg().
+// Fragments are referenced, not copied, so they must stay alive until finish() returns.
+// Every batch except the last is sent with MSG_MORE so the kernel packs full segments; the
+// last one clears the hint and pushes whatever is still queued.
+class ResponseWriter {
+public:
+    // Two iovecs per line keeps a batch well below IOV_MAX (1024 on Linux).
+    static constexpr std::size_t kMaxSegments = 512;
+    static constexpr std::size_t kMaxBatchBytes = 256 * 1024;
+
+    explicit ResponseWriter(int fd);
+
+    ResponseWriter(const ResponseWriter &) = delete;
+    ResponseWriter &operator=(const ResponseWriter &) = delete;
+
+    void append(std::string_view text);
+    void append_line(std::string_view line);
+    // Sends the remaining batch without MSG_MORE. Returns false once any send has failed;
+    // later appends are discarded after a failure.
+    bool finish();
+
+    bool failed() const { return failed_; }
+    std::size_t bytes_sent() const { return bytes_sent_; }
+
+private:
+    void flush(bool more);
+
+    int fd_;
+    iovec segments_[kMaxSegments];
+    std::size_t segment_count_;
+    std::size_t pending_bytes_;
+    std::size_t bytes_sent_;
+    bool failed_;
+};
+
+} // namespace logcrafter::cpp
+
+#endif // LOGCRAFTER_CPP_RESPONSE_WRITER_HPP
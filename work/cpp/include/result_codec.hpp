@@ -0,0 +1,62 @@
+/*
+ * Sequence: SEQ0305
+ * Track: C++
+ * MVP: Step D
+ * Change: Carry the context flag in result records.
+ * Tests: spec_query_context, spec_binary_query
+ */
+#ifndef LOGCRAFTER_CPP_RESULT_CODEC_HPP
+#define LOGCRAFTER_CPP_RESULT_CODEC_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+
+namespace logcrafter::cpp::result_codec {
+
+// format=binary: "BINARY: <n>\n" followed by n records. Record: u32 length of the rest |
+// i64 timestamp (epoch nanoseconds) | u64 sequence | u8 level | u8 stream length | stream |
+// message. Integers are big-endian, as in relay_codec.
+constexpr std::size_t kRecordHeaderBytes = 22;
+constexpr std::string_view kBinaryPrefix = "BINARY: ";
+// format=ndjson: "NDJSON: <n>\n" followed by n lines of
+// {"ts_ns":...,"seq":...,"level":"...","stream":"...","message":"..."}.
+constexpr std::string_view kNdjsonPrefix = "NDJSON: ";
+
+enum class Level : std::uint8_t {
+    Unknown = 0,
+    Debug = 1,
+    Info = 2,
+    Warning = 3,
+    Error = 4,
+};
+constexpr std::size_t kLevelCount = 5;
+
+struct Record {
+    std::int64_t timestamp_ns;
+    std::uint64_t sequence;
+    Level level;
+    std::string_view stream;
+    std::string_view message;
+    // A before=/after= neighbour; NDJSON only, binary records never carry one.
+    bool context;
+};
+
+// The most severe of error/warn/info/debug found in the message, ignoring case; the same
+// words route lines to the #logs-* IRC channels.
+Level classify_level(std::string_view message);
+std::string_view level_name(Level level);
+
+// Writes the fixed part of `record` (kRecordHeaderBytes) to `out`; stream and message follow
+// it on the wire. Streams longer than 255 bytes are cut.
+void encode_record_header(const Record &record, char *out);
+// Reads the record at `offset` and advances past it; false if the bytes there are not a whole record.
+bool next_record(std::string_view payload, std::size_t &offset, Record &record);
+
+void append_ndjson(std::pmr::string &out, const Record &record);
+
+} // namespace logcrafter::cpp::result_codec
+
+#endif // LOGCRAFTER_CPP_RESULT_CODEC_HPP
@@ -0,0 +1,33 @@
+/*
+ * Sequence: SEQ0207
+ * Track: C++
+ * MVP: Step D
+ * Change: Declare the newest-first k-way merge of formatted query results with early termination at a limit.
+ * Tests: spec_federated_query
+ */
+#ifndef LOGCRAFTER_CPP_RESULT_MERGE_HPP
+#define LOGCRAFTER_CPP_RESULT_MERGE_HPP
+
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+namespace logcrafter::cpp {
+
+struct MergedLine {
+    std::string_view line;
+    std::size_t source;
+};
+
+// Merges formatted result lines ("[YYYY-MM-DD HH:MM:SS] message") from several sources by
+// their timestamp text, which sorts lexicographically. A source may hold several ascending
+// runs back to back (one per stream); each maximal run is merged on its own. The merge walks
+// from the newest line down and stops after `limit` lines (0 = all), so a small limit costs
+// O(limit log runs) no matter how many lines the sources hold. `out` ends up ascending; equal
+// stamps keep source order, then line order.
+void merge_newest(const std::vector<std::vector<std::string_view>> &sources, std::size_t limit,
+                  std::vector<MergedLine> &out);
+
+} // namespace logcrafter::cpp
+
+#endif // LOGCRAFTER_CPP_RESULT_MERGE_HPP
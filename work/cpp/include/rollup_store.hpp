@@ -0,0 +1,119 @@
+/*
+ * Sequence: SEQ0259
+ * Track: C++
+ * MVP: Step D
+ * Change: Declare the per-second and per-minute rollup rings kept on the ingest path.
+ * Tests: spec_rollup
+ */
+#ifndef LOGCRAFTER_CPP_ROLLUP_STORE_HPP
+#define LOGCRAFTER_CPP_ROLLUP_STORE_HPP
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "query_parser.hpp"
+#include "result_codec.hpp"
+
+namespace logcrafter::cpp {
+
+struct RollupConfig {
+    // Where the rings are saved across restarts; empty keeps them in memory only.
+    std::string state_path;
+    int save_interval_ms;
+};
+
+struct RollupStats {
+    std::size_t sources;
+    // Entries older than the per-minute ring still covers when they arrived.
+    unsigned long late_entries;
+    unsigned long queries;
+    unsigned long saves;
+    unsigned long save_failures;
+};
+
+// Counts every stored entry by level and source into two fixed rings of buckets (one per
+// second for the last hour, one per minute for the last day), indexed by bucket modulo the
+// ring size. ROLLUP reads the rings directly, so its answer does not depend on what the
+// buffers still hold. The first kMaxSources source names get their own counters; the rest
+// share "other".
+class RollupStore {
+public:
+    static constexpr std::size_t kSecondBuckets = 3600;
+    static constexpr std::size_t kMinuteBuckets = 1440;
+    static constexpr std::size_t kMaxSources = 16;
+    static constexpr std::size_t kDefaultBuckets = 60;
+    static constexpr int kDefaultSaveIntervalMs = 1000;
+    static constexpr std::string_view kOtherSource = "other";
+
+    RollupStore();
+    ~RollupStore();
+
+    RollupStore(const RollupStore &) = delete;
+    RollupStore &operator=(const RollupStore &) = delete;
+
+    // Clears the rings and, with a state path, reloads them and starts the saver thread.
+    int init(const RollupConfig &config);
+    // Stops the saver and writes the rings one last time.
+    void shutdown();
+
+    void record(std::string_view source, result_codec::Level level, std::time_t timestamp);
+    // Writes the whole ROLLUP response, or an ERROR line.
+    void answer(const RollupRequest &request, std::string &out) const;
+
+    RollupStats stats() const;
+
+private:
+    static constexpr std::size_t kSourceSlots = kMaxSources + 1;
+    static constexpr std::size_t kCells = kSourceSlots * result_codec::kLevelCount;
+
+    struct Bucket {
+        // Seconds or minutes since the epoch; -1 while the slot has never been used.
+        std::int64_t index = -1;
+        std::array<std::uint32_t, kCells> counts{};
+    };
+
+    struct Ring {
+        std::int64_t width_seconds;
+        std::vector<Bucket> buckets;
+        // Newest bucket index recorded; -1 while empty.
+        std::int64_t newest;
+    };
+
+    std::size_t source_slot_locked(std::string_view source);
+    static bool add_locked(Ring &ring, std::int64_t index, std::size_t cell);
+    bool load();
+    bool save();
+    void run();
+
+    RollupConfig config_;
+
+    mutable std::mutex mutex_;
+    Ring seconds_;
+    Ring minutes_;
+    std::vector<std::string> sources_;
+    bool dirty_;
+    // Read by stats() without the mutex, so STATS never waits behind record().
+    std::atomic<std::size_t> source_count_;
+    std::atomic<unsigned long> late_entries_;
+    mutable std::atomic<unsigned long> queries_;
+
+    std::mutex saver_mutex_;
+    std::condition_variable saver_condition_;
+    bool stop_;
+    std::thread saver_;
+    std::atomic<unsigned long> saves_;
+    std::atomic<unsigned long> save_failures_;
+};
+
+} // namespace logcrafter::cpp
+
+#endif // LOGCRAFTER_CPP_ROLLUP_STORE_HPP
@@ -0,0 +1,78 @@
+/*
+ * Sequence: SEQ0146
+ * Track: C++
+ * MVP: Step D
+ * Change: Add a fixed-capacity seqlock-published text slot for wait-free reads of slow-changing STATS fragments.
+ * Tests: spec_stats_polling, spec_source_quotas
+ */
+#ifndef LOGCRAFTER_CPP_SEQLOCK_TEXT_HPP
+#define LOGCRAFTER_CPP_SEQLOCK_TEXT_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+namespace logcrafter::cpp {
+
+// Text published by a single (externally serialised) writer and copied out by any number of
+// readers without taking a lock, using the same seqlock scheme as ClockService. Text longer
+// than `Capacity` is cut short.
+template <std::size_t Capacity>
+class SeqlockText {
+public:
+    SeqlockText() : sequence_(0), length_(0), words_{} {}
+
+    SeqlockText(const SeqlockText &) = delete;
+    SeqlockText &operator=(const SeqlockText &) = delete;
+
+    void publish(std::string_view text) {
+        const std::size_t length = text.size() < Capacity ? text.size() : Capacity;
+        std::uint64_t words[kWords] = {};
+        std::memcpy(words, text.data(), length);
+
+        const std::uint64_t sequence = sequence_.load(std::memory_order_relaxed);
+        sequence_.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (std::size_t i = 0; i < kWords; ++i) {
+            words_[i].store(words[i], std::memory_order_relaxed);
+        }
+        length_.store(length, std::memory_order_relaxed);
+        sequence_.store(sequence + 2, std::memory_order_release);
+    }
+
+    // Returns false (leaving `out` empty) only if a writer kept the slot busy for every retry.
+    bool read(std::string &out) const {
+        std::uint64_t words[kWords];
+        for (int attempt = 0; attempt < 16; ++attempt) {
+            const std::uint64_t before = sequence_.load(std::memory_order_acquire);
+            if ((before & 1U) != 0) {
+                continue;
+            }
+            const std::size_t length = length_.load(std::memory_order_relaxed);
+            for (std::size_t i = 0; i < kWords; ++i) {
+                words[i] = words_[i].load(std::memory_order_relaxed);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (sequence_.load(std::memory_order_relaxed) == before) {
+                out.assign(reinterpret_cast<const char *>(words), length);
+                return true;
+            }
+        }
+        out.clear();
+        return false;
+    }
+
+private:
+    static constexpr std::size_t kWords = (Capacity + sizeof(std::uint64_t) - 1) / sizeof(std::uint64_t);
+
+    std::atomic<std::uint64_t> sequence_;
+    std::atomic<std::size_t> length_;
+    std::atomic<std::uint64_t> words_[kWords];
+};
+
+} // namespace logcrafter::cpp
+
+#endif // LOGCRAFTER_CPP_SEQLOCK_TEXT_HPP
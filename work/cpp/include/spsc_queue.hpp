@@ -0,0 +1,92 @@
+/*
+ * Sequence: SEQ0332
+ * Track: C++
+ * MVP: Step D
+ * Change: Add a bounded single-producer/single-consumer ring for handing entries between ingest stages.
+ * Tests: spec_ingest_pipeline
+ */
+#ifndef LOGCRAFTER_CPP_SPSC_QUEUE_HPP
+#define LOGCRAFTER_CPP_SPSC_QUEUE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+namespace logcrafter::cpp {
+
+// Fixed ring of default-constructible slots with one producer and one consumer thread (either
+// may change over time if the hand-over is externally serialised). Each side owns its index
+// and keeps a cached copy of the other's, so an uncontended push or pop touches one shared
+// cache line. The capacity is rounded up to a power of two.
+template <typename T>
+class SpscQueue {
+public:
+    explicit SpscQueue(std::size_t capacity)
+        : capacity_(round_up(capacity)), slots_(new T[capacity_]), head_(0), cached_tail_(0), tail_(0),
+          cached_head_(0) {}
+
+    SpscQueue(const SpscQueue &) = delete;
+    SpscQueue &operator=(const SpscQueue &) = delete;
+
+    // Producer only; leaves `value` untouched when the ring is full.
+    bool try_push(T &value) {
+        const std::size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - cached_head_ == capacity_) {
+            cached_head_ = head_.load(std::memory_order_acquire);
+            if (tail - cached_head_ == capacity_) {
+                return false;
+            }
+        }
+        slots_[tail & (capacity_ - 1)] = std::move(value);
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer only.
+    bool try_pop(T &out) {
+        const std::size_t head = head_.load(std::memory_order_relaxed);
+        if (head == cached_tail_) {
+            cached_tail_ = tail_.load(std::memory_order_acquire);
+            if (head == cached_tail_) {
+                return false;
+            }
+        }
+        out = std::move(slots_[head & (capacity_ - 1)]);
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Any thread; a snapshot that may be stale by the time it is used.
+    std::size_t size() const {
+        const std::size_t head = head_.load(std::memory_order_acquire);
+        const std::size_t tail = tail_.load(std::memory_order_acquire);
+        return tail >= head ? tail - head : 0;
+    }
+
+    std::size_t capacity() const { return capacity_; }
+
+private:
+    static constexpr std::size_t kCacheLine = 64;
+
+    static std::size_t round_up(std::size_t capacity) {
+        std::size_t rounded = 2;
+        while (rounded < capacity) {
+            rounded <<= 1;
+        }
+        return rounded;
+    }
+
+    const std::size_t capacity_;
+    const std::unique_ptr<T[]> slots_;
+    // Consumer side.
+    alignas(kCacheLine) std::atomic<std::size_t> head_;
+    std::size_t cached_tail_;
+    // Producer side.
+    alignas(kCacheLine) std::atomic<std::size_t> tail_;
+    std::size_t cached_head_;
+};
+
+} // namespace logcrafter::cpp
+
+#endif // LOGCRAFTER_CPP_SPSC_QUEUE_HPP
@@ -0,0 +1,104 @@
+/*
+ * Sequence: SEQ0292
+ * Track: C++
+ * MVP: Step D
+ * Change: Carry level shares into every stream's buffer.
+ * Tests: spec_severity_rings
+ */
+#ifndef LOGCRAFTER_CPP_STREAM_REGISTRY_HPP
+#define LOGCRAFTER_CPP_STREAM_REGISTRY_HPP
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "log_buffer.hpp"
+#include "persistence.hpp"
+
+namespace logcrafter::cpp {
+
+struct StreamDeclaration {
+    std::string name;
+    // 0 = the default capacity.
+    std::size_t capacity;
+};
+
+struct StreamSettings {
+    std::size_t default_capacity;
+    std::size_t reorder_window;
+    // Every stream's buffer is split into severity rings with these shares; all zero keeps one.
+    LevelShares level_shares;
+    bool persistence_enabled;
+    // The default stream persists into persistence.directory; named streams into
+    // persistence.directory/<name>.
+    PersistenceConfig persistence;
+    std::vector<StreamDeclaration> declared;
+};
+
+// Fixed table of streams. Slots are filled once and published through an acquire/release
+// count, so ingest and queries resolve ids and read stream state without taking a lock; only
+// creating a stream serialises on a mutex. Stream 0 is the default stream and always exists.
+class StreamRegistry {
+public:
+    using StreamId = std::size_t;
+
+    static constexpr StreamId kDefaultStream = 0;
+    static constexpr const char *kDefaultStreamName = "default";
+    static constexpr std::size_t kMaxStreams = 32;
+    static constexpr std::size_t kMaxNameLength = 32;
+
+    struct Stream {
+        explicit Stream(std::string stream_name) : name(std::move(stream_name)), persistent(false) {}
+
+        const std::string name;
+        LogBuffer buffer;
+        PersistenceManager persistence;
+        bool persistent;
+    };
+
+    StreamRegistry();
+
+    StreamRegistry(const StreamRegistry &) = delete;
+    StreamRegistry &operator=(const StreamRegistry &) = delete;
+
+    // configure() and reset() must not race with ingest or queries. configure() creates the
+    // declared streams plus any stream with a persistence subdirectory from an earlier run and
+    // replays their history; it fails only if the default stream cannot persist.
+    int configure(const StreamSettings &settings);
+    void reset();
+
+    // 1-32 characters of [A-Za-z0-9_-], so a name is always a safe directory component.
+    static bool valid_name(std::string_view name);
+
+    // Resolves `name`, creating the stream with the default capacity on first use. Fails for
+    // invalid names and once kMaxStreams exist.
+    bool open(std::string_view name, StreamId &id);
+    bool find(std::string_view name, StreamId &id) const;
+
+    std::size_t count() const { return count_.load(std::memory_order_acquire); }
+    Stream &at(StreamId id) { return *streams_[id]; }
+    const Stream &at(StreamId id) const { return *streams_[id]; }
+    Stream &default_stream() { return *streams_[kDefaultStream]; }
+
+    // Sums over every stream; lock-free like the per-stream stats() calls they are built from.
+    LogBufferStats buffer_totals() const;
+    PersistenceStats persistence_totals() const;
+
+private:
+    bool create_locked(std::string_view name, std::size_t capacity, StreamId &id);
+    void attach_persistence(Stream &stream, const std::string &directory);
+
+    std::array<std::unique_ptr<Stream>, kMaxStreams> streams_;
+    std::atomic<std::size_t> count_;
+    std::mutex create_mutex_;
+    StreamSettings settings_;
+};
+
+} // namespace logcrafter::cpp
+
+#endif // LOGCRAFTER_CPP_STREAM_REGISTRY_HPP
@@ -0,0 +1,45 @@
+/*
+ * Sequence: SEQ0128
+ * Track: C++
+ * MVP: Step D
+ * Change: Declare fixed-format parsers for leading client timestamps (RFC 3339, epoch, persistence brackets).
+ * Tests: spec_client_timestamps, smoke_persistence_toggle
+ */
+#ifndef LOGCRAFTER_CPP_TIMESTAMP_PARSER_HPP
+#define LOGCRAFTER_CPP_TIMESTAMP_PARSER_HPP
+
+#include <cstddef>
+#include <ctime>
+#include <string_view>
+
+namespace logcrafter::cpp {
+
+struct LeadingTimestamp {
+    enum class Format {
+        None,
+        Rfc3339,
+        EpochSeconds,
+        EpochMillis,
+        Bracketed,
+    };
+
+    Format format = Format::None;
+    std::time_t seconds = 0;
+    int millis = 0;
+    // Bytes consumed from the line, including the whitespace separating stamp and message.
+    std::size_t length = 0;
+};
+
+// Recognises, at the very start of `line`:
+//   2024-05-01T12:00:00Z, 2024-05-01T12:00:00.123+09:00, 2024-05-01 12:00:00Z (RFC 3339)
+//   1714564800 / 1714564800123 followed by whitespace (epoch seconds / milliseconds)
+//   [2024-05-01 12:00:00] (persistence format, local time)
+// Returns false and leaves `out.format == None` when no stamp is present.
+bool parse_leading_timestamp(std::string_view line, LeadingTimestamp &out);
+
+// Only the persistence `[YYYY-MM-DD HH:MM:SS] ` prefix; used by replay.
+bool parse_bracketed_timestamp(std::string_view line, LeadingTimestamp &out);
+
+} // namespace logcrafter::cpp
+
+#endif // LOGCRAFTER_CPP_TIMESTAMP_PARSER_HPP
@@ -0,0 +1,310 @@
+/*
+ * Sequence: SEQ0308
+ * Track: C++
+ * MVP: Step D
+ * Change: Reject before= and after= in alert rule filters.
+ * Tests: spec_alert_rules
+ */
+#include "alert_engine.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+#include "clock_service.hpp"
+#include "log_buffer.hpp"
+
+namespace logcrafter::cpp {
+
+namespace {
+
+constexpr std::string_view kWhitespace = " \t\r\n";
+constexpr std::size_t kRuleLineBytes = 1024;
+// Alert text carries the line that crossed the threshold, cut to keep IRC lines short.
+constexpr std::size_t kMaxQuotedMessage = 200;
+
+bool parse_long(std::string_view value, long long minimum, long long maximum, long long &out) {
+    const std::string text(value);
+    char *end = nullptr;
+    errno = 0;
+    const long long parsed = std::strtoll(text.c_str(), &end, 10);
+    if (text.empty() || *end != '\0' || errno != 0 || parsed < minimum || parsed > maximum) {
+        return false;
+    }
+    out = parsed;
+    return true;
+}
+
+} // namespace
+
+AlertEngine::AlertEngine() : rules_(), notify_(), state_mutex_(), matched_(0), fired_(0), log_mutex_(), logs_() {}
+
+AlertEngine::~AlertEngine() { reset(); }
+
+int AlertEngine::load(const std::string &path, Notify notify, std::string &error) {
+    reset();
+    error.clear();
+
+    std::FILE *file = std::fopen(path.c_str(), "r");
+    if (file == nullptr) {
+        error = path + ": " + std::strerror(errno);
+        return -1;
+    }
+    std::vector<Rule> rules;
+    char line[kRuleLineBytes];
+    unsigned line_number = 0;
+    while (std::fgets(line, sizeof(line), file) != nullptr) {
+        ++line_number;
+        const std::string_view text(line);
+        const std::size_t first = text.find_first_not_of(kWhitespace);
+        if (first == std::string_view::npos || text[first] == '#') {
+            continue;
+        }
+        Rule rule;
+        if (!parse_rule(text, rule, error)) {
+            error = path + ":" + std::to_string(line_number) + ": " + error;
+            break;
+        }
+        const bool duplicate = std::any_of(rules.begin(), rules.end(),
+                                           [&rule](const Rule &other) { return other.name == rule.name; });
+        if (duplicate) {
+            error = path + ":" + std::to_string(line_number) + ": duplicate rule name '" + rule.name + "'";
+            break;
+        }
+        rules.push_back(std::move(rule));
+    }
+    std::fclose(file);
+    if (!error.empty()) {
+        return -1;
+    }
+
+    for (const Rule &rule : rules) {
+        if (rule.log_path.empty() || logs_.count(rule.log_path) != 0) {
+            continue;
+        }
+        std::FILE *log = std::fopen(rule.log_path.c_str(), "a");
+        if (log == nullptr) {
+            error = rule.log_path + ": " + std::strerror(errno);
+            reset();
+            return -1;
+        }
+        logs_.emplace(rule.log_path, log);
+    }
+    rules_ = std::move(rules);
+    notify_ = std::move(notify);
+    return 0;
+}
+
+void AlertEngine::reset() {
+    {
+        std::lock_guard<std::mutex> lock(log_mutex_);
+        for (auto &entry : logs_) {
+            std::fclose(entry.second);
+        }
+        logs_.clear();
+    }
+    std::lock_guard<std::mutex> lock(state_mutex_);
+    rules_.clear();
+    notify_ = nullptr;
+    matched_.store(0, std::memory_order_relaxed);
+    fired_.store(0, std::memory_order_relaxed);
+}
+
+bool AlertEngine::needs_irc() const {
+    return std::any_of(rules_.begin(), rules_.end(), [](const Rule &rule) { return !rule.channel.empty(); });
+}
+
+bool AlertEngine::parse_rule(std::string_view line, Rule &rule, std::string &error) {
+    std::string filters;
+    bool has_window = false;
+    bool has_threshold = false;
+    double rate = 0.0;
+    std::size_t position = line.find_first_not_of(kWhitespace);
+    while (position != std::string_view::npos) {
+        const std::size_t end = line.find_first_of(kWhitespace, position);
+        const std::string_view token = line.substr(position, end == std::string_view::npos ? end : end - position);
+        position = line.find_first_not_of(kWhitespace, end);
+
+        const std::size_t equals = token.find('=');
+        const std::string_view key = token.substr(0, equals);
+        const std::string_view value = equals == std::string_view::npos ? std::string_view() : token.substr(equals + 1);
+        long long number = 0;
+        if (rule.name.empty()) {
+            if (equals != std::string_view::npos) {
+                error = "a rule starts with its name";
+                return false;
+            }
+            rule.name.assign(token.data(), token.size());
+        } else if (key == "window") {
+            if (has_window || !parse_long(value, 1, kMaxWindowSeconds, number)) {
+                error = "window must be 1-" + std::to_string(kMaxWindowSeconds) + " seconds, given once";
+                return false;
+            }
+            has_window = true;
+            rule.window_seconds = number;
+        } else if (key == "count") {
+            if (has_threshold || !parse_long(value, 1, 1000000000, number)) {
+                error = "give one threshold: count=<n> (n >= 1) or rate=<per second>";
+                return false;
+            }
+            has_threshold = true;
+            rule.threshold = static_cast<unsigned long>(number);
+        } else if (key == "rate") {
+            char *end_rate = nullptr;
+            const std::string text(value);
+            rate = std::strtod(text.c_str(), &end_rate);
+            if (has_threshold || text.empty() || *end_rate != '\0' || !(rate > 0.0) || rate > 1e9) {
+                error = "give one threshold: count=<n> (n >= 1) or rate=<per second>";
+                return false;
+            }
+            has_threshold = true;
+        } else if (key == "notify") {
+            if (!rule.channel.empty() || value.size() < 2 || value.front() != '#') {
+                error = "notify must name one #channel";
+                return false;
+            }
+            rule.channel.assign(value.data(), value.size());
+        } else if (key == "log") {
+            if (!rule.log_path.empty() || value.empty()) {
+                error = "log must name one file";
+                return false;
+            }
+            rule.log_path.assign(value.data(), value.size());
+        } else {
+            filters += ' ';
+            filters.append(token.data(), token.size());
+        }
+    }
+
+    if (!has_window || !has_threshold) {
+        error = "rule '" + rule.name + "' needs window= and count= or rate=";
+        return false;
+    }
+    if (rule.channel.empty() && rule.log_path.empty()) {
+        error = "rule '" + rule.name + "' needs notify=<#channel> or log=<path>";
+        return false;
+    }
+    if (rate > 0.0) {
+        rule.threshold = static_cast<unsigned long>(std::ceil(rate * static_cast<double>(rule.window_seconds)));
+    }
+    if (!parse_query_arguments(filters, rule.filter, error)) {
+        return false;
+    }
+    const QueryRequest &filter = rule.filter;
+    if (filter.has_time_from || filter.has_time_to || filter.limit != 0 || filter.scope != QueryRequest::Scope::Local ||
+        filter.has_compression || filter.format != QueryRequest::Format::Text || filter.before != 0 ||
+        filter.after != 0) {
+        error = "rule '" + rule.name + "' may only use keyword=, keywords=, operator=, regex=, level=, and stream=";
+        return false;
+    }
+    rule.buckets.assign(static_cast<std::size_t>(rule.window_seconds), 0);
+    return true;
+}
+
+void AlertEngine::advance(Rule &rule, std::int64_t now) {
+    if (rule.head < 0) {
+        rule.head = now;
+        return;
+    }
+    if (now <= rule.head) {
+        return;
+    }
+    // Each second is cleared once as time passes it, so updates stay O(1) amortised.
+    const std::int64_t steps = std::min(now - rule.head, rule.window_seconds);
+    for (std::int64_t step = 1; step <= steps; ++step) {
+        std::uint32_t &bucket = rule.buckets[static_cast<std::size_t>((rule.head + step) % rule.window_seconds)];
+        rule.sum -= bucket;
+        bucket = 0;
+    }
+    rule.head = now;
+}
+
+void AlertEngine::evaluate(std::string_view stream, const std::string &message, std::time_t timestamp) {
+    if (rules_.empty()) {
+        return;
+    }
+    const std::time_t now = ClockService::instance().now_seconds();
+    for (Rule &rule : rules_) {
+        const QueryRequest &filter = rule.filter;
+        if (!filter.streams.empty() &&
+            std::find(filter.streams.begin(), filter.streams.end(), stream) == filter.streams.end()) {
+            continue;
+        }
+        if (!log_buffer_detail::entry_matches(message, timestamp, filter)) {
+            continue;
+        }
+
+        unsigned long count = 0;
+        bool fire = false;
+        {
+            std::lock_guard<std::mutex> lock(state_mutex_);
+            matched_.fetch_add(1, std::memory_order_relaxed);
+            advance(rule, now);
+            if (rule.sum < rule.threshold) {
+                rule.firing = false;
+            }
+            ++rule.buckets[static_cast<std::size_t>(rule.head % rule.window_seconds)];
+            count = ++rule.sum;
+            if (!rule.firing && count >= rule.threshold) {
+                rule.firing = true;
+                ++rule.fired;
+                fired_.fetch_add(1, std::memory_order_relaxed);
+                fire = true;
+            }
+        }
+        if (fire) {
+            raise(rule, count, message, now);
+        }
+    }
+}
+
+void AlertEngine::raise(const Rule &rule, unsigned long count, const std::string &message, std::time_t now) {
+    std::string text = "ALERT " + rule.name + ": " + std::to_string(count) + " matching lines in " +
+                       std::to_string(rule.window_seconds) + "s (threshold " + std::to_string(rule.threshold) +
+                       "), latest: ";
+    text.append(message, 0, kMaxQuotedMessage);
+
+    if (!rule.channel.empty() && notify_) {
+        notify_(rule.channel, text);
+    }
+    if (!rule.log_path.empty()) {
+        char stamp[32];
+        const std::size_t stamp_length = ClockService::instance().format_timestamp(now, stamp, sizeof(stamp));
+        std::lock_guard<std::mutex> lock(log_mutex_);
+        const auto it = logs_.find(rule.log_path);
+        if (it != logs_.end()) {
+            std::fprintf(it->second, "[%.*s] %s\n", static_cast<int>(stamp_length), stamp, text.c_str());
+            std::fflush(it->second);
+        }
+    }
+}
+
+std::string AlertEngine::describe() const {
+    const std::int64_t now = ClockService::instance().now_seconds();
+    std::lock_guard<std::mutex> lock(state_mutex_);
+    std::string out = "ALERTS: " + std::to_string(rules_.size()) + "\n";
+    for (const Rule &rule : rules_) {
+        // Buckets older than the window are only cleared by the next match; leave them out here.
+        unsigned long count = 0;
+        if (rule.head >= 0 && now - rule.head < rule.window_seconds) {
+            count = rule.sum;
+            for (std::int64_t second = rule.head - rule.window_seconds + 1; second <= now - rule.window_seconds;
+                 ++second) {
+                count -= rule.buckets[static_cast<std::size_t>(((second % rule.window_seconds) + rule.window_seconds) %
+                                                               rule.window_seconds)];
+            }
+        }
+        out += rule.name + " count=" + std::to_string(count) + " threshold=" + std::to_string(rule.threshold) +
+               " window=" + std::to_string(rule.window_seconds) + "s fired=" + std::to_string(rule.fired) +
+               " state=" + (rule.firing && count >= rule.threshold ? "firing" : "ok") + "\n";
+    }
+    return out;
+}
+
+AlertStats AlertEngine::stats() const {
+    return AlertStats{rules_.size(), matched_.load(std::memory_order_relaxed), fired_.load(std::memory_order_relaxed)};
+}
+
+} // namespace logcrafter::cpp
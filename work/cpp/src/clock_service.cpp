@@ -0,0 +1,212 @@
+/*
+ * Sequence: SEQ0120
+ * Track: C++
+ * MVP: Step D
+ * Change: Implement the ticker-driven coarse clock with seqlock-published timestamp text and per-thread minute caches.
+ * Tests: spec_protocol_happy_path, integration_cpp_irc_feature, smoke_persistence_toggle
+ */
+#include "clock_service.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <time.h>
+
+namespace logcrafter::cpp {
+
+namespace {
+
+constexpr const char kEpochText[] = "1970-01-01 00:00:00";
+
+struct MinuteCache {
+    std::time_t minute_start = -1;
+    char text[ClockService::kTimestampLength + 1] = {};
+};
+
+thread_local MinuteCache g_minute_cache;
+
+std::int64_t read_clock_millis(clockid_t clock) {
+    struct timespec ts {};
+    if (::clock_gettime(clock, &ts) != 0) {
+        return static_cast<std::int64_t>(std::time(nullptr)) * 1000;
+    }
+    return static_cast<std::int64_t>(ts.tv_sec) * 1000 + ts.tv_nsec / 1000000;
+}
+
+// Formats `timestamp` in local time and returns the second-of-minute, or -1 when the
+// conversion failed and the epoch placeholder was written instead.
+int format_local(std::time_t timestamp, char *out) {
+    std::tm tm_value{};
+#if defined(_POSIX_THREAD_SAFE_FUNCTIONS)
+    const bool converted = localtime_r(&timestamp, &tm_value) != nullptr;
+#else
+    std::tm *tmp = std::localtime(&timestamp);
+    const bool converted = tmp != nullptr;
+    if (converted) {
+        tm_value = *tmp;
+    }
+#endif
+    if (!converted ||
+        std::strftime(out, ClockService::kTimestampLength + 1, "%Y-%m-%d %H:%M:%S", &tm_value) !=
+            ClockService::kTimestampLength) {
+        std::memcpy(out, kEpochText, sizeof(kEpochText));
+        return -1;
+    }
+    return tm_value.tm_sec;
+}
+
+void write_seconds(char *text, int second) {
+    text[17] = static_cast<char>('0' + second / 10);
+    text[18] = static_cast<char>('0' + second % 10);
+}
+
+} // namespace
+
+ClockService &ClockService::instance() {
+    static ClockService service;
+    return service;
+}
+
+ClockService::ClockService()
+    : running_(false),
+      millis_(0),
+      seconds_(0),
+      text_sequence_(0),
+      text_second_(-1),
+      text_words_{},
+      lifecycle_mutex_(),
+      users_(0),
+      ticker_() {}
+
+ClockService::~ClockService() {
+    std::lock_guard<std::mutex> lock(lifecycle_mutex_);
+    running_.store(false, std::memory_order_release);
+    if (ticker_.joinable()) {
+        ticker_.join();
+    }
+}
+
+int ClockService::start(std::chrono::milliseconds tick) {
+    std::lock_guard<std::mutex> lock(lifecycle_mutex_);
+    if (users_++ > 0) {
+        return 0;
+    }
+    if (tick.count() <= 0) {
+        tick = kDefaultTick;
+    }
+
+    publish(read_clock_millis(CLOCK_REALTIME));
+    running_.store(true, std::memory_order_release);
+    try {
+        ticker_ = std::thread(&ClockService::ticker_loop, this, tick);
+    } catch (...) {
+        running_.store(false, std::memory_order_release);
+        users_ = 0;
+        return -1;
+    }
+    return 0;
+}
+
+void ClockService::stop() {
+    std::lock_guard<std::mutex> lock(lifecycle_mutex_);
+    if (users_ == 0 || --users_ > 0) {
+        return;
+    }
+    running_.store(false, std::memory_order_release);
+    if (ticker_.joinable()) {
+        ticker_.join();
+    }
+}
+
+std::time_t ClockService::now_seconds() const {
+    if (running_.load(std::memory_order_acquire)) {
+        return static_cast<std::time_t>(seconds_.load(std::memory_order_relaxed));
+    }
+    return static_cast<std::time_t>(read_clock_millis(CLOCK_REALTIME_COARSE) / 1000);
+}
+
+std::int64_t ClockService::now_millis() const {
+    if (running_.load(std::memory_order_acquire)) {
+        return millis_.load(std::memory_order_relaxed);
+    }
+    return read_clock_millis(CLOCK_REALTIME_COARSE);
+}
+
+std::size_t ClockService::format_timestamp(std::time_t timestamp, char *buffer, std::size_t capacity) const {
+    if (buffer == nullptr || capacity <= kTimestampLength) {
+        return 0;
+    }
+
+    if (copy_published(timestamp, buffer)) {
+        buffer[kTimestampLength] = '\0';
+        return kTimestampLength;
+    }
+
+    MinuteCache &cache = g_minute_cache;
+    if (cache.minute_start >= 0 && timestamp >= cache.minute_start && timestamp < cache.minute_start + 60) {
+        std::memcpy(buffer, cache.text, kTimestampLength);
+        write_seconds(buffer, static_cast<int>(timestamp - cache.minute_start));
+        buffer[kTimestampLength] = '\0';
+        return kTimestampLength;
+    }
+
+    const int second = format_local(timestamp, buffer);
+    if (second >= 0) {
+        cache.minute_start = timestamp - second;
+        std::memcpy(cache.text, buffer, kTimestampLength + 1);
+    }
+    return kTimestampLength;
+}
+
+void ClockService::ticker_loop(std::chrono::milliseconds tick) {
+    while (running_.load(std::memory_order_acquire)) {
+        std::this_thread::sleep_for(tick);
+        publish(read_clock_millis(CLOCK_REALTIME));
+    }
+}
+
+void ClockService::publish(std::int64_t millis) {
+    const std::int64_t second = millis / 1000;
+    millis_.store(millis, std::memory_order_relaxed);
+    seconds_.store(second, std::memory_order_relaxed);
+    if (text_second_.load(std::memory_order_relaxed) == second) {
+        return;
+    }
+
+    char text[sizeof(text_words_)] = {};
+    format_local(static_cast<std::time_t>(second), text);
+    std::uint64_t words[3];
+    std::memcpy(words, text, sizeof(words));
+
+    const std::uint64_t sequence = text_sequence_.load(std::memory_order_relaxed);
+    text_sequence_.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (std::size_t i = 0; i < 3; ++i) {
+        text_words_[i].store(words[i], std::memory_order_relaxed);
+    }
+    text_second_.store(second, std::memory_order_relaxed);
+    text_sequence_.store(sequence + 2, std::memory_order_release);
+}
+
+bool ClockService::copy_published(std::time_t timestamp, char *out) const {
+    for (int attempt = 0; attempt < 4; ++attempt) {
+        const std::uint64_t before = text_sequence_.load(std::memory_order_acquire);
+        if ((before & 1U) != 0) {
+            continue;
+        }
+        if (text_second_.load(std::memory_order_relaxed) != static_cast<std::int64_t>(timestamp)) {
+            return false;
+        }
+        std::uint64_t words[3];
+        for (std::size_t i = 0; i < 3; ++i) {
+            words[i] = text_words_[i].load(std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (text_sequence_.load(std::memory_order_relaxed) == before) {
+            std::memcpy(out, words, kTimestampLength);
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace logcrafter::cpp
@@ -0,0 +1,155 @@
+/*
+ * Sequence: SEQ0230
+ * Track: C++
+ * MVP: Step D
+ * Change: Deflate query responses through fixed staging and output chunks and account the CPU time spent.
+ * Tests: spec_compressed_query
+ */
+#include "compressed_response_writer.hpp"
+
+#include <cerrno>
+#include <cstdio>
+#include <ctime>
+#include <sys/socket.h>
+
+#ifdef LOGCRAFTER_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+namespace logcrafter::cpp {
+
+namespace {
+
+unsigned long long thread_cpu_micros() {
+    struct timespec now {};
+    ::clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+    return static_cast<unsigned long long>(now.tv_sec) * 1000000ULL +
+           static_cast<unsigned long long>(now.tv_nsec) / 1000ULL;
+}
+
+} // namespace
+
+struct CompressedResponseWriter::Stream {
+#ifdef LOGCRAFTER_HAVE_ZLIB
+    z_stream zs{};
+#endif
+    bool ready = false;
+};
+
+bool CompressedResponseWriter::available() {
+#ifdef LOGCRAFTER_HAVE_ZLIB
+    return true;
+#else
+    return false;
+#endif
+}
+
+CompressedResponseWriter::CompressedResponseWriter(int fd)
+    : fd_(fd),
+      stream_(std::make_unique<Stream>()),
+      staging_(),
+      output_(kChunkBytes, '\0'),
+      output_used_(0),
+      raw_bytes_(0),
+      bytes_sent_(0),
+      cpu_micros_(0),
+      failed_(false) {
+    staging_.reserve(kChunkBytes);
+#ifdef LOGCRAFTER_HAVE_ZLIB
+    stream_->ready = deflateInit(&stream_->zs, 1) == Z_OK;
+#endif
+    failed_ = !stream_->ready;
+}
+
+CompressedResponseWriter::~CompressedResponseWriter() {
+#ifdef LOGCRAFTER_HAVE_ZLIB
+    if (stream_->ready) {
+        deflateEnd(&stream_->zs);
+    }
+#endif
+}
+
+void CompressedResponseWriter::append(std::string_view text) {
+    if (failed_) {
+        return;
+    }
+    raw_bytes_ += text.size();
+    while (!text.empty()) {
+        const std::size_t room = kChunkBytes - staging_.size();
+        const std::size_t take = text.size() < room ? text.size() : room;
+        staging_.append(text.data(), take);
+        text.remove_prefix(take);
+        if (staging_.size() == kChunkBytes) {
+            deflate_staging(false);
+        }
+    }
+}
+
+void CompressedResponseWriter::append_line(std::string_view line) {
+    append(line);
+    append(std::string_view("\n", 1));
+}
+
+bool CompressedResponseWriter::finish() {
+    if (!failed_) {
+        deflate_staging(true);
+        send_output(false);
+    }
+    return !failed_;
+}
+
+void CompressedResponseWriter::deflate_staging(bool final) {
+#ifdef LOGCRAFTER_HAVE_ZLIB
+    // Time spent in send() is left out of the CPU figure.
+    unsigned long long started = thread_cpu_micros();
+    z_stream &zs = stream_->zs;
+    zs.next_in = reinterpret_cast<Bytef *>(&staging_[0]);
+    zs.avail_in = static_cast<uInt>(staging_.size());
+    const int flush = final ? Z_FINISH : Z_NO_FLUSH;
+    while (!failed_) {
+        zs.next_out = reinterpret_cast<Bytef *>(&output_[output_used_]);
+        zs.avail_out = static_cast<uInt>(output_.size() - output_used_);
+        const int result = deflate(&zs, flush);
+        output_used_ = output_.size() - zs.avail_out;
+        if (result == Z_STREAM_ERROR) {
+            failed_ = true;
+            break;
+        }
+        if (output_used_ == output_.size()) {
+            cpu_micros_ += thread_cpu_micros() - started;
+            send_output(true);
+            started = thread_cpu_micros();
+            continue;
+        }
+        if (zs.avail_in == 0 && (!final || result == Z_STREAM_END)) {
+            break;
+        }
+    }
+    staging_.clear();
+    cpu_micros_ += thread_cpu_micros() - started;
+#else
+    (void)final;
+    failed_ = true;
+#endif
+}
+
+void CompressedResponseWriter::send_output(bool more) {
+    std::size_t sent_total = 0;
+    while (!failed_ && sent_total < output_used_) {
+        const ssize_t sent =
+            ::send(fd_, output_.data() + sent_total, output_used_ - sent_total, MSG_NOSIGNAL | (more ? MSG_MORE : 0));
+        if (sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            std::perror("send");
+            failed_ = true;
+            break;
+        }
+        sent_total += static_cast<std::size_t>(sent);
+    }
+    bytes_sent_ += sent_total;
+    output_used_ = 0;
+}
+
+} // namespace logcrafter::cpp
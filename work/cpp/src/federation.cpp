@@ -0,0 +1,356 @@
+/*
+ * Sequence: SEQ0210
+ * Track: C++
+ * MVP: Step D
+ * Change: Scatter one QUERY to all peers over pooled non-blocking connections and gather replies under one deadline.
+ * Tests: spec_federated_query
+ */
+#include "federation.hpp"
+
+#include <cerrno>
+#include <chrono>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace logcrafter::cpp {
+
+namespace {
+
+constexpr std::string_view kReadyLine = "PEER: ready";
+constexpr std::string_view kFoundPrefix = "FOUND: ";
+constexpr std::size_t kReadChunk = 64 * 1024;
+
+int connect_nonblocking(const PeerAddress &address, bool &in_progress) {
+    struct addrinfo hints {};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    struct addrinfo *addresses = nullptr;
+    if (::getaddrinfo(address.host.c_str(), std::to_string(address.port).c_str(), &hints, &addresses) != 0 ||
+        addresses == nullptr) {
+        return -1;
+    }
+    const int fd = ::socket(addresses->ai_family, addresses->ai_socktype | SOCK_NONBLOCK | SOCK_CLOEXEC,
+                            addresses->ai_protocol);
+    if (fd < 0) {
+        ::freeaddrinfo(addresses);
+        return -1;
+    }
+    const int nodelay = 1;
+    ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
+    const int result = ::connect(fd, addresses->ai_addr, addresses->ai_addrlen);
+    ::freeaddrinfo(addresses);
+    in_progress = result != 0 && errno == EINPROGRESS;
+    if (result != 0 && !in_progress) {
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+bool parse_count(std::string_view text, std::size_t &count) {
+    if (text.empty()) {
+        return false;
+    }
+    count = 0;
+    for (const char ch : text) {
+        if (ch < '0' || ch > '9') {
+            return false;
+        }
+        count = count * 10 + static_cast<std::size_t>(ch - '0');
+    }
+    return true;
+}
+
+} // namespace
+
+struct FederationClient::Exchange {
+    Peer *peer = nullptr;
+    PeerReply *reply = nullptr;
+    int fd = -1;
+    bool reused = false;
+    bool retried = false;
+    bool connecting = false;
+    // Fresh connections skip the query banner up to the PEER acknowledgement.
+    bool ready = false;
+    bool done = false;
+    std::string out;
+    std::size_t sent = 0;
+    std::string in;
+    std::size_t scanned = 0;
+    bool have_header = false;
+    std::size_t expected = 0;
+    std::size_t counted = 0;
+    std::size_t body_start = 0;
+};
+
+FederationClient::FederationClient()
+    : peers_(), timeout_ms_(kDefaultTimeoutMs), requests_(0), timeouts_(0), failures_(0), reused_(0) {}
+
+FederationClient::~FederationClient() { reset(); }
+
+void FederationClient::configure(const std::vector<PeerAddress> &peers, int timeout_ms) {
+    reset();
+    timeout_ms_ = timeout_ms > 0 ? timeout_ms : kDefaultTimeoutMs;
+    for (const PeerAddress &address : peers) {
+        auto peer = std::make_unique<Peer>();
+        peer->address = address;
+        peer->label = address.host + ":" + std::to_string(address.port);
+        peers_.push_back(std::move(peer));
+    }
+    requests_.store(0, std::memory_order_relaxed);
+    timeouts_.store(0, std::memory_order_relaxed);
+    failures_.store(0, std::memory_order_relaxed);
+    reused_.store(0, std::memory_order_relaxed);
+}
+
+void FederationClient::reset() {
+    for (const std::unique_ptr<Peer> &peer : peers_) {
+        std::lock_guard<std::mutex> lock(peer->mutex);
+        for (const int fd : peer->idle) {
+            ::close(fd);
+        }
+        peer->idle.clear();
+    }
+    peers_.clear();
+}
+
+FederationStats FederationClient::stats() const {
+    return FederationStats{requests_.load(std::memory_order_relaxed), timeouts_.load(std::memory_order_relaxed),
+                           failures_.load(std::memory_order_relaxed), reused_.load(std::memory_order_relaxed)};
+}
+
+int FederationClient::checkout(Peer &peer) const {
+    std::lock_guard<std::mutex> lock(peer.mutex);
+    if (peer.idle.empty()) {
+        return -1;
+    }
+    const int fd = peer.idle.back();
+    peer.idle.pop_back();
+    return fd;
+}
+
+void FederationClient::checkin(Peer &peer, int fd) const {
+    {
+        std::lock_guard<std::mutex> lock(peer.mutex);
+        if (peer.idle.size() < kMaxIdlePerPeer) {
+            peer.idle.push_back(fd);
+            return;
+        }
+    }
+    ::close(fd);
+}
+
+bool FederationClient::start_fresh(Exchange &exchange, std::string_view request_line) const {
+    exchange.fd = connect_nonblocking(exchange.peer->address, exchange.connecting);
+    exchange.reused = false;
+    exchange.ready = false;
+    exchange.out = "PEER\n";
+    exchange.out.append(request_line.data(), request_line.size());
+    exchange.out.push_back('\n');
+    exchange.sent = 0;
+    exchange.in.clear();
+    exchange.scanned = 0;
+    exchange.have_header = false;
+    return exchange.fd >= 0;
+}
+
+bool FederationClient::advance(Exchange &exchange, short revents) const {
+    if (exchange.connecting) {
+        if ((revents & (POLLOUT | POLLERR | POLLHUP)) == 0) {
+            return true;
+        }
+        int error = 0;
+        socklen_t length = sizeof(error);
+        if (::getsockopt(exchange.fd, SOL_SOCKET, SO_ERROR, &error, &length) != 0 || error != 0) {
+            return false;
+        }
+        exchange.connecting = false;
+    }
+
+    if (exchange.sent < exchange.out.size()) {
+        const ssize_t sent = ::send(exchange.fd, exchange.out.data() + exchange.sent,
+                                    exchange.out.size() - exchange.sent, MSG_NOSIGNAL);
+        if (sent < 0) {
+            return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+        }
+        exchange.sent += static_cast<std::size_t>(sent);
+        return true;
+    }
+
+    if ((revents & (POLLIN | POLLHUP | POLLERR)) == 0) {
+        return true;
+    }
+    char chunk[kReadChunk];
+    const ssize_t received = ::recv(exchange.fd, chunk, sizeof(chunk), 0);
+    if (received < 0) {
+        return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+    }
+    if (received == 0 || exchange.in.size() + static_cast<std::size_t>(received) > kMaxReplyBytes) {
+        return false;
+    }
+    exchange.in.append(chunk, static_cast<std::size_t>(received));
+    return parse(exchange);
+}
+
+bool FederationClient::parse(Exchange &exchange) const {
+    PeerReply &reply = *exchange.reply;
+    while (!exchange.done) {
+        const std::size_t newline = exchange.in.find('\n', exchange.scanned);
+        if (newline == std::string::npos) {
+            return true;
+        }
+        const std::string_view line(exchange.in.data() + exchange.scanned, newline - exchange.scanned);
+        exchange.scanned = newline + 1;
+
+        if (!exchange.ready) {
+            exchange.ready = line == kReadyLine;
+            continue;
+        }
+        if (!exchange.have_header) {
+            if (line.rfind(kFoundPrefix, 0) == 0) {
+                if (!parse_count(line.substr(kFoundPrefix.size()), exchange.expected)) {
+                    return false;
+                }
+                exchange.have_header = true;
+                exchange.counted = 0;
+                exchange.body_start = exchange.scanned;
+            } else if (line.rfind("ERROR", 0) == 0) {
+                reply.status = PeerReply::Status::Rejected;
+                reply.error.assign(line.data(), line.size());
+                exchange.done = true;
+                return true;
+            } else {
+                return false;
+            }
+        } else {
+            ++exchange.counted;
+        }
+
+        if (exchange.counted == exchange.expected) {
+            reply.status = PeerReply::Status::Answered;
+            reply.body = exchange.in.substr(exchange.body_start, exchange.scanned - exchange.body_start);
+            reply.lines.clear();
+            reply.lines.reserve(exchange.expected);
+            std::size_t start = 0;
+            while (start < reply.body.size()) {
+                const std::size_t end = reply.body.find('\n', start);
+                reply.lines.emplace_back(reply.body.data() + start, end - start);
+                start = end + 1;
+            }
+            exchange.done = true;
+        }
+    }
+    return true;
+}
+
+void FederationClient::scatter(std::string_view request_line, const std::function<void()> &while_waiting,
+                               std::vector<PeerReply> &replies) const {
+    replies.assign(peers_.size(), PeerReply{});
+    std::vector<Exchange> exchanges(peers_.size());
+    requests_.fetch_add(peers_.size(), std::memory_order_relaxed);
+
+    // A pooled connection may have been closed by a restarted peer; it gets one fresh retry
+    // as long as nothing came back on it.
+    const auto fail = [this, request_line](Exchange &exchange) {
+        if (exchange.fd >= 0) {
+            ::close(exchange.fd);
+            exchange.fd = -1;
+        }
+        if (exchange.reused && !exchange.retried && exchange.in.empty()) {
+            exchange.retried = true;
+            if (start_fresh(exchange, request_line)) {
+                return;
+            }
+        }
+        exchange.reply->status = PeerReply::Status::Unreachable;
+        exchange.done = true;
+    };
+
+    for (std::size_t i = 0; i < peers_.size(); ++i) {
+        Exchange &exchange = exchanges[i];
+        exchange.peer = peers_[i].get();
+        exchange.reply = &replies[i];
+        exchange.fd = checkout(*exchange.peer);
+        if (exchange.fd >= 0) {
+            exchange.reused = true;
+            exchange.ready = true;
+            exchange.out.assign(request_line.data(), request_line.size());
+            exchange.out.push_back('\n');
+            reused_.fetch_add(1, std::memory_order_relaxed);
+        } else if (!start_fresh(exchange, request_line)) {
+            exchange.reply->status = PeerReply::Status::Unreachable;
+            exchange.done = true;
+            continue;
+        }
+        if (!exchange.connecting && !advance(exchange, POLLOUT)) {
+            fail(exchange);
+        }
+    }
+
+    if (while_waiting) {
+        while_waiting();
+    }
+
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms_);
+    std::vector<struct pollfd> pending;
+    std::vector<Exchange *> owners;
+    while (true) {
+        pending.clear();
+        owners.clear();
+        for (Exchange &exchange : exchanges) {
+            if (exchange.done) {
+                continue;
+            }
+            const bool writing = exchange.connecting || exchange.sent < exchange.out.size();
+            pending.push_back(pollfd{exchange.fd, static_cast<short>(writing ? POLLOUT : POLLIN), 0});
+            owners.push_back(&exchange);
+        }
+        if (pending.empty()) {
+            break;
+        }
+        const auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+            deadline - std::chrono::steady_clock::now());
+        if (remaining.count() <= 0) {
+            break;
+        }
+        const int ready = ::poll(pending.data(), pending.size(), static_cast<int>(remaining.count()));
+        if (ready < 0 && errno == EINTR) {
+            continue;
+        }
+        if (ready < 0) {
+            break;
+        }
+        for (std::size_t i = 0; i < pending.size(); ++i) {
+            if (pending[i].revents != 0 && !advance(*owners[i], pending[i].revents)) {
+                fail(*owners[i]);
+            }
+        }
+    }
+
+    for (Exchange &exchange : exchanges) {
+        if (!exchange.done) {
+            exchange.reply->status = PeerReply::Status::TimedOut;
+            timeouts_.fetch_add(1, std::memory_order_relaxed);
+            if (exchange.fd >= 0) {
+                ::close(exchange.fd);
+            }
+            continue;
+        }
+        if (exchange.fd < 0) {
+            failures_.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+        // Only a connection whose reply was consumed exactly is in sync for the next request.
+        if (exchange.scanned == exchange.in.size()) {
+            checkin(*exchange.peer, exchange.fd);
+        } else {
+            ::close(exchange.fd);
+        }
+    }
+}
+
+} // namespace logcrafter::cpp
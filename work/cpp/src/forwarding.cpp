@@ -0,0 +1,559 @@
+/*
+ * Sequence: SEQ0219
+ * Track: C++
+ * MVP: Step D
+ * Change: Use the shared net_io helpers for the upstream connection and handshake.
+ * Tests: spec_relay_forwarding
+ */
+#include "forwarding.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <vector>
+
+#include "net_io.hpp"
+#include "relay_codec.hpp"
+#include "response_writer.hpp"
+
+namespace logcrafter::cpp {
+
+namespace {
+
+constexpr const char *kCursorFileName = "cursor";
+constexpr const char *kSegmentPrefix = "segment-";
+constexpr const char *kSegmentSuffix = ".spool";
+constexpr std::size_t kMaxBatchBytes = 1024 * 1024;
+constexpr std::size_t kMaxRecordBytes = 64 * 1024;
+constexpr int kConnectTimeoutMs = 2000;
+constexpr int kAckTimeoutSeconds = 5;
+constexpr std::size_t kMaxBannerBytes = 1024;
+constexpr int kInitialBackoffMs = 50;
+constexpr int kMaxBackoffMs = 1000;
+constexpr int kSpoolPollMs = 200;
+
+bool ensure_directory(const std::string &directory) {
+    struct stat st {};
+    if (stat(directory.c_str(), &st) == 0) {
+        return S_ISDIR(st.st_mode);
+    }
+    if (errno != ENOENT) {
+        return false;
+    }
+    return mkdir(directory.c_str(), 0775) == 0;
+}
+
+// Segment indices present in the spool, oldest first.
+std::vector<unsigned long long> collect_segments(const std::string &directory) {
+    std::vector<unsigned long long> segments;
+    DIR *dir = opendir(directory.c_str());
+    if (dir == nullptr) {
+        return segments;
+    }
+    const std::size_t prefix_length = std::strlen(kSegmentPrefix);
+    const std::size_t suffix_length = std::strlen(kSegmentSuffix);
+    struct dirent *entry = nullptr;
+    while ((entry = readdir(dir)) != nullptr) {
+        const std::string name = entry->d_name;
+        if (name.size() <= prefix_length + suffix_length || name.compare(0, prefix_length, kSegmentPrefix) != 0 ||
+            name.compare(name.size() - suffix_length, suffix_length, kSegmentSuffix) != 0) {
+            continue;
+        }
+        const std::string digits = name.substr(prefix_length, name.size() - prefix_length - suffix_length);
+        if (digits.find_first_not_of("0123456789") != std::string::npos) {
+            continue;
+        }
+        segments.push_back(std::stoull(digits));
+    }
+    closedir(dir);
+    std::sort(segments.begin(), segments.end());
+    return segments;
+}
+
+unsigned long long file_size(const std::string &path) {
+    struct stat st {};
+    if (stat(path.c_str(), &st) != 0 || st.st_size < 0) {
+        return 0;
+    }
+    return static_cast<unsigned long long>(st.st_size);
+}
+
+std::uint64_t make_epoch() {
+    const auto now = std::chrono::system_clock::now().time_since_epoch();
+    return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(now).count()) ^
+           (static_cast<std::uint64_t>(::getpid()) << 48);
+}
+
+} // namespace
+
+ForwardingManager::ForwardingManager()
+    : config_(),
+      epoch_(0),
+      stop_(false),
+      running_(false),
+      published_segment_(0),
+      published_offset_(0),
+      write_file_(nullptr),
+      write_segment_(0),
+      write_offset_(0),
+      cursor_{0, 0, 1},
+      read_fd_(-1),
+      read_segment_(0),
+      upstream_fd_(-1),
+      connected_(false),
+      spooled_records_(0),
+      acked_records_(0),
+      acked_batches_(0),
+      reconnects_(0),
+      spool_failures_(0),
+      backlog_bytes_(0),
+      wire_bytes_(0) {}
+
+ForwardingManager::~ForwardingManager() { shutdown(); }
+
+int ForwardingManager::init(const ForwardingConfig &config) {
+    shutdown();
+
+    config_ = config;
+    if (config_.upstream_host.empty() || config_.upstream_port <= 0 || config_.upstream_port > 65535) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (config_.spool_directory.empty()) {
+        config_.spool_directory = kDefaultSpoolDirectory;
+    }
+    if (config_.relay_name.empty()) {
+        config_.relay_name = "relay";
+    }
+    if (config_.batch_records == 0) {
+        config_.batch_records = kDefaultBatchRecords;
+    }
+    if (!ensure_directory(config_.spool_directory)) {
+        return -1;
+    }
+
+    const std::vector<unsigned long long> segments = collect_segments(config_.spool_directory);
+    if (!load_cursor()) {
+        epoch_ = make_epoch();
+        cursor_ = Cursor{segments.empty() ? 0 : segments.front(), 0, 1};
+    }
+    if (!segments.empty() && cursor_.segment < segments.front()) {
+        cursor_.segment = segments.front();
+        cursor_.offset = 0;
+    }
+    // Appends always start a fresh segment so a torn tail from a crash is only ever read as
+    // the end of a finished segment.
+    write_segment_ = segments.empty() ? cursor_.segment : std::max(segments.back() + 1, cursor_.segment);
+    write_offset_ = 0;
+    if (cursor_.segment == write_segment_) {
+        cursor_.offset = 0;
+    }
+
+    unsigned long long backlog = 0;
+    for (const unsigned long long segment : segments) {
+        if (segment >= cursor_.segment) {
+            backlog += file_size(segment_path(segment));
+        }
+    }
+    backlog -= std::min(backlog, cursor_.offset);
+
+    spooled_records_.store(0, std::memory_order_relaxed);
+    acked_records_.store(0, std::memory_order_relaxed);
+    acked_batches_.store(0, std::memory_order_relaxed);
+    reconnects_.store(0, std::memory_order_relaxed);
+    spool_failures_.store(0, std::memory_order_relaxed);
+    backlog_bytes_.store(backlog, std::memory_order_relaxed);
+    wire_bytes_.store(0, std::memory_order_relaxed);
+    connected_.store(false, std::memory_order_relaxed);
+
+    if (!save_cursor() || !open_write_segment()) {
+        return -1;
+    }
+    published_segment_ = write_segment_;
+    published_offset_ = write_offset_;
+    stop_ = false;
+
+    try {
+        spool_worker_ = std::thread(&ForwardingManager::spool_loop, this);
+        running_ = true;
+        sender_ = std::thread(&ForwardingManager::send_loop, this);
+    } catch (...) {
+        shutdown();
+        return -1;
+    }
+    return 0;
+}
+
+void ForwardingManager::shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+        if (upstream_fd_ >= 0) {
+            ::shutdown(upstream_fd_, SHUT_RDWR);
+        }
+    }
+    spool_condition_.notify_all();
+    send_condition_.notify_all();
+    if (spool_worker_.joinable()) {
+        spool_worker_.join();
+    }
+    if (sender_.joinable()) {
+        sender_.join();
+    }
+
+    if (write_file_ != nullptr) {
+        std::fclose(write_file_);
+        write_file_ = nullptr;
+    }
+    if (read_fd_ >= 0) {
+        ::close(read_fd_);
+        read_fd_ = -1;
+    }
+    disconnect_upstream();
+    std::lock_guard<std::mutex> lock(mutex_);
+    queue_.clear();
+    running_ = false;
+    stop_ = false;
+}
+
+bool ForwardingManager::enqueue(std::string_view stream, const std::string &message, std::time_t timestamp) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!running_ || stop_) {
+        return false;
+    }
+    queue_.push_back(Entry{timestamp, std::string(stream), message});
+    spool_condition_.notify_one();
+    return true;
+}
+
+ForwardingStats ForwardingManager::stats() const {
+    return ForwardingStats{connected_.load(std::memory_order_relaxed),
+                           spooled_records_.load(std::memory_order_relaxed),
+                           acked_records_.load(std::memory_order_relaxed),
+                           acked_batches_.load(std::memory_order_relaxed),
+                           reconnects_.load(std::memory_order_relaxed),
+                           spool_failures_.load(std::memory_order_relaxed),
+                           backlog_bytes_.load(std::memory_order_relaxed),
+                           wire_bytes_.load(std::memory_order_relaxed)};
+}
+
+std::string ForwardingManager::segment_path(unsigned long long segment) const {
+    char name[48];
+    std::snprintf(name, sizeof(name), "%s%010llu%s", kSegmentPrefix, segment, kSegmentSuffix);
+    return config_.spool_directory + "/" + name;
+}
+
+bool ForwardingManager::open_write_segment() {
+    write_file_ = std::fopen(segment_path(write_segment_).c_str(), "ab");
+    return write_file_ != nullptr;
+}
+
+bool ForwardingManager::load_cursor() {
+    const std::string path = config_.spool_directory + "/" + kCursorFileName;
+    std::FILE *file = std::fopen(path.c_str(), "r");
+    if (file == nullptr) {
+        return false;
+    }
+    unsigned long long epoch = 0;
+    unsigned long long next_sequence = 0;
+    Cursor cursor{};
+    const int fields = std::fscanf(file, "%llu %llu %llu %llu", &epoch, &cursor.segment, &cursor.offset, &next_sequence);
+    std::fclose(file);
+    if (fields != 4 || next_sequence == 0) {
+        return false;
+    }
+    epoch_ = epoch;
+    cursor.next_sequence = next_sequence;
+    cursor_ = cursor;
+    return true;
+}
+
+bool ForwardingManager::save_cursor() const {
+    const std::string path = config_.spool_directory + "/" + kCursorFileName;
+    const std::string temporary = path + ".tmp";
+    std::FILE *file = std::fopen(temporary.c_str(), "w");
+    if (file == nullptr) {
+        return false;
+    }
+    const int written = std::fprintf(file, "%llu %llu %llu %llu\n", static_cast<unsigned long long>(epoch_),
+                                     cursor_.segment, cursor_.offset,
+                                     static_cast<unsigned long long>(cursor_.next_sequence));
+    const bool closed = std::fclose(file) == 0;
+    return written > 0 && closed && std::rename(temporary.c_str(), path.c_str()) == 0;
+}
+
+void ForwardingManager::spool_loop() {
+    std::deque<Entry> batch;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            spool_condition_.wait(lock, [this]() { return stop_ || !queue_.empty(); });
+            if (queue_.empty()) {
+                break;
+            }
+            batch.swap(queue_);
+        }
+
+        encode_scratch_.clear();
+        for (const Entry &entry : batch) {
+            relay_codec::append_record(encode_scratch_, entry.timestamp, entry.stream, entry.message);
+        }
+        if (write_file_ == nullptr) {
+            open_write_segment();
+        }
+        const bool written = write_file_ != nullptr &&
+                             std::fwrite(encode_scratch_.data(), 1, encode_scratch_.size(), write_file_) ==
+                                 encode_scratch_.size() &&
+                             std::fflush(write_file_) == 0;
+        if (written) {
+            write_offset_ += encode_scratch_.size();
+            spooled_records_.store(spooled_records_.load(std::memory_order_relaxed) + batch.size(),
+                                   std::memory_order_relaxed);
+            backlog_bytes_.fetch_add(encode_scratch_.size(), std::memory_order_relaxed);
+        } else {
+            spool_failures_.store(spool_failures_.load(std::memory_order_relaxed) + batch.size(),
+                                  std::memory_order_relaxed);
+        }
+        batch.clear();
+
+        // A failed write may have left a partial record behind; sealing the segment keeps it
+        // past the published end, where the reader treats it as a torn tail.
+        if (!written || write_offset_ >= kSegmentBytes) {
+            if (write_file_ != nullptr) {
+                std::fclose(write_file_);
+                write_file_ = nullptr;
+            }
+            ++write_segment_;
+            write_offset_ = 0;
+            open_write_segment();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            published_segment_ = write_segment_;
+            published_offset_ = write_offset_;
+        }
+        send_condition_.notify_one();
+    }
+}
+
+void ForwardingManager::send_loop() {
+    std::string payload;
+    std::size_t records = 0;
+    Cursor after = cursor_;
+    bool pending = false;
+    bool ever_connected = false;
+    int delay_ms = kInitialBackoffMs;
+
+    while (true) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (stop_) {
+                break;
+            }
+        }
+        if (upstream_fd_ < 0) {
+            if (!connect_upstream()) {
+                backoff(delay_ms);
+                continue;
+            }
+            if (ever_connected) {
+                reconnects_.store(reconnects_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            }
+            ever_connected = true;
+            delay_ms = kInitialBackoffMs;
+        }
+
+        if (!pending) {
+            payload.clear();
+            records = 0;
+            if (!read_batch(payload, records, after)) {
+                backoff(delay_ms);
+                continue;
+            }
+            if (records == 0) {
+                if (after.segment != cursor_.segment) {
+                    // Only exhausted segments were crossed; retire them without a frame.
+                    const unsigned long long first = cursor_.segment;
+                    cursor_ = after;
+                    save_cursor();
+                    for (unsigned long long segment = first; segment < after.segment; ++segment) {
+                        ::unlink(segment_path(segment).c_str());
+                    }
+                }
+                wait_for_spool(after);
+                continue;
+            }
+            pending = true;
+        }
+
+        if (!send_batch(payload, cursor_.next_sequence)) {
+            disconnect_upstream();
+            backoff(delay_ms);
+            continue;
+        }
+
+        const unsigned long long first = cursor_.segment;
+        after.next_sequence = cursor_.next_sequence + 1;
+        cursor_ = after;
+        save_cursor();
+        for (unsigned long long segment = first; segment < after.segment; ++segment) {
+            ::unlink(segment_path(segment).c_str());
+        }
+        pending = false;
+        acked_records_.store(acked_records_.load(std::memory_order_relaxed) + records, std::memory_order_relaxed);
+        acked_batches_.store(acked_batches_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        const unsigned long long backlog = backlog_bytes_.load(std::memory_order_relaxed);
+        backlog_bytes_.fetch_sub(std::min<unsigned long long>(backlog, payload.size()), std::memory_order_relaxed);
+    }
+    disconnect_upstream();
+}
+
+bool ForwardingManager::read_batch(std::string &payload, std::size_t &records, Cursor &after) {
+    after = cursor_;
+    unsigned long long end_segment = 0;
+    unsigned long long end_offset = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        end_segment = published_segment_;
+        end_offset = published_offset_;
+    }
+
+    while (records < config_.batch_records && payload.size() < kMaxBatchBytes && after.segment <= end_segment) {
+        const bool sealed = after.segment < end_segment;
+        if (!sealed && after.offset >= end_offset) {
+            break;
+        }
+        if (read_fd_ < 0 || read_segment_ != after.segment) {
+            if (read_fd_ >= 0) {
+                ::close(read_fd_);
+            }
+            read_segment_ = after.segment;
+            read_fd_ = ::open(segment_path(after.segment).c_str(), O_RDONLY | O_CLOEXEC);
+            if (read_fd_ < 0) {
+                if (!sealed) {
+                    return false;
+                }
+                ++after.segment;
+                after.offset = 0;
+                continue;
+            }
+        }
+
+        char header[relay_codec::kRecordHeaderBytes];
+        std::size_t size = 0;
+        bool whole = ::pread(read_fd_, header, sizeof(header), static_cast<off_t>(after.offset)) ==
+                     static_cast<ssize_t>(sizeof(header));
+        if (whole) {
+            size = relay_codec::record_size(header);
+            whole = size <= kMaxRecordBytes && (sealed || after.offset + size <= end_offset);
+        }
+        if (whole) {
+            const std::size_t start = payload.size();
+            payload.resize(start + size);
+            whole = ::pread(read_fd_, &payload[start], size, static_cast<off_t>(after.offset)) ==
+                    static_cast<ssize_t>(size);
+            if (!whole) {
+                payload.resize(start);
+            }
+        }
+        if (!whole) {
+            if (!sealed) {
+                return false;
+            }
+            // End of a sealed segment, or a torn record left by a crash or failed write.
+            const unsigned long long remaining = file_size(segment_path(after.segment));
+            if (remaining > after.offset) {
+                const unsigned long long backlog = backlog_bytes_.load(std::memory_order_relaxed);
+                backlog_bytes_.fetch_sub(std::min(backlog, remaining - after.offset), std::memory_order_relaxed);
+            }
+            ++after.segment;
+            after.offset = 0;
+            continue;
+        }
+        after.offset += size;
+        ++records;
+    }
+    return true;
+}
+
+bool ForwardingManager::send_batch(const std::string &payload, std::uint64_t sequence) {
+    const std::string *body = &payload;
+    std::uint8_t flags = 0;
+    if (config_.compress) {
+        relay_codec::compress_payload(payload, wire_scratch_);
+        if (!wire_scratch_.empty()) {
+            body = &wire_scratch_;
+            flags = relay_codec::kFlagCompressed;
+        }
+    }
+
+    char header[relay_codec::kFrameHeaderBytes];
+    relay_codec::encode_frame_header(relay_codec::FrameHeader{static_cast<std::uint32_t>(body->size()), flags, sequence},
+                                     header);
+    ResponseWriter writer(upstream_fd_);
+    writer.append(std::string_view(header, sizeof(header)));
+    writer.append(*body);
+    if (!writer.finish()) {
+        return false;
+    }
+    wire_bytes_.fetch_add(writer.bytes_sent(), std::memory_order_relaxed);
+
+    char ack[relay_codec::kAckBytes];
+    return net_io::recv_exact(upstream_fd_, ack, sizeof(ack)) && relay_codec::decode_u64(ack) == sequence;
+}
+
+bool ForwardingManager::connect_upstream() {
+    const int fd = net_io::connect_tcp(config_.upstream_host, config_.upstream_port, kConnectTimeoutMs, kAckTimeoutSeconds);
+    if (fd < 0) {
+        return false;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        upstream_fd_ = fd;
+        if (stop_) {
+            ::shutdown(fd, SHUT_RDWR);
+        }
+    }
+
+    // Skip the log port's welcome line, then switch the session to relay frames.
+    std::string banner;
+    const std::string hello = "RELAY " + config_.relay_name + " " + std::to_string(epoch_) + "\n";
+    if (!net_io::recv_line(fd, banner, kMaxBannerBytes) || !net_io::send_text(fd, hello)) {
+        disconnect_upstream();
+        return false;
+    }
+    connected_.store(true, std::memory_order_relaxed);
+    return true;
+}
+
+void ForwardingManager::disconnect_upstream() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (upstream_fd_ >= 0) {
+        ::close(upstream_fd_);
+        upstream_fd_ = -1;
+    }
+    connected_.store(false, std::memory_order_relaxed);
+}
+
+void ForwardingManager::wait_for_spool(const Cursor &cursor) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    send_condition_.wait_for(lock, std::chrono::milliseconds(kSpoolPollMs), [this, &cursor]() {
+        return stop_ || published_segment_ != cursor.segment || published_offset_ != cursor.offset;
+    });
+}
+
+void ForwardingManager::backoff(int &delay_ms) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    send_condition_.wait_for(lock, std::chrono::milliseconds(delay_ms), [this]() { return stop_; });
+    delay_ms = std::min(delay_ms * 2, kMaxBackoffMs);
+}
+
+} // namespace logcrafter::cpp
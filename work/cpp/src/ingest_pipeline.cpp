@@ -0,0 +1,249 @@
+/*
+ * Sequence: SEQ0334
+ * Track: C++
+ * MVP: Step D
+ * Change: Run ingest stages inline or on stage workers fed by SPSC queues, with per-stage counters.
+ * Tests: spec_ingest_pipeline
+ */
+#include "ingest_pipeline.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+
+namespace logcrafter::cpp {
+
+namespace {
+
+// Entries taken from one input before the worker looks at the next, so one busy upstream
+// thread cannot starve the others.
+constexpr int kBatch = 64;
+// Empty polls (yielding in between) before a worker sleeps on its condition variable.
+constexpr int kSpinsBeforeSleep = 64;
+// Upper bound on a sleep; a missed wake-up costs at most this much latency.
+constexpr std::chrono::milliseconds kIdleWait{1};
+constexpr std::chrono::microseconds kFullQueueBackoff{50};
+
+} // namespace
+
+IngestPipeline::IngestPipeline() : threaded_(false) {}
+
+IngestPipeline::~IngestPipeline() {
+    stop();
+}
+
+void IngestPipeline::start(const PipelineConfig &config, std::array<Handler, kPipelineStages> handlers) {
+    stop();
+    const std::size_t capacity = std::clamp(config.queue_capacity == 0 ? kDefaultQueueCapacity : config.queue_capacity,
+                                            static_cast<std::size_t>(2), kMaxQueueCapacity);
+    std::size_t lanes = 1;
+    for (std::size_t s = 0; s < kPipelineStages; ++s) {
+        Stage &stage = stages_[s];
+        stage.handler = std::move(handlers[s]);
+        stage.stopping.store(false, std::memory_order_relaxed);
+        stage.processed.store(0, std::memory_order_relaxed);
+        stage.stalls.store(0, std::memory_order_relaxed);
+        const std::size_t threads = std::min(config.threads[s], kMaxStageThreads);
+        for (std::size_t w = 0; w < threads; ++w) {
+            auto worker = std::make_unique<Worker>();
+            for (std::size_t lane = 0; lane < lanes; ++lane) {
+                worker->inputs.push_back(std::make_unique<Queue>(capacity));
+            }
+            stage.workers.push_back(std::move(worker));
+        }
+        if (threads > 0) {
+            lanes = threads;
+            threaded_ = true;
+        }
+    }
+    // Every queue exists before any worker can push into a later stage.
+    for (std::size_t s = 0; s < kPipelineStages; ++s) {
+        for (std::size_t w = 0; w < stages_[s].workers.size(); ++w) {
+            stages_[s].workers[w]->thread = std::thread(&IngestPipeline::worker_loop, this, s, w);
+        }
+    }
+}
+
+void IngestPipeline::stop() {
+    // Stage by stage, so a stage is told to stop only once nothing upstream can feed it.
+    for (Stage &stage : stages_) {
+        stage.stopping.store(true, std::memory_order_release);
+        for (const std::unique_ptr<Worker> &worker : stage.workers) {
+            {
+                std::lock_guard<std::mutex> lock(worker->mutex);
+            }
+            worker->wake.notify_all();
+            if (worker->thread.joinable()) {
+                worker->thread.join();
+            }
+        }
+    }
+    for (Stage &stage : stages_) {
+        stage.workers.clear();
+    }
+    threaded_ = false;
+}
+
+void IngestPipeline::submit(PipelineEntry &&entry) {
+    advance(0, 0, entry);
+}
+
+void IngestPipeline::run_inline(PipelineEntry &entry) {
+    for (Stage &stage : stages_) {
+        if (stage.handler) {
+            stage.handler(entry);
+        }
+        stage.processed.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void IngestPipeline::advance(std::size_t first, std::size_t lane, PipelineEntry &entry) {
+    for (std::size_t s = first; s < kPipelineStages; ++s) {
+        Stage &stage = stages_[s];
+        if (!stage.workers.empty()) {
+            push(stage, *stage.workers[entry.stream % stage.workers.size()], lane, entry);
+            return;
+        }
+        if (stage.handler) {
+            stage.handler(entry);
+        }
+        stage.processed.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void IngestPipeline::push(Stage &stage, Worker &worker, std::size_t lane, PipelineEntry &entry) {
+    Queue &queue = *worker.inputs[lane];
+    const auto wake = [&worker]() {
+        // Pairs with the fence in worker_loop: either the worker sees the new entry before it
+        // sleeps, or this sees `sleeping` and waits for it to be in wait() before notifying.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (worker.sleeping.load(std::memory_order_relaxed)) {
+            std::lock_guard<std::mutex> lock(worker.mutex);
+            worker.wake.notify_one();
+        }
+    };
+    if (!queue.try_push(entry)) {
+        stage.stalls.fetch_add(1, std::memory_order_relaxed);
+        int spins = 0;
+        do {
+            wake();
+            if (++spins < kSpinsBeforeSleep) {
+                std::this_thread::yield();
+            } else {
+                std::this_thread::sleep_for(kFullQueueBackoff);
+            }
+        } while (!queue.try_push(entry));
+    }
+    wake();
+}
+
+void IngestPipeline::worker_loop(std::size_t stage_index, std::size_t lane) {
+    Stage &stage = stages_[stage_index];
+    Worker &worker = *stage.workers[lane];
+    PipelineEntry entry;
+    int idle = 0;
+    while (true) {
+        // Read before polling: once set, every upstream push is already visible, so an empty
+        // pass means the stage is done.
+        const bool stopping = stage.stopping.load(std::memory_order_acquire);
+        bool worked = false;
+        for (const std::unique_ptr<Queue> &input : worker.inputs) {
+            for (int n = 0; n < kBatch && input->try_pop(entry); ++n) {
+                if (stage.handler) {
+                    stage.handler(entry);
+                }
+                stage.processed.fetch_add(1, std::memory_order_relaxed);
+                advance(stage_index + 1, lane, entry);
+                worked = true;
+            }
+        }
+        if (worked) {
+            idle = 0;
+            continue;
+        }
+        if (stopping) {
+            return;
+        }
+        if (++idle < kSpinsBeforeSleep) {
+            std::this_thread::yield();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(worker.mutex);
+        worker.sleeping.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        const bool empty = std::all_of(worker.inputs.begin(), worker.inputs.end(),
+                                       [](const std::unique_ptr<Queue> &input) { return input->size() == 0; });
+        if (empty && !stage.stopping.load(std::memory_order_acquire)) {
+            worker.wake.wait_for(lock, kIdleWait);
+        }
+        worker.sleeping.store(false, std::memory_order_relaxed);
+    }
+}
+
+std::size_t IngestPipeline::queued() const {
+    std::size_t total = 0;
+    for (const Stage &stage : stages_) {
+        for (const std::unique_ptr<Worker> &worker : stage.workers) {
+            for (const std::unique_ptr<Queue> &input : worker->inputs) {
+                total += input->size();
+            }
+        }
+    }
+    return total;
+}
+
+std::array<PipelineStageStats, kPipelineStages> IngestPipeline::stats() const {
+    std::array<PipelineStageStats, kPipelineStages> result{};
+    for (std::size_t s = 0; s < kPipelineStages; ++s) {
+        const Stage &stage = stages_[s];
+        PipelineStageStats &out = result[s];
+        out.threads = stage.workers.size();
+        out.processed = stage.processed.load(std::memory_order_relaxed);
+        out.stalls = stage.stalls.load(std::memory_order_relaxed);
+        for (const std::unique_ptr<Worker> &worker : stage.workers) {
+            for (const std::unique_ptr<Queue> &input : worker->inputs) {
+                out.queued += input->size();
+            }
+        }
+    }
+    return result;
+}
+
+bool IngestPipeline::parse_threads(std::string_view text, std::array<std::size_t, kPipelineStages> &threads,
+                                   std::string &error) {
+    threads.fill(0);
+    std::array<bool, kPipelineStages> seen{};
+    std::size_t start = 0;
+    while (start <= text.size()) {
+        std::size_t comma = text.find(',', start);
+        if (comma == std::string_view::npos) {
+            comma = text.size();
+        }
+        const std::string_view item = text.substr(start, comma - start);
+        const std::size_t equals = item.find('=');
+        const std::string_view name = item.substr(0, equals);
+        const std::string_view count = equals == std::string_view::npos ? std::string_view() : item.substr(equals + 1);
+
+        const auto stage = std::find(kStageNames.begin(), kStageNames.end(), name);
+        std::size_t value = 0;
+        const auto parsed = std::from_chars(count.data(), count.data() + count.size(), value);
+        if (stage == kStageNames.end() || count.empty() || parsed.ec != std::errc() ||
+            parsed.ptr != count.data() + count.size() || value > kMaxStageThreads) {
+            error = "each item is <enrich|store|persist|fanout>=<0-" + std::to_string(kMaxStageThreads) + "> (got '" +
+                    std::string(item) + "')";
+            return false;
+        }
+        const std::size_t index = static_cast<std::size_t>(stage - kStageNames.begin());
+        if (seen[index]) {
+            error = "stage '" + std::string(name) + "' is listed twice";
+            return false;
+        }
+        seen[index] = true;
+        threads[index] = value;
+        start = comma + 1;
+    }
+    return true;
+}
+
+} // namespace logcrafter::cpp
@@ -0,0 +1,491 @@
+/*
+ * Sequence: SEQ0265
+ * Track: C++
+ * MVP: Step D
+ * Change: Keep each queued line's source alive until the sink has seen it.
+ * Tests: spec_repeat_collapsing, spec_source_quotas, spec_stats_polling, spec_rollup
+ */
+#include "ingest_scheduler.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <thread>
+#include <utility>
+
+#include "clock_service.hpp"
+
+namespace logcrafter::cpp {
+
+namespace {
+
+// Rounds one drainer serves before handing the lock back while other producers are active.
+constexpr unsigned kRoundsPerTurn = 4;
+constexpr std::chrono::milliseconds kSpaceWaitSlice{5};
+
+struct SourceSnapshot {
+    const std::string *name;
+    unsigned long accepted;
+    unsigned long dropped;
+    unsigned long deferred;
+};
+
+// Counters below are written under a mutex and read lock-free by stats().
+template <typename T>
+void add_relaxed(std::atomic<T> &counter, T delta) {
+    counter.store(counter.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+}
+
+} // namespace
+
+struct IngestScheduler::Source {
+    explicit Source(std::string source_name)
+        : name(std::move(source_name)),
+          sessions(0),
+          bucket_mutex(),
+          tokens(0.0),
+          refilled_at_ms(0),
+          accepted(0),
+          dropped(0),
+          deferred(0),
+          run_mutex(),
+          run() {}
+
+    std::string name;
+    std::size_t sessions;
+
+    std::mutex bucket_mutex;
+    double tokens;
+    std::int64_t refilled_at_ms;
+
+    std::atomic<unsigned long> accepted;
+    std::atomic<unsigned long> dropped;
+    std::atomic<unsigned long> deferred;
+
+    // Serialises the repeat run across every session that shares this source.
+    std::mutex run_mutex;
+    RepeatCollapser run;
+};
+
+class IngestScheduler::Session {
+public:
+    std::shared_ptr<Source> source;
+    std::deque<Pending> queue;
+    // Written by the owning producer before it submits, read when its lines are queued.
+    std::size_t route = 0;
+    std::size_t deficit = 0;
+    bool active = false;
+};
+
+IngestScheduler::IngestScheduler()
+    : config_{kDefaultQuantumBytes, kDefaultQueueDepth, 0.0, 0, QuotaAction::Drop, RepeatMode::Off,
+              RepeatCollapser::kDefaultWindowMs},
+      sink_(),
+      mutex_(),
+      space_available_(),
+      active_(),
+      sources_mutex_(),
+      sources_(),
+      top_sources_(),
+      top_sources_refreshed_ms_(-1),
+      sessions_(0),
+      backlogged_(0),
+      pending_lines_(0),
+      rounds_(0),
+      queue_waits_(0),
+      drain_mutex_(),
+      pending_(0),
+      submitters_(0),
+      quota_dropped_(0),
+      quota_deferred_(0),
+      collapsed_lines_(0),
+      collapsed_runs_(0) {}
+
+void IngestScheduler::configure(const IngestConfig &config, Sink sink) {
+    reset();
+    std::lock_guard<std::mutex> lock(mutex_);
+    config_ = config;
+    if (config_.quantum_bytes == 0) {
+        config_.quantum_bytes = kDefaultQuantumBytes;
+    }
+    if (config_.queue_depth == 0) {
+        config_.queue_depth = kDefaultQueueDepth;
+    }
+    if (config_.source_rate > 0.0 && config_.source_burst == 0) {
+        config_.source_burst = static_cast<std::size_t>(std::ceil(config_.source_rate));
+    }
+    sink_ = std::move(sink);
+}
+
+void IngestScheduler::reset() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::lock_guard<std::mutex> sources_lock(sources_mutex_);
+    active_.clear();
+    sources_.clear();
+    top_sources_.publish({});
+    top_sources_refreshed_ms_.store(-1, std::memory_order_relaxed);
+    sessions_.store(0, std::memory_order_relaxed);
+    backlogged_.store(0, std::memory_order_relaxed);
+    pending_lines_.store(0, std::memory_order_relaxed);
+    rounds_.store(0, std::memory_order_relaxed);
+    queue_waits_.store(0, std::memory_order_relaxed);
+    pending_.store(0, std::memory_order_relaxed);
+    quota_dropped_.store(0, std::memory_order_relaxed);
+    quota_deferred_.store(0, std::memory_order_relaxed);
+    collapsed_lines_.store(0, std::memory_order_relaxed);
+    collapsed_runs_.store(0, std::memory_order_relaxed);
+}
+
+IngestScheduler::SessionHandle IngestScheduler::open_session(const std::string &source) {
+    auto session = std::make_shared<Session>();
+    std::lock_guard<std::mutex> lock(sources_mutex_);
+    session->source = acquire_source_locked(source);
+    sessions_.fetch_add(1, std::memory_order_relaxed);
+    return session;
+}
+
+void IngestScheduler::rename_session(const SessionHandle &session, const std::string &source) {
+    if (!session || source.empty()) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(sources_mutex_);
+    if (session->source && session->source->name == source) {
+        return;
+    }
+    std::shared_ptr<Source> previous = std::move(session->source);
+    session->source = acquire_source_locked(source);
+    if (previous) {
+        release_source_locked(previous);
+    }
+}
+
+void IngestScheduler::set_route(const SessionHandle &session, std::size_t route) {
+    if (session) {
+        session->route = route;
+    }
+}
+
+void IngestScheduler::close_session(const SessionHandle &session) {
+    if (!session) {
+        return;
+    }
+
+    bool last_of_source = false;
+    {
+        std::lock_guard<std::mutex> sources_lock(sources_mutex_);
+        last_of_source = session->source && session->source->sessions == 1;
+    }
+
+    submitters_.fetch_add(1, std::memory_order_acq_rel);
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (last_of_source && config_.repeat_mode != RepeatMode::Off) {
+        RepeatSummary summary;
+        bool summarised = false;
+        {
+            std::lock_guard<std::mutex> run_lock(session->source->run_mutex);
+            summarised = session->source->run.finish(summary);
+        }
+        if (summarised) {
+            collapsed_runs_.fetch_add(1, std::memory_order_relaxed);
+            enqueue_locked(lock, *session,
+                           Pending{std::move(summary.message), summary.timestamp, summary.route, session->source});
+        }
+    }
+    while (!session->queue.empty()) {
+        lock.unlock();
+        drain();
+        lock.lock();
+        if (!session->queue.empty()) {
+            space_available_.wait_for(lock, kSpaceWaitSlice);
+        }
+    }
+    lock.unlock();
+    submitters_.fetch_sub(1, std::memory_order_acq_rel);
+
+    std::lock_guard<std::mutex> sources_lock(sources_mutex_);
+    if (session->source) {
+        release_source_locked(session->source);
+    }
+    sessions_.fetch_sub(1, std::memory_order_relaxed);
+}
+
+IngestScheduler::Admission IngestScheduler::submit(const SessionHandle &session, std::string message,
+                                                   std::time_t timestamp) {
+    Source &source = *session->source;
+    const bool collapsing = config_.repeat_mode != RepeatMode::Off;
+    if (collapsing) {
+        std::lock_guard<std::mutex> run_lock(source.run_mutex);
+        if (source.run.absorb(message, timestamp, session->route, ClockService::instance().now_millis())) {
+            collapsed_lines_.fetch_add(1, std::memory_order_relaxed);
+            return Admission::Collapsed;
+        }
+    }
+
+    if (config_.source_rate > 0.0) {
+        bool deferred = false;
+        if (!take_quota(source, deferred)) {
+            source.dropped.fetch_add(1, std::memory_order_relaxed);
+            quota_dropped_.fetch_add(1, std::memory_order_relaxed);
+            return Admission::Dropped;
+        }
+        if (deferred) {
+            source.deferred.fetch_add(1, std::memory_order_relaxed);
+            quota_deferred_.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    // Only an admitted line may open a run, so a summary never refers to a dropped line.
+    RepeatSummary summary;
+    bool summarised = false;
+    if (collapsing) {
+        std::lock_guard<std::mutex> run_lock(source.run_mutex);
+        summarised = source.run.restart(message, session->route, ClockService::instance().now_millis(), summary);
+    }
+
+    submitters_.fetch_add(1, std::memory_order_acq_rel);
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (summarised) {
+            collapsed_runs_.fetch_add(1, std::memory_order_relaxed);
+            enqueue_locked(lock, *session,
+                           Pending{std::move(summary.message), summary.timestamp, summary.route, session->source});
+        }
+        enqueue_locked(lock, *session, Pending{std::move(message), timestamp, session->route, session->source});
+    }
+    source.accepted.fetch_add(1, std::memory_order_relaxed);
+    finish_submit();
+    return Admission::Queued;
+}
+
+void IngestScheduler::enqueue_locked(std::unique_lock<std::mutex> &lock, Session &session, Pending pending) {
+    if (session.queue.size() >= config_.queue_depth) {
+        add_relaxed(queue_waits_, 1UL);
+        while (session.queue.size() >= config_.queue_depth) {
+            lock.unlock();
+            drain();
+            lock.lock();
+            if (session.queue.size() >= config_.queue_depth) {
+                space_available_.wait_for(lock, kSpaceWaitSlice);
+            }
+        }
+    }
+    session.queue.push_back(std::move(pending));
+    add_relaxed(pending_lines_, std::size_t{1});
+    if (!session.active) {
+        session.active = true;
+        active_.push_back(&session);
+        backlogged_.store(active_.size(), std::memory_order_relaxed);
+    }
+    pending_.fetch_add(1, std::memory_order_acq_rel);
+}
+
+void IngestScheduler::finish_submit() {
+    drain();
+
+    // Leaving with work still queued is only safe while another producer is inside submit();
+    // the last one out drains whatever remains.
+    while (true) {
+        if (submitters_.fetch_sub(1, std::memory_order_acq_rel) > 1 ||
+            pending_.load(std::memory_order_acquire) == 0) {
+            break;
+        }
+        submitters_.fetch_add(1, std::memory_order_acq_rel);
+        drain();
+    }
+}
+
+IngestStats IngestScheduler::stats() const {
+    IngestStats result{};
+    result.sessions = sessions_.load(std::memory_order_relaxed);
+    result.backlogged_sessions = backlogged_.load(std::memory_order_relaxed);
+    result.pending_lines = pending_lines_.load(std::memory_order_relaxed);
+    result.rounds = rounds_.load(std::memory_order_relaxed);
+    result.queue_waits = queue_waits_.load(std::memory_order_relaxed);
+    result.quota_dropped = quota_dropped_.load(std::memory_order_relaxed);
+    result.quota_deferred = quota_deferred_.load(std::memory_order_relaxed);
+    result.collapsed_lines = collapsed_lines_.load(std::memory_order_relaxed);
+    result.collapsed_runs = collapsed_runs_.load(std::memory_order_relaxed);
+
+    const std::int64_t now = ClockService::instance().now_millis();
+    const std::int64_t refreshed = top_sources_refreshed_ms_.load(std::memory_order_relaxed);
+    if (refreshed < 0 || now - refreshed >= kTopSourcesRefreshMs) {
+        refresh_top_sources();
+    }
+    top_sources_.read(result.top_sources);
+    return result;
+}
+
+void IngestScheduler::refresh_top_sources() const {
+    std::unique_lock<std::mutex> lock(sources_mutex_, std::try_to_lock);
+    if (!lock.owns_lock()) {
+        return;
+    }
+
+    std::vector<SourceSnapshot> sources;
+    sources.reserve(sources_.size());
+    for (const auto &entry : sources_) {
+        const Source &source = *entry.second;
+        sources.push_back(SourceSnapshot{&source.name, source.accepted.load(std::memory_order_relaxed),
+                                         source.dropped.load(std::memory_order_relaxed),
+                                         source.deferred.load(std::memory_order_relaxed)});
+    }
+    const std::size_t top = std::min(sources.size(), kTopSources);
+    std::partial_sort(sources.begin(), sources.begin() + static_cast<std::ptrdiff_t>(top), sources.end(),
+                      [](const SourceSnapshot &lhs, const SourceSnapshot &rhs) {
+                          const unsigned long lhs_over = lhs.dropped + lhs.deferred;
+                          const unsigned long rhs_over = rhs.dropped + rhs.deferred;
+                          if (lhs_over != rhs_over) {
+                              return lhs_over > rhs_over;
+                          }
+                          if (lhs.accepted != rhs.accepted) {
+                              return lhs.accepted > rhs.accepted;
+                          }
+                          return *lhs.name < *rhs.name;
+                      });
+
+    std::string text;
+    for (std::size_t i = 0; i < top; ++i) {
+        if (i > 0) {
+            text += ", ";
+        }
+        text += *sources[i].name;
+        text.push_back('=');
+        text += std::to_string(sources[i].accepted);
+        text.push_back('/');
+        text += std::to_string(sources[i].dropped);
+        text.push_back('/');
+        text += std::to_string(sources[i].deferred);
+    }
+    top_sources_.publish(text);
+    top_sources_refreshed_ms_.store(ClockService::instance().now_millis(), std::memory_order_relaxed);
+}
+
+std::shared_ptr<IngestScheduler::Source> IngestScheduler::acquire_source_locked(const std::string &name) {
+    auto it = sources_.find(name);
+    if (it == sources_.end()) {
+        if (sources_.size() >= kMaxTrackedSources) {
+            // Forget the least busy source nobody is connected as; its counters go with it.
+            auto victim = sources_.end();
+            unsigned long victim_total = 0;
+            for (auto candidate = sources_.begin(); candidate != sources_.end(); ++candidate) {
+                const Source &source = *candidate->second;
+                if (source.sessions > 0) {
+                    continue;
+                }
+                const unsigned long total = source.accepted.load(std::memory_order_relaxed) +
+                                            source.dropped.load(std::memory_order_relaxed);
+                if (victim == sources_.end() || total < victim_total) {
+                    victim = candidate;
+                    victim_total = total;
+                }
+            }
+            if (victim != sources_.end()) {
+                sources_.erase(victim);
+            }
+        }
+        auto source = std::make_shared<Source>(name);
+        source->tokens = static_cast<double>(config_.source_burst);
+        source->refilled_at_ms = ClockService::instance().now_millis();
+        source->run.configure(config_.repeat_mode, config_.repeat_window_ms);
+        it = sources_.emplace(name, std::move(source)).first;
+    }
+    ++it->second->sessions;
+    return it->second;
+}
+
+void IngestScheduler::release_source_locked(const std::shared_ptr<Source> &source) {
+    if (source->sessions > 0) {
+        --source->sessions;
+    }
+}
+
+bool IngestScheduler::take_quota(Source &source, bool &deferred) {
+    deferred = false;
+    std::int64_t wait_ms = 0;
+    {
+        std::lock_guard<std::mutex> lock(source.bucket_mutex);
+        const std::int64_t now = ClockService::instance().now_millis();
+        const double burst = static_cast<double>(config_.source_burst);
+        if (now > source.refilled_at_ms) {
+            source.tokens = std::min(burst, source.tokens + static_cast<double>(now - source.refilled_at_ms) *
+                                                                config_.source_rate / 1000.0);
+            source.refilled_at_ms = now;
+        }
+        if (source.tokens >= 1.0) {
+            source.tokens -= 1.0;
+            return true;
+        }
+        if (config_.quota_action == QuotaAction::Drop) {
+            return false;
+        }
+        // Reserve the token now so concurrent sessions of the same source queue up behind it.
+        wait_ms = static_cast<std::int64_t>(std::ceil((1.0 - source.tokens) * 1000.0 / config_.source_rate));
+        source.tokens -= 1.0;
+    }
+    deferred = true;
+    std::this_thread::sleep_for(std::chrono::milliseconds(wait_ms));
+    return true;
+}
+
+void IngestScheduler::drain() {
+    std::vector<Pending> batch;
+    while (pending_.load(std::memory_order_acquire) > 0) {
+        if (!drain_mutex_.try_lock()) {
+            return;
+        }
+        unsigned rounds = 0;
+        while (serve_round(batch)) {
+            for (Pending &pending : batch) {
+                if (sink_) {
+                    sink_(pending.message, pending.timestamp, pending.route, pending.source->name);
+                }
+            }
+            pending_.fetch_sub(batch.size(), std::memory_order_acq_rel);
+            batch.clear();
+            space_available_.notify_all();
+            if (++rounds >= kRoundsPerTurn && submitters_.load(std::memory_order_acquire) > 1) {
+                break;
+            }
+        }
+        drain_mutex_.unlock();
+        if (submitters_.load(std::memory_order_acquire) > 1) {
+            return;
+        }
+    }
+}
+
+bool IngestScheduler::serve_round(std::vector<Pending> &batch) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (active_.empty()) {
+        return false;
+    }
+    const std::size_t backlogged = active_.size();
+    const std::size_t batch_start = batch.size();
+    for (std::size_t i = 0; i < backlogged; ++i) {
+        Session *session = active_.front();
+        active_.pop_front();
+        session->deficit += config_.quantum_bytes;
+        while (!session->queue.empty()) {
+            const std::size_t cost = session->queue.front().message.size() + 1;
+            if (cost > session->deficit) {
+                break;
+            }
+            session->deficit -= cost;
+            batch.push_back(std::move(session->queue.front()));
+            session->queue.pop_front();
+        }
+        if (session->queue.empty()) {
+            session->deficit = 0;
+            session->active = false;
+        } else {
+            active_.push_back(session);
+        }
+    }
+    pending_lines_.store(pending_lines_.load(std::memory_order_relaxed) - (batch.size() - batch_start),
+                         std::memory_order_relaxed);
+    backlogged_.store(active_.size(), std::memory_order_relaxed);
+    add_relaxed(rounds_, 1UL);
+    return true;
+}
+
+} // namespace logcrafter::cpp
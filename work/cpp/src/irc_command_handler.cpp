@@ -1,9 +1,9 @@
 /*
- * Sequence: SEQ0066
+ * Sequence: SEQ0213
  * Track: C++
- * MVP: mvp6
- * Change: Implement the LogCrafter IRC command helpers for queries, log streaming, and stats reporting.
- * Tests: smoke_cpp_mvp6_irc
+ * MVP: Step D
+ * Change: Reject scope=cluster in !query and keep the newest matches for limit=.
+ * Tests: integration_cpp_irc_feature
  */
 #include "irc_command_handler.hpp"
 
@@ -12,6 +12,7 @@
 #include <sstream>
 
 #include "irc_command_parser.hpp"
+#include "query_arena.hpp"
 #include "query_parser.hpp"
 
 namespace logcrafter::cpp {
@@ -94,7 +95,8 @@ IRCCommandResult IRCCommandHandler::handle_query_command(int client_fd,
     IRCCommandResult result;
     result.handled = true;
 
-    QueryRequest request;
+    QueryArenaScope arena;
+    QueryRequest request(arena.resource());
     std::string error;
     if (!parse_query_arguments(arguments, request, error)) {
         if (error.empty()) {
@@ -103,22 +105,32 @@ IRCCommandResult IRCCommandHandler::handle_query_command(int client_fd,
         result.replies.push_back({IRCCommandReply::Type::Notice, nickname, error});
         return result;
     }
+    if (!request.streams.empty()) {
+        result.replies.push_back({IRCCommandReply::Type::Notice, nickname,
+                                  "!query searches the default stream; use the query port for stream=."});
+        return result;
+    }
+    if (request.scope == QueryRequest::Scope::Cluster) {
+        result.replies.push_back({IRCCommandReply::Type::Notice, nickname,
+                                  "!query searches this node only; use the query port for scope=cluster."});
+        return result;
+    }
 
-    std::vector<std::string> matches = buffer_.execute_query(request);
+    const QueryResults matches = buffer_.execute_query(request, arena.resource());
+    // The default stream is in time order, so limit= keeps the tail.
+    const std::size_t first =
+        request.limit > 0 && request.limit < matches.size() ? matches.size() - request.limit : 0;
+    const std::size_t selected = matches.size() - first;
     constexpr std::size_t kMaxLines = 5;
     std::ostringstream oss;
-    oss << "!query matched " << matches.size() << " entr" << (matches.size() == 1 ? 'y' : 'i') << 's';
-    if (matches.size() > kMaxLines) {
+    oss << "!query matched " << selected << " entr" << (selected == 1 ? 'y' : 'i') << 's';
+    if (selected > kMaxLines) {
         oss << " (showing " << kMaxLines << ")";
     }
     result.replies.push_back({IRCCommandReply::Type::Notice, nickname, oss.str()});
 
-    std::size_t emitted = 0;
-    for (const std::string &line : matches) {
-        if (emitted++ >= kMaxLines) {
-            break;
-        }
-        result.replies.push_back({IRCCommandReply::Type::Notice, nickname, line});
+    for (std::size_t i = first; i < matches.size() && i - first < kMaxLines; ++i) {
+        result.replies.push_back({IRCCommandReply::Type::Notice, nickname, std::string(matches[i])});
     }
 
     if (matches.empty()) {
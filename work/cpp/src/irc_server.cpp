@@ -1,9 +1,9 @@
 /*
- * Sequence: SEQ0072
+ * Sequence: SEQ0273
  * Track: C++
- * MVP: mvp6
- * Change: Integrate IRC command handling, channel statistics, and richer RFC responses.
- * Tests: smoke_cpp_mvp6_irc
+ * MVP: Step D
+ * Change: Send server NOTICEs to the registered members of a channel.
+ * Tests: spec_alert_rules
  */
 #include "irc_server.hpp"
 
@@ -17,12 +17,13 @@
 #include <cerrno>
 #include <algorithm>
 #include <cstring>
-#include <iomanip>
 #include <iostream>
 #include <sstream>
 #include <utility>
 #include <vector>
 
+#include "clock_service.hpp"
+
 namespace logcrafter::cpp {
 namespace {
 
@@ -45,19 +46,6 @@ void send_all(int fd, const std::string &line) {
     }
 }
 
-std::tm safe_localtime(std::time_t timestamp) {
-    std::tm result{};
-#if defined(_POSIX_VERSION)
-    localtime_r(&timestamp, &result);
-#else
-    std::tm *tmp = std::localtime(&timestamp);
-    if (tmp != nullptr) {
-        result = *tmp;
-    }
-#endif
-    return result;
-}
-
 std::vector<std::string> split_channels(const std::vector<std::string> &params) {
     std::vector<std::string> channels;
     if (params.empty()) {
@@ -85,7 +73,9 @@ IRCServer::IRCServer()
       channel_manager_(),
       command_handler_(nullptr),
       auto_join_channels_({"#logs-all"}),
-      active_clients_(0) {}
+      active_clients_(0),
+      channel_count_(0),
+      channel_preview_() {}
 
 IRCServer::~IRCServer() { shutdown(); }
 
@@ -121,6 +111,37 @@ std::vector<IRCChannelManager::ChannelStats> IRCServer::channel_stats() const {
     return channel_manager_.stats();
 }
 
+std::size_t IRCServer::channel_count() const { return channel_count_.load(std::memory_order_relaxed); }
+
+std::string IRCServer::channel_preview() const {
+    std::string preview;
+    channel_preview_.read(preview);
+    return preview;
+}
+
+void IRCServer::publish_channel_stats_locked() {
+    const auto channels = channel_manager_.stats();
+    std::string preview;
+    if (!channels.empty()) {
+        preview.push_back('[');
+        const std::size_t shown = std::min<std::size_t>(channels.size(), kChannelPreviewCount);
+        for (std::size_t i = 0; i < shown; ++i) {
+            if (i > 0) {
+                preview += ", ";
+            }
+            preview += channels[i].name;
+            preview.push_back('=');
+            preview += std::to_string(channels[i].members);
+        }
+        if (channels.size() > shown) {
+            preview += ", ...";
+        }
+        preview.push_back(']');
+    }
+    channel_preview_.publish(preview);
+    channel_count_.store(channels.size(), std::memory_order_relaxed);
+}
+
 int IRCServer::start(int port) {
     shutdown();
 
@@ -153,6 +174,10 @@ int IRCServer::start(int port) {
         return -1;
     }
 
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        publish_channel_stats_locked();
+    }
     running_.store(true, std::memory_order_release);
     worker_ = std::thread(&IRCServer::run_loop, this);
     std::cerr << "[lc][info] IRC server listening on port " << port << std::endl;
@@ -183,6 +208,7 @@ void IRCServer::shutdown() {
     clients_.clear();
     channel_manager_.reset();
     active_clients_.store(0, std::memory_order_relaxed);
+    publish_channel_stats_locked();
 }
 
 void IRCServer::publish_log(const std::string &message, std::time_t timestamp) {
@@ -206,6 +232,21 @@ void IRCServer::publish_log(const std::string &message, std::time_t timestamp) {
     send_lines(sends);
 }
 
+void IRCServer::notice_channel(const std::string &channel, const std::string &text) {
+    std::vector<PendingSend> sends;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        const std::string line = ":" + server_name_ + " NOTICE " + channel + " :" + text + "\r\n";
+        for (const int fd : channel_manager_.members_for(channel)) {
+            auto it = clients_.find(fd);
+            if (it != clients_.end() && it->second.registered) {
+                sends.push_back({fd, line});
+            }
+        }
+    }
+    send_lines(sends);
+}
+
 std::size_t IRCServer::active_clients() const { return active_clients_.load(std::memory_order_relaxed); }
 
 void IRCServer::run_loop() {
@@ -357,8 +398,15 @@ std::vector<std::string> IRCServer::drain_client_lines(IRCClient &client) {
 
 std::vector<IRCServer::PendingSend> IRCServer::process_command(int client_fd, const IRCCommand &command,
                                                                bool &client_closed) {
-    std::vector<PendingSend> sends;
     std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<PendingSend> sends = process_command_locked(client_fd, command, client_closed);
+    publish_channel_stats_locked();
+    return sends;
+}
+
+std::vector<IRCServer::PendingSend> IRCServer::process_command_locked(int client_fd, const IRCCommand &command,
+                                                                      bool &client_closed) {
+    std::vector<PendingSend> sends;
     auto it = clients_.find(client_fd);
     if (it == clients_.end()) {
         client_closed = true;
@@ -651,6 +699,7 @@ void IRCServer::close_client_locked(int client_fd) {
     ::close(client_fd);
     clients_.erase(it);
     active_clients_.fetch_sub(1, std::memory_order_relaxed);
+    publish_channel_stats_locked();
 }
 
 void IRCServer::send_lines(const std::vector<PendingSend> &sends) {
@@ -669,11 +718,21 @@ void IRCServer::set_socket_nonblocking(int fd) {
 
 std::string IRCServer::format_privmsg(const std::string &server_name, const std::string &channel,
                                       const std::string &message, std::time_t timestamp) {
-    std::ostringstream oss;
-    const std::tm tm_value = safe_localtime(timestamp);
-    oss << ':' << server_name << " PRIVMSG " << channel << " :";
-    oss << '[' << std::put_time(&tm_value, "%Y-%m-%d %H:%M:%S") << "] " << message << "\r\n";
-    return oss.str();
+    char stamp[32];
+    const std::size_t stamp_length = ClockService::instance().format_timestamp(timestamp, stamp, sizeof(stamp));
+
+    std::string line;
+    line.reserve(server_name.size() + channel.size() + message.size() + stamp_length + 16);
+    line += ':';
+    line += server_name;
+    line += " PRIVMSG ";
+    line += channel;
+    line += " :[";
+    line.append(stamp, stamp_length);
+    line += "] ";
+    line += message;
+    line += "\r\n";
+    return line;
 }
 
 } // namespace logcrafter::cpp
@@ -1,29 +1,45 @@
 /*
- * Sequence: SEQ0074
+ * Sequence: SEQ0344
  * Track: C++
- * MVP: mvp6
- * Change: Wire the IRC command handler, expose richer stats, and support configurable IRC identities.
- * Tests: smoke_cpp_mvp6_irc
+ * MVP: Step D
+ * Change: Redact received and relayed lines in place before they are queued; report per-rule counts.
+ * Tests: spec_redaction
  */
 #include "lc_server.hpp"
 
 #include <algorithm>
 #include <arpa/inet.h>
 #include <cerrno>
+#include <charconv>
+#include <chrono>
 #include <cstdio>
 #include <cstring>
 #include <exception>
 #include <ctime>
+#include <fcntl.h>
 #include <iostream>
 #include <netinet/in.h>
+#include <poll.h>
 #include <sstream>
 #include <string>
 #include <sys/select.h>
 #include <sys/socket.h>
 #include <sys/types.h>
+#include <type_traits>
 #include <unistd.h>
 #include <vector>
 
+#include "clock_service.hpp"
+#include "compressed_response_writer.hpp"
+#include "net_io.hpp"
+#include "query_arena.hpp"
+#include "regex_cache.hpp"
+#include "relay_codec.hpp"
+#include "response_writer.hpp"
+#include "result_codec.hpp"
+#include "result_merge.hpp"
+#include "timestamp_parser.hpp"
+
 namespace logcrafter::cpp {
 
 namespace {
@@ -33,6 +49,7 @@ constexpr int kDefaultQueryPort = 9998;
 constexpr int kDefaultBacklog = 32;
 constexpr int kDefaultTimeoutMs = 500;
 constexpr std::size_t kQueryBufferSize = 512;
+constexpr std::size_t kMaxSourceNameLength = 64;
 
 class FileDescriptorGuard {
 public:
@@ -66,6 +83,34 @@ private:
     std::atomic<int> &counter_;
 };
 
+// STATS text built with std::to_chars rather than an ostringstream, whose per-field locale
+// formatting cost more than the rest of a polled STATS request.
+class StatsText {
+public:
+    StatsText() { text_.reserve(1024); }
+
+    StatsText &operator<<(std::string_view value) {
+        text_.append(value);
+        return *this;
+    }
+    StatsText &operator<<(char value) {
+        text_.push_back(value);
+        return *this;
+    }
+    template <typename Integer, typename = std::enable_if_t<std::is_integral_v<Integer>>>
+    StatsText &operator<<(Integer value) {
+        char digits[24];
+        const auto result = std::to_chars(digits, digits + sizeof(digits), value);
+        text_.append(digits, static_cast<std::size_t>(result.ptr - digits));
+        return *this;
+    }
+
+    std::string_view str() const { return text_; }
+
+private:
+    std::string text_;
+};
+
 void send_all(int fd, const char *data, std::size_t length) {
     std::size_t total_sent = 0;
     while (total_sent < length) {
@@ -81,8 +126,8 @@ void send_all(int fd, const char *data, std::size_t length) {
     }
 }
 
-void send_all(int fd, const std::string &text) {
-    send_all(fd, text.c_str(), text.size());
+void send_all(int fd, std::string_view text) {
+    send_all(fd, text.data(), text.size());
 }
 
 ssize_t recv_line(int fd, char *buffer, std::size_t capacity, bool &truncated, bool &connection_closed) {
@@ -145,6 +190,74 @@ void apply_ellipsis(std::string &line, std::size_t max_length) {
     }
 }
 
+// Accepts "SOURCE <name>" where name is 1-64 characters of [A-Za-z0-9._:-].
+bool parse_source_declaration(const std::string &line, std::string &name) {
+    static constexpr const char prefix[] = "SOURCE ";
+    if (line.compare(0, sizeof(prefix) - 1, prefix) != 0) {
+        return false;
+    }
+    const std::string candidate = line.substr(sizeof(prefix) - 1);
+    if (candidate.empty() || candidate.size() > kMaxSourceNameLength) {
+        return false;
+    }
+    for (const char ch : candidate) {
+        const bool allowed = (ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z') || (ch >= '0' && ch <= '9') ||
+                             ch == '.' || ch == '_' || ch == ':' || ch == '-';
+        if (!allowed) {
+            return false;
+        }
+    }
+    name = candidate;
+    return true;
+}
+
+// Accepts "STREAM <name>"; the name itself is validated by StreamRegistry::open().
+bool parse_stream_declaration(const std::string &line, std::string &name) {
+    static constexpr const char prefix[] = "STREAM ";
+    if (line.compare(0, sizeof(prefix) - 1, prefix) != 0) {
+        return false;
+    }
+    name = line.substr(sizeof(prefix) - 1);
+    return true;
+}
+
+std::string peer_name(const struct sockaddr_in &address) {
+    char text[INET_ADDRSTRLEN] = {};
+    if (::inet_ntop(AF_INET, &address.sin_addr, text, sizeof(text)) == nullptr) {
+        return "unknown";
+    }
+    return text;
+}
+
+// Accepts "RELAY <name> <epoch>" as the first line of a log session.
+bool parse_relay_hello(const std::string &line, std::string &identity) {
+    static constexpr const char prefix[] = "RELAY ";
+    if (line.compare(0, sizeof(prefix) - 1, prefix) != 0) {
+        return false;
+    }
+    identity = line.substr(sizeof(prefix) - 1);
+    const std::size_t space = identity.find(' ');
+    return space != 0 && space != std::string::npos && space + 1 < identity.size();
+}
+
+// Accepts "REPLICATE <name> <epoch> <next sequence>" as the first line of a log session.
+bool parse_replicate_hello(const std::string &line, std::string &name, std::uint64_t &epoch,
+                           std::uint64_t &next_sequence) {
+    char name_buffer[64];
+    unsigned long long parsed_epoch = 0;
+    unsigned long long parsed_next = 0;
+    char trailing = 0;
+    if (std::sscanf(line.c_str(), "REPLICATE %63s %llu %llu %c", name_buffer, &parsed_epoch, &parsed_next,
+                    &trailing) != 3 ||
+        !StreamRegistry::valid_name(name_buffer)) {
+        return false;
+    }
+    name = name_buffer;
+    epoch = parsed_epoch;
+    next_sequence = parsed_next;
+    return true;
+}
+
 } // namespace
 
 ServerConfig default_config() {
@@ -163,6 +276,35 @@ ServerConfig default_config() {
     config.irc_port = Server::kDefaultIrcPort;
     config.irc_server_name = Server::kDefaultIrcServerName;
     config.irc_auto_join = {"#logs-all"};
+    config.client_timestamps = false;
+    config.reorder_window = LogBuffer::kDefaultReorderWindow;
+    config.level_shares = LevelShares{};
+    config.source_rate = 0.0;
+    config.source_burst = 0;
+    config.quota_action = QuotaAction::Drop;
+    config.repeat_mode = RepeatMode::Off;
+    config.repeat_window_ms = RepeatCollapser::kDefaultWindowMs;
+    config.relay_enabled = false;
+    config.relay.upstream_port = 0;
+    config.relay.spool_directory = ForwardingManager::kDefaultSpoolDirectory;
+    config.relay.relay_name = "relay";
+    config.relay.compress = false;
+    config.relay.batch_records = ForwardingManager::kDefaultBatchRecords;
+    config.replication_enabled = false;
+    config.replication.directory = ReplicationSource::kDefaultDirectory;
+    config.replication.retain_segments = ReplicationSource::kDefaultRetainSegments;
+    config.replication.batch_records = ReplicationSource::kDefaultBatchRecords;
+    config.replication.tail_entries = ReplicationSource::kDefaultTailEntries;
+    config.replica_enabled = false;
+    config.replica.primary_port = 0;
+    config.replica.name = "replica";
+    config.peer_timeout_ms = FederationClient::kDefaultTimeoutMs;
+    config.alert_rules_path.clear();
+    config.redact_rules_path.clear();
+    config.shedding.ladder.clear();
+    config.shedding.high_water = IngestScheduler::kDefaultQueueDepth;
+    config.pipeline.threads.fill(0);
+    config.pipeline.queue_capacity = IngestPipeline::kDefaultQueueCapacity;
     return config;
 }
 
@@ -171,14 +313,42 @@ Server::Server()
       log_listener_fd_(-1),
       query_listener_fd_(-1),
       running_(false),
-      log_buffer_(),
-      persistence_(),
+      streams_(),
+      ingest_(),
       persistence_enabled_(false),
+      forwarder_(),
+      relay_enabled_(false),
+      relay_mutex_(),
+      relay_sequences_(),
+      relay_inbound_records_(0),
+      relay_duplicate_batches_(0),
+      replication_(),
+      replication_enabled_(false),
+      replica_(),
+      replica_enabled_(false),
+      compressed_queries_(0),
+      compress_raw_bytes_(0),
+      compress_wire_bytes_(0),
+      compress_cpu_micros_(0),
+      exports_(0),
+      export_bytes_(0),
+      rollups_(),
+      alerts_(),
+      redactor_(),
+      shedder_(),
+      federation_(),
+      peer_sessions_mutex_(),
+      peer_sessions_(),
+      fetch_waiters_(),
+      fetch_waiter_count_(0),
+      fetches_(0),
+      wake_pipe_{-1, -1},
       irc_server_(nullptr),
       irc_enabled_(false),
+      clock_started_(false),
       active_log_clients_(0),
       active_query_clients_(0) {
-    log_buffer_.configure(kDefaultLogCapacity);
+    streams_.default_stream().buffer.configure(kDefaultLogCapacity);
 }
 
 int Server::init(const ServerConfig &config) {
@@ -211,11 +381,49 @@ int Server::init(const ServerConfig &config) {
         config_.irc_auto_join.push_back("#logs-all");
     }
 
-    log_buffer_.configure(config_.buffer_capacity);
+    IngestConfig ingest_config{};
+    ingest_config.quantum_bytes = IngestScheduler::kDefaultQuantumBytes;
+    ingest_config.queue_depth = IngestScheduler::kDefaultQueueDepth;
+    ingest_config.source_rate = config_.source_rate;
+    ingest_config.source_burst = config_.source_burst;
+    ingest_config.quota_action = config_.quota_action;
+    ingest_config.repeat_mode = config_.repeat_mode;
+    ingest_config.repeat_window_ms = config_.repeat_window_ms;
+    ingest_.configure(ingest_config, [this](std::string &message, std::time_t timestamp, std::size_t route,
+                                            const std::string &source) {
+        PipelineEntry entry;
+        entry.stream = route;
+        entry.message = std::move(message);
+        entry.timestamp = timestamp;
+        entry.source = source;
+        pipeline_.submit(std::move(entry));
+    });
+    pipeline_.start(config_.pipeline, {[this](PipelineEntry &entry) { enrich_entry(entry); },
+                                       [this](PipelineEntry &entry) { store_entry(entry); },
+                                       [this](PipelineEntry &entry) { persist_entry(entry); },
+                                       [this](PipelineEntry &entry) { fanout_entry(entry); }});
+    shedder_.configure(config_.shedding);
     active_log_clients_.store(0, std::memory_order_relaxed);
     active_query_clients_.store(0, std::memory_order_relaxed);
     persistence_enabled_ = false;
+    relay_enabled_ = false;
+    replication_enabled_ = false;
+    replica_enabled_ = false;
     irc_enabled_ = false;
+    {
+        std::lock_guard<std::mutex> lock(relay_mutex_);
+        relay_sequences_.clear();
+    }
+    relay_inbound_records_.store(0, std::memory_order_relaxed);
+    relay_duplicate_batches_.store(0, std::memory_order_relaxed);
+    federation_.configure(config_.peers, config_.peer_timeout_ms);
+
+    if (::pipe2(wake_pipe_, O_CLOEXEC | O_NONBLOCK) != 0) {
+        std::perror("pipe");
+        wake_pipe_[0] = wake_pipe_[1] = -1;
+        running_.store(false, std::memory_order_release);
+        return -1;
+    }
 
     log_listener_fd_ = create_listener(config_.log_port, config_.max_pending_connections);
     if (log_listener_fd_ < 0) {
@@ -243,15 +451,44 @@ int Server::init(const ServerConfig &config) {
         return -1;
     }
 
-    if (config_.persistence_enabled) {
-        PersistenceConfig persistence_config{};
-        persistence_config.directory = config_.persistence_directory;
-        persistence_config.max_file_size = config_.persistence_max_file_size;
-        persistence_config.max_files = config_.persistence_max_files;
+    StreamSettings stream_settings{};
+    stream_settings.default_capacity = config_.buffer_capacity;
+    stream_settings.reorder_window = config_.reorder_window;
+    stream_settings.level_shares = config_.level_shares;
+    stream_settings.persistence_enabled = config_.persistence_enabled;
+    stream_settings.persistence.directory = config_.persistence_directory;
+    stream_settings.persistence.max_file_size = config_.persistence_max_file_size;
+    stream_settings.persistence.max_files = config_.persistence_max_files;
+    stream_settings.declared = config_.streams;
+    if (streams_.configure(stream_settings) != 0) {
+        std::perror("persistence");
+        streams_.reset();
+        thread_pool_.stop();
+        ::close(log_listener_fd_);
+        ::close(query_listener_fd_);
+        log_listener_fd_ = -1;
+        query_listener_fd_ = -1;
+        running_.store(false, std::memory_order_release);
+        return -1;
+    }
+    persistence_enabled_ = config_.persistence_enabled;
 
-        if (persistence_.init(persistence_config) != 0) {
-            std::perror("persistence");
-            persistence_.shutdown();
+    RollupConfig rollup_config{};
+    if (persistence_enabled_) {
+        rollup_config.state_path = config_.persistence_directory + "/rollup.state";
+    }
+    rollup_config.save_interval_ms = RollupStore::kDefaultSaveIntervalMs;
+    if (rollups_.init(rollup_config) != 0) {
+        std::perror("rollups");
+        shutdown();
+        return -1;
+    }
+
+    if (config_.relay_enabled) {
+        if (forwarder_.init(config_.relay) != 0) {
+            std::perror("relay spool");
+            streams_.reset();
+            persistence_enabled_ = false;
             thread_pool_.stop();
             ::close(log_listener_fd_);
             ::close(query_listener_fd_);
@@ -260,35 +497,24 @@ int Server::init(const ServerConfig &config) {
             running_.store(false, std::memory_order_release);
             return -1;
         }
-
-        persistence_enabled_ = true;
-        const int replay_result = persistence_.replay_existing([this](const std::string &message, std::time_t timestamp) {
-            const std::time_t effective = timestamp == static_cast<std::time_t>(0) ? std::time(nullptr) : timestamp;
-            log_buffer_.push_with_time(message, effective);
-            if (irc_enabled_ && irc_server_) {
-                irc_server_->publish_log(message, effective);
-            }
-        });
-        if (replay_result != 0) {
-            std::cerr << "[lc][warn] Failed to replay persisted logs into buffer" << std::endl;
-        }
+        relay_enabled_ = true;
     }
 
     if (config_.irc_enabled) {
         irc_server_ = std::make_unique<IRCServer>();
         irc_server_->set_server_name(config_.irc_server_name);
         irc_server_->set_auto_join_channels(config_.irc_auto_join);
-        irc_server_->set_command_context(log_buffer_, [this]() { return make_irc_stats_snapshot(); });
+        irc_server_->set_command_context(streams_.default_stream().buffer, [this]() { return make_irc_stats_snapshot(); });
         if (irc_server_->start(config_.irc_port) != 0) {
             std::cerr << "[lc][error] Failed to start IRC server" << std::endl;
             if (irc_server_) {
                 irc_server_->shutdown();
                 irc_server_.reset();
             }
-            if (persistence_enabled_) {
-                persistence_.shutdown();
-                persistence_enabled_ = false;
-            }
+            forwarder_.shutdown();
+            relay_enabled_ = false;
+            streams_.reset();
+            persistence_enabled_ = false;
             thread_pool_.stop();
             ::close(log_listener_fd_);
             ::close(query_listener_fd_);
@@ -300,10 +526,129 @@ int Server::init(const ServerConfig &config) {
         irc_enabled_ = true;
     }
 
+    if (ClockService::instance().start() == 0) {
+        clock_started_ = true;
+    } else {
+        std::cerr << "[lc][warn] Clock ticker unavailable; falling back to coarse clock reads" << std::endl;
+    }
+
+    if (!config_.alert_rules_path.empty()) {
+        std::string error;
+        const auto notify = [this](const std::string &channel, const std::string &text) {
+            if (irc_enabled_ && irc_server_) {
+                irc_server_->notice_channel(channel, text);
+            }
+        };
+        if (alerts_.load(config_.alert_rules_path, notify, error) != 0) {
+            std::cerr << "[lc][error] Alert rules: " << error << std::endl;
+            shutdown();
+            return -1;
+        }
+        if (alerts_.needs_irc() && !irc_enabled_) {
+            std::cerr << "[lc][error] Alert rules notify IRC channels; start the server with --enable-irc" << std::endl;
+            shutdown();
+            return -1;
+        }
+    }
+
+    if (!config_.redact_rules_path.empty()) {
+        std::string error;
+        if (redactor_.load(config_.redact_rules_path, error) != 0) {
+            std::cerr << "[lc][error] Redaction rules: " << error << std::endl;
+            shutdown();
+            return -1;
+        }
+    }
+
+    // Last, so replicated entries only arrive once IRC fan-out and every other sink is up.
+    if (config_.replication_enabled) {
+        replication_.set_publish_hook([this]() {
+            if (fetch_waiter_count_.load(std::memory_order_relaxed) > 0) {
+                // Under the lock, so shutdown() cannot close the pipe while it is written.
+                std::lock_guard<std::mutex> lock(peer_sessions_mutex_);
+                if (!fetch_waiters_.empty()) {
+                    wake_accept_loop();
+                }
+            }
+        });
+        if (replication_.init(config_.replication) != 0) {
+            std::perror("replication log");
+            shutdown();
+            return -1;
+        }
+        replication_enabled_ = true;
+    }
+    if (config_.replica_enabled) {
+        ReplicaConfig replica = config_.replica;
+        if (persistence_enabled_) {
+            // Persisted entries are replayed at startup, so the position must survive with them.
+            replica.state_path = config_.persistence_directory + "/replica.state";
+        }
+        if (replica_.init(replica, [this](std::string_view stream, std::string message, std::time_t timestamp) {
+                apply_replicated(stream, std::move(message), timestamp);
+            }) != 0) {
+            std::perror("replica");
+            shutdown();
+            return -1;
+        }
+        replica_enabled_ = true;
+    }
+
+    std::ostringstream quota_text;
+    if (config_.source_rate > 0.0) {
+        quota_text << config_.source_rate << "/s " << (config_.quota_action == QuotaAction::Defer ? "defer" : "drop");
+    } else {
+        quota_text << "off";
+    }
+
+    std::string pipeline_text;
+    for (std::size_t s = 0; s < kPipelineStages; ++s) {
+        if (config_.pipeline.threads[s] > 0) {
+            pipeline_text += (pipeline_text.empty() ? "" : ",") + std::string(IngestPipeline::kStageNames[s]) + "=" +
+                             std::to_string(config_.pipeline.threads[s]);
+        }
+    }
+    if (pipeline_text.empty()) {
+        pipeline_text = "inline";
+    }
+
     running_.store(true, std::memory_order_release);
     std::cerr << "[lc][info] MVP6 C++ server initialized (log=" << config_.log_port
               << ", query=" << config_.query_port
               << ", workers=" << config_.worker_threads
+              << ", timestamps=" << (config_.client_timestamps ? "client" : "arrival")
+              << ", quota=" << quota_text.str()
+              << ", streams=" << streams_.count()
+              << ", rings="
+              << (config_.level_shares == LevelShares{}
+                      ? std::string("shared")
+                      : std::to_string(config_.level_shares[0]) + "/" + std::to_string(config_.level_shares[1]) +
+                            "/" + std::to_string(config_.level_shares[2]))
+              << ", repeats="
+              << (config_.repeat_mode == RepeatMode::Off
+                      ? std::string("kept")
+                      : std::string(config_.repeat_mode == RepeatMode::Exact ? "exact/" : "masked/") +
+                            std::to_string(config_.repeat_window_ms) + "ms")
+              << ", relay="
+              << (relay_enabled_ ? config_.relay.upstream_host + ":" + std::to_string(config_.relay.upstream_port) +
+                                       (config_.relay.compress ? "/zlib" : "")
+                                 : std::string("disabled"))
+              << ", replication="
+              << (replication_enabled_ ? "primary@" + config_.replication.directory
+                  : replica_enabled_ ? "replica-of " + config_.replica.primary_host + ":" +
+                                           std::to_string(config_.replica.primary_port)
+                                     : std::string("disabled"))
+              << ", peers=" << federation_.peer_count()
+              << ", alerts=" << alerts_.stats().rules
+              << ", redact="
+              << (redactor_.enabled() ? std::to_string(redactor_.stats().rules) + " rules/" +
+                                            std::to_string(redactor_.automaton_states()) + " states"
+                                      : std::string("off"))
+              << ", shedding="
+              << (shedder_.enabled() ? std::to_string(config_.shedding.ladder.size()) + " rungs@" +
+                                           std::to_string(config_.shedding.high_water)
+                                     : std::string("off"))
+              << ", pipeline=" << pipeline_text
               << ", persistence="
               << (persistence_enabled_ ? config_.persistence_directory : "disabled")
               << ", irc="
@@ -315,11 +660,9 @@ int Server::init(const ServerConfig &config) {
 
 void Server::shutdown() {
     running_.store(false, std::memory_order_release);
-    if (irc_server_) {
-        irc_server_->shutdown();
-        irc_server_.reset();
-    }
     thread_pool_.stop();
+    replica_.shutdown();
+    replica_enabled_ = false;
     if (log_listener_fd_ >= 0) {
         ::close(log_listener_fd_);
         log_listener_fd_ = -1;
@@ -328,12 +671,50 @@ void Server::shutdown() {
         ::close(query_listener_fd_);
         query_listener_fd_ = -1;
     }
-    log_buffer_.reset();
-    persistence_.shutdown();
+    {
+        std::lock_guard<std::mutex> lock(peer_sessions_mutex_);
+        for (const int fd : peer_sessions_) {
+            ::close(fd);
+        }
+        peer_sessions_.clear();
+        for (const FetchWaiter &waiter : fetch_waiters_) {
+            ::close(waiter.fd);
+        }
+        fetch_waiters_.clear();
+        fetch_waiter_count_.store(0, std::memory_order_relaxed);
+    }
+    for (int &fd : wake_pipe_) {
+        if (fd >= 0) {
+            ::close(fd);
+            fd = -1;
+        }
+    }
+    federation_.reset();
+    ingest_.reset();
+    // After ingest has drained and before the writers and IRC it feeds are gone.
+    pipeline_.stop();
+    if (irc_server_) {
+        irc_server_->shutdown();
+        irc_server_.reset();
+    }
+    // After ingest has drained, so the saved rollups count every stored entry.
+    rollups_.shutdown();
+    alerts_.reset();
+    redactor_.reset();
+    // After ingest has drained, so every stored entry reaches the spool.
+    forwarder_.shutdown();
+    relay_enabled_ = false;
+    replication_.shutdown();
+    replication_enabled_ = false;
+    streams_.reset();
     persistence_enabled_ = false;
     irc_enabled_ = false;
     active_log_clients_.store(0, std::memory_order_relaxed);
     active_query_clients_.store(0, std::memory_order_relaxed);
+    if (clock_started_) {
+        ClockService::instance().stop();
+        clock_started_ = false;
+    }
 }
 
 void Server::request_stop() {
@@ -350,16 +731,29 @@ int Server::run() {
     }
 
     while (running_.load(std::memory_order_acquire)) {
+        const int fetch_wait_ms = dispatch_due_fetches();
+
         fd_set read_fds;
         FD_ZERO(&read_fds);
         FD_SET(log_listener_fd_, &read_fds);
         FD_SET(query_listener_fd_, &read_fds);
+        FD_SET(wake_pipe_[0], &read_fds);
+
+        int max_fd = std::max({log_listener_fd_, query_listener_fd_, wake_pipe_[0]});
+        {
+            std::lock_guard<std::mutex> lock(peer_sessions_mutex_);
+            for (const int fd : peer_sessions_) {
+                FD_SET(fd, &read_fds);
+                max_fd = std::max(max_fd, fd);
+            }
+        }
 
-        int max_fd = std::max(log_listener_fd_, query_listener_fd_);
-
+        // A waiting FETCH is answered at its deadline even when nothing else happens.
+        const int timeout_ms = fetch_wait_ms >= 0 ? std::min(config_.select_timeout_ms, fetch_wait_ms)
+                                                  : config_.select_timeout_ms;
         struct timeval timeout;
-        timeout.tv_sec = config_.select_timeout_ms / 1000;
-        timeout.tv_usec = (config_.select_timeout_ms % 1000) * 1000;
+        timeout.tv_sec = timeout_ms / 1000;
+        timeout.tv_usec = (timeout_ms % 1000) * 1000;
 
         const int ready = ::select(max_fd + 1, &read_fds, nullptr, nullptr, &timeout);
         if (ready < 0) {
@@ -379,7 +773,7 @@ int Server::run() {
             socklen_t addr_len = sizeof(client_addr);
             const int client_fd = ::accept(log_listener_fd_, reinterpret_cast<struct sockaddr *>(&client_addr), &addr_len);
             if (client_fd >= 0) {
-                dispatch_log_client(client_fd);
+                dispatch_log_client(client_fd, peer_name(client_addr));
             } else if (errno != EINTR) {
                 std::perror("accept");
             }
@@ -395,6 +789,30 @@ int Server::run() {
                 std::perror("accept");
             }
         }
+
+        if (FD_ISSET(wake_pipe_[0], &read_fds)) {
+            char drain[64];
+            while (::read(wake_pipe_[0], drain, sizeof(drain)) > 0) {
+            }
+        }
+
+        // Only this loop removes parked sessions, so every fd still listed was in the select set.
+        std::vector<int> ready_sessions;
+        {
+            std::lock_guard<std::mutex> lock(peer_sessions_mutex_);
+            auto parked = peer_sessions_.begin();
+            while (parked != peer_sessions_.end()) {
+                if (FD_ISSET(*parked, &read_fds)) {
+                    ready_sessions.push_back(*parked);
+                    parked = peer_sessions_.erase(parked);
+                } else {
+                    ++parked;
+                }
+            }
+        }
+        for (const int fd : ready_sessions) {
+            dispatch_peer_request(fd);
+        }
     }
 
     return 0;
@@ -434,44 +852,168 @@ int Server::create_listener(int port, int backlog) {
     return fd;
 }
 
-void Server::dispatch_log_client(int client_fd) {
-    if (!thread_pool_.enqueue([this, client_fd]() {
+void Server::dispatch_log_client(int client_fd, std::string peer) {
+    if (!thread_pool_.enqueue([this, client_fd, peer = std::move(peer)]() {
             FileDescriptorGuard guard(client_fd);
-            handle_log_client(client_fd);
+            handle_log_client(client_fd, peer);
         })) {
         ::close(client_fd);
     }
 }
 
 void Server::dispatch_query_client(int client_fd) {
-    if (!thread_pool_.enqueue([this, client_fd]() {
-            FileDescriptorGuard guard(client_fd);
-            handle_query_client(client_fd);
-        })) {
+    if (!thread_pool_.enqueue([this, client_fd]() { finish_session(client_fd, handle_query_client(client_fd)); })) {
         ::close(client_fd);
     }
 }
 
-void Server::store_log(const std::string &message) {
-    const std::time_t timestamp = std::time(nullptr);
-    log_buffer_.push_with_time(message, timestamp);
-    if (persistence_enabled_) {
-        if (!persistence_.enqueue(message, timestamp)) {
+void Server::dispatch_peer_request(int client_fd) {
+    if (!thread_pool_.enqueue([this, client_fd]() { finish_session(client_fd, serve_peer_request(client_fd)); })) {
+        ::close(client_fd);
+    }
+}
+
+void Server::park_peer_session(int client_fd) {
+    {
+        std::lock_guard<std::mutex> lock(peer_sessions_mutex_);
+        if (running_.load(std::memory_order_acquire) && peer_sessions_.size() < kMaxPeerSessions) {
+            peer_sessions_.push_back(client_fd);
+            client_fd = -1;
+        }
+    }
+    if (client_fd >= 0) {
+        ::close(client_fd);
+        return;
+    }
+    // Wake the accept loop so the session joins the next select() set.
+    wake_accept_loop();
+}
+
+void Server::finish_session(int client_fd, SessionAction action) {
+    if (action == SessionAction::Park) {
+        park_peer_session(client_fd);
+    } else if (action == SessionAction::Close) {
+        ::close(client_fd);
+    }
+}
+
+void Server::wake_accept_loop() {
+    const char wake = 1;
+    if (::write(wake_pipe_[1], &wake, 1) < 0 && errno != EAGAIN) {
+        std::perror("write");
+    }
+}
+
+int Server::dispatch_due_fetches() {
+    std::vector<FetchWaiter> due;
+    int next_deadline_ms = -1;
+    {
+        std::lock_guard<std::mutex> lock(peer_sessions_mutex_);
+        if (fetch_waiters_.empty()) {
+            return -1;
+        }
+        const std::uint64_t head = replication_.head();
+        const auto now = std::chrono::steady_clock::now();
+        auto waiter = fetch_waiters_.begin();
+        while (waiter != fetch_waiters_.end()) {
+            if (head >= waiter->request.from || now >= waiter->deadline) {
+                due.push_back(*waiter);
+                waiter = fetch_waiters_.erase(waiter);
+                continue;
+            }
+            // Rounded up, so the loop does not wake just short of the deadline.
+            const int remaining =
+                static_cast<int>(std::chrono::ceil<std::chrono::milliseconds>(waiter->deadline - now).count());
+            next_deadline_ms = next_deadline_ms < 0 ? remaining : std::min(next_deadline_ms, remaining);
+            ++waiter;
+        }
+        fetch_waiter_count_.store(fetch_waiters_.size(), std::memory_order_relaxed);
+    }
+    for (const FetchWaiter &waiter : due) {
+        const int fd = waiter.fd;
+        const FetchRequest request = waiter.request;
+        const auto answer = [this, fd, request]() { finish_session(fd, send_fetch_batch(fd, request, false)); };
+        if (!thread_pool_.enqueue(answer)) {
+            ::close(fd);
+        }
+    }
+    return next_deadline_ms;
+}
+
+std::time_t Server::resolve_timestamp(std::string &line) const {
+    if (config_.client_timestamps) {
+        LeadingTimestamp stamp;
+        if (parse_leading_timestamp(line, stamp) && stamp.length < line.size()) {
+            line.erase(0, stamp.length);
+            return stamp.seconds;
+        }
+    }
+    return ClockService::instance().now_seconds();
+}
+
+void Server::enrich_entry(PipelineEntry &entry) const {
+    entry.level = result_codec::classify_level(entry.message);
+}
+
+void Server::store_entry(PipelineEntry &entry) {
+    StreamRegistry::Stream &stream = streams_.at(entry.stream);
+    stream.buffer.push_with_time(entry.message, entry.timestamp);
+    rollups_.record(entry.source, entry.level, entry.timestamp);
+    alerts_.evaluate(stream.name, entry.message, entry.timestamp);
+}
+
+void Server::persist_entry(PipelineEntry &entry) {
+    StreamRegistry::Stream &stream = streams_.at(entry.stream);
+    if (stream.persistent) {
+        if (!stream.persistence.enqueue(entry.message, entry.timestamp)) {
             std::cerr << "[lc][warn] Failed to enqueue log for persistence" << std::endl;
         }
     }
+    if (relay_enabled_ && !forwarder_.enqueue(stream.name, entry.message, entry.timestamp)) {
+        std::cerr << "[lc][warn] Failed to enqueue log for relay" << std::endl;
+    }
+    if (replication_enabled_ && !replication_.enqueue(stream.name, entry.message, entry.timestamp)) {
+        std::cerr << "[lc][warn] Failed to enqueue log for replication" << std::endl;
+    }
+}
+
+void Server::fanout_entry(PipelineEntry &entry) {
     if (irc_enabled_ && irc_server_) {
-        irc_server_->publish_log(message, timestamp);
+        irc_server_->publish_log(entry.message, entry.timestamp);
+    }
+    // One write per line, so echoes from several fan-out threads do not interleave.
+    entry.message.insert(0, "[lc][log] ");
+    entry.message.push_back('\n');
+    std::cout << entry.message << std::flush;
+}
+
+void Server::apply_replicated(std::string_view stream, std::string message, std::time_t timestamp) {
+    StreamRegistry::StreamId stream_id = StreamRegistry::kDefaultStream;
+    if (!streams_.open(stream, stream_id)) {
+        stream_id = StreamRegistry::kDefaultStream;
     }
+    // The replica thread is not the ingest drain, so it runs the stages itself.
+    PipelineEntry entry;
+    entry.stream = stream_id;
+    entry.message = std::move(message);
+    entry.timestamp = timestamp;
+    entry.source = "replication";
+    pipeline_.run_inline(entry);
 }
 
-void Server::handle_log_client(int client_fd) {
+void Server::handle_log_client(int client_fd, const std::string &peer) {
     ActiveClientGuard guard(active_log_clients_);
 
     const char welcome[] =
         "LogCrafter C++ MVP6: send newline-terminated log lines. Use !logstream via IRC for channel controls.\n";
     send_all(client_fd, welcome, sizeof(welcome) - 1);
 
+    const IngestScheduler::SessionHandle session = ingest_.open_session(peer);
+    // Leading SOURCE and STREAM lines (at most one of each, in either order) configure the
+    // session; the first other line starts the payload.
+    bool source_declared = false;
+    bool stream_declared = false;
+    bool first_line = true;
     char buffer[kMaxLogLength + 1];
     while (running_.load(std::memory_order_acquire)) {
         bool truncated = false;
@@ -484,6 +1026,15 @@ void Server::handle_log_client(int client_fd) {
         if (length == 0 && connection_closed) {
             break;
         }
+        // Past the session header, a line the shedder drops is never copied, trimmed, or queued.
+        if (source_declared && stream_declared && shedder_.enabled() &&
+            shedder_.shed(std::string_view(buffer, static_cast<std::size_t>(length)),
+                          ingest_.backlog() + pipeline_.queued())) {
+            if (connection_closed) {
+                break;
+            }
+            continue;
+        }
 
         std::string line(buffer, static_cast<std::size_t>(length));
         trim_trailing(line);
@@ -496,39 +1047,202 @@ void Server::handle_log_client(int client_fd) {
             continue;
         }
 
-        store_log(line);
-        std::cout << "[lc][log] " << line << std::endl;
+        std::string name;
+        std::uint64_t epoch = 0;
+        std::uint64_t next_sequence = 0;
+        if (first_line && !truncated && parse_replicate_hello(line, name, epoch, next_sequence)) {
+            ingest_.close_session(session);
+            if (!replication_enabled_) {
+                send_all(client_fd, "ERROR: Replication is not enabled on this node.\n");
+                return;
+            }
+            // The replication sender keeps its own descriptor; the worker closes this one.
+            const int replica_fd = ::dup(client_fd);
+            if (replica_fd < 0 || !replication_.attach(replica_fd, name, epoch, next_sequence)) {
+                send_all(client_fd, "ERROR: Replication is not available.\n");
+            }
+            return;
+        }
+        if (replica_enabled_) {
+            send_all(client_fd, "ERROR: This node is a read-only replica; send logs to its primary.\n");
+            break;
+        }
+        if (first_line && !truncated && parse_relay_hello(line, name)) {
+            ingest_.close_session(session);
+            handle_relay_client(client_fd, peer, name);
+            return;
+        }
+        first_line = false;
+        if (!source_declared && !truncated && parse_source_declaration(line, name)) {
+            source_declared = true;
+            ingest_.rename_session(session, name);
+            continue;
+        }
+        if (!stream_declared && !truncated && parse_stream_declaration(line, name)) {
+            stream_declared = true;
+            StreamRegistry::StreamId stream_id = StreamRegistry::kDefaultStream;
+            if (streams_.open(name, stream_id)) {
+                ingest_.set_route(session, stream_id);
+            } else {
+                const std::string notice = "ERROR: Cannot open stream '" + name + "'; using the default stream.\n";
+                send_all(client_fd, notice);
+            }
+            continue;
+        }
+        source_declared = true;
+        stream_declared = true;
+
+        // After the client's timestamp is taken off, so only the message itself is masked.
+        const std::time_t timestamp = resolve_timestamp(line);
+        redactor_.redact(line.data(), line.size());
+        ingest_.submit(session, std::move(line), timestamp);
 
         if (connection_closed) {
             break;
         }
     }
+    ingest_.close_session(session);
+}
+
+void Server::handle_relay_client(int client_fd, const std::string &peer, const std::string &identity) {
+    const IngestScheduler::SessionHandle session = ingest_.open_session(peer);
+    ingest_.rename_session(session, identity.substr(0, identity.find(' ')));
+
+    std::string frame_payload;
+    std::string inflated;
+    std::string route_name = StreamRegistry::kDefaultStreamName;
+    char header[relay_codec::kFrameHeaderBytes];
+    while (running_.load(std::memory_order_acquire)) {
+        // The relay keeps its connection open while idle; wake up regularly so shutdown is not held.
+        struct pollfd idle {
+            client_fd, POLLIN, 0
+        };
+        const int ready = ::poll(&idle, 1, config_.select_timeout_ms);
+        if (ready == 0 || (ready < 0 && errno == EINTR)) {
+            continue;
+        }
+        if (ready < 0 || !net_io::recv_exact(client_fd, header, sizeof(header))) {
+            break;
+        }
+        const relay_codec::FrameHeader frame = relay_codec::decode_frame_header(header);
+        if (frame.length > relay_codec::kMaxPayloadBytes) {
+            std::cerr << "[lc][warn] Relay " << identity << " sent an oversized frame" << std::endl;
+            break;
+        }
+        frame_payload.resize(frame.length);
+        // A stopping server must not ack: the relay keeps the batch and resends it after restart.
+        if (!net_io::recv_exact(client_fd, frame_payload.data(), frame_payload.size()) ||
+            !running_.load(std::memory_order_acquire)) {
+            break;
+        }
+        std::string_view records = frame_payload;
+        if ((frame.flags & relay_codec::kFlagCompressed) != 0) {
+            if (!relay_codec::decompress_payload(frame_payload, inflated)) {
+                std::cerr << "[lc][warn] Relay " << identity << " sent an undecodable frame" << std::endl;
+                break;
+            }
+            records = inflated;
+        }
+
+        bool duplicate = false;
+        {
+            std::lock_guard<std::mutex> lock(relay_mutex_);
+            duplicate = frame.sequence <= relay_sequences_[identity];
+        }
+        if (duplicate) {
+            // The ack for this batch was lost; the entries are already stored.
+            relay_duplicate_batches_.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            std::size_t offset = 0;
+            unsigned long applied = 0;
+            relay_codec::Record record{};
+            while (relay_codec::next_record(records, offset, record)) {
+                if (record.stream != route_name) {
+                    StreamRegistry::StreamId stream_id = StreamRegistry::kDefaultStream;
+                    streams_.open(record.stream, stream_id);
+                    ingest_.set_route(session, stream_id);
+                    route_name.assign(record.stream.data(), record.stream.size());
+                }
+                std::string message(record.message);
+                redactor_.redact(message.data(), message.size());
+                ingest_.submit(session, std::move(message), record.timestamp);
+                ++applied;
+            }
+            relay_inbound_records_.fetch_add(applied, std::memory_order_relaxed);
+            if (offset != records.size()) {
+                std::cerr << "[lc][warn] Relay " << identity << " sent a truncated batch" << std::endl;
+                break;
+            }
+            std::lock_guard<std::mutex> lock(relay_mutex_);
+            std::uint64_t &last = relay_sequences_[identity];
+            last = std::max(last, frame.sequence);
+        }
+
+        char ack[relay_codec::kAckBytes];
+        relay_codec::encode_u64(frame.sequence, ack);
+        send_all(client_fd, ack, sizeof(ack));
+    }
+    ingest_.close_session(session);
 }
 
-void Server::handle_query_client(int client_fd) {
+Server::SessionAction Server::handle_query_client(int client_fd) {
     ActiveClientGuard guard(active_query_clients_);
 
     const char banner[] =
         "LogCrafter C++ MVP6 query service.\n"
-        "Commands: HELP, COUNT, STATS, QUERY keyword=<text> keywords=a,b operator=AND|OR "
-        "regex=<pattern> time_from=<unix> time_to=<unix>.\n";
+        "Commands: HELP, COUNT, STATS, EXPORT from=<unix> to=<unix>, "
+        "ROLLUP resolution=second|minute from=<unix> to=<unix> by=level|source, ALERTS, "
+        "FETCH from_seq=<n> max=<k> wait_ms=<t>, PREPARE <name> <query>, EXECUTE <name> time_from= time_to= limit=, "
+        "QUERY keyword=<text> keywords=a,b operator=AND|OR "
+        "regex=<pattern> time_from=<unix> time_to=<unix> level=<name> stream=a,b limit=<n> scope=local|cluster "
+        "before=<n> after=<n> compress=none|deflate format=text|binary|ndjson.\n";
     send_all(client_fd, banner, sizeof(banner) - 1);
 
     char buffer[kQueryBufferSize];
     bool truncated = false;
     bool connection_closed = false;
-    ssize_t length = recv_line(client_fd, buffer, sizeof(buffer), truncated, connection_closed);
-    if (length < 0) {
-        std::perror("recv");
-        return;
-    }
-    if ((length == 0 && connection_closed) || buffer[0] == '\0') {
-        return;
+    std::string line;
+    const auto read_line = [&]() {
+        const ssize_t length = recv_line(client_fd, buffer, sizeof(buffer), truncated, connection_closed);
+        if (length < 0) {
+            std::perror("recv");
+            return false;
+        }
+        if ((length == 0 && connection_closed) || buffer[0] == '\0') {
+            return false;
+        }
+        line.assign(buffer, static_cast<std::size_t>(length));
+        trim_trailing(line);
+        return true;
+    };
+    if (!read_line()) {
+        return SessionAction::Close;
     }
 
-    std::string line(buffer, static_cast<std::size_t>(length));
-    trim_trailing(line);
+    // A leading COMPRESS line sets the encoding for query responses on this connection.
+    QueryRequest::Compression session_compression = QueryRequest::Compression::None;
+    if (line.rfind("COMPRESS ", 0) == 0) {
+        std::string error;
+        if (!parse_compression(std::string_view(line).substr(9), session_compression, error)) {
+            send_error(client_fd, "ERROR: " + error);
+            return SessionAction::Close;
+        }
+        if (session_compression == QueryRequest::Compression::Deflate && !CompressedResponseWriter::available()) {
+            send_error(client_fd, "ERROR: This build cannot compress responses.");
+            return SessionAction::Close;
+        }
+        send_all(client_fd, session_compression == QueryRequest::Compression::Deflate ? "COMPRESS: deflate\n"
+                                                                                      : "COMPRESS: none\n");
+        if (!read_line()) {
+            return SessionAction::Close;
+        }
+    }
 
+    if (line == "PEER" && !connection_closed) {
+        // Another node's federation client: answer QUERY lines on this connection until it closes.
+        send_all(client_fd, "PEER: ready\n");
+        return SessionAction::Park;
+    }
     if (line == "HELP") {
         send_help(client_fd);
     } else if (line == "COUNT") {
@@ -536,29 +1250,83 @@ void Server::handle_query_client(int client_fd) {
     } else if (line == "STATS") {
         send_stats(client_fd);
     } else if (line.rfind("QUERY", 0) == 0) {
-        const std::string arguments = line.substr(5);
-        handle_query_command(client_fd, arguments);
+        handle_query_command(client_fd, std::string_view(line).substr(5), false, session_compression);
+    } else if (line.rfind("PREPARE", 0) == 0) {
+        handle_prepare_command(client_fd, std::string_view(line).substr(7));
+    } else if (line.rfind("EXECUTE", 0) == 0) {
+        handle_execute_command(client_fd, std::string_view(line).substr(7), session_compression);
+    } else if (line.rfind("EXPORT", 0) == 0) {
+        handle_export_command(client_fd, std::string_view(line).substr(6));
+    } else if (line == "ALERTS") {
+        send_alerts(client_fd);
+    } else if (line.rfind("ROLLUP", 0) == 0) {
+        handle_rollup_command(client_fd, std::string_view(line).substr(6));
+    } else if (line.rfind("FETCH", 0) == 0) {
+        // A consumer keeps its connection and sends the next FETCH on it.
+        const SessionAction action = handle_fetch_command(client_fd, std::string_view(line).substr(5));
+        return connection_closed && action == SessionAction::Park ? SessionAction::Close : action;
     } else {
         send_error(client_fd, "ERROR: Unknown command. Use HELP for usage.");
     }
+    return SessionAction::Close;
+}
+
+Server::SessionAction Server::serve_peer_request(int client_fd) {
+    char buffer[kQueryBufferSize];
+    bool truncated = false;
+    bool connection_closed = false;
+    const ssize_t length = recv_line(client_fd, buffer, sizeof(buffer), truncated, connection_closed);
+    if (length < 0 || (length == 0 && connection_closed)) {
+        return SessionAction::Close;
+    }
+
+    std::string line(buffer, static_cast<std::size_t>(length));
+    trim_trailing(line);
+    SessionAction action = SessionAction::Park;
+    if (line.rfind("QUERY", 0) == 0) {
+        handle_query_command(client_fd, std::string_view(line).substr(5), true, QueryRequest::Compression::None);
+    } else if (line.rfind("FETCH", 0) == 0) {
+        action = handle_fetch_command(client_fd, std::string_view(line).substr(5));
+    } else if (!line.empty()) {
+        send_error(client_fd, "ERROR: Parked sessions accept QUERY and FETCH only.");
+    }
+    if (action == SessionAction::Park && (connection_closed || !running_.load(std::memory_order_acquire))) {
+        return SessionAction::Close;
+    }
+    return action;
 }
 
 void Server::send_help(int client_fd) const {
     const char help[] =
         "HELP - show this text\n"
-        "COUNT - number of logs currently buffered\n"
-        "STATS - totals, persistence counters, and active client counts\n"
+        "COUNT - number of logs currently buffered across all streams\n"
+        "COMPRESS none|deflate - as the first line, sets the default encoding of QUERY responses\n"
+        "EXPORT from=<unix> to=<unix> [stream=<name>] - persisted lines in that range, as stored on disk\n"
+        "ROLLUP [resolution=second|minute] [from=<unix>] [to=<unix>] [by=level|source] [source=<name>] "
+        "[level=<name>] - entry counts per bucket, kept for an hour of seconds and a day of minutes\n"
+        "ALERTS - each --alert-rules rule with its current window count, threshold, and times fired\n"
+        "FETCH from_seq=<n> [max=<k>] [wait_ms=<t>] - up to k (default 1000, at most 10000) replication log "
+        "entries from sequence n as format=binary records; waits up to t ms (at most 60000) for new ones, and the "
+        "connection stays open for the next FETCH\n"
+        "PREPARE <name> <QUERY arguments> - parses the query once and keeps it under name (letters, digits, "
+        "'_' and '-') for every connection; preparing a name again replaces it\n"
+        "EXECUTE <name> [time_from=<unix>] [time_to=<unix>] [limit=<n>] - runs a prepared query as QUERY would, "
+        "with those parameters replaced\n"
+        "STATS - totals, persistence counters, active client counts, and per-stream counters\n"
         "QUERY keyword=<text> keywords=a,b operator=AND|OR regex=<pattern> "
-        "time_from=<unix> time_to=<unix>\n";
+        "time_from=<unix> time_to=<unix> level=<name> stream=a,b limit=<n> scope=local|cluster "
+        "before=<n> after=<n> compress=none|deflate format=text|binary|ndjson\n"
+        "  level=unknown|debug|info|warning|error keeps lines classified at exactly that level\n"
+        "  before=<n> after=<n> (1-100) add neighbouring lines of the stream around each match, marked \"]- \"\n"
+        "  limit=<n> keeps the newest n matches in time order; scope=cluster also asks every --peer\n"
+        "  compress=deflate answers with a COMPRESSED: deflate line followed by a zlib stream\n"
+        "  format=binary|ndjson returns epoch-nanosecond records with sequence, level, and stream (local only)\n";
     send_all(client_fd, help, sizeof(help) - 1);
 }
 
 std::string Server::make_irc_stats_snapshot() const {
-    LogBufferStats stats = log_buffer_.stats();
-    PersistenceStats persistence_stats{0, 0, 0};
-    if (persistence_enabled_) {
-        persistence_stats = persistence_.stats();
-    }
+    const LogBufferStats stats = streams_.buffer_totals();
+    const PersistenceStats persistence_stats = streams_.persistence_totals();
     std::ostringstream oss;
     oss << "logs=" << stats.current_size << '/' << stats.total_logs
         << " dropped=" << stats.dropped_logs
@@ -572,52 +1340,296 @@ std::string Server::make_irc_stats_snapshot() const {
 }
 
 void Server::send_count(int client_fd) const {
-    LogBufferStats stats = log_buffer_.stats();
+    const LogBufferStats stats = streams_.buffer_totals();
     std::ostringstream oss;
     oss << "COUNT: " << stats.current_size << "\n";
     send_all(client_fd, oss.str());
 }
 
 void Server::send_stats(int client_fd) const {
-    LogBufferStats stats = log_buffer_.stats();
-    PersistenceStats persistence_stats{0, 0, 0};
-    if (persistence_enabled_) {
-        persistence_stats = persistence_.stats();
-    }
-    std::ostringstream oss;
-    oss << "STATS: Total=" << stats.total_logs
+    const LogBufferStats stats = streams_.buffer_totals();
+    const PersistenceStats persistence_stats = streams_.persistence_totals();
+    StatsText text;
+    text << "STATS: Total=" << stats.total_logs
         << ", Dropped=" << stats.dropped_logs
         << ", Current=" << stats.current_size
-        << ", Persisted=" << persistence_stats.persisted_logs
+        << ", Reordered=" << stats.reordered_logs;
+    if (config_.level_shares != LevelShares{}) {
+        text << ", RingSevere=" << stats.ring_sizes[0]
+            << ", RingInfo=" << stats.ring_sizes[1]
+            << ", RingDebug=" << stats.ring_sizes[2];
+    }
+    text << ", Persisted=" << persistence_stats.persisted_logs
         << ", PersistFailed=" << persistence_stats.failed_logs
         << ", ActiveLog=" << active_log_clients_.load(std::memory_order_relaxed)
         << ", ActiveQuery=" << active_query_clients_.load(std::memory_order_relaxed)
         << ", ActiveIRC="
         << (irc_enabled_ && irc_server_ ? irc_server_->active_clients() : static_cast<std::size_t>(0));
+    const IngestStats ingest = ingest_.stats();
+    text << ", Backlogged=" << ingest.backlogged_sessions
+        << ", FairRounds=" << ingest.rounds
+        << ", FairWaits=" << ingest.queue_waits
+        << ", QuotaDropped=" << ingest.quota_dropped
+        << ", QuotaDeferred=" << ingest.quota_deferred
+        << ", Collapsed=" << ingest.collapsed_lines
+        << ", CollapsedRuns=" << ingest.collapsed_runs;
+    // Per stage: threads/entries processed/queued for it/hand-offs that stalled on a full queue.
+    const auto stages = pipeline_.stats();
+    text << ", Pipeline=[";
+    for (std::size_t s = 0; s < kPipelineStages; ++s) {
+        text << (s == 0 ? "" : ", ") << IngestPipeline::kStageNames[s] << '=' << stages[s].threads << '/'
+            << stages[s].processed << '/' << stages[s].queued << '/' << stages[s].stalls;
+    }
+    text << ']';
+    if (relay_enabled_) {
+        const ForwardingStats relay = forwarder_.stats();
+        text << ", Relay=" << (relay.connected ? "up" : "down")
+            << ", RelaySpooled=" << relay.spooled_records
+            << ", RelayAcked=" << relay.acked_records
+            << ", RelayBatches=" << relay.acked_batches
+            << ", RelayBacklogBytes=" << relay.backlog_bytes
+            << ", RelayWireBytes=" << relay.wire_bytes
+            << ", RelayReconnects=" << relay.reconnects
+            << ", RelayFailed=" << relay.spool_failures;
+    }
+    text << ", RelayInbound=" << relay_inbound_records_.load(std::memory_order_relaxed)
+        << ", RelayDuplicates=" << relay_duplicate_batches_.load(std::memory_order_relaxed);
+    {
+        // Ratio is raw/wire bytes over every compressed response; CPU is deflate time per response.
+        const unsigned long compressed = compressed_queries_.load(std::memory_order_relaxed);
+        const unsigned long long raw_bytes = compress_raw_bytes_.load(std::memory_order_relaxed);
+        const unsigned long long wire_bytes = compress_wire_bytes_.load(std::memory_order_relaxed);
+        char ratio[32];
+        std::snprintf(ratio, sizeof(ratio), "%.2f",
+                      wire_bytes > 0 ? static_cast<double>(raw_bytes) / static_cast<double>(wire_bytes) : 0.0);
+        text << ", CompressedQueries=" << compressed
+            << ", CompressRawBytes=" << raw_bytes
+            << ", CompressWireBytes=" << wire_bytes
+            << ", CompressRatio=" << ratio
+            << ", CompressCpuUsPerQuery="
+            << (compressed > 0 ? compress_cpu_micros_.load(std::memory_order_relaxed) / compressed : 0);
+    }
+    text << ", Exports=" << exports_.load(std::memory_order_relaxed)
+        << ", ExportBytes=" << export_bytes_.load(std::memory_order_relaxed);
+    const PreparedQueryStats prepared = prepared_.stats();
+    const RegexCacheStats regexes = RegexCache::instance().stats();
+    text << ", Prepared=" << prepared.plans
+        << ", PreparedExecutes=" << prepared.executes
+        << ", ParseUsSaved=" << prepared.parse_micros_saved
+        << ", RegexCacheEntries=" << regexes.entries
+        << ", RegexCacheHits=" << regexes.hits
+        << ", RegexCacheMisses=" << regexes.misses
+        << ", RegexCompileUsSaved=" << regexes.compile_micros_saved;
+    const RollupStats rollups = rollups_.stats();
+    text << ", RollupSources=" << rollups.sources
+        << ", RollupLate=" << rollups.late_entries
+        << ", RollupQueries=" << rollups.queries
+        << ", RollupSaves=" << rollups.saves
+        << ", RollupSaveFailures=" << rollups.save_failures;
+    const AlertStats alerts = alerts_.stats();
+    text << ", AlertRules=" << alerts.rules
+        << ", AlertMatches=" << alerts.matched
+        << ", AlertsFired=" << alerts.fired;
+    if (redactor_.enabled()) {
+        // Per rule: matches masked.
+        const RedactionStats redaction = redactor_.stats();
+        text << ", RedactedLines=" << redaction.lines
+            << ", Redactions=" << redaction.matches
+            << ", RedactRules=" << redaction.rules << " [";
+        for (std::size_t i = 0; i < redaction.per_rule.size(); ++i) {
+            text << (i == 0 ? "" : ", ") << redaction.per_rule[i].first << '=' << redaction.per_rule[i].second;
+        }
+        text << ']';
+    }
+    if (shedder_.enabled()) {
+        const SheddingStats shedding = shedder_.stats();
+        text << ", ShedStage=" << shedding.stage << '/' << shedding.stages
+            << ", ShedUnknown=" << shedding.shed[static_cast<std::size_t>(result_codec::Level::Unknown)]
+            << ", ShedDebug=" << shedding.shed[static_cast<std::size_t>(result_codec::Level::Debug)]
+            << ", ShedInfo=" << shedding.shed[static_cast<std::size_t>(result_codec::Level::Info)]
+            << ", ShedWarning=" << shedding.shed[static_cast<std::size_t>(result_codec::Level::Warning)];
+    }
+    if (replication_enabled_) {
+        // Per replica: last acknowledged sequence/entries behind.
+        const ReplicationStats replication = replication_.stats();
+        text << ", ReplicationHead=" << replication.head
+            << ", ReplicationOldest=" << replication.oldest
+            << ", ReplicationFailed=" << replication.log_failures
+            << ", Replicas=" << replication.replicas.size() << " [";
+        for (std::size_t i = 0; i < replication.replicas.size(); ++i) {
+            const ReplicaStatus &replica = replication.replicas[i];
+            text << (i == 0 ? "" : ", ") << replica.name << '=' << replica.acked << '/'
+                << (replication.head > replica.acked ? replication.head - replica.acked : 0);
+        }
+        text << ']';
+        text << ", Fetches=" << fetches_.load(std::memory_order_relaxed)
+            << ", FetchWaiting=" << fetch_waiter_count_.load(std::memory_order_relaxed)
+            << ", FetchedMemory=" << replication.fetched_memory
+            << ", FetchedDisk=" << replication.fetched_disk;
+    }
+    if (replica_enabled_) {
+        const ReplicaStats replica = replica_.stats();
+        text << ", Replica=" << (replica.connected ? "up" : "down")
+            << ", ReplicaSeq=" << replica.applied_sequence
+            << ", ReplicaLag="
+            << (replica.primary_head > replica.applied_sequence ? replica.primary_head - replica.applied_sequence : 0)
+            << ", ReplicaApplied=" << replica.applied_records
+            << ", ReplicaGaps=" << replica.gaps
+            << ", ReplicaReconnects=" << replica.reconnects;
+    }
+    if (federation_.peer_count() > 0) {
+        const FederationStats federation = federation_.stats();
+        text << ", Peers=" << federation_.peer_count()
+            << ", PeerQueries=" << federation.requests
+            << ", PeerTimeouts=" << federation.timeouts
+            << ", PeerFailures=" << federation.failures
+            << ", PeerReused=" << federation.reused;
+    }
+    if (!ingest.top_sources.empty()) {
+        text << ", TopSources=[" << ingest.top_sources << ']';
+    }
+    // Per stream: current/total/dropped/persisted.
+    const std::size_t stream_count = streams_.count();
+    text << ", Streams=" << stream_count << " [";
+    for (std::size_t i = 0; i < stream_count; ++i) {
+        const StreamRegistry::Stream &stream = streams_.at(i);
+        const LogBufferStats stream_stats = stream.buffer.stats();
+        text << (i == 0 ? "" : ", ") << stream.name << '=' << stream_stats.current_size << '/'
+            << stream_stats.total_logs << '/' << stream_stats.dropped_logs << '/'
+            << (stream.persistent ? stream.persistence.stats().persisted_logs : 0UL);
+    }
+    text << ']';
     if (irc_enabled_ && irc_server_) {
-        const auto channels = irc_server_->channel_stats();
-        oss << ", IRCChannels=" << channels.size();
-        if (!channels.empty()) {
-            oss << " [";
-            const std::size_t preview = std::min<std::size_t>(channels.size(), 3);
-            for (std::size_t i = 0; i < preview; ++i) {
-                if (i > 0) {
-                    oss << ", ";
-                }
-                oss << channels[i].name << '=' << channels[i].members;
-            }
-            if (channels.size() > preview) {
-                oss << ", ...";
-            }
-            oss << ']';
+        const std::string preview = irc_server_->channel_preview();
+        text << ", IRCChannels=" << irc_server_->channel_count();
+        if (!preview.empty()) {
+            text << ' ' << preview;
         }
     }
-    oss << "\n";
-    send_all(client_fd, oss.str());
+    text << "\n";
+    send_all(client_fd, text.str());
+}
+
+void Server::handle_export_command(int client_fd, std::string_view arguments) const {
+    ExportRequest request;
+    std::string error;
+    if (!parse_export_arguments(arguments, request, error)) {
+        send_error(client_fd, error);
+        return;
+    }
+    StreamRegistry::StreamId id = StreamRegistry::kDefaultStream;
+    if (!request.stream.empty() && !streams_.find(request.stream, id)) {
+        send_error(client_fd, "ERROR: Unknown stream '" + request.stream + "'.");
+        return;
+    }
+    const StreamRegistry::Stream &stream = streams_.at(id);
+    if (!persistence_enabled_ || !stream.persistent) {
+        send_error(client_fd, "ERROR: EXPORT reads persisted segments; start the server with --enable-persistence.");
+        return;
+    }
+
+    // Whole lines go out as stored, through sendfile(): no scan and no formatting here.
+    ExportPlan plan;
+    if (stream.persistence.plan_export(request.from, request.to, plan) != 0) {
+        send_error(client_fd, "ERROR: Export failed to read the persistence directory.");
+        return;
+    }
+    const std::uint64_t total = plan.total_bytes();
+    if (!net_io::send_text(client_fd, "EXPORT: " + std::to_string(total) + "\n")) {
+        return;
+    }
+    std::uint64_t sent = 0;
+    for (const ExportSlice &slice : plan.slices) {
+        if (!net_io::send_file(client_fd, slice.fd, slice.offset, slice.length)) {
+            break;
+        }
+        sent += slice.length;
+    }
+    exports_.fetch_add(1, std::memory_order_relaxed);
+    export_bytes_.fetch_add(sent, std::memory_order_relaxed);
+}
+
+void Server::send_alerts(int client_fd) const { send_all(client_fd, alerts_.describe()); }
+
+Server::SessionAction Server::handle_fetch_command(int client_fd, std::string_view arguments) {
+    FetchRequest request;
+    std::string error;
+    if (!parse_fetch_arguments(arguments, request, error)) {
+        send_error(client_fd, error);
+        return SessionAction::Close;
+    }
+    if (!replication_enabled_) {
+        send_error(client_fd, "ERROR: FETCH reads the replication log; start the server with --replication-log.");
+        return SessionAction::Close;
+    }
+    fetches_.fetch_add(1, std::memory_order_relaxed);
+    return send_fetch_batch(client_fd, request, true);
+}
+
+Server::SessionAction Server::send_fetch_batch(int client_fd, const FetchRequest &request, bool may_wait) {
+    FetchBatch batch{};
+    if (!replication_.fetch(request.from, request.max, batch)) {
+        send_error(client_fd, "ERROR: FETCH failed to read the replication log.");
+        return SessionAction::Close;
+    }
+    if (batch.records == 0 && may_wait && request.wait_ms > 0) {
+        // The accept loop holds the connection rather than a worker, so idle consumers cost
+        // no threads; it hands the request back once the log passes `from` or time is up.
+        std::lock_guard<std::mutex> lock(peer_sessions_mutex_);
+        if (running_.load(std::memory_order_acquire) && fetch_waiters_.size() < kMaxFetchWaiters) {
+            FetchRequest waiting = request;
+            waiting.from = batch.next;
+            fetch_waiters_.push_back(FetchWaiter{
+                client_fd, waiting, std::chrono::steady_clock::now() + std::chrono::milliseconds(request.wait_ms)});
+            fetch_waiter_count_.store(fetch_waiters_.size(), std::memory_order_relaxed);
+            wake_accept_loop();
+            return SessionAction::Detached;
+        }
+        // Too many consumers waiting: answer empty now and let this one poll again.
+    }
+
+    // "FETCH: <n> next=<seq> head=<seq>" and n records in the format=binary layout, numbered
+    // from the batch's first sequence.
+    char header[96];
+    const int header_length = std::snprintf(header, sizeof(header), "FETCH: %zu next=%llu head=%llu\n", batch.records,
+                                            static_cast<unsigned long long>(batch.next),
+                                            static_cast<unsigned long long>(batch.head));
+    std::string headers(batch.records * result_codec::kRecordHeaderBytes, '\0');
+    ResponseWriter writer(client_fd);
+    if (header_length > 0) {
+        writer.append(std::string_view(header, static_cast<std::size_t>(header_length)));
+    }
+    std::size_t offset = 0;
+    relay_codec::Record entry{};
+    for (std::size_t i = 0; i < batch.records && relay_codec::next_record(batch.payload, offset, entry); ++i) {
+        const result_codec::Record record{static_cast<std::int64_t>(entry.timestamp) * 1000000000LL,
+                                          batch.first + i, result_codec::classify_level(entry.message),
+                                          entry.stream, entry.message, false};
+        char *slot = &headers[i * result_codec::kRecordHeaderBytes];
+        result_codec::encode_record_header(record, slot);
+        writer.append(std::string_view(slot, result_codec::kRecordHeaderBytes));
+        writer.append(record.stream.substr(0, 255));
+        writer.append(record.message);
+    }
+    return writer.finish() ? SessionAction::Park : SessionAction::Close;
+}
+
+void Server::handle_rollup_command(int client_fd, std::string_view arguments) const {
+    RollupRequest request;
+    std::string error;
+    if (!parse_rollup_arguments(arguments, request, error)) {
+        send_error(client_fd, error);
+        return;
+    }
+    std::string response;
+    rollups_.answer(request, response);
+    send_all(client_fd, response);
 }
 
-void Server::handle_query_command(int client_fd, const std::string &arguments) const {
-    QueryRequest request;
+void Server::handle_query_command(int client_fd, std::string_view arguments, bool from_peer,
+                                  QueryRequest::Compression session_compression) const {
+    QueryArenaScope arena;
+    QueryRequest request(arena.resource());
     std::string error;
     if (!parse_query_arguments(arguments, request, error)) {
         if (error.empty()) {
@@ -628,9 +1640,94 @@ void Server::handle_query_command(int client_fd, const std::string &arguments) c
         send_error(client_fd, error);
         return;
     }
+    answer_query(client_fd, request, arguments, from_peer, session_compression, arena.resource());
+}
+
+void Server::handle_prepare_command(int client_fd, std::string_view arguments) {
+    const std::size_t start = arguments.find_first_not_of(" \t");
+    if (start == std::string_view::npos) {
+        send_error(client_fd, "ERROR: PREPARE requires a name and QUERY arguments.");
+        return;
+    }
+    const std::size_t end = std::min(arguments.find_first_of(" \t", start), arguments.size());
+    const std::string_view name = arguments.substr(start, end - start);
+    std::string error;
+    if (!prepared_.prepare(name, arguments.substr(end), error)) {
+        send_error(client_fd, error);
+        return;
+    }
+    send_all(client_fd, "PREPARED: " + std::string(name) + "\n");
+}
+
+void Server::handle_execute_command(int client_fd, std::string_view arguments,
+                                    QueryRequest::Compression session_compression) {
+    const std::size_t start = arguments.find_first_not_of(" \t");
+    if (start == std::string_view::npos) {
+        send_error(client_fd, "ERROR: EXECUTE requires the name of a prepared query.");
+        return;
+    }
+    const std::size_t end = std::min(arguments.find_first_of(" \t", start), arguments.size());
+    const std::string_view name = arguments.substr(start, end - start);
+    const std::string_view overrides = arguments.substr(end);
+    const std::shared_ptr<const PreparedQueries::Plan> plan = prepared_.find(name);
+    if (!plan) {
+        send_error(client_fd, "ERROR: Unknown prepared query '" + std::string(name) + "'.");
+        return;
+    }
+
+    // Copy-assigning keeps the arena allocator; the regex is shared, not recompiled.
+    QueryArenaScope arena;
+    QueryRequest request(arena.resource());
+    request = plan->request;
+    std::string error;
+    if (!parse_execute_overrides(overrides, request, error)) {
+        send_error(client_fd, error);
+        return;
+    }
+    if (request.scope != QueryRequest::Scope::Cluster || overrides.find_first_not_of(" \t") == std::string_view::npos) {
+        answer_query(client_fd, request, plan->arguments, false, session_compression, arena.resource());
+        return;
+    }
+
+    // Peers get the prepared arguments with the overridden parameters swapped for the new ones.
+    std::pmr::string peer_arguments(arena.resource());
+    std::size_t position = 0;
+    const std::string_view prepared = plan->arguments;
+    while ((position = prepared.find_first_not_of(" \t", position)) != std::string_view::npos) {
+        const std::size_t token_end = std::min(prepared.find_first_of(" \t", position), prepared.size());
+        const std::string_view token = prepared.substr(position, token_end - position);
+        const std::string_view key = token.substr(0, token.find('=') + 1);
+        if (key != "time_from=" && key != "time_to=" && key != "limit=") {
+            peer_arguments.push_back(' ');
+            peer_arguments.append(token.data(), token.size());
+        }
+        position = token_end;
+    }
+    peer_arguments.append(overrides.data(), overrides.size());
+    answer_query(client_fd, request, peer_arguments, false, session_compression, arena.resource());
+}
+
+void Server::answer_query(int client_fd, QueryRequest &request, std::string_view arguments, bool from_peer,
+                          QueryRequest::Compression session_compression, std::pmr::memory_resource *arena) const {
+    if (from_peer) {
+        // A peer already fans out; answering from this node only keeps the fan-out one level deep.
+        request.scope = QueryRequest::Scope::Local;
+        // The federation client parses plain replies only.
+        request.compression = QueryRequest::Compression::None;
+    } else if (!request.has_compression) {
+        request.compression = session_compression;
+    }
+    if (request.compression == QueryRequest::Compression::Deflate && !CompressedResponseWriter::available()) {
+        send_error(client_fd, "ERROR: This build cannot compress responses.");
+        return;
+    }
+    if (request.format != QueryRequest::Format::Text && request.scope == QueryRequest::Scope::Cluster) {
+        send_error(client_fd, "ERROR: format=binary and format=ndjson answer scope=local queries only.");
+        return;
+    }
 
     try {
-        send_query_response(client_fd, request);
+        send_query_response(client_fd, request, arguments, arena);
     } catch (const std::exception &ex) {
         std::string message = "ERROR: Query execution failed.";
         if (const char *what = ex.what()) {
@@ -641,19 +1738,246 @@ void Server::handle_query_command(int client_fd, const std::string &arguments) c
     }
 }
 
-void Server::send_query_response(int client_fd, const QueryRequest &request) const {
-    std::vector<std::string> results = log_buffer_.execute_query(request);
+QueryResults Server::collect_results(const QueryRequest &request,
+                                     const std::pmr::vector<StreamRegistry::StreamId> &targets,
+                                     std::pmr::memory_resource *arena) const {
+    // Results are grouped per stream in the order the streams were named (creation order when
+    // no stream= is given), each group in that stream's time order.
+    QueryResults results = streams_.at(targets.front()).buffer.execute_query(request, arena);
+    for (std::size_t i = 1; i < targets.size(); ++i) {
+        QueryResults part = streams_.at(targets[i]).buffer.execute_query(request, arena);
+        results.insert(results.end(), std::make_move_iterator(part.begin()), std::make_move_iterator(part.end()));
+    }
+    return results;
+}
+
+void Server::send_query_response(int client_fd, const QueryRequest &request, std::string_view arguments,
+                                 std::pmr::memory_resource *arena) const {
+    // Resolve every requested stream before answering so a typo fails the whole query.
+    std::pmr::vector<StreamRegistry::StreamId> targets(arena);
+    if (request.streams.empty()) {
+        const std::size_t stream_count = streams_.count();
+        for (std::size_t i = 0; i < stream_count; ++i) {
+            targets.push_back(i);
+        }
+    } else {
+        for (const std::pmr::string &name : request.streams) {
+            StreamRegistry::StreamId id = StreamRegistry::kDefaultStream;
+            if (!streams_.find(name, id)) {
+                send_error(client_fd, "ERROR: Unknown stream '" + std::string(name) + "'.");
+                return;
+            }
+            if (std::find(targets.begin(), targets.end(), id) == targets.end()) {
+                targets.push_back(id);
+            }
+        }
+    }
+
+    if (request.scope == QueryRequest::Scope::Cluster) {
+        send_cluster_response(client_fd, request, arguments, targets, arena);
+        return;
+    }
+    if (request.format != QueryRequest::Format::Text) {
+        send_record_response(client_fd, request, targets, arena);
+        return;
+    }
+
+    const QueryResults results = collect_results(request, targets, arena);
+    // The header rides in the first batch so small responses leave in a single segment.
+    char header[48];
+    if (request.limit == 0) {
+        const int header_length = std::snprintf(header, sizeof(header), "FOUND: %zu\n", results.size());
+        write_response(client_fd, request.compression, [&](auto &writer) {
+            if (header_length > 0) {
+                writer.append(std::string_view(header, static_cast<std::size_t>(header_length)));
+            }
+            send_query_results(writer, results);
+        });
+        return;
+    }
+
+    // With a limit the per-stream groups are merged so "newest n" holds across streams.
+    std::vector<std::vector<std::string_view>> sources(1);
+    sources.front().assign(results.begin(), results.end());
+    std::vector<MergedLine> merged;
+    merge_newest(sources, request.limit, merged);
+    const int header_length = std::snprintf(header, sizeof(header), "FOUND: %zu\n", merged.size());
+    write_response(client_fd, request.compression, [&](auto &writer) {
+        if (header_length > 0) {
+            writer.append(std::string_view(header, static_cast<std::size_t>(header_length)));
+        }
+        for (const MergedLine &entry : merged) {
+            writer.append_line(entry.line);
+        }
+    });
+}
+
+void Server::send_cluster_response(int client_fd, const QueryRequest &request, std::string_view arguments,
+                                   const std::pmr::vector<StreamRegistry::StreamId> &targets,
+                                   std::pmr::memory_resource *arena) const {
+    // Peers get the same filters and limit; scope= and compress= are dropped.
+    std::string peer_request = "QUERY";
+    std::size_t position = 0;
+    while (position < arguments.size()) {
+        const std::size_t start = arguments.find_first_not_of(" \t", position);
+        if (start == std::string_view::npos) {
+            break;
+        }
+        std::size_t end = arguments.find_first_of(" \t", start);
+        if (end == std::string_view::npos) {
+            end = arguments.size();
+        }
+        const std::string_view token = arguments.substr(start, end - start);
+        if (token.rfind("scope=", 0) != 0 && token.rfind("compress=", 0) != 0) {
+            peer_request.push_back(' ');
+            peer_request.append(token.data(), token.size());
+        }
+        position = end;
+    }
+
+    // The local query runs while the peers work on theirs.
+    QueryResults local(arena);
+    std::vector<PeerReply> replies;
+    federation_.scatter(peer_request, [&]() { local = collect_results(request, targets, arena); }, replies);
+
+    std::vector<std::vector<std::string_view>> sources(1 + replies.size());
+    sources.front().assign(local.begin(), local.end());
+    std::size_t answered = 1;
+    std::string failed;
+    for (std::size_t i = 0; i < replies.size(); ++i) {
+        const PeerReply &reply = replies[i];
+        if (reply.status == PeerReply::Status::Answered) {
+            sources[i + 1] = reply.lines;
+            ++answered;
+            continue;
+        }
+        failed += failed.empty() ? " failed=" : ",";
+        failed += federation_.label(i);
+        failed += reply.status == PeerReply::Status::TimedOut      ? "(timeout)"
+                  : reply.status == PeerReply::Status::Unreachable ? "(unreachable)"
+                                                                   : "(error)";
+    }
+
+    std::vector<MergedLine> merged;
+    merge_newest(sources, request.limit, merged);
 
-    std::ostringstream header;
-    header << "FOUND: " << results.size() << "\n";
-    send_all(client_fd, header.str());
-    send_query_results(client_fd, results);
+    std::ostringstream oss;
+    oss << "CLUSTER: nodes=" << sources.size() << " answered=" << answered
+        << " partial=" << (answered == sources.size() ? "no" : "yes") << failed << "\n"
+        << "FOUND: " << merged.size() << "\n";
+    const std::string header = oss.str();
+    // The writer references its fragments, so the labels live until finish().
+    std::vector<std::string> labels(1, "{local} ");
+    for (std::size_t i = 0; i < replies.size(); ++i) {
+        labels.push_back("{" + federation_.label(i) + "} ");
+    }
+    write_response(client_fd, request.compression, [&](auto &writer) {
+        writer.append(header);
+        for (const MergedLine &entry : merged) {
+            writer.append(labels[entry.source]);
+            writer.append_line(entry.line);
+        }
+    });
 }
 
-void Server::send_query_results(int client_fd, const std::vector<std::string> &results) const {
-    for (const std::string &line : results) {
-        send_all(client_fd, line);
-        send_all(client_fd, "\n", 1);
+void Server::send_record_response(int client_fd, const QueryRequest &request,
+                                  const std::pmr::vector<StreamRegistry::StreamId> &targets,
+                                  std::pmr::memory_resource *arena) const {
+    struct Match {
+        const QueryRecord *record;
+        const std::string *stream;
+    };
+
+    std::pmr::vector<QueryRecords> parts(arena);
+    parts.reserve(targets.size());
+    std::size_t total = 0;
+    for (const StreamRegistry::StreamId id : targets) {
+        parts.push_back(streams_.at(id).buffer.execute_query_records(request, arena));
+        total += parts.back().size();
+    }
+    std::pmr::vector<Match> matches(arena);
+    matches.reserve(total);
+    for (std::size_t i = 0; i < parts.size(); ++i) {
+        for (const QueryRecord &record : parts[i]) {
+            matches.push_back(Match{&record, &streams_.at(targets[i]).name});
+        }
+    }
+    // Like the text form, a limit merges the streams by time and keeps the newest matches.
+    if (request.limit > 0) {
+        std::stable_sort(matches.begin(), matches.end(), [](const Match &lhs, const Match &rhs) {
+            return lhs.record->timestamp < rhs.record->timestamp;
+        });
+        if (matches.size() > request.limit) {
+            matches.erase(matches.begin(), matches.end() - static_cast<std::ptrdiff_t>(request.limit));
+        }
+    }
+
+    const auto to_record = [](const Match &match) {
+        const std::string_view message = match.record->message;
+        return result_codec::Record{static_cast<std::int64_t>(match.record->timestamp) * 1000000000LL,
+                                    match.record->sequence, result_codec::classify_level(message), *match.stream,
+                                    message, match.record->context};
+    };
+    const bool binary = request.format == QueryRequest::Format::Binary;
+    const std::string header = std::string(binary ? result_codec::kBinaryPrefix : result_codec::kNdjsonPrefix) +
+                               std::to_string(matches.size()) + "\n";
+    if (binary) {
+        // Fixed record headers are packed into one block sized up front; streams and messages
+        // are sent from where they already are.
+        std::pmr::string headers(matches.size() * result_codec::kRecordHeaderBytes, '\0', arena);
+        write_response(client_fd, request.compression, [&](auto &writer) {
+            writer.append(header);
+            for (std::size_t i = 0; i < matches.size(); ++i) {
+                const result_codec::Record record = to_record(matches[i]);
+                char *slot = &headers[i * result_codec::kRecordHeaderBytes];
+                result_codec::encode_record_header(record, slot);
+                writer.append(std::string_view(slot, result_codec::kRecordHeaderBytes));
+                writer.append(record.stream.substr(0, 255));
+                writer.append(record.message);
+            }
+        });
+        return;
+    }
+
+    std::pmr::string body(arena);
+    body.reserve(total * 96);
+    for (const Match &match : matches) {
+        result_codec::append_ndjson(body, to_record(match));
+    }
+    write_response(client_fd, request.compression, [&](auto &writer) {
+        writer.append(header);
+        writer.append(body);
+    });
+}
+
+template <typename Writer>
+void Server::send_query_results(Writer &writer, const QueryResults &results) const {
+    for (const std::pmr::string &line : results) {
+        writer.append_line(line);
+    }
+}
+
+template <typename Emit>
+void Server::write_response(int client_fd, QueryRequest::Compression compression, Emit &&emit) const {
+    if (compression == QueryRequest::Compression::None) {
+        ResponseWriter writer(client_fd);
+        emit(writer);
+        writer.finish();
+        return;
+    }
+
+    // The marker stays plain so a client can tell a compressed answer from an ERROR line;
+    // everything after it is one zlib stream that ends with the connection.
+    if (!net_io::send_text(client_fd, "COMPRESSED: deflate\n")) {
+        return;
+    }
+    CompressedResponseWriter writer(client_fd);
+    emit(writer);
+    if (writer.finish()) {
+        compressed_queries_.fetch_add(1, std::memory_order_relaxed);
+        compress_raw_bytes_.fetch_add(writer.raw_bytes(), std::memory_order_relaxed);
+        compress_wire_bytes_.fetch_add(writer.bytes_sent(), std::memory_order_relaxed);
+        compress_cpu_micros_.fetch_add(writer.cpu_micros(), std::memory_order_relaxed);
     }
 }
 
@@ -0,0 +1,116 @@
+/*
+ * Sequence: SEQ0280
+ * Track: C++
+ * MVP: Step D
+ * Change: Sample low-severity lines along the shedding ladder as the ingest backlog grows.
+ * Tests: spec_load_shedding
+ */
+#include "load_shedder.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+
+namespace logcrafter::cpp {
+
+LoadShedder::LoadShedder() : config_(), stage_(0), seen_(), shed_() {
+    for (std::size_t level = 0; level < result_codec::kLevelCount; ++level) {
+        seen_[level].store(0, std::memory_order_relaxed);
+        shed_[level].store(0, std::memory_order_relaxed);
+    }
+}
+
+void LoadShedder::configure(const SheddingConfig &config) {
+    config_ = config;
+    config_.high_water = std::max<std::size_t>(config_.high_water, 1);
+    stage_.store(0, std::memory_order_relaxed);
+    for (std::size_t level = 0; level < result_codec::kLevelCount; ++level) {
+        seen_[level].store(0, std::memory_order_relaxed);
+        shed_[level].store(0, std::memory_order_relaxed);
+    }
+}
+
+bool LoadShedder::shed(std::string_view line, std::size_t backlog) {
+    const std::size_t steps = config_.ladder.size();
+    if (steps == 0) {
+        return false;
+    }
+    const std::size_t stage = std::min(steps, backlog * steps / config_.high_water);
+    if (stage_.load(std::memory_order_relaxed) != stage) {
+        stage_.store(stage, std::memory_order_relaxed);
+    }
+    if (stage == 0) {
+        return false;
+    }
+
+    // Only classified while shedding; the strictest active rung for the level wins.
+    const result_codec::Level level = result_codec::classify_level(line);
+    unsigned keep_one_in = 1;
+    for (std::size_t i = 0; i < stage; ++i) {
+        if (config_.ladder[i].level == level) {
+            keep_one_in = std::max(keep_one_in, config_.ladder[i].keep_one_in);
+        }
+    }
+    if (keep_one_in <= 1) {
+        return false;
+    }
+    const std::size_t index = static_cast<std::size_t>(level);
+    if (seen_[index].fetch_add(1, std::memory_order_relaxed) % keep_one_in == 0) {
+        return false;
+    }
+    shed_[index].fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+SheddingStats LoadShedder::stats() const {
+    SheddingStats result{};
+    result.stage = stage_.load(std::memory_order_relaxed);
+    result.stages = config_.ladder.size();
+    for (std::size_t level = 0; level < result_codec::kLevelCount; ++level) {
+        result.shed[level] = shed_[level].load(std::memory_order_relaxed);
+    }
+    return result;
+}
+
+bool LoadShedder::parse_ladder(std::string_view text, std::vector<ShedStep> &ladder, std::string &error) {
+    ladder.clear();
+    std::size_t start = 0;
+    while (start <= text.size()) {
+        std::size_t comma = text.find(',', start);
+        if (comma == std::string_view::npos) {
+            comma = text.size();
+        }
+        const std::string_view rung = text.substr(start, comma - start);
+        const std::size_t colon = rung.find(':');
+        const std::string_view name = rung.substr(0, colon);
+        const std::string_view ratio = colon == std::string_view::npos ? std::string_view() : rung.substr(colon + 1);
+
+        bool known = false;
+        ShedStep step{result_codec::Level::Unknown, 0};
+        for (std::uint8_t level = 0; level < result_codec::kLevelCount && !known; ++level) {
+            if (name == result_codec::level_name(static_cast<result_codec::Level>(level))) {
+                step.level = static_cast<result_codec::Level>(level);
+                known = true;
+            }
+        }
+        const auto parsed = std::from_chars(ratio.data(), ratio.data() + ratio.size(), step.keep_one_in);
+        if (!known || parsed.ec != std::errc() || parsed.ptr != ratio.data() + ratio.size() ||
+            step.keep_one_in < 2) {
+            error = "each rung is <level>:<keep one in N>, N >= 2 (got '" + std::string(rung) + "')";
+            return false;
+        }
+        if (step.level == result_codec::Level::Error) {
+            error = "error lines are never shed";
+            return false;
+        }
+        ladder.push_back(step);
+        if (ladder.size() > kMaxSteps) {
+            error = "at most " + std::to_string(kMaxSteps) + " rungs";
+            return false;
+        }
+        start = comma + 1;
+    }
+    return true;
+}
+
+} // namespace logcrafter::cpp
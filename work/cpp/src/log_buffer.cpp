@@ -1,160 +1,116 @@
 /*
- * Sequence: SEQ0052
+ * Sequence: SEQ0327
  * Track: C++
- * MVP: mvp4
- * Change: Support explicit timestamps when inserting entries so persistence replay maintains ordering.
- * Tests: smoke_cpp_mvp4_persistence
+ * MVP: Step D
+ * Change: Check the time bounds before the substring, level, and regex predicates.
+ * Tests: spec_prepared_query, spec_protocol_happy_path
  */
 #include "log_buffer.hpp"
 
 #include <algorithm>
-#include <cstdio>
-#include <cstring>
 #include <ctime>
-#include <sstream>
+#include <limits>
+#include <regex>
+#include <string_view>
+
+#include "clock_service.hpp"
+#include "log_buffer_impl.hpp"
 
 namespace logcrafter::cpp {
 
-namespace {
+template class BasicLogBuffer<StringStorage, MutexSync, TimeBlockIndex>;
 
-bool safe_localtime(std::time_t timestamp, std::tm &out) {
-#if defined(_POSIX_THREAD_SAFE_FUNCTIONS)
-    return localtime_r(&timestamp, &out) != nullptr;
-#else
-    std::tm *result = std::localtime(&timestamp);
-    if (result == nullptr) {
-        return false;
+void TimeBlockIndex::configure(std::size_t capacity) {
+    capacity_ = capacity;
+    blocks_.assign((capacity + kBlockSize - 1) / kBlockSize, TimeBlock{TimeBounds::empty(), TimeBounds::empty()});
+}
+
+void TimeBlockIndex::clear() {
+    for (TimeBlock &block : blocks_) {
+        block.covered = TimeBounds::empty();
+        block.fresh = TimeBounds::empty();
     }
-    out = *result;
-    return true;
-#endif
 }
 
-std::size_t oldest_index(std::size_t head, std::size_t size, std::size_t capacity) {
-    if (size == 0) {
-        return 0;
+void TimeBlockIndex::record_write(std::size_t index, std::time_t timestamp) {
+    TimeBlock &block = blocks_[index / kBlockSize];
+    const std::size_t offset = index % kBlockSize;
+    if (offset == 0) {
+        block.fresh = TimeBounds::empty();
     }
-    if (size == capacity) {
-        return head;
+    block.fresh.widen(timestamp);
+    block.covered.widen(timestamp);
+    if (offset == kBlockSize - 1 || index + 1 == capacity_) {
+        block.covered = block.fresh;
     }
-    return 0;
 }
 
-} // namespace
-
-LogBuffer::LogBuffer()
-    : entries_(),
-      capacity_(0),
-      size_(0),
-      head_(0),
-      total_logs_(0),
-      dropped_logs_(0) {}
-
-void LogBuffer::configure(std::size_t capacity) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    capacity_ = capacity;
-    entries_.assign(capacity_, Entry{});
-    size_ = 0;
-    head_ = 0;
-    total_logs_ = 0;
-    dropped_logs_ = 0;
+void TimeBlockIndex::record_move(std::size_t index, std::time_t timestamp) {
+    TimeBlock &block = blocks_[index / kBlockSize];
+    block.fresh.widen(timestamp);
+    block.covered.widen(timestamp);
 }
 
-void LogBuffer::reset() {
-    std::lock_guard<std::mutex> lock(mutex_);
-    size_ = 0;
-    head_ = 0;
-    total_logs_ = 0;
-    dropped_logs_ = 0;
-    for (Entry &entry : entries_) {
-        entry.timestamp = 0;
-        entry.message.clear();
+std::size_t TimeBlockIndex::skip_to(std::size_t index, const QueryRequest &request) const {
+    if (blocks_[index / kBlockSize].covered.overlaps(request)) {
+        return index;
     }
+    return std::min(capacity_, (index / kBlockSize + 1) * kBlockSize);
 }
 
-void LogBuffer::push(const std::string &message) {
-    push_with_time(message, std::time(nullptr));
+TimeBlockIndex::TimeBounds TimeBlockIndex::TimeBounds::empty() {
+    return TimeBounds{std::numeric_limits<std::time_t>::max(), std::numeric_limits<std::time_t>::min()};
 }
 
-void LogBuffer::push_with_time(const std::string &message, std::time_t timestamp) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    if (capacity_ == 0) {
-        return;
-    }
-
-    Entry &slot = entries_[head_];
-    slot.timestamp = timestamp == static_cast<std::time_t>(0) ? std::time(nullptr) : timestamp;
-    slot.message = message;
-    head_ = (head_ + 1) % capacity_;
-    if (size_ == capacity_) {
-        ++dropped_logs_;
-    } else {
-        ++size_;
-    }
-    ++total_logs_;
+void TimeBlockIndex::TimeBounds::widen(std::time_t timestamp) {
+    min = std::min(min, timestamp);
+    max = std::max(max, timestamp);
 }
 
-LogBufferStats LogBuffer::stats() const {
-    std::lock_guard<std::mutex> lock(mutex_);
-    return LogBufferStats{size_, total_logs_, dropped_logs_};
+bool TimeBlockIndex::TimeBounds::overlaps(const QueryRequest &request) const {
+    if (min > max) {
+        return false;
+    }
+    if (request.has_time_from && max < request.time_from) {
+        return false;
+    }
+    if (request.has_time_to && min > request.time_to) {
+        return false;
+    }
+    return true;
 }
 
-std::vector<std::string> LogBuffer::snapshot() const {
-    std::lock_guard<std::mutex> lock(mutex_);
-    std::vector<std::string> copy;
-    copy.reserve(size_);
-    if (size_ == 0 || capacity_ == 0) {
-        return copy;
-    }
+namespace log_buffer_detail {
 
-    std::size_t start_index = oldest_index(head_, size_, capacity_);
-    for (std::size_t i = 0; i < size_; ++i) {
-        std::size_t index = (start_index + i) % capacity_;
-        if (!entries_[index].message.empty()) {
-            copy.push_back(entries_[index].message);
-        }
-    }
-    return copy;
+std::time_t resolve_timestamp(std::time_t timestamp) {
+    return timestamp == static_cast<std::time_t>(0) ? ClockService::instance().now_seconds() : timestamp;
 }
 
-std::vector<std::string> LogBuffer::execute_query(const QueryRequest &request) const {
-    std::lock_guard<std::mutex> lock(mutex_);
-    std::vector<std::string> results;
-    if (size_ == 0 || capacity_ == 0) {
-        return results;
+bool entry_matches(std::string_view message, std::time_t timestamp, const QueryRequest &request) {
+    // Cheapest predicates first: time bounds, substring searches, the level scan, then the regex.
+    if (request.has_time_from && timestamp < request.time_from) {
+        return false;
     }
 
-    std::size_t start_index = oldest_index(head_, size_, capacity_);
-    for (std::size_t i = 0; i < size_; ++i) {
-        std::size_t index = (start_index + i) % capacity_;
-        const Entry &entry = entries_[index];
-        if (!entry.message.empty() && entry_matches(entry, request)) {
-            std::string formatted = format_entry(entry);
-            if (!formatted.empty()) {
-                results.push_back(std::move(formatted));
-            }
-        }
+    if (request.has_time_to && timestamp > request.time_to) {
+        return false;
     }
 
-    return results;
-}
-
-bool LogBuffer::entry_matches(const Entry &entry, const QueryRequest &request) {
-    if (!request.keyword.empty() && entry.message.find(request.keyword) == std::string::npos) {
+    if (!request.keyword.empty() && message.find(std::string_view(request.keyword)) == std::string_view::npos) {
         return false;
     }
 
     if (!request.keywords.empty()) {
         if (request.keyword_operator == QueryRequest::Operator::And) {
-            for (const std::string &kw : request.keywords) {
-                if (!kw.empty() && entry.message.find(kw) == std::string::npos) {
+            for (const std::pmr::string &kw : request.keywords) {
+                if (!kw.empty() && message.find(std::string_view(kw)) == std::string_view::npos) {
                     return false;
                 }
             }
         } else {
             bool any = false;
-            for (const std::string &kw : request.keywords) {
-                if (!kw.empty() && entry.message.find(kw) != std::string::npos) {
+            for (const std::pmr::string &kw : request.keywords) {
+                if (!kw.empty() && message.find(std::string_view(kw)) != std::string_view::npos) {
                     any = true;
                     break;
                 }
@@ -165,9 +121,13 @@ bool LogBuffer::entry_matches(const Entry &entry, const QueryRequest &request) {
         }
     }
 
+    if (request.has_level && result_codec::classify_level(message) != request.level) {
+        return false;
+    }
+
     if (request.has_regex) {
         try {
-            if (!std::regex_search(entry.message, request.regex)) {
+            if (!std::regex_search(message.begin(), message.end(), *request.regex)) {
                 return false;
             }
         } catch (const std::regex_error &) {
@@ -175,34 +135,21 @@ bool LogBuffer::entry_matches(const Entry &entry, const QueryRequest &request) {
         }
     }
 
-    if (request.has_time_from && entry.timestamp < request.time_from) {
-        return false;
-    }
-
-    if (request.has_time_to && entry.timestamp > request.time_to) {
-        return false;
-    }
-
     return true;
 }
 
-std::string LogBuffer::format_entry(const Entry &entry) {
-    std::tm tm_value{};
-    if (!safe_localtime(entry.timestamp, tm_value)) {
-        std::memset(&tm_value, 0, sizeof(tm_value));
-        tm_value.tm_year = 70;
-        tm_value.tm_mon = 0;
-        tm_value.tm_mday = 1;
-    }
-
+void format_entry(std::time_t timestamp, std::string_view message, std::pmr::string &out, bool context) {
     char buffer[32];
-    if (std::strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", &tm_value) == 0) {
-        std::snprintf(buffer, sizeof(buffer), "1970-01-01 00:00:00");
-    }
-
-    std::ostringstream oss;
-    oss << '[' << buffer << "] " << entry.message;
-    return oss.str();
+    const std::size_t stamp_length =
+        ClockService::instance().format_timestamp(timestamp, buffer, sizeof(buffer));
+
+    out.reserve(stamp_length + message.size() + 4);
+    out.push_back('[');
+    out.append(buffer, stamp_length);
+    out.append(context ? "]- " : "] ", context ? 3 : 2);
+    out.append(message);
 }
 
+} // namespace log_buffer_detail
+
 } // namespace logcrafter::cpp
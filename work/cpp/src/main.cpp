@@ -1,9 +1,9 @@
 /*
- * Sequence: SEQ0075
+ * Sequence: SEQ0345
  * Track: C++
- * MVP: mvp6
- * Change: Expand CLI parsing for IRC server naming, auto-join channels, and signal handling improvements.
- * Tests: smoke_cpp_mvp6_irc
+ * MVP: Step D
+ * Change: Add --redact-rules FILE.
+ * Tests: spec_redaction
  */
 #include "lc_server.hpp"
 
@@ -19,8 +19,10 @@
 namespace {
 
 logcrafter::cpp::Server g_server;
+volatile std::sig_atomic_t g_stop_requested = 0;
 
 void handle_signal(int) {
+    g_stop_requested = 1;
     g_server.request_stop();
 }
 
@@ -118,6 +120,63 @@ std::vector<std::string> parse_channel_list(const char *value) {
     return channels;
 }
 
+// NAME or NAME:CAPACITY; the name must satisfy StreamRegistry::valid_name().
+bool parse_stream_declaration(const char *value, logcrafter::cpp::StreamDeclaration &declaration) {
+    if (value == nullptr) {
+        return false;
+    }
+    const std::string text = value;
+    const std::size_t colon = text.find(':');
+    declaration.name = text.substr(0, colon);
+    declaration.capacity = 0;
+    if (!logcrafter::cpp::StreamRegistry::valid_name(declaration.name)) {
+        return false;
+    }
+    if (colon != std::string::npos) {
+        declaration.capacity = parse_capacity(text.c_str() + colon + 1, 0);
+        if (declaration.capacity == 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// HOST:PORT for --relay-to, --replica-of, and --peer.
+bool parse_upstream(const char *value, std::string &host, int &port) {
+    if (value == nullptr) {
+        return false;
+    }
+    const std::string text = value;
+    const std::size_t colon = text.rfind(':');
+    if (colon == 0 || colon == std::string::npos) {
+        return false;
+    }
+    host = text.substr(0, colon);
+    port = parse_port(text.c_str() + colon + 1, 0);
+    return port != 0;
+}
+
+// Three percentages adding up to 100 for the error/warning, info, and debug rings.
+bool parse_level_shares(const char *value, logcrafter::cpp::LevelShares &shares) {
+    if (value == nullptr) {
+        return false;
+    }
+    const char *cursor = value;
+    unsigned total = 0;
+    for (std::size_t ring = 0; ring < shares.size(); ++ring) {
+        char *endptr = nullptr;
+        const unsigned long parsed = std::strtoul(cursor, &endptr, 10);
+        const char expected = ring + 1 < shares.size() ? ',' : '\0';
+        if (endptr == cursor || *endptr != expected || parsed > 100) {
+            return false;
+        }
+        shares[ring] = static_cast<unsigned>(parsed);
+        total += shares[ring];
+        cursor = endptr + 1;
+    }
+    return total == 100;
+}
+
 void print_usage(const char *prog) {
     std::cerr << "Usage: " << prog
               << " [--log-port PORT] [--query-port PORT] [--capacity N] [--workers N]" << std::endl
@@ -126,6 +185,21 @@ void print_usage(const char *prog) {
               << "       [--persistence-max-files N]" << std::endl
               << "       [--enable-irc|--disable-irc] [--irc-port PORT]" << std::endl
               << "       [--irc-server-name NAME] [--irc-auto-join chan1,chan2]" << std::endl
+              << "       [--client-timestamps] [--reorder-window N]" << std::endl
+              << "       [--level-shares SEVERE,INFO,DEBUG]" << std::endl
+              << "         (each of the three rings holds CAPACITY slots: 3x the buffer memory)" << std::endl
+              << "       [--source-rate LINES_PER_SEC] [--source-burst N] [--quota-action drop|defer]" << std::endl
+              << "       [--stream NAME[:CAPACITY]]..." << std::endl
+              << "       [--collapse-repeats off|exact|masked] [--collapse-window MS]" << std::endl
+              << "       [--relay-to HOST:PORT] [--relay-spool DIR] [--relay-name NAME]" << std::endl
+              << "       [--relay-batch N] [--relay-compress]" << std::endl
+              << "       [--replication-log DIR] [--replication-retain SEGMENTS]" << std::endl
+              << "       [--replication-tail ENTRIES]" << std::endl
+              << "       [--replica-of HOST:LOG_PORT] [--replica-name NAME]" << std::endl
+              << "       [--peer HOST:QUERY_PORT]... [--peer-timeout MS]" << std::endl
+              << "       [--alert-rules FILE] [--redact-rules FILE]" << std::endl
+              << "       [--shed-ladder LEVEL:N[,LEVEL:N...]] [--shed-high-water LINES]" << std::endl
+              << "       [--pipeline-threads STAGE=N[,STAGE=N...]] [--pipeline-queue ENTRIES]" << std::endl
               << "Runs the LogCrafter C++ MVP6 server with persistence, IRC streaming, and advanced query handling." << std::endl;
 }
 
@@ -194,6 +268,177 @@ int main(int argc, char **argv) {
             config.irc_enabled = true;
         } else if (std::strcmp(argv[i], "--disable-irc") == 0) {
             config.irc_enabled = false;
+        } else if (std::strcmp(argv[i], "--client-timestamps") == 0) {
+            config.client_timestamps = true;
+        } else if (std::strcmp(argv[i], "--reorder-window") == 0 && i + 1 < argc) {
+            std::size_t window = 0;
+            if (!parse_positive_size(argv[++i], window, 0, 4096)) {
+                print_usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+            config.reorder_window = window;
+        } else if (std::strcmp(argv[i], "--level-shares") == 0 && i + 1 < argc) {
+            if (!parse_level_shares(argv[++i], config.level_shares)) {
+                print_usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+        } else if (std::strcmp(argv[i], "--source-rate") == 0 && i + 1 < argc) {
+            std::size_t rate = 0;
+            if (!parse_positive_size(argv[++i], rate, 0, 1000000)) {
+                print_usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+            config.source_rate = static_cast<double>(rate);
+        } else if (std::strcmp(argv[i], "--source-burst") == 0 && i + 1 < argc) {
+            std::size_t burst = 0;
+            if (!parse_positive_size(argv[++i], burst, 1, 1000000)) {
+                print_usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+            config.source_burst = burst;
+        } else if (std::strcmp(argv[i], "--quota-action") == 0 && i + 1 < argc) {
+            const char *value = argv[++i];
+            if (std::strcmp(value, "drop") == 0) {
+                config.quota_action = logcrafter::cpp::QuotaAction::Drop;
+            } else if (std::strcmp(value, "defer") == 0) {
+                config.quota_action = logcrafter::cpp::QuotaAction::Defer;
+            } else {
+                print_usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+        } else if (std::strcmp(argv[i], "--collapse-repeats") == 0 && i + 1 < argc) {
+            const char *value = argv[++i];
+            if (std::strcmp(value, "off") == 0) {
+                config.repeat_mode = logcrafter::cpp::RepeatMode::Off;
+            } else if (std::strcmp(value, "exact") == 0) {
+                config.repeat_mode = logcrafter::cpp::RepeatMode::Exact;
+            } else if (std::strcmp(value, "masked") == 0) {
+                config.repeat_mode = logcrafter::cpp::RepeatMode::Masked;
+            } else {
+                print_usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+        } else if (std::strcmp(argv[i], "--collapse-window") == 0 && i + 1 < argc) {
+            std::size_t window_ms = 0;
+            if (!parse_positive_size(argv[++i], window_ms, 1, 86400000)) {
+                print_usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+            config.repeat_window_ms = static_cast<std::int64_t>(window_ms);
+        } else if (std::strcmp(argv[i], "--stream") == 0 && i + 1 < argc) {
+            logcrafter::cpp::StreamDeclaration declaration;
+            if (!parse_stream_declaration(argv[++i], declaration)) {
+                print_usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+            config.streams.push_back(declaration);
+        } else if (std::strcmp(argv[i], "--relay-to") == 0 && i + 1 < argc) {
+            if (!parse_upstream(argv[++i], config.relay.upstream_host, config.relay.upstream_port)) {
+                print_usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+            config.relay_enabled = true;
+        } else if (std::strcmp(argv[i], "--relay-spool") == 0 && i + 1 < argc) {
+            const char *value = argv[++i];
+            if (value == nullptr || *value == '\0') {
+                print_usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+            config.relay.spool_directory = value;
+        } else if (std::strcmp(argv[i], "--relay-name") == 0 && i + 1 < argc) {
+            const char *value = argv[++i];
+            if (!logcrafter::cpp::StreamRegistry::valid_name(value)) {
+                print_usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+            config.relay.relay_name = value;
+        } else if (std::strcmp(argv[i], "--relay-batch") == 0 && i + 1 < argc) {
+            std::size_t batch = 0;
+            if (!parse_positive_size(argv[++i], batch, 1, 65536)) {
+                print_usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+            config.relay.batch_records = batch;
+        } else if (std::strcmp(argv[i], "--relay-compress") == 0) {
+            config.relay.compress = true;
+        } else if (std::strcmp(argv[i], "--replication-log") == 0 && i + 1 < argc) {
+            const char *value = argv[++i];
+            if (value == nullptr || *value == '\0') {
+                print_usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+            config.replication.directory = value;
+            config.replication_enabled = true;
+        } else if (std::strcmp(argv[i], "--replication-retain") == 0 && i + 1 < argc) {
+            std::size_t segments = 0;
+            if (!parse_positive_size(argv[++i], segments, 1, 4096)) {
+                print_usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+            config.replication.retain_segments = segments;
+        } else if (std::strcmp(argv[i], "--replication-tail") == 0 && i + 1 < argc) {
+            std::size_t entries = 0;
+            if (!parse_positive_size(argv[++i], entries, 1, 1000000)) {
+                print_usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+            config.replication.tail_entries = entries;
+        } else if (std::strcmp(argv[i], "--replica-of") == 0 && i + 1 < argc) {
+            if (!parse_upstream(argv[++i], config.replica.primary_host, config.replica.primary_port)) {
+                print_usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+            config.replica_enabled = true;
+        } else if (std::strcmp(argv[i], "--replica-name") == 0 && i + 1 < argc) {
+            const char *value = argv[++i];
+            if (!logcrafter::cpp::StreamRegistry::valid_name(value)) {
+                print_usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+            config.replica.name = value;
+        } else if (std::strcmp(argv[i], "--peer") == 0 && i + 1 < argc) {
+            logcrafter::cpp::PeerAddress peer;
+            if (!parse_upstream(argv[++i], peer.host, peer.port)) {
+                print_usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+            config.peers.push_back(peer);
+        } else if (std::strcmp(argv[i], "--peer-timeout") == 0 && i + 1 < argc) {
+            std::size_t timeout_ms = 0;
+            if (!parse_positive_size(argv[++i], timeout_ms, 1, 600000)) {
+                print_usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+            config.peer_timeout_ms = static_cast<int>(timeout_ms);
+        } else if (std::strcmp(argv[i], "--alert-rules") == 0 && i + 1 < argc) {
+            config.alert_rules_path = argv[++i];
+        } else if (std::strcmp(argv[i], "--redact-rules") == 0 && i + 1 < argc) {
+            config.redact_rules_path = argv[++i];
+        } else if (std::strcmp(argv[i], "--shed-ladder") == 0 && i + 1 < argc) {
+            std::string error;
+            if (!logcrafter::cpp::LoadShedder::parse_ladder(argv[++i], config.shedding.ladder, error)) {
+                std::cerr << "--shed-ladder: " << error << std::endl;
+                print_usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+        } else if (std::strcmp(argv[i], "--shed-high-water") == 0 && i + 1 < argc) {
+            if (!parse_positive_size(argv[++i], config.shedding.high_water, 1, 1000000)) {
+                print_usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+        } else if (std::strcmp(argv[i], "--pipeline-threads") == 0 && i + 1 < argc) {
+            std::string error;
+            if (!logcrafter::cpp::IngestPipeline::parse_threads(argv[++i], config.pipeline.threads, error)) {
+                std::cerr << "--pipeline-threads: " << error << std::endl;
+                print_usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+        } else if (std::strcmp(argv[i], "--pipeline-queue") == 0 && i + 1 < argc) {
+            if (!parse_positive_size(argv[++i], config.pipeline.queue_capacity, 2,
+                                     logcrafter::cpp::IngestPipeline::kMaxQueueCapacity)) {
+                print_usage(argv[0]);
+                return EXIT_FAILURE;
+            }
         } else if (std::strcmp(argv[i], "--help") == 0) {
             print_usage(argv[0]);
             return EXIT_SUCCESS;
@@ -203,10 +448,7 @@ int main(int argc, char **argv) {
         }
     }
 
-    if (g_server.init(config) != 0) {
-        return EXIT_FAILURE;
-    }
-
+    // Install handlers before init so a signal racing with listener startup is not lost.
     struct sigaction sa;
     std::memset(&sa, 0, sizeof(sa));
     sa.sa_handler = handle_signal;
@@ -214,6 +456,13 @@ int main(int argc, char **argv) {
     sigaction(SIGINT, &sa, nullptr);
     sigaction(SIGTERM, &sa, nullptr);
 
+    if (g_server.init(config) != 0) {
+        return EXIT_FAILURE;
+    }
+    if (g_stop_requested) {
+        g_server.request_stop();
+    }
+
     const int result = g_server.run();
     g_server.shutdown();
     return result == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
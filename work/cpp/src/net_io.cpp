@@ -0,0 +1,137 @@
+/*
+ * Sequence: SEQ0254
+ * Track: C++
+ * MVP: Step D
+ * Change: Send file ranges to sockets with sendfile().
+ * Tests: spec_export, spec_relay_forwarding, spec_replication
+ */
+#include "net_io.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/sendfile.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+namespace logcrafter::cpp::net_io {
+
+namespace {
+
+// Linux transfers at most 0x7ffff000 bytes per sendfile() call.
+constexpr std::uint64_t kMaxSendfileBytes = 0x7ffff000;
+
+} // namespace
+
+int connect_tcp(const std::string &host, int port, int connect_timeout_ms, int io_timeout_seconds) {
+    struct addrinfo hints {};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    struct addrinfo *addresses = nullptr;
+    if (::getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &addresses) != 0 || addresses == nullptr) {
+        return -1;
+    }
+
+    const int fd = ::socket(addresses->ai_family, addresses->ai_socktype | SOCK_CLOEXEC, addresses->ai_protocol);
+    if (fd < 0) {
+        ::freeaddrinfo(addresses);
+        return -1;
+    }
+    const int flags = ::fcntl(fd, F_GETFL, 0);
+    ::fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+    int result = ::connect(fd, addresses->ai_addr, addresses->ai_addrlen);
+    ::freeaddrinfo(addresses);
+    if (result != 0 && errno == EINPROGRESS) {
+        struct pollfd pending {
+            fd, POLLOUT, 0
+        };
+        int error = ETIMEDOUT;
+        socklen_t error_length = sizeof(error);
+        if (::poll(&pending, 1, connect_timeout_ms) == 1) {
+            ::getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &error_length);
+        }
+        result = error == 0 ? 0 : -1;
+    }
+    if (result != 0) {
+        ::close(fd);
+        return -1;
+    }
+    ::fcntl(fd, F_SETFL, flags);
+
+    struct timeval timeout {};
+    timeout.tv_sec = io_timeout_seconds;
+    ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    ::setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+    // Frames go out in one sendmsg() and then wait for a reply; Nagle would only delay them.
+    const int nodelay = 1;
+    ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
+    return fd;
+}
+
+bool recv_exact(int fd, char *data, std::size_t length) {
+    std::size_t received = 0;
+    while (received < length) {
+        const ssize_t got = ::recv(fd, data + received, length - received, 0);
+        if (got < 0 && errno == EINTR) {
+            continue;
+        }
+        if (got <= 0) {
+            return false;
+        }
+        received += static_cast<std::size_t>(got);
+    }
+    return true;
+}
+
+bool send_text(int fd, std::string_view text) {
+    std::size_t sent = 0;
+    while (sent < text.size()) {
+        const ssize_t result = ::send(fd, text.data() + sent, text.size() - sent, MSG_NOSIGNAL);
+        if (result < 0 && errno == EINTR) {
+            continue;
+        }
+        if (result <= 0) {
+            return false;
+        }
+        sent += static_cast<std::size_t>(result);
+    }
+    return true;
+}
+
+bool send_file(int fd, int file_fd, std::uint64_t offset, std::uint64_t length) {
+    off_t position = static_cast<off_t>(offset);
+    while (length > 0) {
+        const std::size_t chunk = static_cast<std::size_t>(std::min(length, kMaxSendfileBytes));
+        const ssize_t result = ::sendfile(fd, file_fd, &position, chunk);
+        if (result < 0 && errno == EINTR) {
+            continue;
+        }
+        if (result <= 0) {
+            return false;
+        }
+        length -= static_cast<std::uint64_t>(result);
+    }
+    return true;
+}
+
+bool recv_line(int fd, std::string &line, std::size_t max_length) {
+    line.clear();
+    char ch = 0;
+    while (recv_exact(fd, &ch, 1)) {
+        if (ch == '\n') {
+            return true;
+        }
+        if (line.size() >= max_length) {
+            return false;
+        }
+        line.push_back(ch);
+    }
+    return false;
+}
+
+} // namespace logcrafter::cpp::net_io
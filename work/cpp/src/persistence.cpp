@@ -1,9 +1,9 @@
 /*
- * Sequence: SEQ0048
+ * Sequence: SEQ0351
  * Track: C++
- * MVP: mvp4
- * Change: Implement the asynchronous persistence manager with log rotation, pruning, and replay helpers.
- * Tests: smoke_cpp_mvp4_persistence
+ * MVP: Step D
+ * Change: Format line prefixes and rotated names in one place shared with the importer.
+ * Tests: spec_bulk_import, spec_export
  */
 #include "persistence.hpp"
 
@@ -11,6 +11,7 @@
 #include <cerrno>
 #include <cstring>
 #include <dirent.h>
+#include <fcntl.h>
 #include <limits.h>
 #include <sys/stat.h>
 #include <sys/types.h>
@@ -19,6 +20,9 @@
 #include <utility>
 #include <vector>
 
+#include "clock_service.hpp"
+#include "timestamp_parser.hpp"
+
 namespace logcrafter::cpp {
 
 namespace {
@@ -26,6 +30,8 @@ constexpr std::size_t kDefaultMaxFileSize = 10 * 1024 * 1024;
 constexpr std::size_t kDefaultMaxFiles = 10;
 constexpr std::size_t kLineBufferSize = 2048;
 constexpr const char *kCurrentFileName = "current.log";
+constexpr std::size_t kStampProbeBytes = 64;
+constexpr std::size_t kScanChunkBytes = 4096;
 
 bool has_log_extension(const char *name) {
     const std::size_t length = std::strlen(name);
@@ -73,8 +79,102 @@ void trim_newline(char *buffer) {
     }
 }
 
+bool line_stamp(int fd, std::uint64_t start, std::time_t &stamp) {
+    char probe[kStampProbeBytes];
+    const ssize_t length = ::pread(fd, probe, sizeof(probe), static_cast<off_t>(start));
+    LeadingTimestamp parsed;
+    if (length <= 0 || !parse_bracketed_timestamp(std::string_view(probe, static_cast<std::size_t>(length)), parsed)) {
+        return false;
+    }
+    stamp = parsed.seconds;
+    return true;
+}
+
+// Start of the first line that begins at or after `position`, or `limit` if none does before it.
+std::uint64_t line_start_from(int fd, std::uint64_t position, std::uint64_t limit) {
+    if (position == 0) {
+        return 0;
+    }
+    char chunk[kScanChunkBytes];
+    std::uint64_t cursor = position - 1;
+    while (cursor < limit) {
+        const std::size_t want = static_cast<std::size_t>(std::min<std::uint64_t>(sizeof(chunk), limit - cursor));
+        const ssize_t length = ::pread(fd, chunk, want, static_cast<off_t>(cursor));
+        if (length <= 0) {
+            break;
+        }
+        const void *newline = std::memchr(chunk, '\n', static_cast<std::size_t>(length));
+        if (newline != nullptr) {
+            return cursor + static_cast<std::uint64_t>(static_cast<const char *>(newline) - chunk) + 1;
+        }
+        cursor += static_cast<std::uint64_t>(length);
+    }
+    return limit;
+}
+
+// End of the last complete line, so a line the writer is still appending is left out.
+std::uint64_t complete_lines_end(int fd, std::uint64_t size) {
+    char chunk[kScanChunkBytes];
+    std::uint64_t end = size;
+    while (end > 0) {
+        const std::size_t want = static_cast<std::size_t>(std::min<std::uint64_t>(sizeof(chunk), end));
+        const ssize_t length = ::pread(fd, chunk, want, static_cast<off_t>(end - want));
+        if (length != static_cast<ssize_t>(want)) {
+            return 0;
+        }
+        for (std::size_t i = want; i > 0; --i) {
+            if (chunk[i - 1] == '\n') {
+                return end - want + i;
+            }
+        }
+        end -= want;
+    }
+    return 0;
+}
+
+// Binary search over line starts for the first line stamped at or after `bound` (after it
+// when `past` is set); unstamped lines count as earlier. Returns `size` when there is none.
+std::uint64_t find_line(int fd, std::uint64_t size, std::time_t bound, bool past) {
+    const auto reached = [fd, bound, past](std::uint64_t start) {
+        std::time_t stamp = 0;
+        return line_stamp(fd, start, stamp) && (past ? stamp > bound : stamp >= bound);
+    };
+    // `low` is always a line start with only earlier lines before it; the answer is at or before `high`.
+    std::uint64_t low = 0;
+    std::uint64_t high = size;
+    while (low < high) {
+        const std::uint64_t start = line_start_from(fd, low + (high - low) / 2, high);
+        if (start < high) {
+            if (reached(start)) {
+                high = start;
+            } else {
+                low = line_start_from(fd, start + 1, high);
+            }
+        } else if (reached(low)) {
+            high = low;
+        } else {
+            low = line_start_from(fd, low + 1, high);
+        }
+    }
+    return low;
+}
+
 } // namespace
 
+ExportPlan::~ExportPlan() {
+    for (const ExportSlice &slice : slices) {
+        ::close(slice.fd);
+    }
+}
+
+std::uint64_t ExportPlan::total_bytes() const {
+    std::uint64_t total = 0;
+    for (const ExportSlice &slice : slices) {
+        total += slice.length;
+    }
+    return total;
+}
+
 PersistenceManager::PersistenceManager()
     : worker_running_(false),
       stop_(false),
@@ -104,9 +204,9 @@ int PersistenceManager::init(const PersistenceConfig &config) {
     current_path_ = config_.directory + "/" + kCurrentFileName;
 
     stop_ = false;
-    queued_logs_ = 0;
-    persisted_logs_ = 0;
-    failed_logs_ = 0;
+    queued_logs_.store(0, std::memory_order_relaxed);
+    persisted_logs_.store(0, std::memory_order_relaxed);
+    failed_logs_.store(0, std::memory_order_relaxed);
     queue_.clear();
 
     if (!ensure_directory()) {
@@ -161,14 +261,15 @@ bool PersistenceManager::enqueue(const std::string &message, std::time_t timesta
     }
 
     queue_.push_back(Entry{timestamp, message});
-    ++queued_logs_;
+    queued_logs_.store(queued_logs_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
     condition_.notify_one();
     return true;
 }
 
 PersistenceStats PersistenceManager::stats() const {
-    std::lock_guard<std::mutex> lock(mutex_);
-    return PersistenceStats{queued_logs_, persisted_logs_, failed_logs_};
+    return PersistenceStats{queued_logs_.load(std::memory_order_relaxed),
+                            persisted_logs_.load(std::memory_order_relaxed),
+                            failed_logs_.load(std::memory_order_relaxed)};
 }
 
 int PersistenceManager::replay_existing(const std::function<void(const std::string &, std::time_t)> &callback) {
@@ -211,6 +312,51 @@ int PersistenceManager::replay_existing(const std::function<void(const std::stri
     return 0;
 }
 
+int PersistenceManager::plan_export(std::time_t from, std::time_t to, ExportPlan &plan) const {
+    std::lock_guard<std::mutex> files_lock(files_mutex_);
+    std::vector<std::string> files;
+    if (!collect_log_files(config_.directory, true, files)) {
+        return -1;
+    }
+
+    for (const std::string &name : files) {
+        const bool current = name == kCurrentFileName;
+        if (!current) {
+            // Rotated files are named after the stamp of the line that filled them.
+            LeadingTimestamp last;
+            const std::string stamp = "[" + name.substr(0, name.size() - 4) + "] ";
+            if (parse_bracketed_timestamp(stamp, last) && last.seconds < from) {
+                continue;
+            }
+        }
+
+        const std::string path = config_.directory + "/" + name;
+        const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            continue;
+        }
+        struct stat st {};
+        std::uint64_t size = 0;
+        if (::fstat(fd, &st) == 0 && st.st_size > 0) {
+            size = complete_lines_end(fd, static_cast<std::uint64_t>(st.st_size));
+        }
+        std::time_t first = 0;
+        if (size == 0 || (line_stamp(fd, 0, first) && first > to)) {
+            ::close(fd);
+            continue;
+        }
+
+        const std::uint64_t begin = find_line(fd, size, from, false);
+        const std::uint64_t end = find_line(fd, size, to, true);
+        if (end <= begin) {
+            ::close(fd);
+            continue;
+        }
+        plan.slices.push_back(ExportSlice{fd, begin, end - begin});
+    }
+    return 0;
+}
+
 void PersistenceManager::worker_loop() {
     while (true) {
         Entry entry{};
@@ -224,13 +370,9 @@ void PersistenceManager::worker_loop() {
             queue_.pop_front();
         }
 
-        if (!write_entry(entry)) {
-            std::lock_guard<std::mutex> lock(mutex_);
-            ++failed_logs_;
-        } else {
-            std::lock_guard<std::mutex> lock(mutex_);
-            ++persisted_logs_;
-        }
+        // Only this thread writes the outcome counters, so no lock or atomic RMW is needed.
+        std::atomic<unsigned long> &outcome = write_entry(entry) ? persisted_logs_ : failed_logs_;
+        outcome.store(outcome.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
     }
 }
 
@@ -270,17 +412,10 @@ void PersistenceManager::close_current_file() {
 }
 
 bool PersistenceManager::rotate_file(std::time_t timestamp) {
+    std::lock_guard<std::mutex> files_lock(files_mutex_);
     close_current_file();
 
-    char timestamp_buffer[32];
-    format_timestamp(timestamp, timestamp_buffer, sizeof(timestamp_buffer));
-
-    char rotated_name[64];
-    if (std::snprintf(rotated_name, sizeof(rotated_name), "%s.log", timestamp_buffer) < 0) {
-        return false;
-    }
-
-    std::string rotated_path = config_.directory + "/" + rotated_name;
+    std::string rotated_path = config_.directory + "/" + rotated_name(timestamp);
     if (std::rename(current_path_.c_str(), rotated_path.c_str()) != 0) {
         if (errno != ENOENT) {
             return false;
@@ -330,19 +465,17 @@ bool PersistenceManager::write_entry(const Entry &entry) {
     }
 
     const std::time_t timestamp = entry.timestamp == static_cast<std::time_t>(0)
-                                      ? std::time(nullptr)
+                                      ? ClockService::instance().now_seconds()
                                       : entry.timestamp;
 
-    char timestamp_buffer[32];
-    format_timestamp(timestamp, timestamp_buffer, sizeof(timestamp_buffer));
-    std::string line = "[";
-    line += timestamp_buffer;
-    line += "] ";
-    line += entry.message;
-    line += '\n';
+    char prefix[kLinePrefixCapacity];
+    const std::size_t prefix_length = format_line_prefix(timestamp, prefix, sizeof(prefix));
 
-    const std::size_t written = std::fwrite(line.data(), 1, line.size(), current_file_);
-    if (written != line.size()) {
+    const std::size_t line_length = prefix_length + entry.message.size() + 1;
+    std::size_t written = std::fwrite(prefix, 1, prefix_length, current_file_);
+    written += std::fwrite(entry.message.data(), 1, entry.message.size(), current_file_);
+    written += std::fwrite("\n", 1, 1, current_file_);
+    if (written != line_length) {
         return false;
     }
 
@@ -358,55 +491,30 @@ bool PersistenceManager::write_entry(const Entry &entry) {
     return true;
 }
 
-void PersistenceManager::format_timestamp(std::time_t timestamp, char *buffer, std::size_t capacity) {
-    if (capacity == 0) {
-        return;
+std::size_t PersistenceManager::format_line_prefix(std::time_t timestamp, char *buffer, std::size_t capacity) {
+    if (capacity < kLinePrefixCapacity) {
+        return 0;
     }
+    buffer[0] = '[';
+    std::size_t length = 1 + ClockService::instance().format_timestamp(timestamp, buffer + 1, capacity - 3);
+    buffer[length++] = ']';
+    buffer[length++] = ' ';
+    return length;
+}
 
-    std::tm tm_value{};
-#if defined(_POSIX_THREAD_SAFE_FUNCTIONS)
-    if (localtime_r(&timestamp, &tm_value) == nullptr) {
-        std::memset(&tm_value, 0, sizeof(tm_value));
-        tm_value.tm_year = 70;
-        tm_value.tm_mon = 0;
-        tm_value.tm_mday = 1;
-    }
-#else
-    std::tm *tmp = std::localtime(&timestamp);
-    if (tmp == nullptr) {
-        std::memset(&tm_value, 0, sizeof(tm_value));
-        tm_value.tm_year = 70;
-        tm_value.tm_mon = 0;
-        tm_value.tm_mday = 1;
-    } else {
-        tm_value = *tmp;
-    }
-#endif
-
-    if (std::strftime(buffer, capacity, "%Y-%m-%d %H:%M:%S", &tm_value) == 0) {
-        std::snprintf(buffer, capacity, "1970-01-01 00:00:00");
+std::string PersistenceManager::rotated_name(std::time_t timestamp) {
+    char stamp[kLinePrefixCapacity];
+    if (ClockService::instance().format_timestamp(timestamp, stamp, sizeof(stamp)) == 0) {
+        std::snprintf(stamp, sizeof(stamp), "1970-01-01 00:00:00");
     }
+    return std::string(stamp) + ".log";
 }
 
 std::time_t PersistenceManager::parse_line(const char *line, std::size_t &offset) {
-    int year = 0;
-    int month = 0;
-    int day = 0;
-    int hour = 0;
-    int minute = 0;
-    int second = 0;
-    int consumed = 0;
-    if (std::sscanf(line, "[%d-%d-%d %d:%d:%d] %n", &year, &month, &day, &hour, &minute, &second, &consumed) == 6) {
-        std::tm tm_value{};
-        tm_value.tm_year = year - 1900;
-        tm_value.tm_mon = month - 1;
-        tm_value.tm_mday = day;
-        tm_value.tm_hour = hour;
-        tm_value.tm_min = minute;
-        tm_value.tm_sec = second;
-        tm_value.tm_isdst = -1;
-        offset = static_cast<std::size_t>(consumed);
-        return std::mktime(&tm_value);
+    LeadingTimestamp stamp;
+    if (parse_bracketed_timestamp(line, stamp)) {
+        offset = stamp.length;
+        return stamp.seconds;
     }
     offset = 0;
     return static_cast<std::time_t>(0);
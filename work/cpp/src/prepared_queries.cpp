@@ -0,0 +1,86 @@
+/*
+ * Sequence: SEQ0324
+ * Track: C++
+ * MVP: Step D
+ * Change: Parse and store PREPAREd plans and count the parse time EXECUTE saves.
+ * Tests: spec_prepared_query
+ */
+#include "prepared_queries.hpp"
+
+#include <chrono>
+
+namespace logcrafter::cpp {
+
+PreparedQueries::PreparedQueries() : plan_count_(0), executes_(0), parse_micros_saved_(0) {}
+
+bool PreparedQueries::valid_name(std::string_view name) {
+    if (name.empty() || name.size() > kMaxNameLength) {
+        return false;
+    }
+    for (const char ch : name) {
+        const bool allowed = (ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z') || (ch >= '0' && ch <= '9') ||
+                             ch == '_' || ch == '-';
+        if (!allowed) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool PreparedQueries::prepare(std::string_view name, std::string_view arguments, std::string &error) {
+    if (!valid_name(name)) {
+        error = "ERROR: Invalid prepared query name.";
+        return false;
+    }
+
+    auto plan = std::make_shared<Plan>();
+    const auto started = std::chrono::steady_clock::now();
+    if (!parse_query_arguments(arguments, plan->request, error)) {
+        if (error.empty()) {
+            error = "ERROR: Invalid query syntax.";
+        } else if (error.rfind("ERROR:", 0) != 0) {
+            error = "ERROR: " + error;
+        }
+        return false;
+    }
+    plan->parse_micros = static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - started).count());
+    plan->arguments.assign(arguments.data(), arguments.size());
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto found = plans_.find(name);
+    if (found != plans_.end()) {
+        found->second = std::move(plan);
+        return true;
+    }
+    if (plans_.size() >= kMaxPlans) {
+        error = "ERROR: Too many prepared queries (at most " + std::to_string(kMaxPlans) + ").";
+        return false;
+    }
+    plans_.emplace(std::string(name), std::move(plan));
+    plan_count_.store(plans_.size(), std::memory_order_relaxed);
+    return true;
+}
+
+std::shared_ptr<const PreparedQueries::Plan> PreparedQueries::find(std::string_view name) {
+    std::shared_ptr<const Plan> plan;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        const auto found = plans_.find(name);
+        if (found == plans_.end()) {
+            return nullptr;
+        }
+        plan = found->second;
+    }
+    executes_.fetch_add(1, std::memory_order_relaxed);
+    parse_micros_saved_.fetch_add(plan->parse_micros, std::memory_order_relaxed);
+    return plan;
+}
+
+PreparedQueryStats PreparedQueries::stats() const {
+    // Lock-free so STATS never waits behind a PREPARE holding mutex_.
+    return PreparedQueryStats{plan_count_.load(std::memory_order_relaxed), executes_.load(std::memory_order_relaxed),
+                              parse_micros_saved_.load(std::memory_order_relaxed)};
+}
+
+} // namespace logcrafter::cpp
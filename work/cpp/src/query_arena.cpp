@@ -0,0 +1,35 @@
+/*
+ * Sequence: SEQ0110
+ * Track: C++
+ * MVP: Step D
+ * Change: Implement thread-local query arenas that are recycled between QUERY and !query executions.
+ * Tests: spec_protocol_happy_path, integration_multi_client_broadcast
+ */
+#include "query_arena.hpp"
+
+namespace logcrafter::cpp {
+
+namespace {
+
+thread_local int g_scope_depth = 0;
+
+} // namespace
+
+QueryArena::QueryArena()
+    : seed_(),
+      resource_(seed_, sizeof(seed_), std::pmr::new_delete_resource()) {}
+
+QueryArena &QueryArena::for_current_thread() {
+    thread_local QueryArena arena;
+    return arena;
+}
+
+QueryArenaScope::QueryArenaScope() : arena_(QueryArena::for_current_thread()) { ++g_scope_depth; }
+
+QueryArenaScope::~QueryArenaScope() {
+    if (--g_scope_depth == 0) {
+        arena_.recycle();
+    }
+}
+
+} // namespace logcrafter::cpp
@@ -1,21 +1,26 @@
 /*
- * Sequence: SEQ0041
+ * Sequence: SEQ0326
  * Track: C++
- * MVP: mvp3
- * Change: Implement parsing for advanced QUERY arguments including keywords, regex filters, and time windows.
- * Tests: smoke_cpp_mvp3_query
+ * MVP: Step D
+ * Change: Take regex= from the shared cache and parse EXECUTE's time_from=, time_to=, and limit= overrides.
+ * Tests: spec_prepared_query
  */
 #include "query_parser.hpp"
 
-#include <algorithm>
 #include <cctype>
-#include <sstream>
+#include <charconv>
+#include <climits>
 #include <stdexcept>
 
+#include "regex_cache.hpp"
+
 namespace logcrafter::cpp {
 
 namespace {
 
+constexpr std::string_view kWhitespace = " \t\r\n";
+constexpr unsigned long long kMaxLimit = 1000000;
+
 void set_error(std::string &error, const std::string &message) {
     if (message.empty()) {
         error = "ERROR: Invalid query syntax.";
@@ -26,22 +31,37 @@ void set_error(std::string &error, const std::string &message) {
     }
 }
 
-bool parse_time(const std::string &value, const char *label, bool &has_flag, std::time_t &out, std::string &error) {
-    if (value.empty()) {
-        set_error(error, std::string("Invalid ") + label + " parameter.");
+bool parse_number(std::string_view value, std::string_view label, unsigned long long minimum,
+                  unsigned long long maximum, unsigned long long &out, std::string &error) {
+    const char *end = value.data() + value.size();
+    const auto result = std::from_chars(value.data(), end, out, 10);
+    if (value.empty() || result.ec != std::errc() || result.ptr != end || out < minimum || out > maximum) {
+        set_error(error, "Invalid " + std::string(label) + " parameter.");
         return false;
     }
+    return true;
+}
 
-    std::size_t consumed = 0;
-    long long parsed = 0;
-    try {
-        parsed = std::stoll(value, &consumed, 10);
-    } catch (const std::exception &) {
+bool parse_count(std::string_view value, std::string_view label, unsigned long long maximum, std::size_t &out,
+                 std::string &error) {
+    unsigned long long parsed = 0;
+    if (!parse_number(value, label, 1, maximum, parsed, error)) {
+        return false;
+    }
+    out = static_cast<std::size_t>(parsed);
+    return true;
+}
+
+bool parse_time(std::string_view value, const char *label, bool &has_flag, std::time_t &out, std::string &error) {
+    if (value.empty()) {
         set_error(error, std::string("Invalid ") + label + " parameter.");
         return false;
     }
 
-    if (consumed != value.size() || parsed < 0) {
+    long long parsed = 0;
+    const char *end = value.data() + value.size();
+    const auto result = std::from_chars(value.data(), end, parsed, 10);
+    if (result.ec != std::errc() || result.ptr != end || parsed < 0) {
         set_error(error, std::string("Invalid ") + label + " parameter.");
         return false;
     }
@@ -51,54 +71,135 @@ bool parse_time(const std::string &value, const char *label, bool &has_flag, std
     return true;
 }
 
-bool parse_keywords(const std::string &value, std::vector<std::string> &keywords, std::string &error) {
-    std::stringstream ss(value);
-    std::string token;
-    while (std::getline(ss, token, ',')) {
+bool parse_list(std::string_view value, const char *label, std::pmr::vector<std::pmr::string> &items,
+                std::string &error) {
+    // Mirrors std::getline(',') semantics: a trailing comma yields no extra token.
+    std::size_t start = 0;
+    while (start < value.size()) {
+        std::size_t comma = value.find(',', start);
+        if (comma == std::string_view::npos) {
+            comma = value.size();
+        }
+        const std::string_view token = value.substr(start, comma - start);
         if (token.empty()) {
-            set_error(error, "Invalid keywords parameter.");
+            set_error(error, std::string("Invalid ") + label + " parameter.");
             return false;
         }
-        keywords.push_back(token);
+        items.emplace_back(token);
+        start = comma + 1;
     }
 
-    if (keywords.empty()) {
-        set_error(error, "Invalid keywords parameter.");
+    if (items.empty()) {
+        set_error(error, std::string("Invalid ") + label + " parameter.");
         return false;
     }
 
     return true;
 }
 
-std::vector<std::string> tokenize(const std::string &input) {
-    std::vector<std::string> tokens;
-    std::istringstream stream(input);
-    std::string token;
-    while (stream >> token) {
-        tokens.push_back(token);
+void tokenize(std::string_view input, std::pmr::vector<std::string_view> &tokens) {
+    std::size_t position = input.find_first_not_of(kWhitespace);
+    while (position != std::string_view::npos) {
+        std::size_t end = input.find_first_of(kWhitespace, position);
+        if (end == std::string_view::npos) {
+            end = input.size();
+        }
+        tokens.push_back(input.substr(position, end - position));
+        position = input.find_first_not_of(kWhitespace, end);
     }
-    return tokens;
 }
 
-} // namespace
+// Level names as written by format=ndjson.
+bool parse_level(std::string_view value, result_codec::Level &out, std::string &error) {
+    for (std::uint8_t level = 0; level < result_codec::kLevelCount; ++level) {
+        if (value == result_codec::level_name(static_cast<result_codec::Level>(level))) {
+            out = static_cast<result_codec::Level>(level);
+            return true;
+        }
+    }
+    set_error(error, "level must be unknown, debug, info, warning, or error.");
+    return false;
+}
 
-bool parse_query_arguments(const std::string &arguments, QueryRequest &request, std::string &error_message) {
-    request = QueryRequest{};
-    error_message.clear();
+bool iequals(std::string_view lhs, std::string_view rhs) {
+    if (lhs.size() != rhs.size()) {
+        return false;
+    }
+    for (std::size_t i = 0; i < lhs.size(); ++i) {
+        if (std::toupper(static_cast<unsigned char>(lhs[i])) != std::toupper(static_cast<unsigned char>(rhs[i]))) {
+            return false;
+        }
+    }
+    return true;
+}
 
-    if (arguments.empty()) {
-        set_error(error_message, "Missing query parameters.");
+void reset_request(QueryRequest &request) {
+    request.keyword.clear();
+    request.keywords.clear();
+    request.streams.clear();
+    request.keyword_operator = QueryRequest::Operator::And;
+    request.has_regex = false;
+    request.regex.reset();
+    request.has_time_from = false;
+    request.time_from = 0;
+    request.has_time_to = false;
+    request.time_to = 0;
+    request.has_level = false;
+    request.level = result_codec::Level::Unknown;
+    request.before = 0;
+    request.after = 0;
+    request.scope = QueryRequest::Scope::Local;
+    request.limit = 0;
+    request.has_compression = false;
+    request.compression = QueryRequest::Compression::None;
+    request.format = QueryRequest::Format::Text;
+}
+
+// Rules that span parameters; shared by QUERY and EXECUTE's overrides.
+bool check_combinations(const QueryRequest &request, std::string &error_message) {
+    // Context lines have no place in a newest-n merge or a peer's reply, and the binary record
+    // has no field to mark them.
+    if ((request.before != 0 || request.after != 0) &&
+        (request.limit != 0 || request.scope != QueryRequest::Scope::Local ||
+         request.format == QueryRequest::Format::Binary)) {
+        set_error(error_message, "before= and after= cannot be combined with limit=, scope=cluster, or format=binary.");
+        return false;
+    }
+
+    if (request.has_time_from && request.has_time_to && request.time_from > request.time_to) {
+        set_error(error_message, "time_from must be <= time_to.");
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+bool parse_compression(std::string_view value, QueryRequest::Compression &compression, std::string &error_message) {
+    if (value == "none") {
+        compression = QueryRequest::Compression::None;
+    } else if (value == "deflate") {
+        compression = QueryRequest::Compression::Deflate;
+    } else {
+        set_error(error_message, "compress must be none or deflate.");
         return false;
     }
+    return true;
+}
 
-    std::size_t first_non_space = arguments.find_first_not_of(" \t\r\n");
-    if (first_non_space == std::string::npos) {
+bool parse_query_arguments(std::string_view arguments, QueryRequest &request, std::string &error_message) {
+    reset_request(request);
+    error_message.clear();
+
+    if (arguments.empty()) {
         set_error(error_message, "Missing query parameters.");
         return false;
     }
 
-    const std::string trimmed = arguments.substr(first_non_space);
-    std::vector<std::string> tokens = tokenize(trimmed);
+    // Tokens are views into the caller's line; only the scratch vector is allocated, and it
+    // draws from the same resource as the request (the query arena on the server paths).
+    std::pmr::vector<std::string_view> tokens(request.keywords.get_allocator());
+    tokenize(arguments, tokens);
     if (tokens.empty()) {
         set_error(error_message, "Missing query parameters.");
         return false;
@@ -106,15 +207,15 @@ bool parse_query_arguments(const std::string &arguments, QueryRequest &request,
 
     bool operator_explicit = false;
 
-    for (const std::string &token : tokens) {
+    for (const std::string_view token : tokens) {
         std::size_t equals = token.find('=');
-        if (equals == std::string::npos) {
+        if (equals == std::string_view::npos) {
             set_error(error_message, "Unknown query parameter.");
             return false;
         }
 
-        const std::string key = token.substr(0, equals);
-        const std::string value = token.substr(equals + 1);
+        const std::string_view key = token.substr(0, equals);
+        const std::string_view value = token.substr(equals + 1);
 
         if (key == "keyword") {
             if (!request.keyword.empty()) {
@@ -125,13 +226,21 @@ bool parse_query_arguments(const std::string &arguments, QueryRequest &request,
                 set_error(error_message, "Empty keyword parameter.");
                 return false;
             }
-            request.keyword = value;
+            request.keyword.assign(value.data(), value.size());
         } else if (key == "keywords") {
             if (!request.keywords.empty()) {
                 set_error(error_message, "Duplicate keywords parameter.");
                 return false;
             }
-            if (!parse_keywords(value, request.keywords, error_message)) {
+            if (!parse_list(value, "keywords", request.keywords, error_message)) {
+                return false;
+            }
+        } else if (key == "stream") {
+            if (!request.streams.empty()) {
+                set_error(error_message, "Duplicate stream parameter.");
+                return false;
+            }
+            if (!parse_list(value, "stream", request.streams, error_message)) {
                 return false;
             }
         } else if (key == "operator") {
@@ -139,13 +248,9 @@ bool parse_query_arguments(const std::string &arguments, QueryRequest &request,
                 set_error(error_message, "Empty operator parameter.");
                 return false;
             }
-            std::string normalized = value;
-            std::transform(normalized.begin(), normalized.end(), normalized.begin(), [](unsigned char ch) {
-                return static_cast<char>(std::toupper(ch));
-            });
-            if (normalized == "AND") {
+            if (iequals(value, "AND")) {
                 request.keyword_operator = QueryRequest::Operator::And;
-            } else if (normalized == "OR") {
+            } else if (iequals(value, "OR")) {
                 request.keyword_operator = QueryRequest::Operator::Or;
             } else {
                 set_error(error_message, "Operator must be AND or OR.");
@@ -162,7 +267,7 @@ bool parse_query_arguments(const std::string &arguments, QueryRequest &request,
                 return false;
             }
             try {
-                request.regex = std::regex(value, std::regex_constants::extended);
+                request.regex = RegexCache::instance().get(value, std::regex_constants::extended);
             } catch (const std::regex_error &ex) {
                 set_error(error_message, std::string("Regex compile failed: ") + ex.what());
                 return false;
@@ -176,6 +281,61 @@ bool parse_query_arguments(const std::string &arguments, QueryRequest &request,
             if (!parse_time(value, "time_to", request.has_time_to, request.time_to, error_message)) {
                 return false;
             }
+        } else if (key == "level") {
+            if (request.has_level) {
+                set_error(error_message, "Duplicate level parameter.");
+                return false;
+            }
+            if (!parse_level(value, request.level, error_message)) {
+                return false;
+            }
+            request.has_level = true;
+        } else if (key == "scope") {
+            if (value == "local") {
+                request.scope = QueryRequest::Scope::Local;
+            } else if (value == "cluster") {
+                request.scope = QueryRequest::Scope::Cluster;
+            } else {
+                set_error(error_message, "scope must be local or cluster.");
+                return false;
+            }
+        } else if (key == "limit") {
+            if (request.limit != 0) {
+                set_error(error_message, "Duplicate limit parameter.");
+                return false;
+            }
+            if (!parse_count(value, "limit", kMaxLimit, request.limit, error_message)) {
+                return false;
+            }
+        } else if (key == "before" || key == "after") {
+            std::size_t &lines = key == "before" ? request.before : request.after;
+            if (lines != 0) {
+                set_error(error_message, "Duplicate " + std::string(key) + " parameter.");
+                return false;
+            }
+            if (!parse_count(value, key, QueryRequest::kMaxContextLines, lines, error_message)) {
+                return false;
+            }
+        } else if (key == "compress") {
+            if (request.has_compression) {
+                set_error(error_message, "Duplicate compress parameter.");
+                return false;
+            }
+            if (!parse_compression(value, request.compression, error_message)) {
+                return false;
+            }
+            request.has_compression = true;
+        } else if (key == "format") {
+            if (value == "text") {
+                request.format = QueryRequest::Format::Text;
+            } else if (value == "binary") {
+                request.format = QueryRequest::Format::Binary;
+            } else if (value == "ndjson") {
+                request.format = QueryRequest::Format::Ndjson;
+            } else {
+                set_error(error_message, "format must be text, binary, or ndjson.");
+                return false;
+            }
         } else {
             set_error(error_message, "Unknown query parameter.");
             return false;
@@ -187,14 +347,13 @@ bool parse_query_arguments(const std::string &arguments, QueryRequest &request,
         return false;
     }
 
-    if (request.keyword.empty() && request.keywords.empty() && !request.has_regex &&
-        !request.has_time_from && !request.has_time_to) {
+    if (request.keyword.empty() && request.keywords.empty() && request.streams.empty() && !request.has_regex &&
+        !request.has_time_from && !request.has_time_to && !request.has_level) {
         set_error(error_message, "Provide at least one filter parameter.");
         return false;
     }
 
-    if (request.has_time_from && request.has_time_to && request.time_from > request.time_to) {
-        set_error(error_message, "time_from must be <= time_to.");
+    if (!check_combinations(request, error_message)) {
         return false;
     }
 
@@ -202,4 +361,225 @@ bool parse_query_arguments(const std::string &arguments, QueryRequest &request,
     return true;
 }
 
+bool parse_execute_overrides(std::string_view arguments, QueryRequest &request, std::string &error_message) {
+    error_message.clear();
+
+    std::pmr::vector<std::string_view> tokens(request.keywords.get_allocator());
+    tokenize(arguments, tokens);
+    bool has_time_from = false;
+    bool has_time_to = false;
+    bool has_limit = false;
+    for (const std::string_view token : tokens) {
+        const std::size_t equals = token.find('=');
+        const std::string_view key = token.substr(0, equals);
+        const std::string_view value = equals == std::string_view::npos ? std::string_view() : token.substr(equals + 1);
+        bool duplicate = false;
+        if (key == "time_from" && equals != std::string_view::npos) {
+            duplicate = has_time_from;
+            if (!duplicate && !parse_time(value, "time_from", has_time_from, request.time_from, error_message)) {
+                return false;
+            }
+            request.has_time_from = true;
+        } else if (key == "time_to" && equals != std::string_view::npos) {
+            duplicate = has_time_to;
+            if (!duplicate && !parse_time(value, "time_to", has_time_to, request.time_to, error_message)) {
+                return false;
+            }
+            request.has_time_to = true;
+        } else if (key == "limit" && equals != std::string_view::npos) {
+            duplicate = has_limit;
+            if (!duplicate && !parse_count(value, "limit", kMaxLimit, request.limit, error_message)) {
+                return false;
+            }
+            has_limit = true;
+        } else {
+            set_error(error_message, "EXECUTE accepts time_from=, time_to=, and limit= only.");
+            return false;
+        }
+        if (duplicate) {
+            set_error(error_message, "Duplicate " + std::string(key) + " parameter.");
+            return false;
+        }
+    }
+    return check_combinations(request, error_message);
+}
+
+bool parse_export_arguments(std::string_view arguments, ExportRequest &request, std::string &error_message) {
+    request = ExportRequest{};
+    error_message.clear();
+
+    std::pmr::vector<std::string_view> tokens;
+    tokenize(arguments, tokens);
+    bool has_from = false;
+    bool has_to = false;
+    for (const std::string_view token : tokens) {
+        const std::size_t equals = token.find('=');
+        const std::string_view key = token.substr(0, equals);
+        const std::string_view value = equals == std::string_view::npos ? std::string_view() : token.substr(equals + 1);
+        bool duplicate = false;
+        if (key == "from") {
+            duplicate = has_from;
+            if (!duplicate && !parse_time(value, "from", has_from, request.from, error_message)) {
+                return false;
+            }
+        } else if (key == "to") {
+            duplicate = has_to;
+            if (!duplicate && !parse_time(value, "to", has_to, request.to, error_message)) {
+                return false;
+            }
+        } else if (key == "stream" && equals != std::string_view::npos) {
+            duplicate = !request.stream.empty();
+            if (value.empty()) {
+                set_error(error_message, "Invalid stream parameter.");
+                return false;
+            }
+            request.stream.assign(value.data(), value.size());
+        } else {
+            set_error(error_message, "Unknown export parameter.");
+            return false;
+        }
+        if (duplicate) {
+            set_error(error_message, "Duplicate " + std::string(key) + " parameter.");
+            return false;
+        }
+    }
+
+    if (!has_from || !has_to) {
+        set_error(error_message, "EXPORT requires from=<unix> and to=<unix>.");
+        return false;
+    }
+    if (request.from > request.to) {
+        set_error(error_message, "from must not be after to.");
+        return false;
+    }
+    return true;
+}
+
+bool parse_rollup_arguments(std::string_view arguments, RollupRequest &request, std::string &error_message) {
+    request = RollupRequest{};
+    error_message.clear();
+
+    std::pmr::vector<std::string_view> tokens;
+    tokenize(arguments, tokens);
+    bool has_resolution = false;
+    bool has_group_by = false;
+    for (const std::string_view token : tokens) {
+        const std::size_t equals = token.find('=');
+        const std::string_view key = token.substr(0, equals);
+        const std::string_view value = equals == std::string_view::npos ? std::string_view() : token.substr(equals + 1);
+        bool duplicate = false;
+        if (key == "resolution") {
+            duplicate = has_resolution;
+            has_resolution = true;
+            if (value == "second") {
+                request.resolution = RollupRequest::Resolution::Second;
+            } else if (value == "minute") {
+                request.resolution = RollupRequest::Resolution::Minute;
+            } else {
+                set_error(error_message, "resolution must be second or minute.");
+                return false;
+            }
+        } else if (key == "from") {
+            duplicate = request.has_from;
+            if (!duplicate && !parse_time(value, "from", request.has_from, request.from, error_message)) {
+                return false;
+            }
+        } else if (key == "to") {
+            duplicate = request.has_to;
+            if (!duplicate && !parse_time(value, "to", request.has_to, request.to, error_message)) {
+                return false;
+            }
+        } else if (key == "by") {
+            duplicate = has_group_by;
+            has_group_by = true;
+            if (value == "level") {
+                request.group_by = RollupRequest::GroupBy::Level;
+            } else if (value == "source") {
+                request.group_by = RollupRequest::GroupBy::Source;
+            } else {
+                set_error(error_message, "by must be level or source.");
+                return false;
+            }
+        } else if (key == "source" && equals != std::string_view::npos) {
+            duplicate = !request.source.empty();
+            if (value.empty()) {
+                set_error(error_message, "Invalid source parameter.");
+                return false;
+            }
+            request.source.assign(value.data(), value.size());
+        } else if (key == "level") {
+            duplicate = request.has_level;
+            request.has_level = true;
+            if (!parse_level(value, request.level, error_message)) {
+                return false;
+            }
+        } else {
+            set_error(error_message, "Unknown rollup parameter.");
+            return false;
+        }
+        if (duplicate) {
+            set_error(error_message, "Duplicate " + std::string(key) + " parameter.");
+            return false;
+        }
+    }
+
+    if (request.has_from && request.has_to && request.from > request.to) {
+        set_error(error_message, "from must not be after to.");
+        return false;
+    }
+    return true;
+}
+
+bool parse_fetch_arguments(std::string_view arguments, FetchRequest &request, std::string &error_message) {
+    request = FetchRequest{};
+    error_message.clear();
+
+    std::pmr::vector<std::string_view> tokens;
+    tokenize(arguments, tokens);
+    bool has_from = false;
+    bool has_max = false;
+    bool has_wait = false;
+    for (const std::string_view token : tokens) {
+        const std::size_t equals = token.find('=');
+        const std::string_view key = token.substr(0, equals);
+        const std::string_view value = equals == std::string_view::npos ? std::string_view() : token.substr(equals + 1);
+        bool duplicate = false;
+        unsigned long long parsed = 0;
+        if (key == "from_seq") {
+            duplicate = has_from;
+            has_from = true;
+            if (!parse_number(value, key, 0, ULLONG_MAX, parsed, error_message)) {
+                return false;
+            }
+            request.from = parsed;
+        } else if (key == "max") {
+            duplicate = has_max;
+            has_max = true;
+            if (!parse_count(value, key, FetchRequest::kMaxRecords, request.max, error_message)) {
+                return false;
+            }
+        } else if (key == "wait_ms") {
+            duplicate = has_wait;
+            has_wait = true;
+            if (!parse_number(value, key, 0, FetchRequest::kMaxWaitMs, parsed, error_message)) {
+                return false;
+            }
+            request.wait_ms = static_cast<std::size_t>(parsed);
+        } else {
+            set_error(error_message, "Unknown fetch parameter.");
+            return false;
+        }
+        if (duplicate) {
+            set_error(error_message, "Duplicate " + std::string(key) + " parameter.");
+            return false;
+        }
+    }
+
+    if (!has_from) {
+        set_error(error_message, "FETCH requires from_seq=<n>.");
+        return false;
+    }
+    return true;
+}
+
 } // namespace logcrafter::cpp
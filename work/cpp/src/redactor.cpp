@@ -0,0 +1,859 @@
+/*
+ * Sequence: SEQ0342
+ * Track: C++
+ * MVP: Step D
+ * Change: Compile redaction rules into one byte-class DFA and mask matches in place.
+ * Tests: spec_redaction
+ */
+#include "redactor.hpp"
+
+#include <algorithm>
+#include <bitset>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <map>
+
+namespace logcrafter::cpp {
+
+namespace {
+
+constexpr std::string_view kWhitespace = " \t\r\n";
+constexpr std::size_t kRuleLineBytes = 1024;
+constexpr std::size_t kUnbounded = std::numeric_limits<std::size_t>::max();
+
+using ByteSet = std::bitset<256>;
+
+struct Node {
+    enum class Type {
+        Bytes,
+        Concat,
+        Alternate,
+        Repeat,
+    };
+
+    Type type = Type::Concat;
+    ByteSet bytes;
+    std::vector<Node> children;
+    std::size_t min = 0;
+    std::size_t max = 0;
+};
+
+Node byte_node(const ByteSet &bytes) {
+    Node node;
+    node.type = Node::Type::Bytes;
+    node.bytes = bytes;
+    return node;
+}
+
+ByteSet single(unsigned char ch) {
+    ByteSet bytes;
+    bytes.set(ch);
+    return bytes;
+}
+
+ByteSet range(unsigned char first, unsigned char last) {
+    ByteSet bytes;
+    for (unsigned ch = first; ch <= last; ++ch) {
+        bytes.set(ch);
+    }
+    return bytes;
+}
+
+unsigned char first_byte(const ByteSet &bytes) {
+    unsigned ch = 0;
+    while (ch < 255 && !bytes.test(ch)) {
+        ++ch;
+    }
+    return static_cast<unsigned char>(ch);
+}
+
+ByteSet word_bytes() { return range('a', 'z') | range('A', 'Z') | range('0', '9') | single('_'); }
+
+ByteSet space_bytes() {
+    return single(' ') | single('\t') | single('\n') | single('\r') | single('\f') | single('\v');
+}
+
+// Recursive descent over the supported subset; see Redactor in the header.
+class PatternParser {
+public:
+    explicit PatternParser(std::string_view pattern) : pattern_(pattern), position_(0) {}
+
+    bool parse(Node &out, std::string &error) {
+        out = alternation();
+        if (error_.empty() && position_ < pattern_.size()) {
+            error_ = "unbalanced ')'";
+        }
+        if (!error_.empty()) {
+            error = error_ + " at offset " + std::to_string(position_);
+            return false;
+        }
+        return true;
+    }
+
+private:
+    bool done() const { return position_ >= pattern_.size() || !error_.empty(); }
+    char peek() const { return pattern_[position_]; }
+
+    Node alternation() {
+        Node first = concatenation();
+        if (done() || peek() != '|') {
+            return first;
+        }
+        Node node;
+        node.type = Node::Type::Alternate;
+        node.children.push_back(std::move(first));
+        while (!done() && peek() == '|') {
+            ++position_;
+            node.children.push_back(concatenation());
+        }
+        return node;
+    }
+
+    Node concatenation() {
+        Node node;
+        node.type = Node::Type::Concat;
+        while (!done() && peek() != '|' && peek() != ')') {
+            node.children.push_back(repetition());
+        }
+        return node;
+    }
+
+    Node repetition() {
+        Node atom_node = atom();
+        while (!done()) {
+            std::size_t min = 0;
+            std::size_t max = kUnbounded;
+            const char ch = peek();
+            if (ch == '*') {
+                ++position_;
+            } else if (ch == '+') {
+                ++position_;
+                min = 1;
+            } else if (ch == '?') {
+                ++position_;
+                max = 1;
+            } else if (ch == '{') {
+                if (!bounds(min, max)) {
+                    return atom_node;
+                }
+            } else {
+                break;
+            }
+            if (!done() && (peek() == '?' || peek() == '+')) {
+                error_ = "lazy and possessive quantifiers are not supported";
+                return atom_node;
+            }
+            Node node;
+            node.type = Node::Type::Repeat;
+            node.min = min;
+            node.max = max;
+            node.children.push_back(std::move(atom_node));
+            atom_node = std::move(node);
+        }
+        return atom_node;
+    }
+
+    bool bounds(std::size_t &min, std::size_t &max) {
+        ++position_;
+        if (!number(min)) {
+            return false;
+        }
+        max = min;
+        if (!done() && peek() == ',') {
+            ++position_;
+            max = kUnbounded;
+            if (!done() && peek() != '}' && !number(max)) {
+                return false;
+            }
+        }
+        if (done() || peek() != '}') {
+            error_ = "expected '}'";
+            return false;
+        }
+        ++position_;
+        if (min > Redactor::kMaxRepeat || (max != kUnbounded && (max > Redactor::kMaxRepeat || max < min))) {
+            error_ = "repeat bounds must satisfy n <= m <= " + std::to_string(Redactor::kMaxRepeat);
+            return false;
+        }
+        return true;
+    }
+
+    bool number(std::size_t &out) {
+        const std::size_t start = position_;
+        out = 0;
+        while (position_ < pattern_.size() && pattern_[position_] >= '0' && pattern_[position_] <= '9' &&
+               position_ - start < 4) {
+            out = out * 10 + static_cast<std::size_t>(pattern_[position_] - '0');
+            ++position_;
+        }
+        if (position_ == start) {
+            error_ = "expected a repeat count";
+            return false;
+        }
+        return true;
+    }
+
+    Node atom() {
+        const char ch = peek();
+        switch (ch) {
+        case '(': {
+            ++position_;
+            if (pattern_.substr(position_, 2) == "?:") {
+                position_ += 2;
+            } else if (!done() && peek() == '?') {
+                error_ = "only (?: ) groups are supported";
+                return Node();
+            }
+            Node inner = alternation();
+            if (done() || peek() != ')') {
+                if (error_.empty()) {
+                    error_ = "missing ')'";
+                }
+                return inner;
+            }
+            ++position_;
+            return inner;
+        }
+        case '[':
+            return byte_node(bracket());
+        case '.':
+            ++position_;
+            return byte_node(ByteSet().set());
+        case '\\':
+            return byte_node(escape(false));
+        case '^':
+        case '$':
+            error_ = "anchors are not supported";
+            return Node();
+        case '*':
+        case '+':
+        case '?':
+        case '{':
+            error_ = "nothing to repeat";
+            return Node();
+        default:
+            ++position_;
+            return byte_node(single(static_cast<unsigned char>(ch)));
+        }
+    }
+
+    ByteSet escape(bool in_bracket) {
+        ++position_;
+        if (position_ >= pattern_.size()) {
+            error_ = "trailing '\\'";
+            return ByteSet();
+        }
+        const char ch = pattern_[position_++];
+        switch (ch) {
+        case 'd':
+            return range('0', '9');
+        case 'D':
+            return ~range('0', '9');
+        case 'w':
+            return word_bytes();
+        case 'W':
+            return ~word_bytes();
+        case 's':
+            return space_bytes();
+        case 'S':
+            return ~space_bytes();
+        case 't':
+            return single('\t');
+        case 'n':
+            return single('\n');
+        case 'r':
+            return single('\r');
+        case 'b':
+        case 'B':
+            if (!in_bracket) {
+                error_ = "anchors are not supported";
+            } else {
+                error_ = "unknown escape '\\" + std::string(1, ch) + "'";
+            }
+            return ByteSet();
+        default:
+            break;
+        }
+        if (ch >= '1' && ch <= '9') {
+            error_ = "backreferences are not supported";
+            return ByteSet();
+        }
+        if ((ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z') || (ch >= '0' && ch <= '9')) {
+            error_ = "unknown escape '\\" + std::string(1, ch) + "'";
+            return ByteSet();
+        }
+        return single(static_cast<unsigned char>(ch));
+    }
+
+    ByteSet bracket() {
+        ++position_;
+        bool negate = false;
+        if (position_ < pattern_.size() && pattern_[position_] == '^') {
+            negate = true;
+            ++position_;
+        }
+        ByteSet bytes;
+        bool first = true;
+        while (error_.empty()) {
+            if (position_ >= pattern_.size()) {
+                error_ = "missing ']'";
+                return bytes;
+            }
+            if (pattern_[position_] == ']' && !first) {
+                ++position_;
+                break;
+            }
+            first = false;
+            // A class escape such as \d cannot start a range.
+            if (pattern_[position_] == '\\') {
+                const ByteSet escaped = escape(true);
+                if (escaped.count() != 1 || position_ + 1 >= pattern_.size() || pattern_[position_] != '-' ||
+                    pattern_[position_ + 1] == ']') {
+                    bytes |= escaped;
+                    continue;
+                }
+                ++position_;
+                bytes |= span(first_byte(escaped));
+                continue;
+            }
+            const unsigned char low = static_cast<unsigned char>(pattern_[position_++]);
+            if (position_ + 1 < pattern_.size() && pattern_[position_] == '-' && pattern_[position_ + 1] != ']') {
+                ++position_;
+                bytes |= span(low);
+            } else {
+                bytes.set(low);
+            }
+        }
+        return negate ? ~bytes : bytes;
+    }
+
+    // The rest of a range whose low end and '-' have been read.
+    ByteSet span(unsigned char low) {
+        unsigned char high = static_cast<unsigned char>(pattern_[position_]);
+        if (high == '\\') {
+            const ByteSet escaped = escape(true);
+            if (escaped.count() != 1) {
+                error_ = "a range must end in a single character";
+                return ByteSet();
+            }
+            high = first_byte(escaped);
+        } else {
+            ++position_;
+        }
+        if (high < low) {
+            error_ = "range out of order";
+            return ByteSet();
+        }
+        return range(low, high);
+    }
+
+    std::string_view pattern_;
+    std::size_t position_;
+    std::string error_;
+};
+
+bool parse_rule_pattern(const RedactionRule &rule, Node &out, std::string &error) {
+    if (rule.pattern.empty()) {
+        error = "pattern is empty";
+        return false;
+    }
+    if (rule.kind == RedactionRule::Kind::Literal) {
+        out = Node();
+        for (const char ch : rule.pattern) {
+            out.children.push_back(byte_node(single(static_cast<unsigned char>(ch))));
+        }
+        return true;
+    }
+    return PatternParser(rule.pattern).parse(out, error);
+}
+
+bool nullable(const Node &node) {
+    switch (node.type) {
+    case Node::Type::Bytes:
+        return false;
+    case Node::Type::Concat:
+        return std::all_of(node.children.begin(), node.children.end(), nullable);
+    case Node::Type::Alternate:
+        return std::any_of(node.children.begin(), node.children.end(), nullable);
+    case Node::Type::Repeat:
+        return node.min == 0 || nullable(node.children.front());
+    }
+    return false;
+}
+
+// Longest byte string that every match of `node` contains.
+std::string required_literal(const Node &node) {
+    const auto single_byte = [](const Node &candidate) {
+        return candidate.type == Node::Type::Bytes && candidate.bytes.count() == 1;
+    };
+    switch (node.type) {
+    case Node::Type::Bytes:
+        return single_byte(node) ? std::string(1, static_cast<char>(first_byte(node.bytes))) : std::string();
+    case Node::Type::Alternate:
+        return std::string();
+    case Node::Type::Repeat:
+        return node.min == 0 ? std::string() : required_literal(node.children.front());
+    case Node::Type::Concat:
+        break;
+    }
+    std::string best;
+    std::string run;
+    for (const Node &child : node.children) {
+        if (single_byte(child)) {
+            run.push_back(static_cast<char>(first_byte(child.bytes)));
+            continue;
+        }
+        if (child.type == Node::Type::Repeat && child.min > 0 && single_byte(child.children.front())) {
+            // x{2,5} continues a run with "xx" but ends it unless the count is exact.
+            run.append(child.min, static_cast<char>(first_byte(child.children.front().bytes)));
+            if (child.max == child.min) {
+                continue;
+            }
+        } else {
+            const std::string inner = required_literal(child);
+            if (inner.size() > best.size()) {
+                best = inner;
+            }
+        }
+        if (run.size() > best.size()) {
+            best = run;
+        }
+        run.clear();
+    }
+    return run.size() > best.size() ? run : best;
+}
+
+// Thompson NFA, built back to front so every fragment knows its successor.
+class NfaBuilder {
+public:
+    struct State {
+        // Index into sets, or -1 for an epsilon-only state.
+        int set = -1;
+        int next = -1;
+        std::vector<int> epsilon;
+        int accept = -1;
+    };
+
+    int add(State state) {
+        if (states.size() >= Redactor::kMaxNfaStates) {
+            too_large = true;
+            return 0;
+        }
+        states.push_back(std::move(state));
+        return static_cast<int>(states.size()) - 1;
+    }
+
+    int compile(const Node &node, int next) {
+        if (too_large) {
+            return next;
+        }
+        switch (node.type) {
+        case Node::Type::Bytes: {
+            State state;
+            state.set = set_index(node.bytes);
+            state.next = next;
+            return add(std::move(state));
+        }
+        case Node::Type::Concat:
+            for (auto child = node.children.rbegin(); child != node.children.rend(); ++child) {
+                next = compile(*child, next);
+            }
+            return next;
+        case Node::Type::Alternate: {
+            State state;
+            for (const Node &child : node.children) {
+                state.epsilon.push_back(compile(child, next));
+            }
+            return add(std::move(state));
+        }
+        case Node::Type::Repeat:
+            break;
+        }
+        const Node &body = node.children.front();
+        int entry = next;
+        if (node.max == kUnbounded) {
+            const int loop = add(State());
+            const int start = compile(body, loop);
+            if (too_large) {
+                return next;
+            }
+            states[loop].epsilon = {start, next};
+            entry = loop;
+        } else {
+            for (std::size_t n = node.min; n < node.max; ++n) {
+                State optional;
+                optional.epsilon = {compile(body, entry), next};
+                entry = add(std::move(optional));
+            }
+        }
+        for (std::size_t n = 0; n < node.min; ++n) {
+            entry = compile(body, entry);
+        }
+        return entry;
+    }
+
+    int set_index(const ByteSet &bytes) {
+        const auto found = std::find(sets.begin(), sets.end(), bytes);
+        if (found != sets.end()) {
+            return static_cast<int>(found - sets.begin());
+        }
+        sets.push_back(bytes);
+        return static_cast<int>(sets.size()) - 1;
+    }
+
+    // The states reachable from `seeds` through epsilon moves that consume a byte or accept,
+    // sorted so equal closures compare equal.
+    std::vector<int> closure(std::vector<int> seeds) {
+        std::vector<int> result;
+        ++visit_epoch_;
+        visited_.resize(states.size(), 0);
+        while (!seeds.empty()) {
+            const int index = seeds.back();
+            seeds.pop_back();
+            if (visited_[index] == visit_epoch_) {
+                continue;
+            }
+            visited_[index] = visit_epoch_;
+            const State &state = states[index];
+            if (state.set >= 0 || state.accept >= 0) {
+                result.push_back(index);
+            }
+            seeds.insert(seeds.end(), state.epsilon.begin(), state.epsilon.end());
+        }
+        std::sort(result.begin(), result.end());
+        return result;
+    }
+
+    std::vector<State> states;
+    std::vector<ByteSet> sets;
+    bool too_large = false;
+
+private:
+    std::vector<unsigned> visited_;
+    unsigned visit_epoch_ = 0;
+};
+
+struct Dfa {
+    // One row of next states per state, one column per byte class; -1 is the dead state.
+    std::vector<std::int32_t> transitions;
+    // Earliest rule accepting in each state, or -1.
+    std::vector<std::int32_t> accepting;
+};
+
+// Subset construction from NFA state 0. A search DFA re-enters state 0 after every byte, so it
+// follows matches starting anywhere; it stops at its first accepting state, so those get no
+// transitions.
+bool build_dfa(NfaBuilder &nfa, const std::vector<unsigned char> &representative, bool search, Dfa &out) {
+    const std::size_t class_count = representative.size();
+    std::map<std::vector<int>, std::int32_t> known;
+    std::vector<std::vector<int>> pending;
+    const auto intern = [&](std::vector<int> closure) -> std::int32_t {
+        const auto found = known.find(closure);
+        if (found != known.end()) {
+            return found->second;
+        }
+        const auto id = static_cast<std::int32_t>(out.accepting.size());
+        std::int32_t rule = -1;
+        for (const int index : closure) {
+            const int accept = nfa.states[index].accept;
+            if (accept >= 0 && (rule < 0 || accept < rule)) {
+                rule = accept;
+            }
+        }
+        out.accepting.push_back(rule);
+        out.transitions.resize(out.transitions.size() + class_count, -1);
+        known.emplace(closure, id);
+        pending.push_back(std::move(closure));
+        return id;
+    };
+    intern(nfa.closure({0}));
+    for (std::size_t state = 0; state < pending.size(); ++state) {
+        if (out.accepting.size() > Redactor::kMaxDfaStates) {
+            return false;
+        }
+        if (search && out.accepting[state] >= 0) {
+            continue;
+        }
+        for (std::size_t column = 0; column < class_count; ++column) {
+            std::vector<int> seeds;
+            for (const int index : pending[state]) {
+                const NfaBuilder::State &from = nfa.states[index];
+                if (from.set >= 0 && nfa.sets[from.set].test(representative[column])) {
+                    seeds.push_back(from.next);
+                }
+            }
+            if (search) {
+                seeds.push_back(0);
+            }
+            if (!seeds.empty()) {
+                const std::int32_t target = intern(nfa.closure(std::move(seeds)));
+                out.transitions[state * class_count + column] = target;
+            }
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+Redactor::Redactor()
+    : rules_(), byte_class_(), class_count_(0), transitions_(), accepting_(), search_transitions_(), starts_match_(),
+      required_literals_(), scan_every_line_(false), rule_matches_(), lines_(0), matches_(0) {}
+
+Redactor::~Redactor() = default;
+
+int Redactor::load(const std::string &path, std::string &error) {
+    reset();
+    error.clear();
+
+    std::FILE *file = std::fopen(path.c_str(), "r");
+    if (file == nullptr) {
+        error = path + ": " + std::strerror(errno);
+        return -1;
+    }
+    std::vector<RedactionRule> rules;
+    char line[kRuleLineBytes];
+    unsigned line_number = 0;
+    while (std::fgets(line, sizeof(line), file) != nullptr) {
+        ++line_number;
+        std::string_view text(line);
+        const std::size_t first = text.find_first_not_of(kWhitespace);
+        if (first == std::string_view::npos || text[first] == '#') {
+            continue;
+        }
+        const auto fail = [&](const std::string &reason) {
+            error = path + ":" + std::to_string(line_number) + ": " + reason;
+        };
+        if (text.back() != '\n' && !std::feof(file)) {
+            fail("line is longer than " + std::to_string(kRuleLineBytes - 2) + " bytes");
+            break;
+        }
+        while (!text.empty() && (text.back() == '\n' || text.back() == '\r')) {
+            text.remove_suffix(1);
+        }
+
+        const std::size_t name_end = text.find_first_of(kWhitespace, first);
+        const std::size_t value_start = text.find_first_not_of(kWhitespace, name_end);
+        RedactionRule rule;
+        rule.name.assign(text.substr(first, name_end - first));
+        const std::string_view value =
+            value_start == std::string_view::npos ? std::string_view() : text.substr(value_start);
+        if (value.rfind("literal=", 0) == 0) {
+            rule.kind = RedactionRule::Kind::Literal;
+            rule.pattern.assign(value.substr(8));
+        } else if (value.rfind("regex=", 0) == 0) {
+            rule.kind = RedactionRule::Kind::Regex;
+            rule.pattern.assign(value.substr(6));
+        } else {
+            fail("expected <name> literal=<text> or <name> regex=<pattern>");
+            break;
+        }
+        if (rule.name.find('=') != std::string::npos) {
+            fail("a rule starts with its name");
+            break;
+        }
+        const bool duplicate = std::any_of(rules.begin(), rules.end(),
+                                           [&rule](const RedactionRule &other) { return other.name == rule.name; });
+        if (duplicate) {
+            fail("duplicate rule name '" + rule.name + "'");
+            break;
+        }
+        // Checked here as well as in compile() so the error names the line.
+        Node parsed;
+        std::string reason;
+        if (!parse_rule_pattern(rule, parsed, reason)) {
+            fail(reason);
+            break;
+        }
+        rules.push_back(std::move(rule));
+    }
+    std::fclose(file);
+    if (!error.empty()) {
+        return -1;
+    }
+    if (!compile(std::move(rules), error)) {
+        error = path + ": " + error;
+        return -1;
+    }
+    return 0;
+}
+
+bool Redactor::compile(std::vector<RedactionRule> rules, std::string &error) {
+    reset();
+    if (rules.size() > kMaxRules) {
+        error = "at most " + std::to_string(kMaxRules) + " rules";
+        return false;
+    }
+
+    NfaBuilder nfa;
+    NfaBuilder::State start;
+    nfa.states.push_back(start);
+    std::vector<std::string> literals;
+    bool scan_every_line = false;
+    for (std::size_t index = 0; index < rules.size(); ++index) {
+        const RedactionRule &rule = rules[index];
+        Node parsed;
+        std::string reason;
+        if (!parse_rule_pattern(rule, parsed, reason)) {
+            error = "rule '" + rule.name + "': " + reason;
+            return false;
+        }
+        if (nullable(parsed)) {
+            error = "rule '" + rule.name + "': pattern matches the empty string";
+            return false;
+        }
+        NfaBuilder::State accept;
+        accept.accept = static_cast<int>(index);
+        const int entry = nfa.compile(parsed, nfa.add(std::move(accept)));
+        if (nfa.too_large) {
+            error = "rules need more than " + std::to_string(kMaxNfaStates) + " NFA states";
+            return false;
+        }
+        nfa.states[0].epsilon.push_back(entry);
+
+        std::string literal = required_literal(parsed);
+        if (literal.empty()) {
+            scan_every_line = true;
+        } else if (std::find(literals.begin(), literals.end(), literal) == literals.end()) {
+            literals.push_back(std::move(literal));
+        }
+    }
+
+    // Bytes that no pattern tells apart share a class, so a DFA row has one column per class.
+    std::array<std::uint16_t, 256> byte_class{};
+    std::size_t class_count = 1;
+    for (const ByteSet &set : nfa.sets) {
+        std::map<std::pair<std::uint16_t, bool>, std::uint16_t> split;
+        for (unsigned ch = 0; ch < 256; ++ch) {
+            const auto key = std::make_pair(byte_class[ch], set.test(ch));
+            const auto inserted = split.emplace(key, static_cast<std::uint16_t>(split.size()));
+            byte_class[ch] = inserted.first->second;
+        }
+        class_count = split.size();
+    }
+    std::vector<unsigned char> representative(class_count);
+    for (unsigned ch = 256; ch-- > 0;) {
+        representative[byte_class[ch]] = static_cast<unsigned char>(ch);
+    }
+
+    Dfa matcher;
+    Dfa searcher;
+    if (!build_dfa(nfa, representative, false, matcher) || !build_dfa(nfa, representative, true, searcher)) {
+        error = "rules need more than " + std::to_string(kMaxDfaStates) + " automaton states";
+        return false;
+    }
+
+    rules_ = std::move(rules);
+    byte_class_ = byte_class;
+    class_count_ = class_count;
+    transitions_ = std::move(matcher.transitions);
+    accepting_ = std::move(matcher.accepting);
+    // Row offsets instead of state numbers, and -1 once any match has ended: one load per byte.
+    search_transitions_.resize(searcher.transitions.size());
+    for (std::size_t cell = 0; cell < searcher.transitions.size(); ++cell) {
+        const std::int32_t target = searcher.transitions[cell];
+        search_transitions_[cell] =
+            searcher.accepting[target] >= 0 ? -1 : static_cast<std::int32_t>(target * class_count);
+    }
+    for (unsigned ch = 0; ch < 256; ++ch) {
+        starts_match_[ch] = transitions_[byte_class_[ch]] >= 0;
+    }
+    required_literals_ = std::move(literals);
+    scan_every_line_ = scan_every_line;
+    rule_matches_ = std::make_unique<std::atomic<unsigned long>[]>(rules_.size());
+    for (std::size_t index = 0; index < rules_.size(); ++index) {
+        rule_matches_[index].store(0, std::memory_order_relaxed);
+    }
+    return true;
+}
+
+void Redactor::reset() {
+    rules_.clear();
+    byte_class_.fill(0);
+    class_count_ = 0;
+    transitions_.clear();
+    accepting_.clear();
+    search_transitions_.clear();
+    starts_match_.fill(false);
+    required_literals_.clear();
+    scan_every_line_ = false;
+    rule_matches_.reset();
+    lines_.store(0, std::memory_order_relaxed);
+    matches_.store(0, std::memory_order_relaxed);
+}
+
+bool Redactor::worth_scanning(std::string_view line) const {
+    if (!scan_every_line_ &&
+        std::none_of(required_literals_.begin(), required_literals_.end(),
+                     [line](const std::string &literal) { return line.find(literal) != std::string_view::npos; })) {
+        return false;
+    }
+    std::int32_t row = 0;
+    for (const char ch : line) {
+        row = search_transitions_[static_cast<std::size_t>(row) + byte_class_[static_cast<unsigned char>(ch)]];
+        if (row < 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::size_t Redactor::longest_match(const unsigned char *data, std::size_t length, std::size_t start,
+                                    int &rule) const {
+    std::size_t best = 0;
+    std::int32_t state = 0;
+    for (std::size_t position = start; position < length; ++position) {
+        state = transitions_[static_cast<std::size_t>(state) * class_count_ + byte_class_[data[position]]];
+        if (state < 0) {
+            break;
+        }
+        if (accepting_[state] >= 0) {
+            best = position - start + 1;
+            rule = accepting_[state];
+        }
+    }
+    return best;
+}
+
+std::size_t Redactor::redact(char *data, std::size_t length) {
+    if (rules_.empty() || !worth_scanning(std::string_view(data, length))) {
+        return 0;
+    }
+    const auto *bytes = reinterpret_cast<const unsigned char *>(data);
+    std::size_t found = 0;
+    std::size_t position = 0;
+    while (position < length) {
+        if (!starts_match_[bytes[position]]) {
+            ++position;
+            continue;
+        }
+        int rule = -1;
+        const std::size_t matched = longest_match(bytes, length, position, rule);
+        if (matched == 0) {
+            ++position;
+            continue;
+        }
+        std::memset(data + position, kMask, matched);
+        rule_matches_[rule].fetch_add(1, std::memory_order_relaxed);
+        ++found;
+        position += matched;
+    }
+    if (found > 0) {
+        lines_.fetch_add(1, std::memory_order_relaxed);
+        matches_.fetch_add(found, std::memory_order_relaxed);
+    }
+    return found;
+}
+
+RedactionStats Redactor::stats() const {
+    RedactionStats result{rules_.size(), lines_.load(std::memory_order_relaxed),
+                          matches_.load(std::memory_order_relaxed), {}};
+    for (std::size_t index = 0; index < rules_.size(); ++index) {
+        result.per_rule.emplace_back(rules_[index].name, rule_matches_[index].load(std::memory_order_relaxed));
+    }
+    return result;
+}
+
+} // namespace logcrafter::cpp
@@ -0,0 +1,77 @@
+/*
+ * Sequence: SEQ0322
+ * Track: C++
+ * MVP: Step D
+ * Change: Implement the LRU compiled-regex cache with hit, miss, and compile-time-saved counters.
+ * Tests: spec_prepared_query
+ */
+#include "regex_cache.hpp"
+
+#include <chrono>
+
+namespace logcrafter::cpp {
+
+namespace {
+
+std::string make_key(std::string_view pattern, std::regex_constants::syntax_option_type flags) {
+    std::string key = std::to_string(static_cast<unsigned long>(flags));
+    key.push_back(':');
+    key.append(pattern.data(), pattern.size());
+    return key;
+}
+
+// Counters are only written under mutex_, so a plain load/store pair is enough.
+void bump(std::atomic<unsigned long long> &counter, unsigned long long by) {
+    counter.store(counter.load(std::memory_order_relaxed) + by, std::memory_order_relaxed);
+}
+
+} // namespace
+
+RegexCache &RegexCache::instance() {
+    static RegexCache cache;
+    return cache;
+}
+
+std::shared_ptr<const std::regex> RegexCache::get(std::string_view pattern,
+                                                  std::regex_constants::syntax_option_type flags) {
+    std::string key = make_key(pattern, flags);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        const auto found = index_.find(key);
+        if (found != index_.end()) {
+            entries_.splice(entries_.begin(), entries_, found->second);
+            bump(hits_, 1);
+            bump(compile_micros_saved_, found->second->compile_micros);
+            return found->second->regex;
+        }
+        bump(misses_, 1);
+    }
+
+    // Compiled outside the lock; two threads missing on the same pattern both compile it and
+    // the second insert is dropped.
+    const auto started = std::chrono::steady_clock::now();
+    auto regex = std::make_shared<const std::regex>(pattern.begin(), pattern.end(), flags);
+    const auto compile_micros = static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - started).count());
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (index_.find(key) != index_.end()) {
+        return regex;
+    }
+    entries_.push_front(Entry{std::move(key), regex, compile_micros});
+    index_.emplace(entries_.front().key, entries_.begin());
+    if (entries_.size() > kCapacity) {
+        index_.erase(entries_.back().key);
+        entries_.pop_back();
+    }
+    entry_count_.store(entries_.size(), std::memory_order_relaxed);
+    return regex;
+}
+
+RegexCacheStats RegexCache::stats() const {
+    return RegexCacheStats{entry_count_.load(std::memory_order_relaxed), hits_.load(std::memory_order_relaxed),
+                           misses_.load(std::memory_order_relaxed),
+                           compile_micros_saved_.load(std::memory_order_relaxed)};
+}
+
+} // namespace logcrafter::cpp
@@ -0,0 +1,156 @@
+/*
+ * Sequence: SEQ0197
+ * Track: C++
+ * MVP: Step D
+ * Change: Encode and decode relay records, frame headers, and zlib payloads.
+ * Tests: spec_relay_forwarding
+ */
+#include "relay_codec.hpp"
+
+#include <algorithm>
+
+#ifdef LOGCRAFTER_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+namespace logcrafter::cpp::relay_codec {
+
+namespace {
+
+// Payloads smaller than this rarely shrink enough to pay for the deflate call.
+constexpr std::size_t kMinCompressBytes = 256;
+
+void put_u32(std::uint32_t value, char *out) {
+    for (int i = 3; i >= 0; --i) {
+        out[i] = static_cast<char>(value & 0xFFu);
+        value >>= 8;
+    }
+}
+
+std::uint32_t get_u32(const char *in) {
+    std::uint32_t value = 0;
+    for (int i = 0; i < 4; ++i) {
+        value = (value << 8) | static_cast<unsigned char>(in[i]);
+    }
+    return value;
+}
+
+} // namespace
+
+void encode_u64(std::uint64_t value, char *out) {
+    for (int i = 7; i >= 0; --i) {
+        out[i] = static_cast<char>(value & 0xFFu);
+        value >>= 8;
+    }
+}
+
+std::uint64_t decode_u64(const char *in) {
+    std::uint64_t value = 0;
+    for (int i = 0; i < 8; ++i) {
+        value = (value << 8) | static_cast<unsigned char>(in[i]);
+    }
+    return value;
+}
+
+void append_record(std::string &out, std::time_t timestamp, std::string_view stream, std::string_view message) {
+    const std::size_t stream_length = std::min<std::size_t>(stream.size(), 255);
+    char header[kRecordHeaderBytes];
+    encode_u64(static_cast<std::uint64_t>(static_cast<std::int64_t>(timestamp)), header);
+    header[8] = static_cast<char>(stream_length);
+    put_u32(static_cast<std::uint32_t>(message.size()), header + 9);
+    out.append(header, sizeof(header));
+    out.append(stream.data(), stream_length);
+    out.append(message.data(), message.size());
+}
+
+std::size_t record_size(const char *header) {
+    return kRecordHeaderBytes + static_cast<unsigned char>(header[8]) + get_u32(header + 9);
+}
+
+bool next_record(std::string_view payload, std::size_t &offset, Record &record) {
+    if (payload.size() - offset < kRecordHeaderBytes) {
+        return false;
+    }
+    const char *header = payload.data() + offset;
+    const std::size_t total = record_size(header);
+    if (payload.size() - offset < total) {
+        return false;
+    }
+    const std::size_t stream_length = static_cast<unsigned char>(header[8]);
+    record.timestamp = static_cast<std::time_t>(static_cast<std::int64_t>(decode_u64(header)));
+    record.stream = payload.substr(offset + kRecordHeaderBytes, stream_length);
+    record.message = payload.substr(offset + kRecordHeaderBytes + stream_length, total - kRecordHeaderBytes - stream_length);
+    offset += total;
+    return true;
+}
+
+void encode_frame_header(const FrameHeader &header, char *out) {
+    put_u32(header.length, out);
+    out[4] = static_cast<char>(header.flags);
+    encode_u64(header.sequence, out + 5);
+}
+
+FrameHeader decode_frame_header(const char *in) {
+    FrameHeader header{};
+    header.length = get_u32(in);
+    header.flags = static_cast<std::uint8_t>(in[4]);
+    header.sequence = decode_u64(in + 5);
+    return header;
+}
+
+bool compression_available() {
+#ifdef LOGCRAFTER_HAVE_ZLIB
+    return true;
+#else
+    return false;
+#endif
+}
+
+void compress_payload(std::string_view raw, std::string &out) {
+    out.clear();
+#ifdef LOGCRAFTER_HAVE_ZLIB
+    if (raw.size() < kMinCompressBytes) {
+        return;
+    }
+    uLongf bound = compressBound(static_cast<uLong>(raw.size()));
+    out.resize(4 + bound);
+    put_u32(static_cast<std::uint32_t>(raw.size()), &out[0]);
+    // Level 1: catch-up after an outage is bounded by deflate speed, not by ratio.
+    if (compress2(reinterpret_cast<Bytef *>(&out[4]), &bound, reinterpret_cast<const Bytef *>(raw.data()),
+                  static_cast<uLong>(raw.size()), 1) != Z_OK ||
+        4 + bound >= raw.size()) {
+        out.clear();
+        return;
+    }
+    out.resize(4 + bound);
+#else
+    (void)raw;
+#endif
+}
+
+bool decompress_payload(std::string_view compressed, std::string &out) {
+#ifdef LOGCRAFTER_HAVE_ZLIB
+    if (compressed.size() < 4) {
+        return false;
+    }
+    const std::uint32_t raw_size = get_u32(compressed.data());
+    if (raw_size > kMaxPayloadBytes) {
+        return false;
+    }
+    out.resize(raw_size);
+    uLongf produced = raw_size;
+    if (uncompress(reinterpret_cast<Bytef *>(out.data()), &produced,
+                   reinterpret_cast<const Bytef *>(compressed.data() + 4),
+                   static_cast<uLong>(compressed.size() - 4)) != Z_OK ||
+        produced != raw_size) {
+        return false;
+    }
+    return true;
+#else
+    (void)compressed;
+    out.clear();
+    return false;
+#endif
+}
+
+} // namespace logcrafter::cpp::relay_codec
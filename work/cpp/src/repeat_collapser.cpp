@@ -0,0 +1,112 @@
+/*
+ * Sequence: SEQ0188
+ * Track: C++
+ * MVP: Step D
+ * Change: Collapse consecutive exact or number-masked repeats within a window into a single summary line.
+ * Tests: spec_repeat_collapsing
+ */
+#include "repeat_collapser.hpp"
+
+namespace logcrafter::cpp {
+
+RepeatCollapser::RepeatCollapser()
+    : mode_(RepeatMode::Off),
+      window_ms_(kDefaultWindowMs),
+      active_(false),
+      key_(),
+      last_message_(),
+      last_timestamp_(0),
+      route_(0),
+      started_ms_(0),
+      repeats_(0),
+      scratch_() {}
+
+void RepeatCollapser::configure(RepeatMode mode, std::int64_t window_ms) {
+    mode_ = mode;
+    window_ms_ = window_ms > 0 ? window_ms : kDefaultWindowMs;
+    active_ = false;
+    repeats_ = 0;
+}
+
+bool RepeatCollapser::absorb(std::string_view message, std::time_t timestamp, std::size_t route,
+                             std::int64_t now_ms) {
+    if (mode_ == RepeatMode::Off || !active_ || route != route_ || now_ms - started_ms_ > window_ms_) {
+        return false;
+    }
+    if (mode_ == RepeatMode::Exact) {
+        if (message != key_) {
+            return false;
+        }
+    } else {
+        make_key(message, scratch_);
+        if (scratch_ != key_) {
+            return false;
+        }
+        last_message_.assign(message.data(), message.size());
+    }
+    last_timestamp_ = timestamp;
+    ++repeats_;
+    return true;
+}
+
+bool RepeatCollapser::restart(std::string_view message, std::size_t route, std::int64_t now_ms,
+                              RepeatSummary &summary) {
+    const bool summarised = take_summary(summary);
+    if (mode_ == RepeatMode::Off) {
+        return summarised;
+    }
+    make_key(message, key_);
+    if (mode_ == RepeatMode::Masked) {
+        last_message_.assign(message.data(), message.size());
+    }
+    route_ = route;
+    started_ms_ = now_ms;
+    repeats_ = 0;
+    active_ = true;
+    return summarised;
+}
+
+bool RepeatCollapser::finish(RepeatSummary &summary) {
+    const bool summarised = take_summary(summary);
+    active_ = false;
+    return summarised;
+}
+
+bool RepeatCollapser::take_summary(RepeatSummary &summary) {
+    if (!active_ || repeats_ == 0) {
+        return false;
+    }
+    // In exact mode the key is the line itself.
+    const std::string &line = mode_ == RepeatMode::Exact ? key_ : last_message_;
+    summary.message = line;
+    summary.message += " (repeated ";
+    summary.message += std::to_string(repeats_);
+    summary.message += repeats_ == 1 ? " time)" : " times)";
+    summary.timestamp = last_timestamp_;
+    summary.route = route_;
+    summary.repeats = repeats_;
+    repeats_ = 0;
+    return true;
+}
+
+void RepeatCollapser::make_key(std::string_view message, std::string &key) const {
+    if (mode_ != RepeatMode::Masked) {
+        key.assign(message.data(), message.size());
+        return;
+    }
+    key.clear();
+    bool in_number = false;
+    for (const char ch : message) {
+        if (ch >= '0' && ch <= '9') {
+            if (!in_number) {
+                key.push_back('#');
+                in_number = true;
+            }
+            continue;
+        }
+        in_number = false;
+        key.push_back(ch);
+    }
+}
+
+} // namespace logcrafter::cpp
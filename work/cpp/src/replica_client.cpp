@@ -0,0 +1,295 @@
+/*
+ * Sequence: SEQ0223
+ * Track: C++
+ * MVP: Step D
+ * Change: Follow a primary's replication log, apply entries in sequence order, and resume from the saved position after reconnects and restarts.
+ * Tests: spec_replication
+ */
+#include "replica_client.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "net_io.hpp"
+#include "relay_codec.hpp"
+
+namespace logcrafter::cpp {
+
+namespace {
+
+constexpr int kConnectTimeoutMs = 2000;
+// Several missed heartbeats before a silent primary is treated as gone.
+constexpr int kReadTimeoutSeconds = 5;
+constexpr std::size_t kMaxLineBytes = 1024;
+constexpr int kInitialBackoffMs = 50;
+constexpr int kMaxBackoffMs = 1000;
+
+// "REPLICATION <epoch> <first sequence>"
+bool parse_replication_reply(const std::string &line, std::uint64_t &epoch, std::uint64_t &start) {
+    unsigned long long parsed_epoch = 0;
+    unsigned long long parsed_start = 0;
+    char trailing = 0;
+    if (std::sscanf(line.c_str(), "REPLICATION %llu %llu %c", &parsed_epoch, &parsed_start, &trailing) != 2 ||
+        parsed_start == 0) {
+        return false;
+    }
+    epoch = parsed_epoch;
+    start = parsed_start;
+    return true;
+}
+
+} // namespace
+
+ReplicaClient::ReplicaClient()
+    : config_(),
+      apply_(),
+      stop_(false),
+      running_(false),
+      primary_fd_(-1),
+      epoch_(0),
+      next_sequence_(0),
+      connected_(false),
+      applied_sequence_(0),
+      primary_head_(0),
+      applied_records_(0),
+      gaps_(0),
+      reconnects_(0) {}
+
+ReplicaClient::~ReplicaClient() { shutdown(); }
+
+int ReplicaClient::init(const ReplicaConfig &config, ApplyCallback apply) {
+    shutdown();
+
+    config_ = config;
+    if (config_.primary_host.empty() || config_.primary_port <= 0 || config_.primary_port > 65535 || !apply) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (config_.name.empty()) {
+        config_.name = "replica";
+    }
+    apply_ = std::move(apply);
+    if (!load_state()) {
+        epoch_ = 0;
+        next_sequence_ = 0;
+    }
+    connected_.store(false, std::memory_order_relaxed);
+    applied_sequence_.store(next_sequence_ > 0 ? next_sequence_ - 1 : 0, std::memory_order_relaxed);
+    primary_head_.store(0, std::memory_order_relaxed);
+    applied_records_.store(0, std::memory_order_relaxed);
+    gaps_.store(0, std::memory_order_relaxed);
+    reconnects_.store(0, std::memory_order_relaxed);
+    stop_ = false;
+
+    try {
+        worker_ = std::thread(&ReplicaClient::run, this);
+    } catch (...) {
+        return -1;
+    }
+    running_ = true;
+    return 0;
+}
+
+void ReplicaClient::shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+        if (primary_fd_ >= 0) {
+            ::shutdown(primary_fd_, SHUT_RDWR);
+        }
+    }
+    condition_.notify_all();
+    if (worker_.joinable()) {
+        worker_.join();
+    }
+    disconnect_primary();
+    std::lock_guard<std::mutex> lock(mutex_);
+    running_ = false;
+    stop_ = false;
+}
+
+ReplicaStats ReplicaClient::stats() const {
+    return ReplicaStats{connected_.load(std::memory_order_relaxed),
+                        applied_sequence_.load(std::memory_order_relaxed),
+                        primary_head_.load(std::memory_order_relaxed),
+                        applied_records_.load(std::memory_order_relaxed),
+                        gaps_.load(std::memory_order_relaxed),
+                        reconnects_.load(std::memory_order_relaxed)};
+}
+
+bool ReplicaClient::load_state() {
+    if (config_.state_path.empty()) {
+        return false;
+    }
+    std::FILE *file = std::fopen(config_.state_path.c_str(), "r");
+    if (file == nullptr) {
+        return false;
+    }
+    unsigned long long epoch = 0;
+    unsigned long long next_sequence = 0;
+    const int fields = std::fscanf(file, "%llu %llu", &epoch, &next_sequence);
+    std::fclose(file);
+    if (fields != 2 || next_sequence == 0) {
+        return false;
+    }
+    epoch_ = epoch;
+    next_sequence_ = next_sequence;
+    return true;
+}
+
+bool ReplicaClient::save_state() const {
+    if (config_.state_path.empty()) {
+        return true;
+    }
+    const std::string temporary = config_.state_path + ".tmp";
+    std::FILE *file = std::fopen(temporary.c_str(), "w");
+    if (file == nullptr) {
+        return false;
+    }
+    const int written = std::fprintf(file, "%llu %llu\n", static_cast<unsigned long long>(epoch_),
+                                     static_cast<unsigned long long>(next_sequence_));
+    const bool closed = std::fclose(file) == 0;
+    return written > 0 && closed && std::rename(temporary.c_str(), config_.state_path.c_str()) == 0;
+}
+
+void ReplicaClient::run() {
+    bool ever_connected = false;
+    int delay_ms = kInitialBackoffMs;
+    while (true) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (stop_) {
+                break;
+            }
+        }
+        if (primary_fd_ < 0) {
+            if (!connect_primary()) {
+                disconnect_primary();
+                backoff(delay_ms);
+                continue;
+            }
+            if (ever_connected) {
+                reconnects_.fetch_add(1, std::memory_order_relaxed);
+            }
+            ever_connected = true;
+            delay_ms = kInitialBackoffMs;
+        }
+        if (!apply_frame()) {
+            disconnect_primary();
+            backoff(delay_ms);
+        }
+    }
+    disconnect_primary();
+}
+
+bool ReplicaClient::connect_primary() {
+    const int fd = net_io::connect_tcp(config_.primary_host, config_.primary_port, kConnectTimeoutMs,
+                                       kReadTimeoutSeconds);
+    if (fd < 0) {
+        return false;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        primary_fd_ = fd;
+        if (stop_) {
+            ::shutdown(fd, SHUT_RDWR);
+        }
+    }
+
+    // Skip the log port's welcome line, then ask for the log from the next wanted sequence.
+    std::string line;
+    const std::string hello = "REPLICATE " + config_.name + " " + std::to_string(epoch_) + " " +
+                              std::to_string(next_sequence_) + "\n";
+    if (!net_io::recv_line(fd, line, kMaxLineBytes) || !net_io::send_text(fd, hello) ||
+        !net_io::recv_line(fd, line, kMaxLineBytes)) {
+        return false;
+    }
+    std::uint64_t epoch = 0;
+    std::uint64_t start = 0;
+    if (!parse_replication_reply(line, epoch, start)) {
+        std::cerr << "[lc][warn] Primary refused replication: " << line << std::endl;
+        return false;
+    }
+    if (epoch != epoch_) {
+        if (epoch_ != 0) {
+            std::cerr << "[lc][warn] Primary replication log changed; following it from sequence " << start
+                      << std::endl;
+        }
+        epoch_ = epoch;
+    } else if (start > next_sequence_) {
+        gaps_.fetch_add(static_cast<unsigned long>(start - next_sequence_), std::memory_order_relaxed);
+    }
+    next_sequence_ = start;
+    connected_.store(true, std::memory_order_relaxed);
+    return true;
+}
+
+void ReplicaClient::disconnect_primary() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (primary_fd_ >= 0) {
+        ::close(primary_fd_);
+        primary_fd_ = -1;
+    }
+    connected_.store(false, std::memory_order_relaxed);
+}
+
+bool ReplicaClient::apply_frame() {
+    char header[relay_codec::kFrameHeaderBytes];
+    if (!net_io::recv_exact(primary_fd_, header, sizeof(header))) {
+        return false;
+    }
+    const relay_codec::FrameHeader frame = relay_codec::decode_frame_header(header);
+    if (frame.length < relay_codec::kAckBytes || frame.length > relay_codec::kMaxPayloadBytes) {
+        std::cerr << "[lc][warn] Primary sent a malformed replication frame" << std::endl;
+        return false;
+    }
+    payload_.resize(frame.length);
+    if (!net_io::recv_exact(primary_fd_, &payload_[0], payload_.size())) {
+        return false;
+    }
+
+    // The primary skipped ahead only if retention removed what this replica still needed.
+    std::uint64_t sequence = frame.sequence;
+    if (sequence > next_sequence_) {
+        gaps_.fetch_add(static_cast<unsigned long>(sequence - next_sequence_), std::memory_order_relaxed);
+        next_sequence_ = sequence;
+    }
+    const std::string_view records(payload_.data() + relay_codec::kAckBytes, payload_.size() - relay_codec::kAckBytes);
+    std::size_t offset = 0;
+    unsigned long applied = 0;
+    relay_codec::Record record{};
+    while (relay_codec::next_record(records, offset, record)) {
+        if (sequence++ >= next_sequence_) {
+            apply_(record.stream, std::string(record.message), record.timestamp);
+            ++applied;
+        }
+    }
+    if (offset != records.size()) {
+        std::cerr << "[lc][warn] Primary sent a truncated replication frame" << std::endl;
+        return false;
+    }
+    next_sequence_ = std::max(next_sequence_, sequence);
+    applied_records_.fetch_add(applied, std::memory_order_relaxed);
+    applied_sequence_.store(next_sequence_ - 1, std::memory_order_relaxed);
+    primary_head_.store(relay_codec::decode_u64(payload_.data()), std::memory_order_relaxed);
+    if (applied > 0 && !save_state()) {
+        std::cerr << "[lc][warn] Failed to save the replica position" << std::endl;
+    }
+
+    char ack[relay_codec::kAckBytes];
+    relay_codec::encode_u64(next_sequence_, ack);
+    return net_io::send_text(primary_fd_, std::string_view(ack, sizeof(ack)));
+}
+
+void ReplicaClient::backoff(int &delay_ms) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    condition_.wait_for(lock, std::chrono::milliseconds(delay_ms), [this]() { return stop_; });
+    delay_ms = std::min(delay_ms * 2, kMaxBackoffMs);
+}
+
+} // namespace logcrafter::cpp
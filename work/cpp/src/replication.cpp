@@ -0,0 +1,751 @@
+/*
+ * Sequence: SEQ0312
+ * Track: C++
+ * MVP: Step D
+ * Change: Serve FETCH from the in-memory tail or the segments, resuming where the previous fetch stopped.
+ * Tests: spec_fetch, spec_replication
+ */
+#include "replication.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include "net_io.hpp"
+#include "relay_codec.hpp"
+#include "response_writer.hpp"
+
+namespace logcrafter::cpp {
+
+namespace {
+
+constexpr const char *kEpochFileName = "epoch";
+constexpr const char *kSegmentPrefix = "segment-";
+constexpr const char *kSegmentSuffix = ".log";
+constexpr std::size_t kMaxBatchBytes = 1024 * 1024;
+constexpr std::size_t kReadChunk = 256 * 1024;
+constexpr int kSendTimeoutSeconds = 5;
+constexpr int kIdleWaitMs = 100;
+
+bool ensure_directory(const std::string &directory) {
+    struct stat st {};
+    if (stat(directory.c_str(), &st) == 0) {
+        return S_ISDIR(st.st_mode);
+    }
+    if (errno != ENOENT) {
+        return false;
+    }
+    return mkdir(directory.c_str(), 0775) == 0;
+}
+
+// First sequences of the segments in the log directory, oldest first.
+std::vector<std::uint64_t> collect_segments(const std::string &directory) {
+    std::vector<std::uint64_t> segments;
+    DIR *dir = opendir(directory.c_str());
+    if (dir == nullptr) {
+        return segments;
+    }
+    const std::size_t prefix_length = std::strlen(kSegmentPrefix);
+    const std::size_t suffix_length = std::strlen(kSegmentSuffix);
+    struct dirent *entry = nullptr;
+    while ((entry = readdir(dir)) != nullptr) {
+        const std::string name = entry->d_name;
+        if (name.size() <= prefix_length + suffix_length || name.compare(0, prefix_length, kSegmentPrefix) != 0 ||
+            name.compare(name.size() - suffix_length, suffix_length, kSegmentSuffix) != 0) {
+            continue;
+        }
+        const std::string digits = name.substr(prefix_length, name.size() - prefix_length - suffix_length);
+        if (digits.find_first_not_of("0123456789") != std::string::npos) {
+            continue;
+        }
+        segments.push_back(std::stoull(digits));
+    }
+    closedir(dir);
+    std::sort(segments.begin(), segments.end());
+    return segments;
+}
+
+std::uint64_t make_epoch() {
+    const auto now = std::chrono::system_clock::now().time_since_epoch();
+    return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(now).count()) ^
+           (static_cast<std::uint64_t>(::getpid()) << 48);
+}
+
+// Counts up to `max_records` whole records at the start of `chunk`; `consumed` is their size.
+std::size_t walk_records(std::string_view chunk, std::size_t max_records, std::size_t &consumed) {
+    std::size_t records = 0;
+    consumed = 0;
+    relay_codec::Record record{};
+    while (records < max_records && relay_codec::next_record(chunk, consumed, record)) {
+        ++records;
+    }
+    return records;
+}
+
+// Complete records in a segment file and their total size; a torn tail is left uncounted.
+std::uint64_t count_records(const std::string &path, std::uint64_t &complete_bytes) {
+    complete_bytes = 0;
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return 0;
+    }
+    std::string chunk(kReadChunk, '\0');
+    std::uint64_t records = 0;
+    while (true) {
+        const ssize_t got = ::pread(fd, &chunk[0], chunk.size(), static_cast<off_t>(complete_bytes));
+        if (got <= 0) {
+            break;
+        }
+        std::size_t consumed = 0;
+        const std::size_t found =
+            walk_records(std::string_view(chunk.data(), static_cast<std::size_t>(got)), SIZE_MAX, consumed);
+        if (found == 0) {
+            break;
+        }
+        records += found;
+        complete_bytes += consumed;
+    }
+    ::close(fd);
+    return records;
+}
+
+} // namespace
+
+ReplicationSource::ReplicationSource()
+    : config_(),
+      epoch_(0),
+      stop_(false),
+      running_(false),
+      published_offset_(0),
+      next_sequence_(1),
+      published_head_(0),
+      published_oldest_(0),
+      write_file_(nullptr),
+      write_offset_(0),
+      tail_first_(1),
+      resume_(),
+      resume_next_(0),
+      fetched_memory_(0),
+      fetched_disk_(0),
+      replica_slots_(),
+      log_failures_(0) {}
+
+ReplicationSource::~ReplicationSource() { shutdown(); }
+
+int ReplicationSource::init(const ReplicationConfig &config) {
+    shutdown();
+
+    config_ = config;
+    if (config_.directory.empty()) {
+        config_.directory = kDefaultDirectory;
+    }
+    if (config_.retain_segments == 0) {
+        config_.retain_segments = kDefaultRetainSegments;
+    }
+    if (config_.batch_records == 0) {
+        config_.batch_records = kDefaultBatchRecords;
+    }
+    if (config_.tail_entries == 0) {
+        config_.tail_entries = kDefaultTailEntries;
+    }
+    if (!ensure_directory(config_.directory) || !recover() || !open_write_segment()) {
+        return -1;
+    }
+    log_failures_.store(0, std::memory_order_relaxed);
+    fetched_memory_.store(0, std::memory_order_relaxed);
+    fetched_disk_.store(0, std::memory_order_relaxed);
+    stop_ = false;
+
+    try {
+        writer_ = std::thread(&ReplicationSource::write_loop, this);
+    } catch (...) {
+        std::fclose(write_file_);
+        write_file_ = nullptr;
+        return -1;
+    }
+    running_ = true;
+    return 0;
+}
+
+bool ReplicationSource::recover() {
+    const std::string epoch_path = config_.directory + "/" + kEpochFileName;
+    unsigned long long epoch = 0;
+    if (std::FILE *file = std::fopen(epoch_path.c_str(), "r")) {
+        if (std::fscanf(file, "%llu", &epoch) != 1) {
+            epoch = 0;
+        }
+        std::fclose(file);
+    }
+    if (epoch == 0) {
+        epoch = make_epoch();
+        std::FILE *file = std::fopen(epoch_path.c_str(), "w");
+        if (file == nullptr) {
+            return false;
+        }
+        const bool written = std::fprintf(file, "%llu\n", epoch) > 0;
+        if (std::fclose(file) != 0 || !written) {
+            return false;
+        }
+    }
+    epoch_ = epoch;
+
+    // Sequences continue after the last whole record; appends always go to a fresh segment.
+    std::vector<std::uint64_t> segments = collect_segments(config_.directory);
+    std::uint64_t next_sequence = 1;
+    while (!segments.empty()) {
+        const std::string path = segment_path(segments.back());
+        std::uint64_t complete_bytes = 0;
+        const std::uint64_t records = count_records(path, complete_bytes);
+        if (records > 0) {
+            if (::truncate(path.c_str(), static_cast<off_t>(complete_bytes)) != 0) {
+                return false;
+            }
+            next_sequence = segments.back() + records;
+            break;
+        }
+        ::unlink(path.c_str());
+        next_sequence = segments.back();
+        segments.pop_back();
+    }
+
+    {
+        // The tail starts empty; FETCH reads anything older from the recovered segments.
+        std::lock_guard<std::mutex> lock(fetch_mutex_);
+        tail_.clear();
+        tail_first_ = next_sequence;
+        resume_.fill(Cursor{0, 0, 0, -1});
+        resume_next_ = 0;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    segments_.assign(segments.begin(), segments.end());
+    segments_.push_back(next_sequence);
+    while (segments_.size() > config_.retain_segments + 1) {
+        ::unlink(segment_path(segments_.front()).c_str());
+        segments_.pop_front();
+    }
+    next_sequence_ = next_sequence;
+    publish_range_locked();
+    published_offset_ = 0;
+    write_offset_ = 0;
+    return true;
+}
+
+void ReplicationSource::shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    write_condition_.notify_all();
+    publish_condition_.notify_all();
+    if (writer_.joinable()) {
+        writer_.join();
+    }
+    {
+        std::lock_guard<std::mutex> lock(replicas_mutex_);
+        for (const std::unique_ptr<Replica> &replica : replicas_) {
+            ::shutdown(replica->fd, SHUT_RDWR);
+        }
+        for (const std::unique_ptr<Replica> &replica : replicas_) {
+            if (replica->thread.joinable()) {
+                replica->thread.join();
+            }
+        }
+        replicas_.clear();
+    }
+
+    if (write_file_ != nullptr) {
+        std::fclose(write_file_);
+        write_file_ = nullptr;
+    }
+    {
+        std::lock_guard<std::mutex> lock(fetch_mutex_);
+        tail_.clear();
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    queue_.clear();
+    segments_.clear();
+    publish_range_locked();
+    running_ = false;
+    stop_ = false;
+}
+
+bool ReplicationSource::enqueue(std::string_view stream, const std::string &message, std::time_t timestamp) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!running_ || stop_) {
+        return false;
+    }
+    queue_.push_back(Entry{timestamp, std::string(stream), message});
+    write_condition_.notify_one();
+    return true;
+}
+
+ReplicationStats ReplicationSource::stats() const {
+    // Lock-free like the rest of STATS: the writer or a sender may be holding mutex_ across
+    // disk I/O. A slot reused while it is read can show its new name with its old ack.
+    ReplicationStats stats{};
+    stats.head = published_head_.load(std::memory_order_relaxed);
+    stats.oldest = published_oldest_.load(std::memory_order_relaxed);
+    stats.log_failures = log_failures_.load(std::memory_order_relaxed);
+    stats.fetched_memory = fetched_memory_.load(std::memory_order_relaxed);
+    stats.fetched_disk = fetched_disk_.load(std::memory_order_relaxed);
+    for (const ReplicaSlot &slot : replica_slots_) {
+        if (!slot.live.load(std::memory_order_acquire)) {
+            continue;
+        }
+        ReplicaStatus status{std::string(), slot.acked.load(std::memory_order_relaxed)};
+        if (slot.name.read(status.name)) {
+            stats.replicas.push_back(std::move(status));
+        }
+    }
+    return stats;
+}
+
+void ReplicationSource::publish_range_locked() {
+    const std::uint64_t head = next_sequence_ - 1;
+    published_head_.store(head, std::memory_order_relaxed);
+    published_oldest_.store(segments_.empty() ? 0 : std::min(segments_.front(), head), std::memory_order_relaxed);
+}
+
+std::uint64_t ReplicationSource::head() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return next_sequence_ - 1;
+}
+
+bool ReplicationSource::fetch(std::uint64_t from, std::size_t max_records, FetchBatch &batch) {
+    batch.payload.clear();
+    batch.records = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!running_ || segments_.empty()) {
+            return false;
+        }
+        from = std::min(std::max(from, segments_.front()), next_sequence_);
+        batch.head = next_sequence_ - 1;
+    }
+    batch.first = from;
+    batch.next = from;
+    if (from > batch.head || max_records == 0) {
+        return true;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(fetch_mutex_);
+        if (from >= tail_first_ && from - tail_first_ < tail_.size()) {
+            const std::size_t begin = static_cast<std::size_t>(from - tail_first_);
+            const std::size_t end = std::min(tail_.size(), begin + max_records);
+            for (std::size_t i = begin; i < end; ++i) {
+                relay_codec::append_record(batch.payload, tail_[i].timestamp, tail_[i].stream, tail_[i].message);
+            }
+            batch.records = end - begin;
+        }
+    }
+    if (batch.records > 0) {
+        batch.next = from + batch.records;
+        fetched_memory_.fetch_add(batch.records, std::memory_order_relaxed);
+        return true;
+    }
+
+    // Behind the tail: read the segments, from where an earlier fetch stopped if one did, so a
+    // consumer catching up batch by batch does not walk its segment from the start each time.
+    Cursor cursor{0, 0, 0, -1};
+    if (!resume(cursor, from)) {
+        seek(cursor, from);
+    }
+    ReadResult result = ReadResult::Ok;
+    while (true) {
+        batch.first = cursor.next_sequence;
+        result = read_batch(cursor, max_records, batch.payload, batch.records);
+        if (result != ReadResult::Behind) {
+            break;
+        }
+        // Retention removed the segment meanwhile; continue from the oldest one left.
+        batch.payload.clear();
+        batch.records = 0;
+        seek(cursor, from);
+    }
+    if (cursor.fd >= 0) {
+        ::close(cursor.fd);
+        cursor.fd = -1;
+    }
+    if (result == ReadResult::Failed) {
+        return false;
+    }
+    batch.next = cursor.next_sequence;
+    remember(cursor);
+    fetched_disk_.fetch_add(batch.records, std::memory_order_relaxed);
+    return true;
+}
+
+bool ReplicationSource::resume(Cursor &cursor, std::uint64_t sequence) const {
+    std::lock_guard<std::mutex> lock(fetch_mutex_);
+    for (const Cursor &position : resume_) {
+        if (position.next_sequence == sequence && sequence != 0) {
+            cursor = position;
+            return true;
+        }
+    }
+    return false;
+}
+
+void ReplicationSource::remember(const Cursor &cursor) {
+    std::lock_guard<std::mutex> lock(fetch_mutex_);
+    Cursor *slot = &resume_[resume_next_];
+    for (Cursor &position : resume_) {
+        if (position.next_sequence == cursor.next_sequence) {
+            slot = &position;
+            break;
+        }
+    }
+    if (slot == &resume_[resume_next_]) {
+        resume_next_ = (resume_next_ + 1) % kResumePositions;
+    }
+    *slot = Cursor{cursor.segment, cursor.offset, cursor.next_sequence, -1};
+}
+
+std::string ReplicationSource::segment_path(std::uint64_t first_sequence) const {
+    char name[48];
+    std::snprintf(name, sizeof(name), "%s%020llu%s", kSegmentPrefix, static_cast<unsigned long long>(first_sequence),
+                  kSegmentSuffix);
+    return config_.directory + "/" + name;
+}
+
+bool ReplicationSource::open_write_segment() {
+    std::uint64_t segment = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        segment = segments_.back();
+    }
+    write_file_ = std::fopen(segment_path(segment).c_str(), "ab");
+    return write_file_ != nullptr;
+}
+
+void ReplicationSource::write_loop() {
+    std::deque<Entry> batch;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            write_condition_.wait(lock, [this]() { return stop_ || !queue_.empty(); });
+            if (queue_.empty()) {
+                break;
+            }
+            batch.swap(queue_);
+        }
+
+        encode_scratch_.clear();
+        for (const Entry &entry : batch) {
+            relay_codec::append_record(encode_scratch_, entry.timestamp, entry.stream, entry.message);
+        }
+        if (write_file_ == nullptr) {
+            open_write_segment();
+        }
+        const bool written = write_file_ != nullptr &&
+                             std::fwrite(encode_scratch_.data(), 1, encode_scratch_.size(), write_file_) ==
+                                 encode_scratch_.size() &&
+                             std::fflush(write_file_) == 0;
+        if (written) {
+            write_offset_ += encode_scratch_.size();
+        } else {
+            // Sequence numbers must not skip, so the batch is dropped whole: cut any partial
+            // write back off the segment and keep appending where it ended.
+            log_failures_.fetch_add(batch.size(), std::memory_order_relaxed);
+            if (write_file_ != nullptr) {
+                std::fclose(write_file_);
+                write_file_ = nullptr;
+            }
+            std::uint64_t segment = 0;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                segment = segments_.back();
+            }
+            ::truncate(segment_path(segment).c_str(), static_cast<off_t>(write_offset_));
+        }
+
+        if (written) {
+            // Filled before the batch is published, so FETCH finds every published entry here
+            // until it ages out.
+            std::lock_guard<std::mutex> lock(fetch_mutex_);
+            for (Entry &entry : batch) {
+                tail_.push_back(std::move(entry));
+            }
+            while (tail_.size() > config_.tail_entries) {
+                tail_.pop_front();
+                ++tail_first_;
+            }
+        }
+
+        const bool roll = written && write_offset_ >= kSegmentBytes;
+        if (roll && write_file_ != nullptr) {
+            std::fclose(write_file_);
+            write_file_ = nullptr;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (written) {
+                next_sequence_ += batch.size();
+            }
+            published_offset_ = write_offset_;
+            if (roll) {
+                segments_.push_back(next_sequence_);
+                published_offset_ = 0;
+                while (segments_.size() > config_.retain_segments + 1) {
+                    // Readers holding the file open finish it; others see it as gone.
+                    ::unlink(segment_path(segments_.front()).c_str());
+                    segments_.pop_front();
+                }
+            }
+            publish_range_locked();
+        }
+        if (roll) {
+            write_offset_ = 0;
+            open_write_segment();
+        }
+        batch.clear();
+        publish_condition_.notify_all();
+        if (publish_hook_) {
+            publish_hook_();
+        }
+    }
+}
+
+void ReplicationSource::seek(Cursor &cursor, std::uint64_t sequence) const {
+    std::string skipped;
+    while (true) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            sequence = std::min(std::max(sequence, segments_.front()), next_sequence_);
+            const auto segment = std::upper_bound(segments_.begin(), segments_.end(), sequence);
+            cursor.segment = *(segment - 1);
+        }
+        if (cursor.fd >= 0) {
+            ::close(cursor.fd);
+            cursor.fd = -1;
+        }
+        cursor.offset = 0;
+        cursor.next_sequence = cursor.segment;
+
+        ReadResult result = ReadResult::Ok;
+        while (result == ReadResult::Ok && cursor.next_sequence < sequence) {
+            std::size_t records = 0;
+            skipped.clear();
+            result = read_batch(cursor, static_cast<std::size_t>(sequence - cursor.next_sequence), skipped, records);
+            if (records == 0) {
+                break;
+            }
+        }
+        if (result != ReadResult::Behind) {
+            return;
+        }
+    }
+}
+
+ReplicationSource::ReadResult ReplicationSource::read_batch(Cursor &cursor, std::size_t max_records,
+                                                            std::string &payload, std::size_t &records) const {
+    std::string chunk;
+    while (records < max_records && payload.size() < kMaxBatchBytes) {
+        bool sealed = false;
+        std::uint64_t end = 0;
+        std::uint64_t following = 0;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            const auto segment = std::lower_bound(segments_.begin(), segments_.end(), cursor.segment);
+            if (segment == segments_.end() || *segment != cursor.segment) {
+                return ReadResult::Behind;
+            }
+            sealed = segment + 1 != segments_.end();
+            following = sealed ? *(segment + 1) : 0;
+            end = published_offset_;
+        }
+
+        if (cursor.fd < 0) {
+            cursor.fd = ::open(segment_path(cursor.segment).c_str(), O_RDONLY | O_CLOEXEC);
+            if (cursor.fd < 0) {
+                return sealed ? ReadResult::Behind : ReadResult::Failed;
+            }
+        }
+        if (sealed) {
+            struct stat st {};
+            if (::fstat(cursor.fd, &st) != 0) {
+                return ReadResult::Failed;
+            }
+            end = static_cast<std::uint64_t>(st.st_size);
+        }
+
+        std::size_t found = 0;
+        std::size_t consumed = 0;
+        if (cursor.offset < end) {
+            chunk.resize(static_cast<std::size_t>(std::min<std::uint64_t>(end - cursor.offset, kReadChunk)));
+            const ssize_t got = ::pread(cursor.fd, &chunk[0], chunk.size(), static_cast<off_t>(cursor.offset));
+            if (got < 0) {
+                return ReadResult::Failed;
+            }
+            found = walk_records(std::string_view(chunk.data(), static_cast<std::size_t>(got)), max_records - records,
+                                 consumed);
+        }
+        if (found == 0) {
+            if (!sealed) {
+                break;
+            }
+            // Finished segment: continue with the next one.
+            ::close(cursor.fd);
+            cursor.fd = -1;
+            cursor.segment = following;
+            cursor.offset = 0;
+            cursor.next_sequence = following;
+            continue;
+        }
+        payload.append(chunk.data(), consumed);
+        cursor.offset += consumed;
+        cursor.next_sequence += found;
+        records += found;
+    }
+    return ReadResult::Ok;
+}
+
+bool ReplicationSource::attach(int fd, const std::string &name, std::uint64_t epoch, std::uint64_t next_sequence) {
+    std::lock_guard<std::mutex> lock(replicas_mutex_);
+    for (auto replica = replicas_.begin(); replica != replicas_.end();) {
+        if ((*replica)->finished.load(std::memory_order_acquire)) {
+            (*replica)->thread.join();
+            replica = replicas_.erase(replica);
+        } else {
+            ++replica;
+        }
+    }
+    bool accepting = false;
+    {
+        std::lock_guard<std::mutex> state_lock(mutex_);
+        accepting = running_ && !stop_;
+    }
+    if (!accepting || replicas_.size() >= kMaxReplicas) {
+        ::close(fd);
+        return false;
+    }
+    // Fewer than kMaxReplicas are attached, so some slot is not held by any of them.
+    ReplicaSlot *free_slot = nullptr;
+    for (ReplicaSlot &candidate : replica_slots_) {
+        const bool held = std::any_of(replicas_.begin(), replicas_.end(),
+                                      [&candidate](const std::unique_ptr<Replica> &held_by) {
+                                          return held_by->slot == &candidate;
+                                      });
+        if (!held) {
+            free_slot = &candidate;
+            break;
+        }
+    }
+
+    struct timeval timeout {};
+    timeout.tv_sec = kSendTimeoutSeconds;
+    ::setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+    ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    const int nodelay = 1;
+    ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
+
+    auto replica = std::make_unique<Replica>();
+    replica->name = name;
+    replica->fd = fd;
+    replica->finished.store(false, std::memory_order_relaxed);
+    replica->slot = free_slot;
+    free_slot->name.publish(name);
+    free_slot->acked.store(0, std::memory_order_relaxed);
+    free_slot->live.store(true, std::memory_order_release);
+    Replica &slot = *replica;
+    try {
+        slot.thread = std::thread(&ReplicationSource::serve, this, std::ref(slot), epoch, next_sequence);
+    } catch (...) {
+        free_slot->live.store(false, std::memory_order_release);
+        ::close(fd);
+        return false;
+    }
+    replicas_.push_back(std::move(replica));
+    return true;
+}
+
+void ReplicationSource::serve(Replica &replica, std::uint64_t epoch, std::uint64_t next_sequence) {
+    // A replica of another log (or a fresh one) starts from the oldest retained entry.
+    Cursor cursor{0, 0, 0, -1};
+    seek(cursor, epoch == epoch_ ? next_sequence : 0);
+    replica.slot->acked.store(cursor.next_sequence - 1, std::memory_order_relaxed);
+    const std::string hello =
+        "REPLICATION " + std::to_string(epoch_) + " " + std::to_string(cursor.next_sequence) + "\n";
+    bool healthy = net_io::send_text(replica.fd, hello);
+
+    // Payload: u64 newest logged sequence | records starting at the frame's sequence.
+    std::string payload;
+    auto last_frame = std::chrono::steady_clock::now();
+    while (healthy) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (stop_) {
+                break;
+            }
+        }
+
+        payload.assign(relay_codec::kAckBytes, '\0');
+        std::size_t records = 0;
+        const ReadResult result = read_batch(cursor, config_.batch_records, payload, records);
+        if (result == ReadResult::Behind) {
+            seek(cursor, 0);
+            continue;
+        }
+        if (result == ReadResult::Failed) {
+            break;
+        }
+
+        const auto now = std::chrono::steady_clock::now();
+        if (records > 0 || now - last_frame >= std::chrono::milliseconds(kHeartbeatMs)) {
+            std::uint64_t head = 0;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                head = next_sequence_ - 1;
+            }
+            relay_codec::encode_u64(head, &payload[0]);
+            char header[relay_codec::kFrameHeaderBytes];
+            relay_codec::encode_frame_header(
+                relay_codec::FrameHeader{static_cast<std::uint32_t>(payload.size()), 0, cursor.next_sequence - records},
+                header);
+            ResponseWriter writer(replica.fd);
+            writer.append(std::string_view(header, sizeof(header)));
+            writer.append(payload);
+            healthy = writer.finish();
+            last_frame = now;
+        }
+
+        // Acks arrive while the next frames go out; a closed replica shows up here too.
+        struct pollfd incoming {
+            replica.fd, POLLIN, 0
+        };
+        while (healthy && ::poll(&incoming, 1, 0) == 1) {
+            char ack[relay_codec::kAckBytes];
+            healthy = net_io::recv_exact(replica.fd, ack, sizeof(ack));
+            if (healthy) {
+                replica.slot->acked.store(relay_codec::decode_u64(ack) - 1, std::memory_order_relaxed);
+            }
+        }
+
+        if (healthy && records == 0) {
+            std::unique_lock<std::mutex> lock(mutex_);
+            publish_condition_.wait_for(lock, std::chrono::milliseconds(kIdleWaitMs), [this, &cursor]() {
+                return stop_ || next_sequence_ > cursor.next_sequence;
+            });
+        }
+    }
+
+    if (cursor.fd >= 0) {
+        ::close(cursor.fd);
+    }
+    ::close(replica.fd);
+    replica.slot->live.store(false, std::memory_order_release);
+    replica.finished.store(true, std::memory_order_release);
+}
+
+} // namespace logcrafter::cpp
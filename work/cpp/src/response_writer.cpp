@@ -0,0 +1,83 @@
+/*
+ * Sequence: SEQ0167
+ * Track: C++
+ * MVP: Step D
+ * Change: Write batched query output with sendmsg, resuming partial writes across iovec boundaries.
+ * Tests: spec_protocol_happy_path, spec_large_query_response, logcrafter_cpp_bench_query_send (manual)
+ */
+#include "response_writer.hpp"
+
+#include <cerrno>
+#include <cstdio>
+#include <sys/socket.h>
+
+namespace logcrafter::cpp {
+
+namespace {
+
+char newline[] = "\n";
+
+} // namespace
+
+ResponseWriter::ResponseWriter(int fd)
+    : fd_(fd), segments_(), segment_count_(0), pending_bytes_(0), bytes_sent_(0), failed_(false) {}
+
+void ResponseWriter::append(std::string_view text) {
+    if (text.empty() || failed_) {
+        return;
+    }
+    if (segment_count_ == kMaxSegments) {
+        flush(true);
+    }
+    segments_[segment_count_].iov_base = const_cast<char *>(text.data());
+    segments_[segment_count_].iov_len = text.size();
+    ++segment_count_;
+    pending_bytes_ += text.size();
+    if (pending_bytes_ >= kMaxBatchBytes) {
+        flush(true);
+    }
+}
+
+void ResponseWriter::append_line(std::string_view line) {
+    append(line);
+    append(std::string_view(newline, 1));
+}
+
+bool ResponseWriter::finish() {
+    flush(false);
+    return !failed_;
+}
+
+void ResponseWriter::flush(bool more) {
+    std::size_t first = 0;
+    while (!failed_ && first < segment_count_) {
+        msghdr message{};
+        message.msg_iov = segments_ + first;
+        message.msg_iovlen = segment_count_ - first;
+        const ssize_t sent = ::sendmsg(fd_, &message, more ? MSG_MORE : 0);
+        if (sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            std::perror("sendmsg");
+            failed_ = true;
+            break;
+        }
+
+        // Skip fully written segments and trim the one the kernel stopped in.
+        std::size_t remaining = static_cast<std::size_t>(sent);
+        bytes_sent_ += remaining;
+        while (first < segment_count_ && remaining >= segments_[first].iov_len) {
+            remaining -= segments_[first].iov_len;
+            ++first;
+        }
+        if (remaining > 0) {
+            segments_[first].iov_base = static_cast<char *>(segments_[first].iov_base) + remaining;
+            segments_[first].iov_len -= remaining;
+        }
+    }
+    segment_count_ = 0;
+    pending_bytes_ = 0;
+}
+
+} // namespace logcrafter::cpp
@@ -0,0 +1,155 @@
+/*
+ * Sequence: SEQ0306
+ * Track: C++
+ * MVP: Step D
+ * Change: Mark NDJSON context records with "context":true.
+ * Tests: spec_query_context, spec_binary_query
+ */
+#include "result_codec.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+
+#include "relay_codec.hpp"
+
+namespace logcrafter::cpp::result_codec {
+
+namespace {
+
+void put_u32(std::uint32_t value, char *out) {
+    for (int i = 3; i >= 0; --i) {
+        out[i] = static_cast<char>(value & 0xFFu);
+        value >>= 8;
+    }
+}
+
+std::uint32_t get_u32(const char *in) {
+    std::uint32_t value = 0;
+    for (int i = 0; i < 4; ++i) {
+        value = (value << 8) | static_cast<unsigned char>(in[i]);
+    }
+    return value;
+}
+
+bool contains_ignore_case(std::string_view haystack, std::string_view word) {
+    return std::search(haystack.begin(), haystack.end(), word.begin(), word.end(), [](char lhs, char rhs) {
+               return std::tolower(static_cast<unsigned char>(lhs)) == rhs;
+           }) != haystack.end();
+}
+
+template <typename Integer>
+void append_integer(std::pmr::string &out, Integer value) {
+    char digits[24];
+    const auto result = std::to_chars(digits, digits + sizeof(digits), value);
+    out.append(digits, static_cast<std::size_t>(result.ptr - digits));
+}
+
+void append_json_string(std::pmr::string &out, std::string_view text) {
+    static constexpr char kHex[] = "0123456789abcdef";
+    out.push_back('"');
+    std::size_t plain = 0;
+    for (std::size_t i = 0; i < text.size(); ++i) {
+        const unsigned char ch = static_cast<unsigned char>(text[i]);
+        if (ch >= 0x20 && ch != '"' && ch != '\\') {
+            continue;
+        }
+        out.append(text.data() + plain, i - plain);
+        plain = i + 1;
+        if (ch == '"' || ch == '\\') {
+            out.push_back('\\');
+            out.push_back(static_cast<char>(ch));
+        } else if (ch == '\t') {
+            out.append("\\t", 2);
+        } else if (ch == '\r') {
+            out.append("\\r", 2);
+        } else {
+            const char escaped[] = {'\\', 'u', '0', '0', kHex[ch >> 4], kHex[ch & 0x0F]};
+            out.append(escaped, sizeof(escaped));
+        }
+    }
+    out.append(text.data() + plain, text.size() - plain);
+    out.push_back('"');
+}
+
+} // namespace
+
+Level classify_level(std::string_view message) {
+    if (contains_ignore_case(message, "error")) {
+        return Level::Error;
+    }
+    if (contains_ignore_case(message, "warn")) {
+        return Level::Warning;
+    }
+    if (contains_ignore_case(message, "info")) {
+        return Level::Info;
+    }
+    if (contains_ignore_case(message, "debug")) {
+        return Level::Debug;
+    }
+    return Level::Unknown;
+}
+
+std::string_view level_name(Level level) {
+    switch (level) {
+    case Level::Debug:
+        return "debug";
+    case Level::Info:
+        return "info";
+    case Level::Warning:
+        return "warning";
+    case Level::Error:
+        return "error";
+    case Level::Unknown:
+        break;
+    }
+    return "unknown";
+}
+
+void encode_record_header(const Record &record, char *out) {
+    const std::size_t stream_length = std::min<std::size_t>(record.stream.size(), 255);
+    put_u32(static_cast<std::uint32_t>(kRecordHeaderBytes - 4 + stream_length + record.message.size()), out);
+    relay_codec::encode_u64(static_cast<std::uint64_t>(record.timestamp_ns), out + 4);
+    relay_codec::encode_u64(record.sequence, out + 12);
+    out[20] = static_cast<char>(record.level);
+    out[21] = static_cast<char>(stream_length);
+}
+
+bool next_record(std::string_view payload, std::size_t &offset, Record &record) {
+    if (offset > payload.size() || payload.size() - offset < kRecordHeaderBytes) {
+        return false;
+    }
+    const char *header = payload.data() + offset;
+    const std::size_t total = 4 + static_cast<std::size_t>(get_u32(header));
+    const std::size_t stream_length = static_cast<unsigned char>(header[21]);
+    if (total < kRecordHeaderBytes + stream_length || payload.size() - offset < total) {
+        return false;
+    }
+    record.timestamp_ns = static_cast<std::int64_t>(relay_codec::decode_u64(header + 4));
+    record.sequence = relay_codec::decode_u64(header + 12);
+    record.level = static_cast<Level>(static_cast<unsigned char>(header[20]));
+    record.stream = payload.substr(offset + kRecordHeaderBytes, stream_length);
+    record.message = payload.substr(offset + kRecordHeaderBytes + stream_length, total - kRecordHeaderBytes - stream_length);
+    record.context = false;
+    offset += total;
+    return true;
+}
+
+void append_ndjson(std::pmr::string &out, const Record &record) {
+    out.append("{\"ts_ns\":", 9);
+    append_integer(out, record.timestamp_ns);
+    out.append(",\"seq\":", 7);
+    append_integer(out, record.sequence);
+    out.append(",\"level\":\"", 10);
+    out.append(level_name(record.level));
+    out.append("\",\"stream\":", 11);
+    append_json_string(out, record.stream);
+    out.append(",\"message\":", 11);
+    append_json_string(out, record.message);
+    if (record.context) {
+        out.append(",\"context\":true", 15);
+    }
+    out.append("}\n", 2);
+}
+
+} // namespace logcrafter::cpp::result_codec
@@ -0,0 +1,90 @@
+/*
+ * Sequence: SEQ0208
+ * Track: C++
+ * MVP: Step D
+ * Change: Merge per-source result runs newest first with a heap and stop at the requested limit.
+ * Tests: spec_federated_query
+ */
+#include "result_merge.hpp"
+
+#include <algorithm>
+#include <queue>
+
+namespace logcrafter::cpp {
+
+namespace {
+
+// "[YYYY-MM-DD HH:MM:SS]"
+constexpr std::size_t kStampLength = 21;
+
+std::string_view stamp_of(std::string_view line) {
+    if (line.size() >= kStampLength && line.front() == '[' && line[kStampLength - 1] == ']') {
+        return line.substr(0, kStampLength);
+    }
+    return std::string_view();
+}
+
+struct Run {
+    std::size_t source;
+    // Next line to emit (counting down) and the run's first line.
+    std::size_t next;
+    std::size_t first;
+};
+
+} // namespace
+
+void merge_newest(const std::vector<std::vector<std::string_view>> &sources, std::size_t limit,
+                  std::vector<MergedLine> &out) {
+    out.clear();
+    std::vector<Run> runs;
+    std::size_t total = 0;
+    for (std::size_t source = 0; source < sources.size(); ++source) {
+        const std::vector<std::string_view> &lines = sources[source];
+        total += lines.size();
+        std::size_t first = 0;
+        for (std::size_t i = 1; i <= lines.size(); ++i) {
+            if (i == lines.size() || stamp_of(lines[i]) < stamp_of(lines[i - 1])) {
+                if (i > first) {
+                    runs.push_back(Run{source, i - 1, first});
+                }
+                first = i;
+            }
+        }
+    }
+
+    // Max-heap on (stamp, source, position): popping in that order and reversing yields an
+    // ascending result that is stable across sources.
+    const auto older = [&sources, &runs](std::size_t lhs, std::size_t rhs) {
+        const Run &a = runs[lhs];
+        const Run &b = runs[rhs];
+        const std::string_view stamp_a = stamp_of(sources[a.source][a.next]);
+        const std::string_view stamp_b = stamp_of(sources[b.source][b.next]);
+        if (stamp_a != stamp_b) {
+            return stamp_a < stamp_b;
+        }
+        if (a.source != b.source) {
+            return a.source < b.source;
+        }
+        return a.next < b.next;
+    };
+    std::priority_queue<std::size_t, std::vector<std::size_t>, decltype(older)> heap(older);
+    for (std::size_t i = 0; i < runs.size(); ++i) {
+        heap.push(i);
+    }
+
+    const std::size_t wanted = limit == 0 ? total : std::min(limit, total);
+    out.reserve(wanted);
+    while (out.size() < wanted && !heap.empty()) {
+        const std::size_t index = heap.top();
+        heap.pop();
+        Run &run = runs[index];
+        out.push_back(MergedLine{sources[run.source][run.next], run.source});
+        if (run.next > run.first) {
+            --run.next;
+            heap.push(index);
+        }
+    }
+    std::reverse(out.begin(), out.end());
+}
+
+} // namespace logcrafter::cpp
@@ -0,0 +1,363 @@
+/*
+ * Sequence: SEQ0260
+ * Track: C++
+ * MVP: Step D
+ * Change: Count stored entries per second and per minute by level and source, answer ROLLUP from them, and save them.
+ * Tests: spec_rollup
+ */
+#include "rollup_store.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#include "clock_service.hpp"
+
+namespace logcrafter::cpp {
+
+namespace {
+
+constexpr char kStateMagic[] = "LCROLLUP 1";
+// Large enough for a bucket line with every cell set.
+constexpr std::size_t kStateLineBytes = 4096;
+
+std::int64_t bucket_index(std::time_t timestamp, std::int64_t width_seconds) {
+    return static_cast<std::int64_t>(timestamp) / width_seconds;
+}
+
+} // namespace
+
+RollupStore::RollupStore()
+    : config_(),
+      seconds_{1, std::vector<Bucket>(kSecondBuckets), -1},
+      minutes_{60, std::vector<Bucket>(kMinuteBuckets), -1},
+      sources_(),
+      dirty_(false),
+      source_count_(0),
+      late_entries_(0),
+      queries_(0),
+      stop_(false),
+      saves_(0),
+      save_failures_(0) {}
+
+RollupStore::~RollupStore() { shutdown(); }
+
+int RollupStore::init(const RollupConfig &config) {
+    shutdown();
+
+    config_ = config;
+    if (config_.save_interval_ms <= 0) {
+        config_.save_interval_ms = kDefaultSaveIntervalMs;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (Ring *ring : {&seconds_, &minutes_}) {
+            std::fill(ring->buckets.begin(), ring->buckets.end(), Bucket{});
+            ring->newest = -1;
+        }
+        sources_.clear();
+        source_count_.store(0, std::memory_order_relaxed);
+        late_entries_.store(0, std::memory_order_relaxed);
+        queries_.store(0, std::memory_order_relaxed);
+        dirty_ = false;
+        saves_.store(0, std::memory_order_relaxed);
+        save_failures_.store(0, std::memory_order_relaxed);
+    }
+    if (config_.state_path.empty()) {
+        return 0;
+    }
+    if (!load()) {
+        std::cerr << "[lc][warn] Ignoring unreadable rollup state " << config_.state_path << std::endl;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(saver_mutex_);
+        stop_ = false;
+    }
+    try {
+        saver_ = std::thread(&RollupStore::run, this);
+    } catch (...) {
+        return -1;
+    }
+    return 0;
+}
+
+void RollupStore::shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(saver_mutex_);
+        stop_ = true;
+    }
+    saver_condition_.notify_all();
+    if (saver_.joinable()) {
+        saver_.join();
+        if (!save()) {
+            std::cerr << "[lc][warn] Failed to save rollups to " << config_.state_path << std::endl;
+        }
+    }
+}
+
+void RollupStore::record(std::string_view source, result_codec::Level level, std::time_t timestamp) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const std::size_t cell = source_slot_locked(source) * result_codec::kLevelCount + static_cast<std::size_t>(level);
+    add_locked(seconds_, bucket_index(timestamp, seconds_.width_seconds), cell);
+    // Only the day-long ring decides lateness; an entry too old for the hour ring is still counted per minute.
+    if (!add_locked(minutes_, bucket_index(timestamp, minutes_.width_seconds), cell)) {
+        late_entries_.fetch_add(1, std::memory_order_relaxed);
+    }
+    dirty_ = true;
+}
+
+std::size_t RollupStore::source_slot_locked(std::string_view source) {
+    for (std::size_t slot = 0; slot < sources_.size(); ++slot) {
+        if (sources_[slot] == source) {
+            return slot;
+        }
+    }
+    if (sources_.size() < kMaxSources && source != kOtherSource) {
+        sources_.emplace_back(source);
+        source_count_.store(sources_.size(), std::memory_order_relaxed);
+        return sources_.size() - 1;
+    }
+    return kMaxSources;
+}
+
+bool RollupStore::add_locked(Ring &ring, std::int64_t index, std::size_t cell) {
+    const std::int64_t size = static_cast<std::int64_t>(ring.buckets.size());
+    if (index < 0 || (ring.newest >= 0 && index <= ring.newest - size)) {
+        return false;
+    }
+    Bucket &bucket = ring.buckets[static_cast<std::size_t>(index % size)];
+    if (bucket.index < index) {
+        // The slot still holds a bucket one or more laps older: start it over.
+        bucket.index = index;
+        bucket.counts.fill(0);
+    }
+    ++bucket.counts[cell];
+    ring.newest = std::max(ring.newest, index);
+    return true;
+}
+
+void RollupStore::answer(const RollupRequest &request, std::string &out) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const Ring &ring = request.resolution == RollupRequest::Resolution::Second ? seconds_ : minutes_;
+    const std::int64_t size = static_cast<std::int64_t>(ring.buckets.size());
+
+    std::size_t source_filter = kSourceSlots;
+    if (!request.source.empty()) {
+        if (request.source == kOtherSource) {
+            source_filter = kMaxSources;
+        } else {
+            const auto it = std::find(sources_.begin(), sources_.end(), request.source);
+            if (it == sources_.end()) {
+                out = "ERROR: No rollups for source '" + request.source + "'.\n";
+                return;
+            }
+            source_filter = static_cast<std::size_t>(it - sources_.begin());
+        }
+    }
+
+    // Buckets the ring no longer holds are left out rather than reported as zero.
+    const std::int64_t newest =
+        ring.newest >= 0 ? ring.newest : bucket_index(ClockService::instance().now_seconds(), ring.width_seconds);
+    std::int64_t last = request.has_to ? bucket_index(request.to, ring.width_seconds) : newest;
+    std::int64_t first = request.has_from ? bucket_index(request.from, ring.width_seconds)
+                                          : last - static_cast<std::int64_t>(kDefaultBuckets) + 1;
+    last = std::min(last, newest);
+    first = std::max({first, newest - size + 1, last - size + 1, std::int64_t{0}});
+    const std::int64_t count = last >= first ? last - first + 1 : 0;
+    queries_.fetch_add(1, std::memory_order_relaxed);
+
+    out.clear();
+    out.reserve(static_cast<std::size_t>(count) * 96 + 128);
+    out += "ROLLUP: resolution=";
+    out += request.resolution == RollupRequest::Resolution::Second ? "second" : "minute";
+    out += " from=" + std::to_string(first * ring.width_seconds);
+    out += " to=" + std::to_string(last * ring.width_seconds);
+    out += " buckets=" + std::to_string(count);
+    out += request.group_by == RollupRequest::GroupBy::Level ? " by=level\n" : " by=source\n";
+
+    std::array<std::uint64_t, kSourceSlots> by_source{};
+    std::array<std::uint64_t, result_codec::kLevelCount> by_level{};
+    for (std::int64_t index = first; index <= last; ++index) {
+        const Bucket &bucket = ring.buckets[static_cast<std::size_t>(index % size)];
+        by_source.fill(0);
+        by_level.fill(0);
+        std::uint64_t total = 0;
+        if (bucket.index == index) {
+            for (std::size_t slot = 0; slot < kSourceSlots; ++slot) {
+                if (source_filter != kSourceSlots && slot != source_filter) {
+                    continue;
+                }
+                for (std::size_t level = 0; level < result_codec::kLevelCount; ++level) {
+                    if (request.has_level && level != static_cast<std::size_t>(request.level)) {
+                        continue;
+                    }
+                    const std::uint32_t value = bucket.counts[slot * result_codec::kLevelCount + level];
+                    by_source[slot] += value;
+                    by_level[level] += value;
+                    total += value;
+                }
+            }
+        }
+
+        out += std::to_string(index * ring.width_seconds);
+        out += " total=" + std::to_string(total);
+        if (request.group_by == RollupRequest::GroupBy::Level) {
+            for (std::size_t level = 0; level < result_codec::kLevelCount; ++level) {
+                out += ' ';
+                out += result_codec::level_name(static_cast<result_codec::Level>(level));
+                out += '=' + std::to_string(by_level[level]);
+            }
+        } else {
+            for (std::size_t slot = 0; slot < kSourceSlots; ++slot) {
+                if (by_source[slot] == 0) {
+                    continue;
+                }
+                out += ' ';
+                out += slot < kMaxSources ? std::string_view(sources_[slot]) : kOtherSource;
+                out += '=' + std::to_string(by_source[slot]);
+            }
+        }
+        out += '\n';
+    }
+}
+
+RollupStats RollupStore::stats() const {
+    return RollupStats{source_count_.load(std::memory_order_relaxed), late_entries_.load(std::memory_order_relaxed),
+                       queries_.load(std::memory_order_relaxed), saves_.load(std::memory_order_relaxed),
+                       save_failures_.load(std::memory_order_relaxed)};
+}
+
+bool RollupStore::load() {
+    std::FILE *file = std::fopen(config_.state_path.c_str(), "r");
+    if (file == nullptr) {
+        return errno == ENOENT;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    char line[kStateLineBytes];
+    bool valid = std::fgets(line, sizeof(line), file) != nullptr &&
+                 std::strncmp(line, kStateMagic, sizeof(kStateMagic) - 1) == 0;
+    while (valid && std::fgets(line, sizeof(line), file) != nullptr) {
+        line[std::strcspn(line, "\n")] = '\0';
+        if (std::strncmp(line, "source ", 7) == 0) {
+            // Slots are written in order, so each name lands back on its own counters.
+            if (sources_.size() >= kMaxSources || line[7] == '\0') {
+                valid = false;
+            } else {
+                sources_.emplace_back(line + 7);
+            }
+        } else if (std::strncmp(line, "late ", 5) == 0) {
+            late_entries_.store(std::strtoul(line + 5, nullptr, 10), std::memory_order_relaxed);
+        } else if (std::strncmp(line, "second ", 7) == 0 || std::strncmp(line, "minute ", 7) == 0) {
+            Ring &ring = line[0] == 's' ? seconds_ : minutes_;
+            char *cursor = nullptr;
+            const long long index = std::strtoll(line + 7, &cursor, 10);
+            if (cursor == line + 7 || index < 0) {
+                valid = false;
+                break;
+            }
+            Bucket &bucket = ring.buckets[static_cast<std::size_t>(index) % ring.buckets.size()];
+            bucket.index = index;
+            bucket.counts.fill(0);
+            while (*cursor == ' ') {
+                char *end = nullptr;
+                const unsigned long cell = std::strtoul(cursor + 1, &end, 10);
+                if (*end != ':' || cell >= kCells) {
+                    valid = false;
+                    break;
+                }
+                bucket.counts[cell] = static_cast<std::uint32_t>(std::strtoul(end + 1, &cursor, 10));
+            }
+            ring.newest = std::max<std::int64_t>(ring.newest, index);
+        } else if (line[0] != '\0') {
+            valid = false;
+        }
+    }
+    std::fclose(file);
+
+    if (!valid) {
+        for (Ring *ring : {&seconds_, &minutes_}) {
+            std::fill(ring->buckets.begin(), ring->buckets.end(), Bucket{});
+            ring->newest = -1;
+        }
+        sources_.clear();
+        late_entries_.store(0, std::memory_order_relaxed);
+    }
+    source_count_.store(sources_.size(), std::memory_order_relaxed);
+    return valid;
+}
+
+bool RollupStore::save() {
+    // Render under the lock, write outside it: ingest only waits for the copy.
+    std::string text;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!dirty_) {
+            return true;
+        }
+        dirty_ = false;
+        text.reserve(64 * 1024);
+        text += kStateMagic;
+        text += '\n';
+        for (const std::string &source : sources_) {
+            text += "source " + source + "\n";
+        }
+        text += "late " + std::to_string(late_entries_.load(std::memory_order_relaxed)) + "\n";
+        for (const Ring *ring : {&seconds_, &minutes_}) {
+            const std::int64_t oldest = ring->newest - static_cast<std::int64_t>(ring->buckets.size()) + 1;
+            for (const Bucket &bucket : ring->buckets) {
+                if (bucket.index < 0 || bucket.index < oldest) {
+                    continue;
+                }
+                text += ring == &seconds_ ? "second " : "minute ";
+                text += std::to_string(bucket.index);
+                for (std::size_t cell = 0; cell < kCells; ++cell) {
+                    if (bucket.counts[cell] != 0) {
+                        text += ' ' + std::to_string(cell) + ':' + std::to_string(bucket.counts[cell]);
+                    }
+                }
+                text += '\n';
+            }
+        }
+    }
+
+    const std::string temporary = config_.state_path + ".tmp";
+    std::FILE *file = std::fopen(temporary.c_str(), "w");
+    bool saved = false;
+    if (file != nullptr) {
+        const bool written = std::fwrite(text.data(), 1, text.size(), file) == text.size();
+        const bool closed = std::fclose(file) == 0;
+        saved = written && closed && std::rename(temporary.c_str(), config_.state_path.c_str()) == 0;
+    }
+
+    if (saved) {
+        saves_.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        // Try again on the next tick.
+        std::lock_guard<std::mutex> lock(mutex_);
+        dirty_ = true;
+        save_failures_.fetch_add(1, std::memory_order_relaxed);
+    }
+    return saved;
+}
+
+void RollupStore::run() {
+    std::unique_lock<std::mutex> lock(saver_mutex_);
+    while (!stop_) {
+        const auto interval = std::chrono::milliseconds(config_.save_interval_ms);
+        saver_condition_.wait_for(lock, interval, [this]() { return stop_; });
+        if (stop_) {
+            break;
+        }
+        lock.unlock();
+        save();
+        lock.lock();
+    }
+}
+
+} // namespace logcrafter::cpp
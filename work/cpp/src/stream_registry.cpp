@@ -0,0 +1,201 @@
+/*
+ * Sequence: SEQ0293
+ * Track: C++
+ * MVP: Step D
+ * Change: Configure stream buffers with level shares and sum per-ring sizes.
+ * Tests: spec_severity_rings
+ */
+#include "stream_registry.hpp"
+
+#include <dirent.h>
+#include <iostream>
+#include <sys/stat.h>
+
+#include "clock_service.hpp"
+
+namespace logcrafter::cpp {
+
+namespace {
+
+void replay_into(PersistenceManager &persistence, LogBuffer &buffer) {
+    persistence.replay_existing([&buffer](const std::string &message, std::time_t timestamp) {
+        const std::time_t effective =
+            timestamp == static_cast<std::time_t>(0) ? ClockService::instance().now_seconds() : timestamp;
+        buffer.push_with_time(message, effective);
+    });
+}
+
+std::vector<std::string> persisted_stream_names(const std::string &directory) {
+    std::vector<std::string> names;
+    DIR *dir = opendir(directory.c_str());
+    if (dir == nullptr) {
+        return names;
+    }
+    struct dirent *entry = nullptr;
+    while ((entry = readdir(dir)) != nullptr) {
+        const std::string name = entry->d_name;
+        if (!StreamRegistry::valid_name(name) || name == StreamRegistry::kDefaultStreamName) {
+            continue;
+        }
+        struct stat st {};
+        const std::string path = directory + "/" + name;
+        if (stat(path.c_str(), &st) == 0 && S_ISDIR(st.st_mode)) {
+            names.push_back(name);
+        }
+    }
+    closedir(dir);
+    return names;
+}
+
+} // namespace
+
+StreamRegistry::StreamRegistry() : streams_(), count_(0), create_mutex_(), settings_() {
+    streams_[kDefaultStream] = std::make_unique<Stream>(kDefaultStreamName);
+    count_.store(1, std::memory_order_release);
+}
+
+int StreamRegistry::configure(const StreamSettings &settings) {
+    reset();
+
+    std::lock_guard<std::mutex> lock(create_mutex_);
+    settings_ = settings;
+    Stream &fallback = *streams_[kDefaultStream];
+    fallback.buffer.configure(settings_.default_capacity, settings_.level_shares);
+    fallback.buffer.set_reorder_window(settings_.reorder_window);
+    if (settings_.persistence_enabled) {
+        if (fallback.persistence.init(settings_.persistence) != 0) {
+            return -1;
+        }
+        fallback.persistent = true;
+        replay_into(fallback.persistence, fallback.buffer);
+    }
+
+    StreamId id = kDefaultStream;
+    for (const StreamDeclaration &declaration : settings_.declared) {
+        const std::size_t capacity = declaration.capacity > 0 ? declaration.capacity : settings_.default_capacity;
+        if (!create_locked(declaration.name, capacity, id)) {
+            std::cerr << "[lc][warn] Ignoring stream declaration '" << declaration.name << "'" << std::endl;
+        }
+    }
+    if (settings_.persistence_enabled) {
+        for (const std::string &name : persisted_stream_names(settings_.persistence.directory)) {
+            if (!create_locked(name, settings_.default_capacity, id)) {
+                std::cerr << "[lc][warn] Not restoring stream '" << name << "'" << std::endl;
+            }
+        }
+    }
+    return 0;
+}
+
+void StreamRegistry::reset() {
+    std::lock_guard<std::mutex> lock(create_mutex_);
+    const std::size_t existing = count_.load(std::memory_order_relaxed);
+    count_.store(1, std::memory_order_release);
+    for (std::size_t i = 1; i < existing; ++i) {
+        streams_[i].reset();
+    }
+    Stream &fallback = *streams_[kDefaultStream];
+    fallback.buffer.reset();
+    fallback.persistence.shutdown();
+    fallback.persistent = false;
+}
+
+bool StreamRegistry::valid_name(std::string_view name) {
+    if (name.empty() || name.size() > kMaxNameLength) {
+        return false;
+    }
+    for (const char ch : name) {
+        const bool allowed = (ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z') || (ch >= '0' && ch <= '9') ||
+                             ch == '_' || ch == '-';
+        if (!allowed) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool StreamRegistry::open(std::string_view name, StreamId &id) {
+    if (find(name, id)) {
+        return true;
+    }
+    std::lock_guard<std::mutex> lock(create_mutex_);
+    return create_locked(name, settings_.default_capacity, id);
+}
+
+bool StreamRegistry::find(std::string_view name, StreamId &id) const {
+    const std::size_t published = count();
+    for (std::size_t i = 0; i < published; ++i) {
+        if (streams_[i]->name == name) {
+            id = i;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool StreamRegistry::create_locked(std::string_view name, std::size_t capacity, StreamId &id) {
+    // Another producer may have created it between find() and taking the lock.
+    if (find(name, id)) {
+        return true;
+    }
+    const std::size_t next = count_.load(std::memory_order_relaxed);
+    if (!valid_name(name) || next >= kMaxStreams) {
+        return false;
+    }
+
+    auto stream = std::make_unique<Stream>(std::string(name));
+    stream->buffer.configure(capacity, settings_.level_shares);
+    stream->buffer.set_reorder_window(settings_.reorder_window);
+    if (settings_.persistence_enabled) {
+        attach_persistence(*stream, settings_.persistence.directory + "/" + stream->name);
+    }
+    streams_[next] = std::move(stream);
+    count_.store(next + 1, std::memory_order_release);
+    id = next;
+    return true;
+}
+
+void StreamRegistry::attach_persistence(Stream &stream, const std::string &directory) {
+    PersistenceConfig config = settings_.persistence;
+    config.directory = directory;
+    if (stream.persistence.init(config) != 0) {
+        // The stream still serves queries from memory; its lines count as not persisted.
+        std::cerr << "[lc][warn] Persistence unavailable for stream '" << stream.name << "'" << std::endl;
+        return;
+    }
+    stream.persistent = true;
+    replay_into(stream.persistence, stream.buffer);
+}
+
+LogBufferStats StreamRegistry::buffer_totals() const {
+    LogBufferStats totals{0, 0, 0, 0, {}};
+    const std::size_t published = count();
+    for (std::size_t i = 0; i < published; ++i) {
+        const LogBufferStats stats = streams_[i]->buffer.stats();
+        totals.current_size += stats.current_size;
+        totals.total_logs += stats.total_logs;
+        totals.dropped_logs += stats.dropped_logs;
+        totals.reordered_logs += stats.reordered_logs;
+        for (std::size_t ring = 0; ring < kLevelRings; ++ring) {
+            totals.ring_sizes[ring] += stats.ring_sizes[ring];
+        }
+    }
+    return totals;
+}
+
+PersistenceStats StreamRegistry::persistence_totals() const {
+    PersistenceStats totals{0, 0, 0};
+    const std::size_t published = count();
+    for (std::size_t i = 0; i < published; ++i) {
+        if (!streams_[i]->persistent) {
+            continue;
+        }
+        const PersistenceStats stats = streams_[i]->persistence.stats();
+        totals.queued_logs += stats.queued_logs;
+        totals.persisted_logs += stats.persisted_logs;
+        totals.failed_logs += stats.failed_logs;
+    }
+    return totals;
+}
+
+} // namespace logcrafter::cpp
@@ -0,0 +1,263 @@
+/*
+ * Sequence: SEQ0129
+ * Track: C++
+ * MVP: Step D
+ * Change: Implement allocation-free fixed-format timestamp parsers with a cached local UTC offset.
+ * Tests: spec_client_timestamps, smoke_persistence_toggle
+ */
+#include "timestamp_parser.hpp"
+
+#include <cstdint>
+#include <cstring>
+
+namespace logcrafter::cpp {
+
+namespace {
+
+constexpr std::int64_t kSecondsPerDay = 86400;
+
+bool read_digits(const char *data, std::size_t count, int &out) {
+    int value = 0;
+    for (std::size_t i = 0; i < count; ++i) {
+        const unsigned digit = static_cast<unsigned char>(data[i]) - static_cast<unsigned>('0');
+        if (digit > 9) {
+            return false;
+        }
+        value = value * 10 + static_cast<int>(digit);
+    }
+    out = value;
+    return true;
+}
+
+bool is_space(char ch) { return ch == ' ' || ch == '\t'; }
+
+// Howard Hinnant's days_from_civil: proleptic Gregorian date to days since 1970-01-01.
+std::int64_t days_from_civil(int year, int month, int day) {
+    year -= month <= 2 ? 1 : 0;
+    const std::int64_t era = (year >= 0 ? year : year - 399) / 400;
+    const unsigned yoe = static_cast<unsigned>(year - era * 400);
+    const unsigned doy = (153U * static_cast<unsigned>(month + (month > 2 ? -3 : 9)) + 2U) / 5U +
+                         static_cast<unsigned>(day) - 1U;
+    const unsigned doe = yoe * 365U + yoe / 4U - yoe / 100U + doy;
+    return era * 146097 + static_cast<std::int64_t>(doe) - 719468;
+}
+
+int days_in_month(int year, int month) {
+    static constexpr int kDays[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    if (month == 2 && (year % 4 == 0 && (year % 100 != 0 || year % 400 == 0))) {
+        return 29;
+    }
+    return kDays[month - 1];
+}
+
+struct CivilTime {
+    int year;
+    int month;
+    int day;
+    int hour;
+    int minute;
+    int second;
+};
+
+// Parses "YYYY-MM-DD?HH:MM:SS" where `?` is any of `separators`.
+bool parse_civil(const char *data, const char *separators, CivilTime &out) {
+    if (data[4] != '-' || data[7] != '-' || data[10] == '\0' || std::strchr(separators, data[10]) == nullptr ||
+        data[13] != ':' || data[16] != ':') {
+        return false;
+    }
+    if (!read_digits(data, 4, out.year) || !read_digits(data + 5, 2, out.month) ||
+        !read_digits(data + 8, 2, out.day) || !read_digits(data + 11, 2, out.hour) ||
+        !read_digits(data + 14, 2, out.minute) || !read_digits(data + 17, 2, out.second)) {
+        return false;
+    }
+    if (out.month < 1 || out.month > 12 || out.day < 1 || out.day > days_in_month(out.year, out.month) ||
+        out.hour > 23 || out.minute > 59 || out.second > 60) {
+        return false;
+    }
+    if (out.second == 60) {
+        out.second = 59; // Leap second: clamp rather than roll into the next minute.
+    }
+    return true;
+}
+
+std::int64_t civil_to_naive_epoch(const CivilTime &civil) {
+    return days_from_civil(civil.year, civil.month, civil.day) * kSecondsPerDay + civil.hour * 3600 +
+           civil.minute * 60 + civil.second;
+}
+
+// Converts a local wall-clock time to epoch seconds. mktime() is only consulted once per
+// wall-clock hour per thread; zone transitions happen on hour boundaries in practice.
+std::time_t local_to_epoch(const CivilTime &civil) {
+    struct OffsetCache {
+        std::int64_t hour_key = INT64_MIN;
+        std::int64_t offset = 0;
+    };
+    thread_local OffsetCache cache;
+
+    const std::int64_t naive = civil_to_naive_epoch(civil);
+    const std::int64_t hour_key = naive >= 0 ? naive / 3600 : (naive - 3599) / 3600;
+    if (hour_key != cache.hour_key) {
+        std::tm tm_value{};
+        tm_value.tm_year = civil.year - 1900;
+        tm_value.tm_mon = civil.month - 1;
+        tm_value.tm_mday = civil.day;
+        tm_value.tm_hour = civil.hour;
+        tm_value.tm_min = 0;
+        tm_value.tm_sec = 0;
+        tm_value.tm_isdst = -1;
+        const std::time_t hour_start = std::mktime(&tm_value);
+        if (hour_start == static_cast<std::time_t>(-1)) {
+            return static_cast<std::time_t>(naive);
+        }
+        cache.hour_key = hour_key;
+        cache.offset = hour_key * 3600 - static_cast<std::int64_t>(hour_start);
+    }
+    return static_cast<std::time_t>(naive - cache.offset);
+}
+
+std::size_t skip_separator(std::string_view line, std::size_t position) {
+    while (position < line.size() && is_space(line[position])) {
+        ++position;
+    }
+    return position;
+}
+
+bool parse_rfc3339(std::string_view line, LeadingTimestamp &out) {
+    if (line.size() < 20) {
+        return false;
+    }
+    CivilTime civil{};
+    if (!parse_civil(line.data(), "Tt ", civil)) {
+        return false;
+    }
+
+    std::size_t position = 19;
+    int millis = 0;
+    if (position < line.size() && line[position] == '.') {
+        ++position;
+        int scale = 100;
+        const std::size_t fraction_start = position;
+        while (position < line.size() && line[position] >= '0' && line[position] <= '9') {
+            millis += (line[position] - '0') * scale;
+            scale /= 10;
+            ++position;
+        }
+        if (position == fraction_start) {
+            return false;
+        }
+    }
+
+    if (position >= line.size()) {
+        return false;
+    }
+    std::int64_t offset_seconds = 0;
+    const char zone = line[position];
+    if (zone == 'Z' || zone == 'z') {
+        ++position;
+    } else if (zone == '+' || zone == '-') {
+        int offset_hours = 0;
+        int offset_minutes = 0;
+        if (line.size() < position + 6 || line[position + 3] != ':' ||
+            !read_digits(line.data() + position + 1, 2, offset_hours) ||
+            !read_digits(line.data() + position + 4, 2, offset_minutes) || offset_hours > 23 ||
+            offset_minutes > 59) {
+            return false;
+        }
+        offset_seconds = (offset_hours * 3600 + offset_minutes * 60) * (zone == '+' ? 1 : -1);
+        position += 6;
+    } else {
+        return false;
+    }
+
+    if (position < line.size() && !is_space(line[position])) {
+        return false;
+    }
+
+    out.format = LeadingTimestamp::Format::Rfc3339;
+    out.seconds = static_cast<std::time_t>(civil_to_naive_epoch(civil) - offset_seconds);
+    out.millis = millis;
+    out.length = skip_separator(line, position);
+    return true;
+}
+
+bool parse_epoch(std::string_view line, LeadingTimestamp &out) {
+    std::size_t digits = 0;
+    std::int64_t value = 0;
+    while (digits < line.size() && digits < 14 && line[digits] >= '0' && line[digits] <= '9') {
+        value = value * 10 + (line[digits] - '0');
+        ++digits;
+    }
+
+    std::size_t position = digits;
+    int millis = 0;
+    LeadingTimestamp::Format format = LeadingTimestamp::Format::None;
+    if (digits == 10) {
+        format = LeadingTimestamp::Format::EpochSeconds;
+        if (position < line.size() && line[position] == '.') {
+            ++position;
+            int scale = 100;
+            const std::size_t fraction_start = position;
+            while (position < line.size() && line[position] >= '0' && line[position] <= '9') {
+                millis += (line[position] - '0') * scale;
+                scale /= 10;
+                ++position;
+            }
+            if (position == fraction_start) {
+                return false;
+            }
+        }
+    } else if (digits == 13) {
+        format = LeadingTimestamp::Format::EpochMillis;
+        millis = static_cast<int>(value % 1000);
+        value /= 1000;
+    } else {
+        return false;
+    }
+
+    // A bare number must be followed by whitespace so "1714564800123abc" stays a message.
+    if (position >= line.size() || !is_space(line[position])) {
+        return false;
+    }
+
+    out.format = format;
+    out.seconds = static_cast<std::time_t>(value);
+    out.millis = millis;
+    out.length = skip_separator(line, position);
+    return true;
+}
+
+} // namespace
+
+bool parse_bracketed_timestamp(std::string_view line, LeadingTimestamp &out) {
+    out = LeadingTimestamp{};
+    if (line.size() < 21 || line[0] != '[' || line[20] != ']') {
+        return false;
+    }
+    CivilTime civil{};
+    if (!parse_civil(line.data() + 1, " ", civil)) {
+        return false;
+    }
+    out.format = LeadingTimestamp::Format::Bracketed;
+    out.seconds = local_to_epoch(civil);
+    out.length = skip_separator(line, 21);
+    return true;
+}
+
+bool parse_leading_timestamp(std::string_view line, LeadingTimestamp &out) {
+    out = LeadingTimestamp{};
+    if (line.empty()) {
+        return false;
+    }
+    if (line[0] == '[') {
+        return parse_bracketed_timestamp(line, out);
+    }
+    if (line[0] < '0' || line[0] > '9') {
+        return false;
+    }
+    if (line.size() >= 20 && line[4] == '-') {
+        return parse_rfc3339(line, out);
+    }
+    return parse_epoch(line, out);
+}
+
+} // namespace logcrafter::cpp
@@ -0,0 +1,88 @@
+/*
+ * Sequence: SEQ0245
+ * Track: C++
+ * MVP: Step D
+ * Change: Decode a format=binary QUERY response from stdin into the equivalent NDJSON response.
+ * Tests: spec_binary_query
+ */
+#include "result_codec.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <string_view>
+
+#ifdef LOGCRAFTER_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+namespace {
+
+namespace result_codec = logcrafter::cpp::result_codec;
+
+constexpr std::string_view kCompressedLine = "COMPRESSED: deflate\n";
+
+bool inflate_all(std::string_view compressed, std::string &out) {
+#ifdef LOGCRAFTER_HAVE_ZLIB
+    z_stream zs{};
+    if (inflateInit(&zs) != Z_OK) {
+        return false;
+    }
+    zs.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(compressed.data()));
+    zs.avail_in = static_cast<uInt>(compressed.size());
+    char chunk[64 * 1024];
+    int status = Z_OK;
+    while (status == Z_OK) {
+        zs.next_out = reinterpret_cast<Bytef *>(chunk);
+        zs.avail_out = sizeof(chunk);
+        status = inflate(&zs, Z_NO_FLUSH);
+        out.append(chunk, sizeof(chunk) - zs.avail_out);
+    }
+    inflateEnd(&zs);
+    return status == Z_STREAM_END;
+#else
+    (void)compressed;
+    (void)out;
+    return false;
+#endif
+}
+
+} // namespace
+
+int main() {
+    std::string input((std::istreambuf_iterator<char>(std::cin)), std::istreambuf_iterator<char>());
+    if (input.compare(0, kCompressedLine.size(), kCompressedLine) == 0) {
+        std::string inflated;
+        if (!inflate_all(std::string_view(input).substr(kCompressedLine.size()), inflated)) {
+            std::cerr << "decode: cannot inflate the response" << std::endl;
+            return EXIT_FAILURE;
+        }
+        input.swap(inflated);
+    }
+
+    const std::size_t newline = input.find('\n');
+    if (input.compare(0, result_codec::kBinaryPrefix.size(), result_codec::kBinaryPrefix) != 0 ||
+        newline == std::string::npos) {
+        std::cerr << "decode: not a format=binary response: " << input.substr(0, input.find('\n')) << std::endl;
+        return EXIT_FAILURE;
+    }
+    const unsigned long expected = std::strtoul(input.c_str() + result_codec::kBinaryPrefix.size(), nullptr, 10);
+
+    const std::string_view payload = std::string_view(input).substr(newline + 1);
+    std::pmr::string out;
+    std::size_t offset = 0;
+    unsigned long decoded = 0;
+    result_codec::Record record{};
+    while (result_codec::next_record(payload, offset, record)) {
+        result_codec::append_ndjson(out, record);
+        ++decoded;
+    }
+    if (offset != payload.size() || decoded != expected) {
+        std::cerr << "decode: expected " << expected << " records, decoded " << decoded << std::endl;
+        return EXIT_FAILURE;
+    }
+    std::cout << result_codec::kNdjsonPrefix << decoded << '\n' << out;
+    return std::cout.good() ? EXIT_SUCCESS : EXIT_FAILURE;
+}
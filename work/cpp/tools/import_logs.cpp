@@ -0,0 +1,603 @@
+/*
+ * Sequence: SEQ0352
+ * Track: C++
+ * MVP: Step D
+ * Change: Bulk-import plain or gzip log files straight into persisted segments that the server replays.
+ * Tests: spec_bulk_import
+ */
+#include "lc_server.hpp"
+#include "persistence.hpp"
+#include "redactor.hpp"
+#include "stream_registry.hpp"
+#include "timestamp_parser.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <functional>
+#include <iostream>
+#include <queue>
+#include <string>
+#include <string_view>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <tuple>
+#include <unistd.h>
+#include <vector>
+
+#ifdef LOGCRAFTER_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+namespace {
+
+using logcrafter::cpp::LeadingTimestamp;
+using logcrafter::cpp::PersistenceManager;
+using logcrafter::cpp::Redactor;
+using logcrafter::cpp::Server;
+using logcrafter::cpp::StreamRegistry;
+
+// Parse work is handed out in pieces of about this size, cut at line ends.
+constexpr std::size_t kChunkBytes = 4 * 1024 * 1024;
+constexpr std::size_t kWriteBufferBytes = 1024 * 1024;
+constexpr std::string_view kEllipsis = "...";
+
+struct Options {
+    std::string directory;
+    std::string stream;
+    std::size_t threads = 0;
+    std::size_t max_file_size = Server::kDefaultPersistenceMaxFileSize;
+    std::string redact_rules_path;
+    std::vector<std::string> paths;
+};
+
+struct Line {
+    std::time_t timestamp;
+    // Points into the input's mapping or inflated text, past any leading stamp.
+    const char *message;
+    std::uint32_t length;
+    // Stamped lines carry their own time; the rest inherit the previous stamped line's.
+    bool stamped;
+    // Longer than Server::kMaxLogLength; written cut short with "..." as the server would store it.
+    bool truncated;
+};
+
+struct Input {
+    std::string path;
+    char *data = nullptr;
+    std::size_t size = 0;
+    bool mapped = false;
+    std::string inflated;
+    std::time_t modified = 0;
+    std::string error;
+    std::vector<Line> lines;
+    unsigned long reordered = 0;
+};
+
+struct Chunk {
+    std::size_t input;
+    std::size_t begin;
+    std::size_t end;
+    std::vector<Line> lines;
+};
+
+struct Totals {
+    std::atomic<unsigned long> truncated{0};
+    std::atomic<unsigned long> redactions{0};
+};
+
+// Runs `job(0..count-1)` on up to `threads` threads, each taking the next index as it finishes one.
+void parallel_for(std::size_t count, std::size_t threads, const std::function<void(std::size_t)> &job) {
+    std::atomic<std::size_t> next(0);
+    const auto worker = [&]() {
+        for (std::size_t index = next.fetch_add(1); index < count; index = next.fetch_add(1)) {
+            job(index);
+        }
+    };
+    std::vector<std::thread> pool;
+    for (std::size_t t = 1; t < std::min(threads, count); ++t) {
+        pool.emplace_back(worker);
+    }
+    worker();
+    for (std::thread &thread : pool) {
+        thread.join();
+    }
+}
+
+bool inflate_gzip(const unsigned char *compressed, std::size_t size, std::string &out, std::string &error) {
+#ifdef LOGCRAFTER_HAVE_ZLIB
+    z_stream zs{};
+    // 32 + MAX_WBITS accepts gzip and zlib headers.
+    if (inflateInit2(&zs, 32 + MAX_WBITS) != Z_OK) {
+        error = "cannot initialise zlib";
+        return false;
+    }
+    zs.next_in = const_cast<Bytef *>(compressed);
+    std::size_t remaining = size;
+    out.resize(std::max<std::size_t>(size * 4, 64 * 1024));
+    std::size_t produced = 0;
+    int status = Z_OK;
+    while (true) {
+        if (zs.avail_in == 0 && remaining > 0) {
+            zs.avail_in = static_cast<uInt>(std::min<std::size_t>(remaining, 1U << 30));
+            remaining -= zs.avail_in;
+        }
+        if (produced == out.size()) {
+            out.resize(out.size() * 2);
+        }
+        const std::size_t room = std::min<std::size_t>(out.size() - produced, 1U << 30);
+        zs.next_out = reinterpret_cast<Bytef *>(&out[produced]);
+        zs.avail_out = static_cast<uInt>(room);
+        status = inflate(&zs, Z_NO_FLUSH);
+        produced += room - zs.avail_out;
+        if (status == Z_STREAM_END) {
+            // `gzip a b > c` and appended rotations leave several members back to back.
+            if (zs.avail_in == 0 && remaining == 0) {
+                break;
+            }
+            inflateReset(&zs);
+            continue;
+        }
+        if (status != Z_OK && status != Z_BUF_ERROR) {
+            break;
+        }
+        if (status == Z_BUF_ERROR && zs.avail_in == 0 && remaining == 0) {
+            break;
+        }
+    }
+    inflateEnd(&zs);
+    out.resize(produced);
+    if (status != Z_STREAM_END) {
+        error = "corrupt or truncated gzip data";
+        return false;
+    }
+    return true;
+#else
+    (void)compressed;
+    (void)size;
+    (void)out;
+    error = "gzip input needs a build with zlib";
+    return false;
+#endif
+}
+
+// Maps `input` copy-on-write, so redaction can mask in place without touching the file; gzip
+// files are inflated into memory instead.
+bool load(Input &input) {
+    const int fd = ::open(input.path.c_str(), O_RDONLY | O_CLOEXEC);
+    struct stat st {};
+    if (fd < 0 || ::fstat(fd, &st) != 0) {
+        input.error = std::strerror(errno);
+        if (fd >= 0) {
+            ::close(fd);
+        }
+        return false;
+    }
+    input.modified = st.st_mtime;
+    if (!S_ISREG(st.st_mode)) {
+        ::close(fd);
+        input.error = "not a regular file";
+        return false;
+    }
+    if (st.st_size == 0) {
+        ::close(fd);
+        return true;
+    }
+    const auto size = static_cast<std::size_t>(st.st_size);
+    void *mapping = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        input.error = std::strerror(errno);
+        return false;
+    }
+    ::madvise(mapping, size, MADV_SEQUENTIAL);
+    const auto *bytes = static_cast<const unsigned char *>(mapping);
+    if (size >= 2 && bytes[0] == 0x1f && bytes[1] == 0x8b) {
+        const bool inflated = inflate_gzip(bytes, size, input.inflated, input.error);
+        ::munmap(mapping, size);
+        input.data = input.inflated.data();
+        input.size = input.inflated.size();
+        return inflated;
+    }
+    input.data = static_cast<char *>(mapping);
+    input.size = size;
+    input.mapped = true;
+    return true;
+}
+
+void parse_chunk(Input &input, Chunk &chunk, Redactor &redactor, Totals &totals) {
+    char *cursor = input.data + chunk.begin;
+    char *const end = input.data + chunk.end;
+    unsigned long truncated = 0;
+    unsigned long redactions = 0;
+    while (cursor < end) {
+        char *newline = static_cast<char *>(std::memchr(cursor, '\n', static_cast<std::size_t>(end - cursor)));
+        char *const line_end = newline != nullptr ? newline : end;
+        std::size_t length = static_cast<std::size_t>(line_end - cursor);
+        while (length > 0 && cursor[length - 1] == '\r') {
+            --length;
+        }
+        char *message = cursor;
+        Line line{0, nullptr, 0, false, false};
+        LeadingTimestamp stamp;
+        if (length > 0 && logcrafter::cpp::parse_leading_timestamp(std::string_view(cursor, length), stamp) &&
+            stamp.length < length) {
+            line.timestamp = stamp.seconds;
+            line.stamped = true;
+            message += stamp.length;
+            length -= stamp.length;
+        }
+        if (length > Server::kMaxLogLength) {
+            length = Server::kMaxLogLength - kEllipsis.size();
+            line.truncated = true;
+            ++truncated;
+        }
+        // The server skips empty lines as well.
+        if (length > 0) {
+            redactions += redactor.redact(message, length);
+            line.message = message;
+            line.length = static_cast<std::uint32_t>(length);
+            chunk.lines.push_back(line);
+        }
+        cursor = newline != nullptr ? newline + 1 : end;
+    }
+    totals.truncated.fetch_add(truncated, std::memory_order_relaxed);
+    totals.redactions.fetch_add(redactions, std::memory_order_relaxed);
+}
+
+// Gives unstamped lines the time of the stamped line before them (the file's first stamp, or
+// its modification time, before any), then puts the file in time order.
+void order_lines(Input &input) {
+    std::time_t carry = input.modified;
+    const auto first =
+        std::find_if(input.lines.begin(), input.lines.end(), [](const Line &line) { return line.stamped; });
+    if (first != input.lines.end()) {
+        carry = first->timestamp;
+    }
+    std::time_t latest = carry;
+    for (Line &line : input.lines) {
+        if (line.stamped) {
+            carry = line.timestamp;
+        } else {
+            line.timestamp = carry;
+        }
+        if (line.timestamp < latest) {
+            ++input.reordered;
+        }
+        latest = std::max(latest, line.timestamp);
+    }
+    if (input.reordered > 0) {
+        std::stable_sort(input.lines.begin(), input.lines.end(),
+                         [](const Line &a, const Line &b) { return a.timestamp < b.timestamp; });
+    }
+}
+
+// Writes lines in the persistence format into segments of about `max_file_size` bytes, each
+// renamed to the stamp of its last line as rotation would. A segment is only cut where the
+// stamp changes, so two segments never share a name.
+class SegmentWriter {
+public:
+    SegmentWriter(std::string directory, std::size_t max_file_size)
+        : directory_(std::move(directory)),
+          temp_path_(directory_ + "/.import-" + std::to_string(::getpid()) + ".tmp"),
+          max_file_size_(max_file_size),
+          fd_(-1),
+          segment_bytes_(0),
+          last_(0),
+          prefix_time_(-1),
+          prefix_length_(0),
+          segments_(0),
+          bytes_(0) {
+        buffer_.reserve(kWriteBufferBytes + 2 * Server::kMaxLogLength);
+    }
+
+    ~SegmentWriter() {
+        if (fd_ >= 0) {
+            ::close(fd_);
+            ::unlink(temp_path_.c_str());
+        }
+    }
+
+    SegmentWriter(const SegmentWriter &) = delete;
+    SegmentWriter &operator=(const SegmentWriter &) = delete;
+
+    bool append(const Line &line, std::string &error) {
+        if (fd_ >= 0 && segment_bytes_ >= max_file_size_ && line.timestamp != last_ && !close_segment(error)) {
+            return false;
+        }
+        if (fd_ < 0) {
+            fd_ = ::open(temp_path_.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+            if (fd_ < 0) {
+                error = temp_path_ + ": " + std::strerror(errno);
+                return false;
+            }
+            segment_bytes_ = 0;
+        }
+        if (line.timestamp != prefix_time_) {
+            prefix_time_ = line.timestamp;
+            prefix_length_ = PersistenceManager::format_line_prefix(line.timestamp, prefix_, sizeof(prefix_));
+        }
+        const std::size_t before = buffer_.size();
+        buffer_.append(prefix_, prefix_length_);
+        buffer_.append(line.message, line.length);
+        if (line.truncated) {
+            buffer_.append(kEllipsis);
+        }
+        buffer_.push_back('\n');
+        segment_bytes_ += buffer_.size() - before;
+        last_ = line.timestamp;
+        return buffer_.size() < kWriteBufferBytes || flush(error);
+    }
+
+    bool finish(std::string &error) { return fd_ < 0 || close_segment(error); }
+
+    std::size_t segments() const { return segments_; }
+    unsigned long long bytes() const { return bytes_; }
+
+private:
+    bool flush(std::string &error) {
+        const char *cursor = buffer_.data();
+        std::size_t left = buffer_.size();
+        while (left > 0) {
+            const ssize_t written = ::write(fd_, cursor, left);
+            if (written < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                error = temp_path_ + ": " + std::strerror(errno);
+                return false;
+            }
+            cursor += written;
+            left -= static_cast<std::size_t>(written);
+        }
+        bytes_ += buffer_.size();
+        buffer_.clear();
+        return true;
+    }
+
+    bool close_segment(std::string &error) {
+        if (!flush(error)) {
+            return false;
+        }
+        const bool synced = ::fsync(fd_) == 0;
+        ::close(fd_);
+        fd_ = -1;
+        const std::string name = PersistenceManager::rotated_name(last_);
+        const std::string path = directory_ + "/" + name;
+        // link() rather than rename(), so an existing segment of the same second is never replaced.
+        if (!synced || ::link(temp_path_.c_str(), path.c_str()) != 0) {
+            error = errno == EEXIST ? "segment '" + name + "' already exists in " + directory_
+                                    : path + ": " + std::strerror(errno);
+            ::unlink(temp_path_.c_str());
+            return false;
+        }
+        ::unlink(temp_path_.c_str());
+        ++segments_;
+        return true;
+    }
+
+    const std::string directory_;
+    const std::string temp_path_;
+    const std::size_t max_file_size_;
+    int fd_;
+    std::string buffer_;
+    std::size_t segment_bytes_;
+    std::time_t last_;
+    std::time_t prefix_time_;
+    char prefix_[PersistenceManager::kLinePrefixCapacity];
+    std::size_t prefix_length_;
+    std::size_t segments_;
+    unsigned long long bytes_;
+};
+
+bool ensure_directory(const std::string &path) {
+    struct stat st {};
+    if (::stat(path.c_str(), &st) == 0) {
+        return S_ISDIR(st.st_mode);
+    }
+    return errno == ENOENT && ::mkdir(path.c_str(), 0775) == 0;
+}
+
+// Rotated segments in `directory`: what --persistence-max-files has to cover.
+std::size_t count_segments(const std::string &directory) {
+    std::size_t count = 0;
+    DIR *dir = ::opendir(directory.c_str());
+    if (dir == nullptr) {
+        return 0;
+    }
+    while (const struct dirent *entry = ::readdir(dir)) {
+        const std::string_view name = entry->d_name;
+        if (name.size() > 4 && name[0] != '.' && name.substr(name.size() - 4) == ".log" && name != "current.log") {
+            ++count;
+        }
+    }
+    ::closedir(dir);
+    return count;
+}
+
+bool parse_count(const char *value, std::size_t minimum, std::size_t maximum, std::size_t &out) {
+    char *end = nullptr;
+    errno = 0;
+    const unsigned long long parsed = std::strtoull(value, &end, 10);
+    if (end == value || *end != '\0' || errno != 0 || parsed < minimum || parsed > maximum) {
+        return false;
+    }
+    out = static_cast<std::size_t>(parsed);
+    return true;
+}
+
+void print_usage(const char *prog) {
+    std::cerr << "Usage: " << prog << " --persistence-dir PATH [--stream NAME] [--threads N]" << std::endl
+              << "       [--persistence-max-size MB] [--redact-rules FILE] FILE..." << std::endl
+              << "Writes FILE... (plain or gzip) as persisted segments that the server replays at startup."
+              << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        std::size_t value = 0;
+        if (std::strcmp(argv[i], "--persistence-dir") == 0 && i + 1 < argc) {
+            options.directory = argv[++i];
+        } else if (std::strcmp(argv[i], "--stream") == 0 && i + 1 < argc) {
+            options.stream = argv[++i];
+        } else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            if (!parse_count(argv[++i], 1, 256, value)) {
+                print_usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+            options.threads = value;
+        } else if (std::strcmp(argv[i], "--persistence-max-size") == 0 && i + 1 < argc) {
+            if (!parse_count(argv[++i], 1, 1024 * 1024, value)) {
+                print_usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+            options.max_file_size = value * 1024 * 1024;
+        } else if (std::strcmp(argv[i], "--redact-rules") == 0 && i + 1 < argc) {
+            options.redact_rules_path = argv[++i];
+        } else if (argv[i][0] == '-' && argv[i][1] != '\0') {
+            print_usage(argv[0]);
+            return EXIT_FAILURE;
+        } else {
+            options.paths.emplace_back(argv[i]);
+        }
+    }
+    if (options.directory.empty() || options.paths.empty()) {
+        print_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    if (!options.stream.empty() && options.stream != StreamRegistry::kDefaultStreamName &&
+        !StreamRegistry::valid_name(options.stream)) {
+        std::cerr << "import: invalid stream name '" << options.stream << "'" << std::endl;
+        return EXIT_FAILURE;
+    }
+    if (options.threads == 0) {
+        options.threads = std::max(1U, std::thread::hardware_concurrency());
+    }
+
+    // The default stream persists at the top of the directory, others in a subdirectory.
+    const bool named_stream = !options.stream.empty() && options.stream != StreamRegistry::kDefaultStreamName;
+    const std::string target = named_stream ? options.directory + "/" + options.stream : options.directory;
+    if (!ensure_directory(options.directory) || !ensure_directory(target)) {
+        std::cerr << "import: cannot create " << target << ": " << std::strerror(errno) << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    Redactor redactor;
+    if (!options.redact_rules_path.empty()) {
+        std::string error;
+        if (redactor.load(options.redact_rules_path, error) != 0) {
+            std::cerr << "import: redaction rules: " << error << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    const auto started = std::chrono::steady_clock::now();
+    std::vector<Input> inputs(options.paths.size());
+    for (std::size_t i = 0; i < inputs.size(); ++i) {
+        inputs[i].path = options.paths[i];
+    }
+    parallel_for(inputs.size(), options.threads, [&inputs](std::size_t i) { load(inputs[i]); });
+    for (const Input &input : inputs) {
+        if (!input.error.empty()) {
+            std::cerr << "import: " << input.path << ": " << input.error << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    std::vector<Chunk> chunks;
+    unsigned long long input_bytes = 0;
+    for (std::size_t i = 0; i < inputs.size(); ++i) {
+        const Input &input = inputs[i];
+        input_bytes += input.size;
+        for (std::size_t begin = 0; begin < input.size;) {
+            std::size_t end = std::min(begin + kChunkBytes, input.size);
+            if (end < input.size) {
+                const void *newline = std::memchr(input.data + end, '\n', input.size - end);
+                end = newline != nullptr ? static_cast<std::size_t>(static_cast<const char *>(newline) - input.data) + 1
+                                         : input.size;
+            }
+            chunks.push_back(Chunk{i, begin, end, {}});
+            begin = end;
+        }
+    }
+    Totals totals;
+    parallel_for(chunks.size(), options.threads, [&](std::size_t c) {
+        parse_chunk(inputs[chunks[c].input], chunks[c], redactor, totals);
+    });
+    for (Chunk &chunk : chunks) {
+        std::vector<Line> &lines = inputs[chunk.input].lines;
+        lines.insert(lines.end(), chunk.lines.begin(), chunk.lines.end());
+        std::vector<Line>().swap(chunk.lines);
+    }
+    parallel_for(inputs.size(), options.threads, [&inputs](std::size_t i) { order_lines(inputs[i]); });
+
+    // Each file is now in time order; merge them, the earlier file first on equal stamps.
+    using Cursor = std::tuple<std::time_t, std::size_t, std::size_t>;
+    std::priority_queue<Cursor, std::vector<Cursor>, std::greater<Cursor>> heads;
+    unsigned long lines = 0;
+    unsigned long reordered = 0;
+    for (std::size_t i = 0; i < inputs.size(); ++i) {
+        lines += inputs[i].lines.size();
+        reordered += inputs[i].reordered;
+        if (!inputs[i].lines.empty()) {
+            heads.emplace(inputs[i].lines.front().timestamp, i, 0);
+        }
+    }
+    SegmentWriter writer(target, options.max_file_size);
+    std::string error;
+    while (!heads.empty()) {
+        const auto [timestamp, input, index] = heads.top();
+        heads.pop();
+        const std::vector<Line> &source = inputs[input].lines;
+        if (!writer.append(source[index], error)) {
+            break;
+        }
+        if (index + 1 < source.size()) {
+            heads.emplace(source[index + 1].timestamp, input, index + 1);
+        }
+    }
+    if (!error.empty() || !writer.finish(error)) {
+        std::cerr << "import: " << error << std::endl;
+        return EXIT_FAILURE;
+    }
+    for (Input &input : inputs) {
+        if (input.mapped) {
+            ::munmap(input.data, input.size);
+        }
+    }
+
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    const double megabytes = static_cast<double>(input_bytes) / (1024.0 * 1024.0);
+    std::printf("Imported %lu lines from %zu files into %zu segments in %s\n", lines, inputs.size(),
+                writer.segments(), target.c_str());
+    std::printf("Read %.1f MB, wrote %.1f MB in %.2f s (%.1f MB/s, %.0f lines/s)\n", megabytes,
+                static_cast<double>(writer.bytes()) / (1024.0 * 1024.0), seconds,
+                seconds > 0.0 ? megabytes / seconds : 0.0, seconds > 0.0 ? static_cast<double>(lines) / seconds : 0.0);
+    if (reordered > 0) {
+        std::printf("Sorted %lu lines that were out of time order\n", reordered);
+    }
+    const unsigned long truncated = totals.truncated.load();
+    if (truncated > 0) {
+        std::printf("Cut %lu lines to %zu bytes\n", truncated, Server::kMaxLogLength);
+    }
+    if (redactor.enabled()) {
+        std::printf("Masked %lu matches\n", totals.redactions.load());
+    }
+    const std::size_t segments = count_segments(target);
+    if (segments > Server::kDefaultPersistenceMaxFiles) {
+        std::printf("Start the server with --persistence-max-files %zu or more; rotation prunes the oldest segments "
+                    "beyond that limit\n",
+                    segments);
+    }
+    return EXIT_SUCCESS;
+}